@@ -1,8 +1,14 @@
-// Cyborg ZOSCII v20260418
+// Cyborg ZOSCII v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 
 // Windows & Linux Version
+// Linux: gcc -O2 zstrength.c -o zstrength -lm -pthread
+
+#ifndef _WIN32
+    #define _FILE_OFFSET_BITS 64
+    #define _POSIX_C_SOURCE 200809L
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,6 +19,14 @@
 #ifdef _WIN32
     #include <fcntl.h>
     #include <io.h>
+    #include <windows.h>
+    #define fileSeek _fseeki64
+    #define fileTell _ftelli64
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #define fileSeek fseeko
+    #define fileTell ftello
 #endif
 
 typedef struct 
@@ -25,12 +39,29 @@ typedef struct
 {
     uint8_t* ptrROMData;
     long lngROMSize;
-    uint32_t arrROMCounts[256];
-    uint32_t arrROMCountsHigh[256];
+    uint64_t arrROMCounts[256];
+    uint64_t arrROMCountsHigh[256];
 } ROMData;
 
 #define ZOSCII_ROM_LOAD_MAX 131072L
 
+// Byte histograms: each thread counts one slice of the input into HISTOGRAM_LANES
+// interleaved sub-histograms (consecutive bytes hit different lanes, so a run of equal
+// bytes does not stall on its own counter's last store), merged at the end
+#define HISTOGRAM_LANES         4
+#define HISTOGRAM_BUFFER_SIZE   (1 << 20)
+#define HISTOGRAM_MIN_SLICE     (16LL << 20)
+#define HISTOGRAM_MAX_THREADS   64
+
+typedef struct
+{
+    const char* strFilename;
+    int64_t lngStart;
+    int64_t lngEnd;                         // -1 = to EOF (input size unknown)
+    uint64_t arrLanes[HISTOGRAM_LANES][256];
+    bool blnOk;
+} HistogramSlice;
+
 static void printLargeNumber(double dblExponent_a) 
 {
     if (dblExponent_a < 3) 
@@ -67,6 +98,201 @@ static void printLargeNumber(double dblExponent_a)
     }
 }
 
+static void histogramBuffer(const uint8_t* ptrData_a, size_t lngLen_a, uint64_t arrLanes_a[HISTOGRAM_LANES][256])
+{
+    size_t lngI = 0;
+    
+    for (; lngI + 8 <= lngLen_a; lngI += 8)
+    {
+        uint64_t lngWord;
+        memcpy(&lngWord, ptrData_a + lngI, 8);
+        arrLanes_a[0][(uint8_t)(lngWord)]++;
+        arrLanes_a[1][(uint8_t)(lngWord >> 8)]++;
+        arrLanes_a[2][(uint8_t)(lngWord >> 16)]++;
+        arrLanes_a[3][(uint8_t)(lngWord >> 24)]++;
+        arrLanes_a[0][(uint8_t)(lngWord >> 32)]++;
+        arrLanes_a[1][(uint8_t)(lngWord >> 40)]++;
+        arrLanes_a[2][(uint8_t)(lngWord >> 48)]++;
+        arrLanes_a[3][(uint8_t)(lngWord >> 56)]++;
+    }
+    for (; lngI < lngLen_a; lngI++)
+    {
+        arrLanes_a[0][ptrData_a[lngI]]++;
+    }
+}
+
+static void histogramMerge(uint64_t arrLanes_a[HISTOGRAM_LANES][256], uint64_t arrCounts_a[256])
+{
+    for (int intI = 0; intI < 256; intI++)
+    {
+        for (int intLane = 0; intLane < HISTOGRAM_LANES; intLane++)
+        {
+            arrCounts_a[intI] += arrLanes_a[intLane][intI];
+        }
+    }
+}
+
+// Counts one slice of the file through its own FILE handle
+static void histogramSlice(HistogramSlice* ptrSlice_a)
+{
+    FILE* ptrFile = fopen(ptrSlice_a->strFilename, "rb");
+    uint8_t* ptrBuffer = (uint8_t*)malloc(HISTOGRAM_BUFFER_SIZE);
+    
+    ptrSlice_a->blnOk = false;
+    if (ptrFile && ptrBuffer && (ptrSlice_a->lngStart == 0 || fileSeek(ptrFile, ptrSlice_a->lngStart, SEEK_SET) == 0))
+    {
+        int64_t lngPos = ptrSlice_a->lngStart;
+        size_t lngRead = 1;
+        
+        while (lngRead > 0 && (ptrSlice_a->lngEnd < 0 || lngPos < ptrSlice_a->lngEnd))
+        {
+            size_t lngWant = HISTOGRAM_BUFFER_SIZE;
+            if (ptrSlice_a->lngEnd >= 0 && ptrSlice_a->lngEnd - lngPos < (int64_t)lngWant)
+            {
+                lngWant = (size_t)(ptrSlice_a->lngEnd - lngPos);
+            }
+            lngRead = fread(ptrBuffer, 1, lngWant, ptrFile);
+            histogramBuffer(ptrBuffer, lngRead, ptrSlice_a->arrLanes);
+            lngPos += (int64_t)lngRead;
+        }
+        ptrSlice_a->blnOk = !ferror(ptrFile);
+    }
+    
+    if (ptrBuffer)
+    {
+        free(ptrBuffer);
+    }
+    if (ptrFile)
+    {
+        fclose(ptrFile);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI histogramThread(LPVOID ptrSlice_a)
+{
+    histogramSlice((HistogramSlice*)ptrSlice_a);
+    return 0;
+}
+#else
+static void* histogramThread(void* ptrSlice_a)
+{
+    histogramSlice((HistogramSlice*)ptrSlice_a);
+    return NULL;
+}
+#endif
+
+static int cpuCount(void)
+{
+    int intCount = 1;
+#ifdef _WIN32
+    SYSTEM_INFO objInfo;
+    GetSystemInfo(&objInfo);
+    intCount = (int)objInfo.dwNumberOfProcessors;
+#else
+    long lngCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (lngCount > 0)
+    {
+        intCount = (int)lngCount;
+    }
+#endif
+    return (intCount < 1) ? 1 : intCount;
+}
+
+// Byte counts of a whole file: one slice per CPU (at least HISTOGRAM_MIN_SLICE each),
+// read in parallel; a stream whose size is unknown is read by one thread
+static bool histogramFile(const char* strFilename_a, uint64_t arrCounts_a[256], uint64_t* ptrLength_a)
+{
+    bool blnSuccess = false;
+    int64_t lngSize = -1;
+    int intThreads = 1;
+    HistogramSlice* ptrSlices = NULL;
+    FILE* ptrFile = fopen(strFilename_a, "rb");
+    
+    if (ptrFile)
+    {
+        if (fileSeek(ptrFile, 0, SEEK_END) == 0)
+        {
+            lngSize = (int64_t)fileTell(ptrFile);
+        }
+        fclose(ptrFile);
+        
+        if (lngSize > 0)
+        {
+            int64_t lngSlices = lngSize / HISTOGRAM_MIN_SLICE;
+            intThreads = cpuCount();
+            if (intThreads > HISTOGRAM_MAX_THREADS)
+            {
+                intThreads = HISTOGRAM_MAX_THREADS;
+            }
+            if (lngSlices < intThreads)
+            {
+                intThreads = (lngSlices < 1) ? 1 : (int)lngSlices;
+            }
+        }
+        ptrSlices = (HistogramSlice*)calloc((size_t)intThreads, sizeof(HistogramSlice));
+    }
+    
+    if (ptrSlices)
+    {
+#ifdef _WIN32
+        HANDLE arrThreads[HISTOGRAM_MAX_THREADS];
+#else
+        pthread_t arrThreads[HISTOGRAM_MAX_THREADS];
+#endif
+        bool arrStarted[HISTOGRAM_MAX_THREADS];
+        
+        for (int intI = 0; intI < intThreads; intI++)
+        {
+            ptrSlices[intI].strFilename = strFilename_a;
+            ptrSlices[intI].lngStart = (lngSize > 0) ? lngSize * intI / intThreads : 0;
+            ptrSlices[intI].lngEnd = (lngSize > 0) ? lngSize * (intI + 1) / intThreads : -1;
+        }
+        
+        // Slice 0 runs here; the rest on threads (inline if one cannot be started)
+        for (int intI = 1; intI < intThreads; intI++)
+        {
+#ifdef _WIN32
+            arrThreads[intI] = CreateThread(NULL, 0, histogramThread, &ptrSlices[intI], 0, NULL);
+            arrStarted[intI] = (arrThreads[intI] != NULL);
+#else
+            arrStarted[intI] = (pthread_create(&arrThreads[intI], NULL, histogramThread, &ptrSlices[intI]) == 0);
+#endif
+            if (!arrStarted[intI])
+            {
+                histogramSlice(&ptrSlices[intI]);
+            }
+        }
+        histogramSlice(&ptrSlices[0]);
+        
+        blnSuccess = true;
+        for (int intI = 0; intI < intThreads; intI++)
+        {
+            if (intI > 0 && arrStarted[intI])
+            {
+#ifdef _WIN32
+                WaitForSingleObject(arrThreads[intI], INFINITE);
+                CloseHandle(arrThreads[intI]);
+#else
+                pthread_join(arrThreads[intI], NULL);
+#endif
+            }
+            blnSuccess = blnSuccess && ptrSlices[intI].blnOk;
+            histogramMerge(ptrSlices[intI].arrLanes, arrCounts_a);
+        }
+        
+        *ptrLength_a = 0;
+        for (int intI = 0; intI < 256; intI++)
+        {
+            *ptrLength_a += arrCounts_a[intI];
+        }
+        
+        free(ptrSlices);
+    }
+    
+    return blnSuccess;
+}
+
 static ROMData* loadROM(const char* strFilename_a)
 {
     ROMData* ptrROMData = NULL;
@@ -96,16 +322,17 @@ static ROMData* loadROM(const char* strFilename_a)
                 fread(ptrROMData->ptrROMData, 1, ptrROMData->lngROMSize, ptrROMFile);
                 
                 // Count ROM byte occurrences - first 64KB (encoding range)
+                uint64_t arrLanes[HISTOGRAM_LANES][256] = {{0}};
                 long lngLowSize = (ptrROMData->lngROMSize > 65536L) ? 65536L : ptrROMData->lngROMSize;
-                for (long lngI = 0; lngI < lngLowSize; lngI++)
-                {
-                    ptrROMData->arrROMCounts[ptrROMData->ptrROMData[lngI]]++;
-                }
+                histogramBuffer(ptrROMData->ptrROMData, (size_t)lngLowSize, arrLanes);
+                histogramMerge(arrLanes, ptrROMData->arrROMCounts);
                 
                 // Count ROM byte occurrences - second 64KB (if present)
-                for (long lngI = 65536L; lngI < ptrROMData->lngROMSize; lngI++)
+                if (ptrROMData->lngROMSize > 65536L)
                 {
-                    ptrROMData->arrROMCountsHigh[ptrROMData->ptrROMData[lngI]]++;
+                    memset(arrLanes, 0, sizeof(arrLanes));
+                    histogramBuffer(ptrROMData->ptrROMData + 65536L, (size_t)(ptrROMData->lngROMSize - 65536L), arrLanes);
+                    histogramMerge(arrLanes, ptrROMData->arrROMCountsHigh);
                 }
             }
             else
@@ -141,28 +368,17 @@ static void unloadROM(ROMData* ptrROMData_a)
 
 static bool analyzeFile(const ROMData* ptrROMData_a, const char* strInputFile_a)
 {
-    uint32_t arrInputCounts[256] = {0};
+    uint64_t arrInputCounts[256] = {0};
     bool blnSuccess = false;
     double dblFileStrength = 0.0;
     double dblGeneralStrength = 0.0;
     double dblUtilisation = 0.0;
-    int intCh = 0;
     int intCharsUsed = 0;
-    int intInputLength = 0;
-    FILE* ptrInput = NULL;
+    uint64_t lngInputLength = 0;
     
-    ptrInput = fopen(strInputFile_a, "rb");
-    if (ptrInput)
+    // Count input character occurrences
+    if (histogramFile(strInputFile_a, arrInputCounts, &lngInputLength))
     {
-        // Count input character occurrences
-        while ((intCh = fgetc(ptrInput)) != EOF)
-        {
-            uint8_t by = (uint8_t)intCh;
-            arrInputCounts[by]++;
-            intInputLength++;
-        }
-        fclose(ptrInput);
-        
         // Count characters utilized
         for (int intI = 0; intI < 256; intI++)
         {
@@ -177,11 +393,11 @@ static bool analyzeFile(const ROMData* ptrROMData_a, const char* strInputFile_a)
         {
             if (ptrROMData_a->arrROMCounts[intI] > 0)
             {
-                dblGeneralStrength += log10(ptrROMData_a->arrROMCounts[intI]);
+                dblGeneralStrength += log10((double)ptrROMData_a->arrROMCounts[intI]);
             }
             if (arrInputCounts[intI] > 0 && ptrROMData_a->arrROMCounts[intI] > 0)
             {
-                dblFileStrength += arrInputCounts[intI] * log10(ptrROMData_a->arrROMCounts[intI]);
+                dblFileStrength += (double)arrInputCounts[intI] * log10((double)ptrROMData_a->arrROMCounts[intI]);
             }
         }
         
@@ -191,7 +407,7 @@ static bool analyzeFile(const ROMData* ptrROMData_a, const char* strInputFile_a)
         printf("=====================\n\n");
         
         printf("Input Information:\n");
-        printf("- Text Length: %d characters\n", intInputLength);
+        printf("- Text Length: %llu characters\n", (unsigned long long)lngInputLength);
         printf("- Characters Utilized: %d of 256 (%.1f%%)\n", intCharsUsed, dblUtilisation);
         printf("\n");
         
@@ -212,8 +428,9 @@ static bool analyzeFile(const ROMData* ptrROMData_a, const char* strInputFile_a)
             if (ptrROMData_a->arrROMCounts[intI] > 0 || ptrROMData_a->arrROMCountsHigh[intI] > 0 || arrInputCounts[intI] > 0)
             {
                 char chDisplay = (intI >= 32 && intI <= 126) ? (char)intI : ' ';
-                printf("0x%02X  %3d  %10u  %10u  %11u    %c\n", 
-                       intI, intI, ptrROMData_a->arrROMCounts[intI], ptrROMData_a->arrROMCountsHigh[intI], arrInputCounts[intI], chDisplay);
+                printf("0x%02X  %3d  %10llu  %10llu  %11llu    %c\n", 
+                       intI, intI, (unsigned long long)ptrROMData_a->arrROMCounts[intI], (unsigned long long)ptrROMData_a->arrROMCountsHigh[intI],
+                       (unsigned long long)arrInputCounts[intI], chDisplay);
             }
         }
         
@@ -234,7 +451,7 @@ int main(int intArgC_a, char* strArgv_a[])
     _setmode(_fileno(stdout), _O_BINARY);
 #endif
 
-    printf("ZOSCII ROM Strength Analyzer v20260418\n");
+    printf("ZOSCII ROM Strength Analyzer v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
     if (intArgC_a == 3)
@@ -1,7 +1,19 @@
-cl /O2 /MT ztbaddblock.c /link
-cl /O2 /MT ztbaddbranch.c /link
-cl /O2 /MT ztbcheckpoint.c /link
-cl /O2 /MT ztbcreate.c /link
-cl /O2 /MT ztbfetch.c /link
-cl /O2 /MT ztbtruncate.c /link
-cl /O2 /MT ztbverify.c /link
+cl /O2 /MT /c ztbcommon.c libztb.c
+lib /OUT:libztb.lib ztbcommon.obj libztb.obj
+cl /O2 /MT /LD /DZTB_BUILD_DLL ztbcommon.c libztb.c /Feztb.dll
+cl /O2 /MT ztbaddblock.c libztb.lib /link
+cl /O2 /MT ztbaddbranch.c libztb.lib /link
+cl /O2 /MT ztbarchive.c libztb.lib /link
+cl /O2 /MT ztbbench.c libztb.lib /link
+cl /O2 /MT ztbcheckpoint.c libztb.lib /link
+cl /O2 /MT ztbcreate.c libztb.lib /link
+cl /O2 /MT ztbd.c libztb.lib /link
+cl /O2 /MT ztbexport.c libztb.lib /link
+cl /O2 /MT ztbfetch.c libztb.lib /link
+cl /O2 /MT ztbgrep.c libztb.lib /link
+cl /O2 /MT ztbimport.c libztb.lib /link
+cl /O2 /MT ztbmigrate.c libztb.lib /link
+cl /O2 /MT ztbprove.c libztb.lib /link
+cl /O2 /MT ztbstat.c libztb.lib /link
+cl /O2 /MT ztbtruncate.c libztb.lib /link
+cl /O2 /MT ztbverify.c libztb.lib /link
@@ -0,0 +1,694 @@
+// Cyborg ZTB Library v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// ZTBChain handle API (see libztb.h) over the ztbcommon block functions.
+//
+// The handle holds one rolling ROM: the ROM for the block after objRom->strPrevID.
+// ztb_append, ztb_fetch and ztb_verify all take it from chain_rom, which only
+// rebuilds it (up to 64 block reads) when the next block does not follow the last
+// one the handle wrote, fetched or verified. A failed read or write drops it.
+// Chains index updates are queued per chain and written by ztb_commit once the
+// blocks they point at are durable, so a batch of appends records one tip. The
+// chain's lock (see ZTBChainLock) is taken by the first append to it and held until
+// then, so other writers find the new tip in chains.idx when they get the lock.
+
+#include "ztbcommon.h"
+#include "libztb.h"
+
+// --- A chain this handle holds the lock of, and its index update for ztb_commit ---
+// Names longer than 36 characters are kept cut to 37, which chains_index rejects.
+typedef struct
+{
+    char         strChain[GUID_LEN + 1];
+    char         strTrunk[GUID_LEN + 1];    // "" unless the chain was forked here
+    char         strFirst[GUID_LEN];
+    char         strFork[GUID_LEN];
+    char         strTip[GUID_LEN];          // "" until a block is appended
+    ZTBChainLock objLock;
+    int          blnLocked;
+} ZTBPendingTip;
+
+struct ZTBChain
+{
+    char          *strWorkDir;
+    ZTBRollingRom *objRom;                  // NULL until first needed
+    ZTBSync        objSync;
+    char           strLast[GUID_LEN];       // last block appended ("" if none)
+    ZTBPendingTip *arrTips;
+    int            intTips;
+    int            intTipCap;
+};
+
+// --- Rolling ROM for the block after strPrevID_a, reusing the handle's if it is there ---
+static ZTBRollingRom* chain_rom(ZTBChain *objChain_a, const char *strPrevID_a)
+{
+    if (objChain_a->objRom && strcmp(objChain_a->objRom->strPrevID, strPrevID_a) != 0)
+    {
+        rolling_rom_close(objChain_a->objRom);
+        objChain_a->objRom = NULL;
+    }
+
+    if (!objChain_a->objRom)
+    {
+        objChain_a->objRom = rolling_rom_open(objChain_a->strWorkDir, strPrevID_a);
+        if (!objChain_a->objRom) { fprintf(stderr, "Error: Cannot build rolling ROM\n"); }
+    }
+
+    return objChain_a->objRom;
+}
+
+static void chain_rom_drop(ZTBChain *objChain_a)
+{
+    if (objChain_a->objRom)
+    {
+        rolling_rom_close(objChain_a->objRom);
+        objChain_a->objRom = NULL;
+    }
+}
+
+// --- 1 if strBlockID_a is a truncation marker (so the next block's prev_hash is not checked) ---
+static int is_truncation(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    ZTBBlockHeader objHeader;
+    return strcmp(strBlockID_a, NULL_GUID) != 0 &&
+           block_header(strWorkDir_a, strBlockID_a, &objHeader) &&
+           objHeader.intBlockType == BLOCK_TYPE_TRUNCATION;
+}
+
+static void info_from_header(const ZTBBlockHeader *objHeader_a, ZTBBlockInfo *objInfo_a)
+{
+    snprintf(objInfo_a->strBlockID, ZTB_ID_LEN, "%s", objHeader_a->strBlockID);
+    snprintf(objInfo_a->strPrevID, ZTB_ID_LEN, "%s", objHeader_a->strPrevID);
+    snprintf(objInfo_a->strTrunkID, ZTB_ID_LEN, "%s", objHeader_a->strTrunkID);
+    objInfo_a->intBlockType = objHeader_a->intBlockType;
+    objInfo_a->blnIsBranch  = objHeader_a->blnIsBranch;
+    objInfo_a->intFileLen   = objHeader_a->intFileLen;
+}
+
+// --- The handle's entry for a chain, added the first time the chain is appended to ---
+static ZTBPendingTip* pending_chain(ZTBChain *objChain_a, const char *strChain_a)
+{
+    ZTBPendingTip *objTip = NULL;
+    int intI;
+
+    for (intI = 0; intI < objChain_a->intTips && !objTip; intI++)
+    {
+        if (strncmp(objChain_a->arrTips[intI].strChain, strChain_a, GUID_LEN) == 0)
+        {
+            objTip = &objChain_a->arrTips[intI];
+        }
+    }
+
+    if (!objTip)
+    {
+        if (objChain_a->intTips == objChain_a->intTipCap)
+        {
+            int intCap = objChain_a->intTipCap ? objChain_a->intTipCap * 2 : 4;
+            ZTBPendingTip *arrNew = (ZTBPendingTip*)realloc(objChain_a->arrTips,
+                                                             (size_t)intCap * sizeof(ZTBPendingTip));
+            if (arrNew)
+            {
+                objChain_a->arrTips   = arrNew;
+                objChain_a->intTipCap = intCap;
+            }
+        }
+        if (objChain_a->intTips < objChain_a->intTipCap)
+        {
+            objTip = &objChain_a->arrTips[objChain_a->intTips++];
+            memset(objTip, 0, sizeof(ZTBPendingTip));
+            snprintf(objTip->strChain, sizeof(objTip->strChain), "%s", strChain_a);
+        }
+    }
+
+    if (!objTip) { fprintf(stderr, "Error: Cannot allocate chains index update\n"); }
+    return objTip;
+}
+
+// --- Where strPrevID_a stands against the chain's recorded tip ---
+// Walks back from both at once, one block each per step, so the usual cases (a writer a
+// few blocks behind, or an index lagging a few blocks) stop after a few headers. Only
+// blocks on two different forks walk both all the way down.
+#define TIP_FORKED      0                   // neither descends from the other
+#define TIP_AHEAD       1                   // prev is a strict ancestor of the tip: rebase
+#define TIP_BEHIND      2                   // the tip is an ancestor of prev: index lags
+#define TIP_FIRST       3                   // prev is NULL_GUID: a first block on a non-empty chain
+
+static int tip_relation(const char *strWorkDir_a, const char *strTip_a, const char *strPrevID_a)
+{
+    int intResult = TIP_FORKED;
+    int blnFromTip  = 1;
+    int blnFromPrev = 1;
+    char strFromTip[GUID_LEN];
+    char strFromPrev[GUID_LEN];
+    ZTBBlockHeader objHeader;
+
+    snprintf(strFromTip, GUID_LEN, "%s", strTip_a);
+    snprintf(strFromPrev, GUID_LEN, "%s", strPrevID_a);
+    if (strcmp(strPrevID_a, NULL_GUID) == 0) { intResult = TIP_FIRST; }
+
+    while (intResult == TIP_FORKED && (blnFromTip || blnFromPrev))
+    {
+        if (blnFromTip)
+        {
+            blnFromTip = block_header(strWorkDir_a, strFromTip, &objHeader) &&
+                         strcmp(objHeader.strPrevID, NULL_GUID) != 0;
+            if (blnFromTip)
+            {
+                snprintf(strFromTip, GUID_LEN, "%s", objHeader.strPrevID);
+                if (strcmp(strFromTip, strPrevID_a) == 0) { intResult = TIP_AHEAD; }
+            }
+        }
+        if (blnFromPrev && intResult == TIP_FORKED)
+        {
+            blnFromPrev = block_header(strWorkDir_a, strFromPrev, &objHeader) &&
+                          strcmp(objHeader.strPrevID, NULL_GUID) != 0;
+            if (blnFromPrev)
+            {
+                snprintf(strFromPrev, GUID_LEN, "%s", objHeader.strPrevID);
+                if (strcmp(strFromPrev, strTip_a) == 0) { intResult = TIP_BEHIND; }
+            }
+        }
+    }
+
+    return intResult;
+}
+
+// --- Take the chain's lock, then check strPrevID_a against the chain's tip ---
+// The tip is this handle's own last block on the chain, else the one in chains.idx.
+// If strPrevID_a is a strict ancestor of the tip, another writer has moved the chain
+// on: the append goes on the tip instead (strPrevID_a is updated), or fails as a
+// conflict with blnStrict. If the tip is an ancestor of strPrevID_a, the index lags
+// (a crash before ztb_commit, or blocks from older tools): strPrevID_a stands and the
+// commit moves the index up to the new block. A first block (prev NULL_GUID) on a chain
+// that has a tip is a conflict too. Anything else would fork the chain and fails. A
+// branch's first block follows its fork point, so branches are locked but never rebased.
+static int lock_and_rebase(ZTBChain *objChain_a, const ZTBAppend *objAppend_a, ZTBPendingTip *objTip_a,
+                           char *strPrevID_a, ZTBAppendResult *objResult_a)
+{
+    int intResult = 1;
+    char strTip[GUID_LEN];
+
+    if (!objTip_a->blnLocked)
+    {
+        objTip_a->blnLocked = chain_lock(objChain_a->strWorkDir, objTip_a->strChain, &objTip_a->objLock);
+        intResult = objTip_a->blnLocked;
+    }
+
+    if (intResult && objAppend_a->intKind != ZTB_APPEND_BRANCH)
+    {
+        if (objTip_a->strTip[0]) { snprintf(strTip, GUID_LEN, "%s", objTip_a->strTip); }
+        else                     { chains_index_last_tip(objChain_a->strWorkDir, objTip_a->strChain, strTip); }
+
+        if (strTip[0] && strcmp(strTip, strPrevID_a) != 0 && block_exists(objChain_a->strWorkDir, strTip))
+        {
+            int intRelation = tip_relation(objChain_a->strWorkDir, strTip, strPrevID_a);
+
+            if (intRelation == TIP_FIRST)
+            {
+                fprintf(stderr, "Error: Chain '%s' is not empty (its tip is %s)\n", objTip_a->strChain, strTip);
+                snprintf(objResult_a->strPrevID, ZTB_ID_LEN, "%s", strTip);
+                objResult_a->blnConflict = 1;
+                intResult = 0;
+            }
+            else if (intRelation == TIP_FORKED)
+            {
+                fprintf(stderr, "Error: %s and the tip of chain '%s' (%s) are on different forks\n",
+                        strPrevID_a, objTip_a->strChain, strTip);
+                snprintf(objResult_a->strPrevID, ZTB_ID_LEN, "%s", strTip);
+                intResult = 0;
+            }
+            else if (intRelation == TIP_AHEAD && objAppend_a->blnStrict)
+            {
+                fprintf(stderr, "Error: %s is not the tip of chain '%s' (%s is)\n",
+                        strPrevID_a, objTip_a->strChain, strTip);
+                snprintf(objResult_a->strPrevID, ZTB_ID_LEN, "%s", strTip);
+                objResult_a->blnConflict = 1;
+                intResult = 0;
+            }
+            else if (intRelation == TIP_AHEAD)
+            {
+                snprintf(strPrevID_a, GUID_LEN, "%s", strTip);
+                objResult_a->blnRebased = 1;
+            }
+        }
+    }
+
+    return intResult;
+}
+
+// --- Record the chain's new tip (and its fork, for a branch) for ztb_commit ---
+static void queue_tip(ZTBPendingTip *objTip_a, const ZTBAppend *objAppend_a, const char *strBlockID_a,
+                      const char *strPrevID_a)
+{
+    if (objAppend_a->intKind == ZTB_APPEND_BRANCH)
+    {
+        snprintf(objTip_a->strTrunk, sizeof(objTip_a->strTrunk), "%s", objAppend_a->strTrunk);
+        snprintf(objTip_a->strFirst, GUID_LEN, "%s", strBlockID_a);
+        snprintf(objTip_a->strFork, GUID_LEN, "%s", strPrevID_a);
+    }
+    snprintf(objTip_a->strTip, GUID_LEN, "%s", strBlockID_a);
+}
+
+// --- Open a workdir (it must hold a genesis block) ---
+ZTB_API ZTBChain* ztb_open(const char *strWorkDir_a)
+{
+    ZTBChain *objChain = NULL;
+    char strGenesisID[GUID_LEN];
+
+    if (!find_genesis_id(strWorkDir_a, strGenesisID))
+    {
+        fprintf(stderr, "Error: No genesis block in workdir %s\n", strWorkDir_a);
+    }
+    else
+    {
+        size_t intLen = strlen(strWorkDir_a) + 1;
+        objChain = (ZTBChain*)calloc(1, sizeof(ZTBChain));
+        if (objChain) { objChain->strWorkDir = (char*)malloc(intLen); }
+        if (objChain && objChain->strWorkDir)
+        {
+            memcpy(objChain->strWorkDir, strWorkDir_a, intLen);
+            sync_init(&objChain->objSync);
+        }
+        else
+        {
+            if (objChain) { free(objChain); }
+            objChain = NULL;
+            fprintf(stderr, "Error: Cannot allocate chain handle\n");
+        }
+    }
+
+    return objChain;
+}
+
+// --- Commit whatever is pending, then free the handle ---
+ZTB_API void ztb_close(ZTBChain *objChain_a)
+{
+    if (objChain_a)
+    {
+        ztb_commit(objChain_a);
+        chain_rom_drop(objChain_a);
+        sync_free(&objChain_a->objSync);
+        if (objChain_a->arrTips) { free(objChain_a->arrTips); }
+        free(objChain_a->strWorkDir);
+        free(objChain_a);
+    }
+}
+
+ZTB_API const char* ztb_version(void)
+{
+    return ZTB_LIB_VERSION;
+}
+
+ZTB_API int ztb_set_sync(ZTBChain *objChain_a, const char *strPolicy_a)
+{
+    return sync_parse(&objChain_a->objSync, strPolicy_a);
+}
+
+ZTB_API void ztb_set_durable(ZTBChain *objChain_a, ZTBDurableFn fnDurable_a)
+{
+    objChain_a->objSync.fnDurable = fnDurable_a;
+}
+
+// --- A Merkle checkpoint's payload: the label, then the root of the blocks below it ---
+// Called once strPrevID_a is final (after any rebase). *arrLeaves_a is kept for the .mrk.
+static int merkle_payload(ZTBChain *objChain_a, const ZTBAppend *objAppend_a, const char *strPrevID_a,
+                          uint8_t **arrLeaves_a, int *intLeaves_a, uint8_t **byPayload_a,
+                          size_t *intPayloadLen_a, ZTBAppendResult *objResult_a)
+{
+    int intResult = 1;
+    char strLine[MERKLE_LINE_MAX];
+    size_t intLabelLen = objAppend_a->byData ? (size_t)objAppend_a->intDataLen : 0;
+
+    if (objAppend_a->fData)
+    {
+        fprintf(stderr, "Error: A Merkle checkpoint takes its label in memory\n");
+        intResult = 0;
+    }
+    else if ((*intLeaves_a = merkle_chain_leaves(objChain_a->strWorkDir, strPrevID_a, NULL, arrLeaves_a)) < 0)
+    {
+        intResult = 0;
+    }
+    else
+    {
+        merkle_root(*arrLeaves_a, (uint32_t)*intLeaves_a, objResult_a->arrMerkleRoot);
+        objResult_a->intMerkleLeaves = (uint32_t)*intLeaves_a;
+        int intLineLen = merkle_line(objResult_a->intMerkleLeaves, objResult_a->arrMerkleRoot, strLine);
+
+        *byPayload_a = (uint8_t*)malloc(intLabelLen + (size_t)intLineLen);
+        if (!*byPayload_a)
+        {
+            fprintf(stderr, "Error: Cannot allocate checkpoint payload\n");
+            intResult = 0;
+        }
+        else
+        {
+            if (intLabelLen) { memcpy(*byPayload_a, objAppend_a->byData, intLabelLen); }
+            memcpy(*byPayload_a + intLabelLen, strLine, (size_t)intLineLen);
+            *intPayloadLen_a = intLabelLen + (size_t)intLineLen;
+        }
+    }
+
+    return intResult;
+}
+
+// --- Append a block (see ZTBAppend) ---
+ZTB_API int ztb_append(ZTBChain *objChain_a, const ZTBAppend *objAppend_a,
+                       ZTBAppendResult *objResult_a)
+{
+    int intResult = 1;
+    const char *strWorkDir = objChain_a->strWorkDir;
+    char strBlockID[GUID_LEN];
+    char strPrevID[GUID_LEN];
+
+    memset(objResult_a, 0, sizeof(ZTBAppendResult));
+
+    // --- 1. Prev and new block ID ---
+    if (objAppend_a->strPrevID)
+    {
+        snprintf(strPrevID, GUID_LEN, "%s", objAppend_a->strPrevID);
+    }
+    else if (objChain_a->strLast[0])
+    {
+        snprintf(strPrevID, GUID_LEN, "%s", objChain_a->strLast);
+    }
+    else
+    {
+        fprintf(stderr, "Error: No prev block given and none appended yet\n");
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        if (objAppend_a->strBlockID && objAppend_a->strBlockID[0])
+        {
+            snprintf(strBlockID, GUID_LEN, "%s", objAppend_a->strBlockID);
+        }
+        else
+        {
+            do { generate_guid(strBlockID); } while (block_exists(strWorkDir, strBlockID));
+        }
+
+        if (strcmp(strBlockID, NULL_GUID) == 0)
+        {
+            fprintf(stderr, "Error: Block ID cannot be %s\n", NULL_GUID);
+            intResult = 0;
+        }
+        else if (objAppend_a->intKind == ZTB_APPEND_BRANCH && (!objAppend_a->strTrunk || !objAppend_a->strChain))
+        {
+            fprintf(stderr, "Error: A branch needs its trunk and branch chain IDs\n");
+            intResult = 0;
+        }
+    }
+
+    // --- 2. Lock the chain; go on its tip if another writer moved it on ---
+    ZTBPendingTip *objTip = NULL;
+    if (intResult && objAppend_a->strChain)
+    {
+        objTip = pending_chain(objChain_a, objAppend_a->strChain);
+        intResult = objTip && lock_and_rebase(objChain_a, objAppend_a, objTip, strPrevID, objResult_a);
+    }
+
+    // --- 3. Payload source; a Merkle checkpoint's label gets the root of the blocks below ---
+    uint8_t *arrLeaves  = NULL;
+    uint8_t *byMerkle   = NULL;
+    int intLeaves       = 0;
+    size_t intMerkleLen = 0;
+    if (intResult && objAppend_a->intKind == ZTB_APPEND_CHECKPOINT && objAppend_a->blnMerkle)
+    {
+        intResult = merkle_payload(objChain_a, objAppend_a, strPrevID, &arrLeaves, &intLeaves,
+                                   &byMerkle, &intMerkleLen, objResult_a);
+    }
+
+    ZTBSource objSource;
+    if (byMerkle)
+    {
+        source_from_memory(&objSource, byMerkle, intMerkleLen);
+    }
+    else if (objAppend_a->fData && objAppend_a->intDataLen == ZTB_DATA_TO_EOF)
+    {
+        source_from_file(&objSource, objAppend_a->fData);
+    }
+    else if (objAppend_a->fData)
+    {
+        source_from_file_range(&objSource, objAppend_a->fData, objAppend_a->intDataLen);
+    }
+    else
+    {
+        source_from_memory(&objSource, objAppend_a->byData ? objAppend_a->byData : (const uint8_t*)"",
+                           objAppend_a->byData ? objAppend_a->intDataLen : 0);
+    }
+    objSource.blnCompress = objAppend_a->blnCompress;
+
+    // --- 4. Raw header (matches WriteRawHeader) ---
+    uint8_t arrRawHeader[HEADER_RAW_SIZE];
+    if (intResult)
+    {
+        if (objAppend_a->intKind == ZTB_APPEND_BRANCH)
+        {
+            build_raw_header(arrRawHeader, BLOCK_TYPE_NORMAL, 1, objAppend_a->strTrunk, strBlockID, strPrevID);
+        }
+        else
+        {
+            build_raw_header(arrRawHeader, objAppend_a->intKind == ZTB_APPEND_CHECKPOINT ?
+                             BLOCK_TYPE_CHECKPOINT : BLOCK_TYPE_NORMAL, 0, NULL_GUID, strBlockID, strPrevID);
+        }
+    }
+
+    // --- 5. Pad, hash, ZOSCII encode and write against the ROM at prev (see write_block) ---
+    ZTBRollingRom *objRom = intResult ? chain_rom(objChain_a, strPrevID) : NULL;
+    ZTBWriteResult objWrite;
+    if (!objRom)
+    {
+        intResult = 0;
+    }
+    else if (!write_block(strWorkDir, arrRawHeader, objRom, &objSource, &objChain_a->objSync, &objWrite))
+    {
+        chain_rom_drop(objChain_a);
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        snprintf(objResult_a->strBlockID, ZTB_ID_LEN, "%s", strBlockID);
+        snprintf(objResult_a->strPrevID, ZTB_ID_LEN, "%s", strPrevID);
+        objResult_a->intHash       = objWrite.intHash;
+        objResult_a->intPrevHash   = objWrite.intPrevHash;
+        objResult_a->intPayloadLen = objWrite.intPayloadLen;
+        objResult_a->intPaddedLen  = objWrite.intPaddedLen;
+        objResult_a->intDataLen    = objWrite.intDataLen;
+        objResult_a->intFileCrc    = objWrite.intFileCrc;
+        snprintf(objChain_a->strLast, GUID_LEN, "%s", strBlockID);
+
+        // --- 6. Checkpoint: snapshot the ROM as of it (objRom was advanced past it) ---
+        // The snapshot is only a cache; failing to write it leaves a valid checkpoint.
+        if (objAppend_a->intKind == ZTB_APPEND_CHECKPOINT && objAppend_a->blnSnapshot)
+        {
+            objResult_a->blnSnapshot = rom_snapshot_write(strWorkDir, strBlockID, objRom->arrRom,
+                                                          objRom->intSlices, objWrite.intFileCrc);
+            if (!objResult_a->blnSnapshot) { fprintf(stderr, "Warning: ROM snapshot not written\n"); }
+        }
+        // The leaves are a cache too, for the next Merkle checkpoint and ztbprove
+        if (byMerkle &&
+            !merkle_leaves_write(strWorkDir, strBlockID, objWrite.intFileCrc, arrLeaves,
+                                 (uint32_t)intLeaves, objResult_a->arrMerkleRoot))
+        {
+            fprintf(stderr, "Warning: Merkle leaves not saved\n");
+        }
+
+        // --- 7. The chain's new tip goes into chains.idx at the next commit ---
+        if (objTip) { queue_tip(objTip, objAppend_a, strBlockID, strPrevID); }
+    }
+
+    // Nothing of this handle's is pending on the chain: let other writers have it
+    if (!intResult && objTip && objTip->blnLocked && !objTip->strTip[0])
+    {
+        chain_unlock(&objTip->objLock);
+        objTip->blnLocked = 0;
+    }
+    if (arrLeaves) { free(arrLeaves); }
+    if (byMerkle)  { free(byMerkle); }
+
+    return intResult;
+}
+
+// --- Make the appended blocks durable, write the queued chains index updates, unlock ---
+ZTB_API int ztb_commit(ZTBChain *objChain_a)
+{
+    int intResult = sync_commit(&objChain_a->objSync, objChain_a->strWorkDir);
+    int intI;
+
+    for (intI = 0; intI < objChain_a->intTips; intI++)
+    {
+        ZTBPendingTip *objTip = &objChain_a->arrTips[intI];
+        if (intResult && objTip->strTip[0] &&
+            (!objTip->strTrunk[0] ||
+             chains_index_branch(objChain_a->strWorkDir, objTip->strTrunk, objTip->strChain,
+                                 objTip->strFirst, objTip->strFork, &objChain_a->objSync)))
+        {
+            chains_index_tip(objChain_a->strWorkDir, objTip->strChain, objTip->strTip, &objChain_a->objSync);
+        }
+        if (objTip->blnLocked) { chain_unlock(&objTip->objLock); }
+    }
+    objChain_a->intTips = 0;
+
+    return intResult;
+}
+
+// --- Tip of a chain as recorded in chains.idx. Returns 1 if recorded ---
+ZTB_API int ztb_tip(ZTBChain *objChain_a, const char *strChain_a, char *strTipID_a)
+{
+    ZTBChainIndex objIndex;
+    strTipID_a[0] = '\0';
+
+    if (chains_index_load(objChain_a->strWorkDir, &objIndex))
+    {
+        int intAt = chains_index_find(&objIndex, strChain_a);
+        if (intAt >= 0) { snprintf(strTipID_a, ZTB_ID_LEN, "%s", objIndex.arrChains[intAt].strTip); }
+        chains_index_free(&objIndex);
+    }
+
+    return strTipID_a[0] != '\0';
+}
+
+ZTB_API int ztb_block_info(ZTBChain *objChain_a, const char *strBlockID_a, ZTBBlockInfo *objInfo_a)
+{
+    ZTBBlockHeader objHeader;
+    int intResult = block_header(objChain_a->strWorkDir, strBlockID_a, &objHeader);
+    if (intResult) { info_from_header(&objHeader, objInfo_a); }
+    return intResult;
+}
+
+// --- Decode a block, passing its payload to fnPayload_a (may be NULL) ---
+// Returns 1 only if the block was read through and its hash and prev_hash match; the
+// payload is streamed before that is known. A truncation block has no payload.
+ZTB_API int ztb_fetch(ZTBChain *objChain_a, const char *strBlockID_a, ZTBPayloadFn fnPayload_a,
+                      void *objCtx_a, ZTBBlockInfo *objInfo_a)
+{
+    int intResult = 1;
+    ZTBBlockHeader objHeader;
+
+    if (!block_header(objChain_a->strWorkDir, strBlockID_a, &objHeader))
+    {
+        fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+        intResult = 0;
+    }
+    else
+    {
+        if (objInfo_a) { info_from_header(&objHeader, objInfo_a); }
+
+        if (objHeader.intBlockType != BLOCK_TYPE_TRUNCATION)
+        {
+            int blnPrevTrunc = is_truncation(objChain_a->strWorkDir, objHeader.strPrevID);
+            int blnIntact    = 0;
+            ZTBRollingRom *objRom = chain_rom(objChain_a, objHeader.strPrevID);
+
+            if (!objRom ||
+                !read_run_block(objChain_a->strWorkDir, objRom, strBlockID_a, blnPrevTrunc,
+                                fnPayload_a, objCtx_a, &blnIntact))
+            {
+                if (objRom) { fprintf(stderr, "Error: Cannot decode block '%s'\n", strBlockID_a); }
+                chain_rom_drop(objChain_a);
+                intResult = 0;
+            }
+            else if (!blnIntact)
+            {
+                fprintf(stderr, "Error: Block '%s' failed its integrity check\n", strBlockID_a);
+                intResult = 0;
+            }
+        }
+    }
+
+    return intResult;
+}
+
+// --- Walk back from strTipID_a over the raw headers, newest first ---
+// Stops at the start of the chain, after a truncation block, or when fnBlock_a
+// returns 0. Returns 0 only if a block on the way cannot be read.
+ZTB_API int ztb_iterate(ZTBChain *objChain_a, const char *strTipID_a, ZTBBlockFn fnBlock_a,
+                        void *objCtx_a)
+{
+    int intResult = 1;
+    int blnGo     = 1;
+    char strCurrentID[GUID_LEN];
+    snprintf(strCurrentID, GUID_LEN, "%s", strTipID_a);
+
+    while (intResult && blnGo && strcmp(strCurrentID, NULL_GUID) != 0)
+    {
+        ZTBBlockHeader objHeader;
+        ZTBBlockInfo objInfo;
+
+        if (!block_header(objChain_a->strWorkDir, strCurrentID, &objHeader))
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", strCurrentID);
+            intResult = 0;
+        }
+        else
+        {
+            info_from_header(&objHeader, &objInfo);
+            blnGo = fnBlock_a(objCtx_a, &objInfo) && objHeader.intBlockType != BLOCK_TYPE_TRUNCATION;
+            snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
+        }
+    }
+
+    return intResult;
+}
+
+// --- Verify the chain from strStopID_a (NULL = its start) up to strTipID_a ---
+// The blocks are decoded oldest first with the handle's ROM advanced block to block,
+// so verifying up to a tip leaves the handle ready to append on it. Returns 1 if
+// every block checked out; otherwise objResult_a->strFailedID names the first that
+// did not (or "" if the chain could not be walked).
+ZTB_API int ztb_verify(ZTBChain *objChain_a, const char *strTipID_a, const char *strStopID_a,
+                       ZTBVerifyResult *objResult_a)
+{
+    int intResult = 1;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    int intCount = collect_chain(objChain_a->strWorkDir, strTipID_a, strStopID_a, 0, &arrIDs);
+
+    memset(objResult_a, 0, sizeof(ZTBVerifyResult));
+    if (intCount < 0) { intResult = 0; }
+
+    if (intCount > 0)
+    {
+        ZTBBlockHeader objHeader;
+        ZTBRollingRom *objRom = NULL;
+        int blnPrevTrunc = 0;
+        int intI;
+
+        if (block_header(objChain_a->strWorkDir, arrIDs[intCount - 1], &objHeader))
+        {
+            blnPrevTrunc = is_truncation(objChain_a->strWorkDir, objHeader.strPrevID);
+            objRom = chain_rom(objChain_a, objHeader.strPrevID);
+        }
+
+        // The IDs are known, so the next few block files are read ahead while each decodes
+        int intAhead = readahead_depth();
+        for (intI = intCount - 1; intI >= 0 && intI >= intCount - intAhead; intI--)
+        {
+            block_readahead(objChain_a->strWorkDir, arrIDs[intI]);
+        }
+
+        for (intI = intCount - 1; intI >= 0 && intResult; intI--)
+        {
+            int blnIntact = 0;
+            if (intAhead > 0 && intI - intAhead >= 0) { block_readahead(objChain_a->strWorkDir, arrIDs[intI - intAhead]); }
+            if (!objRom ||
+                !read_run_block(objChain_a->strWorkDir, objRom, arrIDs[intI], blnPrevTrunc,
+                                NULL, NULL, &blnIntact) || !blnIntact)
+            {
+                if (objRom) { chain_rom_drop(objChain_a); }
+                snprintf(objResult_a->strFailedID, ZTB_ID_LEN, "%s", arrIDs[intI]);
+                intResult = 0;
+            }
+            else
+            {
+                objResult_a->intVerified++;
+                blnPrevTrunc = 0;
+            }
+        }
+    }
+
+    if (arrIDs) { free(arrIDs); }
+    return intResult;
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+// Cyborg ZTB Library v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Embeddable ZTB chain API (libztb.a / libztb.so, libztb.lib / ztb.dll), the C
+// counterpart of the ZTBChain class. A ZTBChain handle is one open workdir. It keeps
+// its rolling ROM between calls, so appending or fetching the block after the last
+// one it touched costs no ROM rebuild, and the process-wide block cache (see
+// ztbcommon.h) keeps headers and ROM slices between handles. The CLI tools are built
+// on the same library.
+//
+// Functions return 1 on success and 0 on failure, with the reason on stderr. A handle
+// must not be used by two threads at once; separate handles may be.
+//
+// Minimal use:
+//   ZTBChain *objChain = ztb_open("workdir");
+//   ZTBAppend objAppend = { 0 };
+//   objAppend.strChain  = "MyChain";
+//   objAppend.strPrevID = strTip;                 // NULL = the handle's last block
+//   objAppend.byData    = byPayload;
+//   objAppend.intDataLen = intPayloadLen;
+//   ztb_append(objChain, &objAppend, &objResult) && ztb_commit(objChain);
+//   ztb_close(objChain);
+
+#ifndef LIBZTB_H
+#define LIBZTB_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+    #if defined(ZTB_BUILD_DLL)
+        #define ZTB_API __declspec(dllexport)
+    #elif defined(ZTB_USE_DLL)
+        #define ZTB_API __declspec(dllimport)
+    #else
+        #define ZTB_API
+    #endif
+#elif defined(__GNUC__)
+    #define ZTB_API __attribute__((visibility("default")))
+#else
+    #define ZTB_API
+#endif
+
+#define ZTB_LIB_VERSION     "20261019"
+#define ZTB_ID_LEN          37              // 36-character GUID + NUL
+#define ZTB_DATA_TO_EOF     UINT64_MAX      // ZTBAppend.intDataLen: read fData to EOF
+
+typedef struct ZTBChain ZTBChain;
+
+// --- What ztb_append writes ---
+#define ZTB_APPEND_BLOCK        0           // normal block on strChain
+#define ZTB_APPEND_BRANCH       1           // first block of branch strChain, forked off strTrunk
+#define ZTB_APPEND_CHECKPOINT   2           // checkpoint; the payload is its label
+
+typedef struct
+{
+    int            intKind;
+    const char    *strChain;                // chain whose tip moves (NULL = none recorded)
+    const char    *strTrunk;                // ZTB_APPEND_BRANCH: the trunk chain
+    const char    *strBlockID;              // NULL = a fresh GUID
+    const char    *strPrevID;               // NULL = the last block this handle appended
+    const uint8_t *byData;                  // payload in memory ...
+    FILE          *fData;                   // ... or read from here, if not NULL
+    uint64_t       intDataLen;              // bytes (ZTB_DATA_TO_EOF with fData)
+    int            blnSnapshot;             // ZTB_APPEND_CHECKPOINT: also save a ROM snapshot
+    int            blnStrict;               // fail rather than rebase if strPrevID is not the tip
+    int            blnCompress;             // store the payload LZ4-compressed (read back as is)
+    int            blnMerkle;               // ZTB_APPEND_CHECKPOINT: commit a Merkle root of the
+                                            // blocks below it after the label (byData only)
+} ZTBAppend;
+
+typedef struct
+{
+    char     strBlockID[ZTB_ID_LEN];
+    char     strPrevID[ZTB_ID_LEN];
+    uint32_t intHash;
+    uint32_t intPrevHash;
+    uint64_t intPayloadLen;                 // bytes stored (compressed, with blnCompress)
+    uint64_t intPaddedLen;
+    uint64_t intDataLen;                    // payload bytes before compression
+    uint32_t intFileCrc;                    // CRC32 of the block file (the next prev_hash)
+    int      blnSnapshot;                   // a ROM snapshot was written
+    int      blnRebased;                    // strPrevID was not the chain's tip; went on the tip
+    int      blnConflict;                   // blnStrict failure (strPrevID holds the tip); nothing read
+    uint32_t intMerkleLeaves;               // blnMerkle: blocks under the root ...
+    uint8_t  arrMerkleRoot[32];             // ... and the root (SHA-256, RFC 6962 tree)
+} ZTBAppendResult;
+
+// --- A block's raw header (block types: 0 genesis, 1 normal, 2 checkpoint,
+//     3 truncation, 4 finalise, 5 bridge) ---
+typedef struct
+{
+    char     strBlockID[ZTB_ID_LEN];
+    char     strPrevID[ZTB_ID_LEN];
+    char     strTrunkID[ZTB_ID_LEN];
+    int      intBlockType;
+    int      blnIsBranch;
+    uint64_t intFileLen;
+} ZTBBlockInfo;
+
+typedef struct
+{
+    int  intVerified;
+    char strFailedID[ZTB_ID_LEN];           // "" if every block checked out
+} ZTBVerifyResult;
+
+// Payload chunks from ztb_fetch, decompressed if it was stored so; return 0 to stop
+typedef int (*ZTBPayloadFn)(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a);
+// Blocks from ztb_iterate, newest first; return 0 to stop
+typedef int (*ZTBBlockFn)(void *objCtx_a, const ZTBBlockInfo *objInfo_a);
+// Called with each appended block's ID once it is durable under the sync policy
+// (under "group", possibly from the thread that commits a group when its window closes)
+typedef void (*ZTBDurableFn)(const char *strBlockID_a);
+
+// --- Open / close ---
+ZTB_API ZTBChain*   ztb_open(const char *strWorkDir_a);      // NULL if not a ZTB workdir
+ZTB_API void        ztb_close(ZTBChain *objChain_a);         // commits pending blocks first
+ZTB_API const char* ztb_version(void);
+
+// --- Durability: "none" (default), "block" or "group[:count[:ms]]" ---
+ZTB_API int  ztb_set_sync(ZTBChain *objChain_a, const char *strPolicy_a);
+ZTB_API void ztb_set_durable(ZTBChain *objChain_a, ZTBDurableFn fnDurable_a);
+
+// --- Append a block. Under "group" it may stay pending until ztb_commit or its window closes ---
+// Appends to a chain are safe from several processes at once: the first append to
+// strChain takes the chain's lock file, held until ztb_commit. If another writer has
+// moved the chain's recorded tip on from strPrevID meanwhile, the block goes on the
+// tip instead (blnRebased), encoded against the ROM there, so the chain never forks.
+// Commit before appending to a second chain if other processes may write both.
+ZTB_API int ztb_append(ZTBChain *objChain_a, const ZTBAppend *objAppend_a,
+                       ZTBAppendResult *objResult_a);
+// --- Make every appended block durable, then record the chains' new tips ---
+// Returns 0 if a group commit failed, here or on the timer since the last call; blocks
+// that could not be renamed into place stay pending for the next ztb_commit.
+ZTB_API int ztb_commit(ZTBChain *objChain_a);
+
+// --- Read ---
+ZTB_API int ztb_tip(ZTBChain *objChain_a, const char *strChain_a, char *strTipID_a);
+ZTB_API int ztb_block_info(ZTBChain *objChain_a, const char *strBlockID_a, ZTBBlockInfo *objInfo_a);
+ZTB_API int ztb_fetch(ZTBChain *objChain_a, const char *strBlockID_a, ZTBPayloadFn fnPayload_a,
+                      void *objCtx_a, ZTBBlockInfo *objInfo_a);
+ZTB_API int ztb_iterate(ZTBChain *objChain_a, const char *strTipID_a, ZTBBlockFn fnBlock_a,
+                        void *objCtx_a);
+ZTB_API int ztb_verify(ZTBChain *objChain_a, const char *strTipID_a, const char *strStopID_a,
+                       ZTBVerifyResult *objResult_a);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,6 @@
 @echo off
 REM ============================================================
-REM  ZTB Test Suite v20260618
+REM  ZTB Test Suite v20261019
 REM  (c) 2026 Cyborg Unicorn Pty Ltd - MIT License
 REM
 REM  Mirrors runZTBTests() from test.cs as closely as possible.
@@ -17,6 +17,24 @@ REM    8.  AddBranch - branch block, IsBranch=true, TrunkID links
 REM    9.  AddCheckpoint - BlockType=Checkpoint, label round trip
 REM    10. Finalise
 REM    11. Truncate - checkpoint, truncate, post-truncation block, verify-walk
+REM    12. Batch append - manifest with given/generated IDs, verify-walk
+REM    13. Durability - -sync block / group appends, verify-walk
+REM    14. ROM snapshot - checkpoint writes .rom, verify -checkpoint stops there
+REM    15. Incremental verify - watermark recorded, later run stops at it
+REM    16. Fetch range - -range / -last framed output and -d directory output
+REM    17. Fetch -o - payload streamed to a file and to stdout, byte-exact
+REM    18. Grep - multi-pattern search of a chain and of the whole workdir
+REM    19. Verify -branches - trunk and branches from chains.idx, shared blocks once
+REM    20. Export / Import - full bundle with genesis, then a -since delta, verify-walk
+REM    21. Fanout layout - ztbmigrate to fanout and back, verify-walk after each
+REM    22. Block cache - verify-walk served from the cache, and with ZTB_CACHE_MB=0
+REM    23. Concurrent writers - rebase onto a moved tip, keep prev ahead of a lagging index
+REM    24. Compression - -z payload round trip, verify-walk over a compressed block
+REM    25. Archive - pack a severed segment and a dead fork, fetch from the archive alone
+REM    26. Stat - JSON report and health check of a workdir
+REM    27. Merkle checkpoint - root over the blocks below, inclusion proof checks
+REM    28. Readahead - verify-walk with ancestor readahead
+REM    29. Bench - small synthetic workload, JSON report, refuse a used workdir
 REM ============================================================
 
 setlocal enabledelayedexpansion
@@ -28,7 +46,7 @@ set TOTAL=0
 set NULL_GUID=00000000-0000-0000-0000-000000000000
 
 echo ============================================================
-echo  ZTB Test Suite v20260618
+echo  ZTB Test Suite v20261019
 echo  ^(c^) 2026 Cyborg Unicorn Pty Ltd - MIT License
 echo ============================================================
 echo.
@@ -623,6 +641,715 @@ if not errorlevel 1 (
 set /a TOTAL+=1
 echo.
 
+REM ============================================================
+REM  TEST 12: Batch append
+REM ============================================================
+echo --- TEST 12: ZTB - Batch append ---
+
+mkdir testdata\batchchain
+set BA_GEN=B1000001-0000-4000-8000-000000000000
+set BA_2=B1000001-0000-4000-8000-000000000002
+set BA_3=B1000001-0000-4000-8000-000000000003
+
+ztbcreate selfie.jpg testdata\batchchain %BA_GEN% > nul 2>&1
+> testdata\batch1.txt echo Batch payload 1
+> testdata\batch2.txt echo Batch payload 2
+> testdata\batch3.txt echo Batch payload 3
+echo testdata\batch1.txt> testdata\manifest.txt
+echo %BA_2% testdata\batch2.txt>> testdata\manifest.txt
+echo %BA_3% testdata\batch3.txt>> testdata\manifest.txt
+
+REM First block gets a generated GUID, the other two use the IDs from the manifest
+ztbaddblock testdata\batchchain BatchChain %NULL_GUID% -batch testdata\manifest.txt > testdata\batchout.txt 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock batch - 3 blocks appended in one process
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock batch - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbfetch testdata\batchchain %BA_3% > testdata\batchfetch.txt 2>&1
+findstr /c:"Batch payload 3" testdata\batchfetch.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock batch - FetchBlock round trip
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock batch fetch - mismatch
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\batchchain %BA_3% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock batch - Verify walk back to generated first block
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock batch verify - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM A block file is never replaced: reusing a block ID must fail
+ztbaddblock testdata\batchchain BatchChain %BA_2% %BA_3% -t "Reused ID" > nul 2>&1
+if errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock batch - Refuse duplicate block ID
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock batch - duplicate block ID accepted
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 13: Durability policies
+REM ============================================================
+echo --- TEST 13: ZTB - Durability (-sync) ---
+
+set SY_1=B1000001-0000-4000-8000-000000000004
+set SY_2=B1000001-0000-4000-8000-000000000005
+
+ztbaddblock testdata\batchchain BatchChain %SY_1% %BA_3% -t "Synced block" -sync block > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock -sync block - Success
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock -sync block - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM Group mode holds the block as .tmp until the commit at exit
+ztbaddblock testdata\batchchain BatchChain %SY_2% %SY_1% -t "Group block" -sync group:8:50 > nul 2>&1
+if exist testdata\batchchain\%SY_2%.ztb (
+    echo   [PASS] ZTBChain.AddBlock -sync group - committed on exit
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock -sync group - block not renamed into place
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\batchchain %SY_2% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.AddBlock -sync - Verify walk
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddBlock -sync verify - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 14: ROM snapshot at checkpoint
+REM ============================================================
+echo --- TEST 14: ZTB - ROM snapshot / verify from checkpoint ---
+
+set SN_CP=B1000001-0000-4000-8000-000000000006
+set SN_1=B1000001-0000-4000-8000-000000000007
+
+ztbcheckpoint testdata\batchchain BatchChain %SN_CP% %SY_2% "Snapshot checkpoint" > nul 2>&1
+if exist testdata\batchchain\%SN_CP%.rom (
+    echo   [PASS] ZTBChain.AddCheckpoint - ROM snapshot written
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.AddCheckpoint - no ROM snapshot
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbaddblock testdata\batchchain BatchChain %SN_1% %SN_CP% -t "After snapshot" > nul 2>&1
+ztbverify testdata\batchchain %SN_1% -checkpoint > testdata\snapverify.txt 2>&1
+findstr /c:"Trusted:  1" testdata\snapverify.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify -checkpoint - stops at trusted checkpoint
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -checkpoint - did not stop at checkpoint
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\batchchain %SN_CP% -checkpoint > testdata\snaptip.txt 2>&1
+findstr /c:"Verified: 1" testdata\snaptip.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify -checkpoint - checkpoint tip itself verified
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -checkpoint - checkpoint tip trusted unverified
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\batchchain %SN_1% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify - full walk still passes with snapshots
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify full walk with snapshots - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 15: Incremental verify (watermark)
+REM ============================================================
+echo --- TEST 15: ZTB - Verify -incremental ---
+
+ztbverify testdata\batchchain %SY_2% -incremental > nul 2>&1
+if exist testdata\batchchain\verify.wm (
+    echo   [PASS] ZTBChain.Verify -incremental - watermark recorded
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -incremental - no watermark
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\batchchain %SN_1% -incremental > testdata\wmverify.txt 2>&1
+findstr /c:"Verified: 2" testdata\wmverify.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify -incremental - only blocks above the watermark verified
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -incremental - did not stop at watermark
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 16: Fetch range
+REM ============================================================
+echo --- TEST 16: ZTB - Fetch range ---
+
+ztbfetch testdata\batchchain -range %BA_2% %SN_1% > testdata\range.txt 2> nul
+findstr /c:"ZTBFRAME %SN_1%" testdata\range.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.FetchRange - framed output includes the last block
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.FetchRange - missing frame
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+findstr /c:"Batch payload 2" testdata\range.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.FetchRange - payload of the first block decoded
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.FetchRange - first payload mismatch
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+mkdir testdata\rangeout
+ztbfetch testdata\batchchain -last 2 %SN_1% -d testdata\rangeout > nul 2>&1
+if exist testdata\rangeout\%SN_CP%.bin (
+    echo   [PASS] ZTBChain.FetchRange -last -d - payload files written
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.FetchRange -last -d - no payload files
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 17: Fetch -o (streamed payload output)
+REM ============================================================
+echo --- TEST 17: ZTB - Fetch -o ---
+
+ztbfetch testdata\batchchain %BA_2% -o testdata\fetcho.bin > nul 2>&1
+fc /b testdata\fetcho.bin testdata\batch2.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.FetchBlock -o file - payload matches the source file
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.FetchBlock -o file - payload mismatch
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbfetch testdata\batchchain %BA_3% -o - > testdata\fetchostd.bin 2> nul
+fc /b testdata\fetchostd.bin testdata\batch3.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.FetchBlock -o - - raw payload on stdout
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.FetchBlock -o - - stdout payload mismatch
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 18: Grep
+REM ============================================================
+echo --- TEST 18: ZTB - Grep ---
+
+ztbgrep testdata\batchchain %SN_1% -e "Batch payload 2" -e "no such text" > testdata\grep.txt 2> nul
+findstr /b /c:"%BA_2% 0 1" testdata\grep.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Grep - match reported with block ID and offset
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Grep - match missing
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbgrep testdata\batchchain -all -e "Batch payload" -l -m 1 > testdata\grepall.txt 2> nul
+findstr /b /c:"%BA_2%" testdata\grepall.txt > nul 2>&1
+if errorlevel 1 (
+    echo   [PASS] ZTBChain.Grep -all -m 1 - stopped after the first matching block
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Grep -all -m 1 - did not stop
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 19: Verify -branches
+REM ============================================================
+echo --- TEST 19: ZTB - Verify -branches ---
+
+ztbverify testdata\trunk20 Trunk20 -branches -j 2 > testdata\brverify.txt 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify -branches - trunk and BranchA pass
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -branches - failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM 20 trunk blocks + 2 branch blocks; the trunk below the fork is not verified twice
+findstr /b /c:"Verified: 22" testdata\brverify.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Verify -branches - shared blocks verified once
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Verify -branches - wrong block count
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 20: Export / Import
+REM ============================================================
+echo --- TEST 20: ZTB - Export / Import ---
+
+mkdir testdata\mirror
+ztbexport testdata\trunk20 %T20_B10% -genesis %T20_GEN% -o testdata\t20a.bnd > nul 2>&1
+ztbimport testdata\mirror testdata\t20a.bnd > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Import - genesis and blocks 1-10 imported
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Import - full bundle failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM Delta: only the blocks after the mirror's tip
+ztbexport testdata\trunk20 %T20_B20% -since %T20_B10% -o testdata\t20b.bnd > nul 2>&1
+ztbimport testdata\mirror testdata\t20b.bnd > testdata\import.txt 2>&1
+findstr /b /c:"Imported: 10" testdata\import.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Import -since - 10 new blocks imported
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Import -since - delta failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\mirror %T20_B20% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Import - mirror verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Import - mirror does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 21: Fanout layout
+REM ============================================================
+echo --- TEST 21: ZTB - Fanout layout ---
+
+ztbmigrate testdata\mirror -fanout > nul 2>&1
+if exist testdata\mirror\%T20_B20:~0,2%\%T20_B20:~2,2%\%T20_B20%.ztb (
+    echo   [PASS] ZTBChain.Migrate -fanout - blocks moved into shard directories
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Migrate -fanout - block not in its shard
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\mirror %T20_B20% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Migrate -fanout - chain verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Migrate -fanout - chain does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbmigrate testdata\mirror -flat > nul 2>&1
+ztbverify testdata\mirror %T20_B20% -walk > nul 2>&1
+if not errorlevel 1 (
+    if exist testdata\mirror\%T20_B20%.ztb (
+        echo   [PASS] ZTBChain.Migrate -flat - back to flat, chain verifies
+        set /a PASS+=1
+    ) else (
+        echo   [FAIL] ZTBChain.Migrate -flat - block not moved back
+        set /a FAIL+=1
+    )
+) else (
+    echo   [FAIL] ZTBChain.Migrate -flat - chain does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 22: Block cache
+REM ============================================================
+echo --- TEST 22: ZTB - Block cache ---
+
+ztbverify testdata\mirror %T20_B20% -walk > testdata\cache1.txt 2>&1
+if not errorlevel 1 (
+    findstr /r /c:"^Cache: *[1-9][0-9]* hits" testdata\cache1.txt > nul 2>&1
+    if not errorlevel 1 (
+        echo   [PASS] ZTBChain.Cache - verify-walk passes with cache hits
+        set /a PASS+=1
+    ) else (
+        echo   [FAIL] ZTBChain.Cache - no cache hits reported
+        set /a FAIL+=1
+    )
+) else (
+    echo   [FAIL] ZTBChain.Cache - chain does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+set ZTB_CACHE_MB=0
+ztbverify testdata\mirror %T20_B20% -walk > testdata\cache0.txt 2>&1
+set CACHE_RC=%errorlevel%
+set ZTB_CACHE_MB=
+if "%CACHE_RC%"=="0" (
+    findstr /c:"Cache:    0 hits" testdata\cache0.txt > nul 2>&1
+    if not errorlevel 1 (
+        echo   [PASS] ZTBChain.Cache - ZTB_CACHE_MB=0 verifies uncached
+        set /a PASS+=1
+    ) else (
+        echo   [FAIL] ZTBChain.Cache - ZTB_CACHE_MB=0 still hit the cache
+        set /a FAIL+=1
+    )
+) else (
+    echo   [FAIL] ZTBChain.Cache - chain does not verify uncached
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 23: Concurrent writers (chain lock and rebase)
+REM ============================================================
+echo --- TEST 23: ZTB - Rebase onto a moved tip ---
+
+set RB_1=D0000001-0000-4000-8000-000000000011
+set RB_2=D0000001-0000-4000-8000-000000000012
+
+REM Two writers both start from CP_POST; the second finds the tip moved to RB_1
+ztbaddblock testdata\cpchain CPChain %RB_1% %CP_POST% -t "Writer one" > nul 2>&1
+ztbaddblock testdata\cpchain CPChain %RB_2% %CP_POST% -t "Writer two" > testdata\rebase.txt 2>&1
+if not errorlevel 1 (
+    findstr /c:"Prev ID:      %RB_1%" testdata\rebase.txt > nul 2>&1
+    if not errorlevel 1 (
+        echo   [PASS] ZTBChain.Rebase - stale prev rebased onto the new tip
+        set /a PASS+=1
+    ) else (
+        echo   [FAIL] ZTBChain.Rebase - block forked the chain instead of rebasing
+        set /a FAIL+=1
+    )
+) else (
+    echo   [FAIL] ZTBChain.Rebase - second writer failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\cpchain %RB_2% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Rebase - rebased chain verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Rebase - rebased chain does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM A lagging chains.idx (LG_3 written, index put back to LG_2) must not rebase LG_4
+set LG_1=D0000001-0000-4000-8000-000000000031
+set LG_2=D0000001-0000-4000-8000-000000000032
+set LG_3=D0000001-0000-4000-8000-000000000033
+set LG_4=D0000001-0000-4000-8000-000000000034
+
+ztbaddblock testdata\cpchain LagChain %LG_1% %NULL_GUID% -t "Lag 1" > nul 2>&1
+ztbaddblock testdata\cpchain LagChain %LG_2% %LG_1% -t "Lag 2" > nul 2>&1
+copy /y testdata\cpchain\chains.idx testdata\chains.lag > nul
+ztbaddblock testdata\cpchain LagChain %LG_3% %LG_2% -t "Lag 3" > nul 2>&1
+copy /y testdata\chains.lag testdata\cpchain\chains.idx > nul
+ztbaddblock testdata\cpchain LagChain %LG_4% %LG_3% -t "Lag 4" > testdata\lag.txt 2>&1
+findstr /c:"Prev ID:      %LG_3%" testdata\lag.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Rebase - prev ahead of a lagging index is kept
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Rebase - prev ahead of a lagging index was rebased
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM A second first block on a chain that already has a tip is refused
+ztbaddblock testdata\cpchain LagChain D0000001-0000-4000-8000-000000000035 %NULL_GUID% -t "Lag again" > testdata\lagfirst.txt 2>&1
+findstr /c:"Chain 'LagChain' is not empty" testdata\lagfirst.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Rebase - first block on a non-empty chain refused
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Rebase - first block on a non-empty chain accepted
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 24: Compressed payloads (-z)
+REM ============================================================
+echo --- TEST 24: ZTB - LZ4 payload compression ---
+
+set LZ_1=D0000001-0000-4000-8000-000000000021
+
+ztbaddblock testdata\cpchain CPChain %LZ_1% %RB_2% -f ztbcommon.c -z > nul 2>&1
+ztbfetch testdata\cpchain %LZ_1% -o testdata\lz4.bin > nul 2>&1
+fc /b testdata\lz4.bin ztbcommon.c > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Compress - payload decompresses to the source file
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Compress - decompressed payload mismatch
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\cpchain %LZ_1% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBChain.Compress - chain with a compressed block verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBChain.Compress - chain with a compressed block does not verify
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 25: Cold archive of a severed segment
+REM ============================================================
+echo --- TEST 25: ZTB - Archive severed segment ---
+
+REM TEST 11's truncation left TR_1 reachable from no chain
+ztbarchive testdata\trchain %TR_1% testdata\trchain.zar > nul 2>&1
+ztbarchive -verify testdata\trchain.zar > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBArchive - severed segment packed into a verified archive
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBArchive - pack or archive verify failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbarchive -fetch testdata\trchain.zar %TR_1% -o testdata\trarc.txt > nul 2>&1
+findstr /c:"TR 1" testdata\trarc.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBArchive - block fetched from the archive alone
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBArchive - fetch from archive failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbverify testdata\trchain %TR_POST% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBArchive - live chain still verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBArchive - live chain no longer verifies
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+REM A dead fork off the live chain: its chains.idx lines dropped, so nothing reaches it
+set TR_DEAD=F0000001-0000-4000-8000-000000000005
+ztbaddblock testdata\trchain TRDead %TR_DEAD% %TR_POST% -t "Dead fork" > nul 2>&1
+findstr /v /c:" TRDead " testdata\trchain\chains.idx > testdata\trchain\idx.tmp
+move /y testdata\trchain\idx.tmp testdata\trchain\chains.idx > nul
+ztbarchive testdata\trchain -severed > testdata\trsevered.txt 2>&1
+findstr /c:"%TR_DEAD%  1 block" testdata\trsevered.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBArchive - dead fork listed down to its live fork point
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBArchive - dead fork segment runs into the live chain
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbarchive testdata\trchain %TR_DEAD% testdata\trdead.zar > nul 2>&1 && ztbverify testdata\trchain %TR_POST% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBArchive - dead fork packed, live chain still verifies
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBArchive - dead fork pack failed or broke the live chain
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 26: Chain statistics
+REM ============================================================
+echo --- TEST 26: ZTB - Stat ---
+
+ztbstat testdata\cpchain > testdata\stat.json 2> nul
+findstr /c:"\"name\": \"CPChain\"" testdata\stat.json > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBStat - JSON report lists the chain
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBStat - chain missing from the report
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+findstr /c:"\"missing_prev\": 0" testdata\stat.json > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBStat - health report clean
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBStat - health report shows missing blocks
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 27: Merkle checkpoint and inclusion proof
+REM ============================================================
+echo --- TEST 27: ZTB - Merkle Proof ---
+
+set MK_ID=D0000001-0000-4000-8000-000000000031
+ztbcheckpoint testdata\cpchain CPChain %MK_ID% %LZ_1% "Merkle label" -merkle > testdata\merkle.txt 2>&1
+findstr /c:"Merkle:       7 blocks" testdata\merkle.txt > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBCheckpoint - Merkle root over the 7 blocks below
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBCheckpoint - Merkle root missing or wrong block count
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbprove testdata\cpchain %CP_B2% %MK_ID% -o testdata\proof.txt > nul 2>&1
+ztbprove -check testdata\proof.txt testdata\cpchain > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBProve - inclusion proof checks out
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBProve - inclusion proof did not check out
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbprove -check testdata\proof.txt testdata\cpchain\%CP_B1%.ztb 0000000000000000000000000000000000000000000000000000000000000000 > nul 2>&1
+if errorlevel 1 (
+    echo   [PASS] ZTBProve - wrong block and root rejected
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBProve - wrong block and root accepted
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
+REM ============================================================
+REM  TEST 28: Walk with ancestor readahead
+REM ============================================================
+echo --- TEST 28: ZTB - Readahead ---
+
+set ZTB_READAHEAD=2
+ztbverify testdata\cpchain %MK_ID% -walk > nul 2>&1
+if not errorlevel 1 (
+    echo   [PASS] ZTBVerify - walk with readahead depth 2
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBVerify - walk with readahead depth 2 failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+set ZTB_READAHEAD=
+echo.
+
+REM ============================================================
+REM  TEST 29: Benchmark on a small synthetic workdir
+REM ============================================================
+echo --- TEST 29: ZTB - Bench ---
+
+mkdir testdata\bench
+ztbbench testdata\bench -n 50 -size pareto:64:8192 -branches 2 -checkpoint 20 -fetch 20 -rom 5 > testdata\bench.json 2>nul
+if not errorlevel 1 (
+    findstr /C:"\"rom_build\"" testdata\bench.json > nul
+    if not errorlevel 1 (
+        echo   [PASS] ZTBBench - small workload, JSON report
+        set /a PASS+=1
+    ) else (
+        echo   [FAIL] ZTBBench - report incomplete
+        set /a FAIL+=1
+    )
+) else (
+    echo   [FAIL] ZTBBench - run failed
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+
+ztbbench testdata\bench -n 5 > nul 2>&1
+if errorlevel 1 (
+    echo   [PASS] ZTBBench - refuses a workdir that has a genesis
+    set /a PASS+=1
+) else (
+    echo   [FAIL] ZTBBench - reused an existing workdir
+    set /a FAIL+=1
+)
+set /a TOTAL+=1
+echo.
+
 REM ============================================================
 REM  SUMMARY
 REM ============================================================
@@ -2,52 +2,82 @@
 # (c) 2025 Cyborg Unicorn Pty Ltd. - MIT License
 
 CC = gcc
-CFLAGS = -Wall -Wextra -O2 -std=c99
-LDFLAGS = 
+AR = ar
+CFLAGS = -Wall -Wextra -O2 -std=c99 -pthread
+LDFLAGS = -pthread
 
 # Detect OS
 ifeq ($(OS),Windows_NT)
     EXT = .exe
+    SO = .dll
     RM = del /Q
+    RMDIR = rmdir /S /Q
+    LDFLAGS += -lbcrypt
 else
     EXT =
+    SO = .so
     RM = rm -f
+    RMDIR = rm -rf
 endif
 
-# Targets
-TARGETS = ztbcreate$(EXT) ztbaddblock$(EXT) ztbaddbranch$(EXT) ztbfetch$(EXT) ztbverify$(EXT)
+# Tools
+TOOLS = ztbcreate ztbaddblock ztbaddbranch ztbcheckpoint ztbtruncate ztbarchive ztbfetch ztbgrep \
+        ztbverify ztbstat ztbprove ztbbench ztbexport ztbimport ztbmigrate ztbd
+TARGETS = $(addsuffix $(EXT),$(TOOLS))
 
-# Object files
-COMMON_OBJ = ztbcommon.o
+# libztb: the chain library the tools are built on (see libztb.h)
+LIB_SRC = ztbcommon.c libztb.c
+LIB_HDR = ztbcommon.h libztb.h
+STATIC_LIB = libztb.a
+SHARED_LIB = libztb$(SO)
 
-all: $(TARGETS)
+all: $(STATIC_LIB) $(SHARED_LIB) $(TARGETS)
 
-# Compile common functions
-ztbcommon.o: ztbcommon.c ztbcommon.h
-	$(CC) $(CFLAGS) -c ztbcommon.c -o ztbcommon.o
+# Static library
+%.o: %.c $(LIB_HDR)
+	$(CC) $(CFLAGS) -c $< -o $@
 
-# Build each tool
-ztbcreate$(EXT): ztbcreate.c $(COMMON_OBJ)
-	$(CC) $(CFLAGS) ztbcreate.c $(COMMON_OBJ) -o ztbcreate$(EXT) $(LDFLAGS)
+$(STATIC_LIB): $(LIB_SRC:.c=.o)
+	$(AR) rcs $@ $^
 
-ztbaddblock$(EXT): ztbaddblock.c $(COMMON_OBJ)
-	$(CC) $(CFLAGS) ztbaddblock.c $(COMMON_OBJ) -o ztbaddblock$(EXT) $(LDFLAGS)
+# Shared library (only the ztb_* API is exported)
+%.pic.o: %.c $(LIB_HDR)
+	$(CC) $(CFLAGS) -fPIC -fvisibility=hidden -DZTB_BUILD_DLL -c $< -o $@
 
-ztbaddbranch$(EXT): ztbaddbranch.c $(COMMON_OBJ)
-	$(CC) $(CFLAGS) ztbaddbranch.c $(COMMON_OBJ) -o ztbaddbranch$(EXT) $(LDFLAGS)
+$(SHARED_LIB): $(LIB_SRC:.c=.pic.o)
+	$(CC) -shared $^ -o $@ $(LDFLAGS)
 
-ztbfetch$(EXT): ztbfetch.c $(COMMON_OBJ)
-	$(CC) $(CFLAGS) ztbfetch.c $(COMMON_OBJ) -o ztbfetch$(EXT) $(LDFLAGS)
-
-ztbverify$(EXT): ztbverify.c $(COMMON_OBJ)
-	$(CC) $(CFLAGS) ztbverify.c $(COMMON_OBJ) -o ztbverify$(EXT) $(LDFLAGS)
+# Build each tool against the static library
+$(TARGETS): %$(EXT): %.c $(STATIC_LIB)
+	$(CC) $(CFLAGS) $< $(STATIC_LIB) -o $@ $(LDFLAGS)
 
 # Clean build artifacts
 clean:
-	$(RM) $(TARGETS) *.o
+	$(RM) $(TARGETS) $(STATIC_LIB) $(SHARED_LIB) *.o ztbpy*$(SO) *.pyd
 
 # Install (optional - adjust paths as needed)
 install: all
 	@echo "Install targets to /usr/local/bin or desired location"
 
-.PHONY: all clean install
\ No newline at end of file
+# Benchmark: a synthetic workdir in BENCH_DIR, JSON results on stdout (see ztbbench.c),
+# e.g. make -f ztb.mk bench BENCH_ARGS="-n 20000 -size pareto:128:65536 -branches 8"
+BENCH_DIR = bench.tmp
+BENCH_ARGS = -n 2000 -checkpoint 500 -branches 4
+
+bench: ztbbench$(EXT)
+	-$(RMDIR) $(BENCH_DIR)
+	mkdir $(BENCH_DIR)
+	./ztbbench$(EXT) $(BENCH_DIR) $(BENCH_ARGS)
+	$(RMDIR) $(BENCH_DIR)
+
+# Python extension module ztbpy (see ztbpy.c), built against PYTHON's headers
+PYTHON = python3
+PY_INC = $(shell $(PYTHON) -c "import sysconfig; print(sysconfig.get_paths()['include'])")
+PY_EXT = $(shell $(PYTHON) -c "import sysconfig; print(sysconfig.get_config_var('EXT_SUFFIX'))")
+
+python: ztbpy$(PY_EXT)
+
+ztbpy$(PY_EXT): ztbpy.c $(LIB_SRC:.c=.pic.o)
+	$(CC) $(CFLAGS) -fPIC -fvisibility=hidden -I$(PY_INC) -shared $^ -o $@ $(LDFLAGS)
+
+.PHONY: all clean install bench python
\ No newline at end of file
@@ -1,3 +1,6 @@
+# Standalone pure-Python ZTB. Its blocks (132-byte header) are not compatible with the C
+# tools'; for those, use the ztbpy extension module over libztb (see ztbpy.c).
+
 import argparse
 import os
 import struct
@@ -1,38 +1,253 @@
-// Cyborg ZTB Add Block v20260618
+// Cyborg ZTB Add Block v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
 // Adds a block to a chain. Matches ZTBChain.AddBlock/WriteBlock exactly.
+// The payload is streamed through write_block(), so memory use stays flat
+// however large the -f file is.
 //
-// Usage: ztbaddblock <workdir> <chain_id> <new_block_id> <prev_block_id> -t "text" | -f <file>
+// Usage: ztbaddblock <workdir> <chain_id> <new_block_id> <prev_block_id> -t "text" | -f <file> [-z] [-sync <policy>]
+//        ztbaddblock <workdir> <chain_id> <prev_block_id> -batch <manifest|-> [-z] [-sync <policy>]
+//        ztbaddblock <workdir> <chain_id> <prev_block_id> -stream [-z] [-sync <policy>]
 //
 // prev_block_id: use 00000000-0000-0000-0000-000000000000 for the first block
+// policy: none (default), block (fsync every block) or group[:count[:ms]]
+//         (blocks written within the window share one commit; see ZTBSync)
+// -z:     store payloads LZ4-compressed (see ENC_FLAG_LZ4). Encoding doubles every
+//         stored byte, so JSON and logs that compress 5-10x take a fraction of the
+//         space. Readers decompress such blocks transparently.
+//
+// Batch modes append many blocks in one process, each linked to the one before,
+// keeping the rolling ROM, prev CRC and tip in memory between blocks:
+//   -batch   manifest of payload files, one per line, optionally preceded by the
+//            block ID and a space or tab ("<block_id> <file>"); blank lines and
+//            lines starting with '#' are skipped. "-" reads the manifest from stdin.
+//   -stream  length-prefixed records on stdin: uint32 little-endian length, then
+//            that many payload bytes, repeated until EOF.
+// Blocks without an ID get a generated GUID. Each new block ID is printed on its
+// own line once it is durable under the sync policy (as soon as it is written for
+// none/block, at the group commit for group). On failure the blocks already written
+// stay on disk and form a valid chain up to the last ID printed.
+//
+// The chain's new tip is recorded in <workdir>/chains.idx (see CHAINS_INDEX_FILE).
+// Every block is written through one ZTBChain handle (see libztb.h), which keeps the
+// rolling ROM positioned on the tip from one block to the next.
+//
+// Several ztbaddblock processes may append to one chain at once. Each holds the
+// chain's lock file from picking its prev block until its tip is recorded (a whole
+// batch, for the batch modes). A writer whose prev_block_id has since been superseded
+// rebases: its block goes on the chain's recorded tip, and a warning names both.
+
+#include "ztbcommon.h"
+#include "libztb.h"
+
+#define MANIFEST_LINE_MAX   (FILENAME_MAX + GUID_LEN + 8)
+
+static int blnCompress = 0;                 // -z
+
+// --- Append one block from a source on top of strTip_a, then move strTip_a on ---
+static int append_next(ZTBChain *objChain_a, const char *strChainID_a, char *strTip_a,
+                       const char *strBlockID_a, FILE *fData_a, uint64_t intLen_a)
+{
+    ZTBAppend objAppend;
+    ZTBAppendResult objWrite;
+
+    memset(&objAppend, 0, sizeof(objAppend));
+    objAppend.intKind    = ZTB_APPEND_BLOCK;
+    objAppend.strChain   = strChainID_a;
+    objAppend.strBlockID = strBlockID_a;
+    objAppend.strPrevID  = strTip_a;
+    objAppend.fData      = fData_a;
+    objAppend.intDataLen = intLen_a;
+    objAppend.blnCompress = blnCompress;
+
+    int intResult = ztb_append(objChain_a, &objAppend, &objWrite);
+    if (intResult && objWrite.blnRebased)
+    {
+        fprintf(stderr, "Warning: Chain '%s' moved on from %s; rebased onto its tip %s\n",
+                strChainID_a, strTip_a, objWrite.strPrevID);
+    }
+    if (intResult) { snprintf(strTip_a, GUID_LEN, "%s", objWrite.strBlockID); }
+    return intResult;
+}
+
+// --- -batch: one payload file per manifest line ---
+static int append_manifest(ZTBChain *objChain_a, const char *strChainID_a, char *strTip_a,
+                           FILE *fManifest_a, int *intCount_a)
+{
+    int intResult = 1;
+    char strLine[MANIFEST_LINE_MAX];
+    int intLineNo = 0;
+
+    while (intResult && fgets(strLine, sizeof(strLine), fManifest_a))
+    {
+        intLineNo++;
+
+        size_t intLen = strlen(strLine);
+        while (intLen > 0 && (strLine[intLen - 1] == '\n' || strLine[intLen - 1] == '\r'))
+        {
+            strLine[--intLen] = '\0';
+        }
+        if (intLen == 0 || strLine[0] == '#') { continue; }
+
+        // Optional leading block ID
+        char strGiven[GUID_LEN];
+        const char *strPath = strLine;
+        int blnGiven = (intLen > 36 && (strLine[36] == ' ' || strLine[36] == '\t') &&
+                        is_valid_guid(strLine));
+        if (blnGiven)
+        {
+            memcpy(strGiven, strLine, 36);
+            strGiven[36] = '\0';
+            strPath = strLine + 37;
+            while (*strPath == ' ' || *strPath == '\t') { strPath++; }
+        }
+
+        FILE *fPayload = fopen(strPath, "rb");
+        if (!fPayload)
+        {
+            fprintf(stderr, "Error: Cannot open file: %s (manifest line %d)\n",
+                    strPath, intLineNo);
+            intResult = 0;
+        }
+        else
+        {
+            intResult = append_next(objChain_a, strChainID_a, strTip_a, blnGiven ? strGiven : NULL,
+                                    fPayload, ZTB_DATA_TO_EOF);
+            fclose(fPayload);
+        }
+
+        if (intResult) { (*intCount_a)++; }
+    }
+
+    if (intResult && ferror(fManifest_a))
+    {
+        fprintf(stderr, "Error: Cannot read manifest\n");
+        intResult = 0;
+    }
+
+    return intResult;
+}
+
+// --- -stream: uint32 LE length + payload records on stdin ---
+static int append_stream(ZTBChain *objChain_a, const char *strChainID_a, char *strTip_a,
+                         FILE *fIn_a, int *intCount_a)
+{
+    int intResult = 1;
+
+    while (intResult)
+    {
+        uint8_t arrLen[4];
+        size_t intGot = fread(arrLen, 1, sizeof(arrLen), fIn_a);
+        if (intGot == 0 && feof(fIn_a)) { break; }
+        if (intGot != sizeof(arrLen))
+        {
+            fprintf(stderr, "Error: Truncated record length after %d record(s)\n", *intCount_a);
+            intResult = 0;
+            break;
+        }
+
+        uint32_t intRecLen = (uint32_t)arrLen[0] | ((uint32_t)arrLen[1] << 8) |
+                             ((uint32_t)arrLen[2] << 16) | ((uint32_t)arrLen[3] << 24);
+
+        intResult = append_next(objChain_a, strChainID_a, strTip_a, NULL, fIn_a, intRecLen);
+        if (intResult) { (*intCount_a)++; }
+    }
 
-#include "ztbcommon.c"
+    return intResult;
+}
+
+// --- Batch modes print each block ID once it is durable ---
+static void print_block_id(const char *strBlockID_a)
+{
+    printf("%s\n", strBlockID_a);
+    fflush(stdout);
+}
 
 int main(int argc, char *argv[])
 {
     int intResult = 0;
+    const char *strSync = sync_option(&argc, argv);
+
+    if (argc > 5 && strcmp(argv[argc - 1], "-z") == 0)
+    {
+        blnCompress = 1;
+        argc--;
+    }
+
+    int blnBatch  = (argc == 6 && strcmp(argv[4], "-batch") == 0) ||
+                    (argc == 5 && strcmp(argv[4], "-stream") == 0);
 
-    printf("ZTB Add Block v20260618\n");
+    printf("ZTB Add Block v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
-    if (argc < 7 || argc > 7)
+    if (argc != 7 && !blnBatch)
     {
         fprintf(stderr, "Usage: %s <workdir> <chain_id> <new_block_id> <prev_block_id> -t \"text\"\n", argv[0]);
         fprintf(stderr, "       %s <workdir> <chain_id> <new_block_id> <prev_block_id> -f <file>\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> <chain_id> <prev_block_id> -batch <manifest|->\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> <chain_id> <prev_block_id> -stream\n", argv[0]);
+        fprintf(stderr, "       (any form may end with -z, then -sync none|block|group[:count[:ms]])\n");
         fprintf(stderr, "\n  prev_block_id: %s for first block\n", NULL_GUID);
+        fprintf(stderr, "  -batch:  one payload file per line, optionally \"<block_id> <file>\"\n");
+        fprintf(stderr, "  -stream: stdin records of uint32 LE length + payload\n");
+        fprintf(stderr, "  -z:      store payloads LZ4-compressed\n");
         intResult = 1;
     }
 
-    uint8_t *byPayload    = NULL;
-    uint8_t *byPadded     = NULL;
-    uint8_t *byRollingRom = NULL;
-    uint8_t *byEncRaw     = NULL;
-    uint8_t *byEncZoscii  = NULL;
-    uint8_t *byFinal      = NULL;
-
+    // --- 0. Open the workdir and set the sync policy ---
+    ZTBChain *objChain = NULL;
     if (intResult == 0)
+    {
+        objChain = ztb_open(argv[1]);
+        if (!objChain || (strSync && !ztb_set_sync(objChain, strSync))) { intResult = 1; }
+    }
+
+    FILE *fPayload = NULL;
+
+    if (intResult == 0 && blnBatch)
+    {
+        const char *strChainID_a     = argv[2];
+        const char *strPrevBlockID_a = argv[3];
+        const char *strMode_a        = argv[4];
+        char strTip[GUID_LEN];
+        int intCount = 0;
+
+        snprintf(strTip, GUID_LEN, "%s", strPrevBlockID_a);
+
+        // --- 1. Open input ---
+        FILE *fIn = stdin;
+        if (strcmp(strMode_a, "-batch") == 0 && strcmp(argv[5], "-") != 0)
+        {
+            fIn = fopen(argv[5], "rb");
+            if (!fIn) { fprintf(stderr, "Error: Cannot open manifest: %s\n", argv[5]); intResult = 1; }
+        }
+#ifdef _WIN32
+        if (fIn == stdin) { _setmode(_fileno(stdin), _O_BINARY); }
+#endif
+
+        // --- 2. Append every payload in order, then commit whatever the group still holds ---
+        // The handle's rolling ROM follows the tip, so it is only built for the first block.
+        if (intResult == 0)
+        {
+            ztb_set_durable(objChain, print_block_id);
+
+            int blnOK = (strcmp(strMode_a, "-stream") == 0)
+                      ? append_stream(objChain, strChainID_a, strTip, fIn, &intCount)
+                      : append_manifest(objChain, strChainID_a, strTip, fIn, &intCount);
+
+            // --- 3. Record the new tip (blocks before a failure are still on the chain) ---
+            if (!ztb_commit(objChain)) { blnOK = 0; }
+            if (!blnOK) { intResult = 1; }
+
+            printf("\n%s %d block(s) appended\n", intResult == 0 ? "+" : "-", intCount);
+            printf("  Chain:        %s\n", strChainID_a);
+            printf("  Tip:          %s\n", strTip);
+        }
+
+        if (fIn && fIn != stdin) { fclose(fIn); }
+    }
+    else if (intResult == 0)
     {
         const char *strWorkDir_a    = argv[1];
         const char *strChainID_a    = argv[2];
@@ -41,40 +256,26 @@ int main(int argc, char *argv[])
         const char *strFlag_a       = argv[5];
         const char *strData_a       = argv[6];
 
-        // --- 1. Load payload ---
-        int intPayloadLen = 0;
+        // --- 1. Payload: the text, or the file streamed through ---
+        ZTBAppend objAppend;
+        memset(&objAppend, 0, sizeof(objAppend));
+        objAppend.intKind    = ZTB_APPEND_BLOCK;
+        objAppend.strChain   = strChainID_a;
+        objAppend.strBlockID = strNewBlockID_a;
+        objAppend.strPrevID  = strPrevBlockID_a;
+        objAppend.blnCompress = blnCompress;
 
         if (strcmp(strFlag_a, "-t") == 0)
         {
-            intPayloadLen = (int)strlen(strData_a);
-            byPayload     = (uint8_t*)malloc(intPayloadLen > 0 ? intPayloadLen : 1);
-            if (!byPayload) { fprintf(stderr, "Error: Cannot allocate payload\n"); intResult = 1; }
-            if (intResult == 0 && intPayloadLen > 0)
-            {
-                memcpy(byPayload, strData_a, intPayloadLen);
-            }
+            objAppend.byData     = (const uint8_t*)strData_a;
+            objAppend.intDataLen = strlen(strData_a);
         }
         else if (strcmp(strFlag_a, "-f") == 0)
         {
-            FILE *f = fopen(strData_a, "rb");
-            if (!f) { fprintf(stderr, "Error: Cannot open file: %s\n", strData_a); intResult = 1; }
-            else
-            {
-                fseek(f, 0, SEEK_END);
-                intPayloadLen = (int)ftell(f);
-                fseek(f, 0, SEEK_SET);
-                byPayload = (uint8_t*)malloc(intPayloadLen > 0 ? intPayloadLen : 1);
-                if (!byPayload) { fprintf(stderr, "Error: Cannot allocate payload\n"); intResult = 1; }
-                if (intResult == 0 && intPayloadLen > 0)
-                {
-                    if (fread(byPayload, 1, intPayloadLen, f) != (size_t)intPayloadLen)
-                    {
-                        fprintf(stderr, "Error: Cannot read file: %s\n", strData_a);
-                        intResult = 1;
-                    }
-                }
-                fclose(f);
-            }
+            fPayload = fopen(strData_a, "rb");
+            if (!fPayload) { fprintf(stderr, "Error: Cannot open file: %s\n", strData_a); intResult = 1; }
+            objAppend.fData      = fPayload;
+            objAppend.intDataLen = ZTB_DATA_TO_EOF;
         }
         else
         {
@@ -82,194 +283,38 @@ int main(int argc, char *argv[])
             intResult = 1;
         }
 
-        // --- 2. Pad payload so the COMPLETE on-disk block reaches at least ROM_ENTRY_SIZE
-        //        (1024) bytes. The rolling ROM unconditionally copies ROM_ENTRY_SIZE bytes
-        //        from each historical block's full on-disk file -- if any block were smaller
-        //        than that, the sample would run past the end of the block. Total on-disk
-        //        size = raw header (never encoded) + 2x(encoded-section header + payload),
-        //        since ZOSCII encoding doubles every byte it touches. (matches C# exactly)
-        if (intResult == 0)
+        // --- 2. Build header, pad, hash, ZOSCII encode and write, then commit and record the tip ---
+        ZTBAppendResult objWrite;
+        if (intResult == 0 &&
+            (!ztb_append(objChain, &objAppend, &objWrite) || !ztb_commit(objChain)))
         {
-            int intPaddedLen = intPayloadLen;
-            int intTotalSize = HEADER_RAW_SIZE + 2 * (ENC_HEADER_SIZE + intPaddedLen);
+            intResult = 1;
+        }
 
-            if (intTotalSize <= ROM_ENTRY_SIZE)
+        if (intResult == 0)
+        {
+            printf("+ Block created: %s/%s.ztb\n",
+                   strWorkDir_a, strNewBlockID_a);
+            printf("  Chain:        %s\n", strChainID_a);
+            printf("  Block ID:     %s\n", strNewBlockID_a);
+            printf("  Prev ID:      %s\n", objWrite.strPrevID);
+            if (objWrite.blnRebased)
             {
-                intPaddedLen = (ROM_ENTRY_SIZE - HEADER_RAW_SIZE) / 2 - ENC_HEADER_SIZE + 1;
-                if (intPaddedLen < intPayloadLen) { intPaddedLen = intPayloadLen; }
+                printf("  Rebased from: %s (chain moved on)\n", strPrevBlockID_a);
             }
-
-            byPadded         = (uint8_t*)malloc(intPaddedLen);
-            if (!byPadded) { fprintf(stderr, "Error: Cannot allocate padded buffer\n"); intResult = 1; }
-
-            if (intResult == 0)
+            printf("  Hash:         0x%08X\n", objWrite.intHash);
+            printf("  PrevHash:     0x%08X\n", objWrite.intPrevHash);
+            printf("  PayloadLen:   %llu\n", (unsigned long long)objWrite.intPayloadLen);
+            if (blnCompress)
             {
-                memset(byPadded, 0, intPaddedLen);
-                if (intPayloadLen > 0) { memcpy(byPadded, byPayload, intPayloadLen); }
-
-                // Fill padding with XorShift32 (matches C# WriteBlock padding)
-                if (intPaddedLen > intPayloadLen)
-                {
-                    uint32_t intSeed = (uint32_t)(time(NULL) & 0xFFFFFFFF);
-                    intSeed          = xorshift32(intSeed);
-                    int intI         = intPayloadLen;
-                    while (intI < intPaddedLen)
-                    {
-                        intSeed      = xorshift32(intSeed);
-                        byPadded[intI] = (uint8_t)(intSeed & 0xFF);
-                        intI++;
-                    }
-                }
-
-                // --- 3. Build raw header (matches WriteRawHeader) ---
-                uint8_t arrRawHeader[HEADER_RAW_SIZE];
-                memset(arrRawHeader, 0, HEADER_RAW_SIZE);
-                arrRawHeader[RAW_OFF_BLOCK_TYPE] = BLOCK_TYPE_NORMAL;
-                arrRawHeader[RAW_OFF_BLOCK_VER]  = BLOCK_VERSION;
-                arrRawHeader[RAW_OFF_IS_BRANCH]  = 0;
-                write_fixed_string(arrRawHeader, RAW_OFF_TRUNK_ID, 36, NULL_GUID);
-                write_fixed_string(arrRawHeader, RAW_OFF_BLOCK_ID, 36, strNewBlockID_a);
-                write_fixed_string(arrRawHeader, RAW_OFF_PREV_ID,  36,
-                                   strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
-
-                // --- 4. Build rolling ROM ---
-                byRollingRom = build_rolling_rom(strWorkDir_a, strPrevBlockID_a);
-                if (!byRollingRom)
-                {
-                    fprintf(stderr, "Error: Cannot build rolling ROM\n");
-                    intResult = 1;
-                }
-
-                if (intResult == 0)
-                {
-                    // --- 5. Compute prev_hash ---
-                    uint32_t intPrevHash = 0;
-                    if (strPrevBlockID_a != NULL && strcmp(strPrevBlockID_a, NULL_GUID) != 0)
-                    {
-                        int intPrevLen = 0;
-                        uint8_t *byPrev = load_block(strWorkDir_a, strPrevBlockID_a, &intPrevLen);
-                        if (byPrev)
-                        {
-                            intPrevHash = hash_bytes(HASH_TYPE_CRC32_FULL, byPrev, 0, intPrevLen);
-                            free(byPrev);
-                        }
-                    }
-
-                    // --- 6. Build encoded section with the real hash and prev hash ---
-                    int intEncRawLen = ENC_HEADER_SIZE + intPaddedLen;
-                    byEncRaw         = (uint8_t*)malloc(intEncRawLen);
-                    if (!byEncRaw) { fprintf(stderr, "Error: Cannot allocate enc raw\n"); intResult = 1; }
-
-                    if (intResult == 0)
-                    {
-                        // Current block hash covers the payload ONLY (not header/metadata).
-                        // This keeps the payload hashable independently of the header, which
-                        // matters once payload hashing is streamed -- the header is always
-                        // small and fully in-memory, so it must never be folded into a hash
-                        // that the payload portion needs to compute incrementally.
-                        uint32_t intHash = hash_bytes(HASH_TYPE_CRC32_FULL, byPadded, 0, intPaddedLen);
-
-                        byEncRaw[ENC_OFF_HASH_TYPE] = HASH_TYPE_CRC32_FULL;
-                        byEncRaw[ENC_OFF_HASH]     = (uint8_t)(intHash & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 1] = (uint8_t)((intHash >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 2] = (uint8_t)((intHash >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 3] = (uint8_t)((intHash >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH]     = (uint8_t)(intPrevHash & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 1] = (uint8_t)((intPrevHash >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 2] = (uint8_t)((intPrevHash >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 3] = (uint8_t)((intPrevHash >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN]     = (uint8_t)(intPayloadLen & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 1] = (uint8_t)((intPayloadLen >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 2] = (uint8_t)((intPayloadLen >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 3] = (uint8_t)((intPayloadLen >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN]     = (uint8_t)(intPaddedLen & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 1] = (uint8_t)((intPaddedLen >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 2] = (uint8_t)((intPaddedLen >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 3] = (uint8_t)((intPaddedLen >> 24) & 0xFF);
-                        memcpy(byEncRaw + ENC_OFF_PAYLOAD, byPadded, intPaddedLen);
-
-                        // ZOSCII encode the encoded section
-                        int intEncZosciiLen = 0;
-                        byEncZoscii = zoscii_encode(byRollingRom, byEncRaw,
-                                                    intEncRawLen, &intEncZosciiLen);
-                        if (!byEncZoscii)
-                        {
-                            fprintf(stderr, "Error: ZOSCII encoding failed\n");
-                            intResult = 1;
-                        }
-
-                        if (intResult == 0)
-                        {
-                            // Assemble final output: raw header + ZOSCII encoded section
-                            int intFinalLen = HEADER_RAW_SIZE + intEncZosciiLen;
-                            byFinal         = (uint8_t*)malloc(intFinalLen);
-                            if (!byFinal) { fprintf(stderr, "Error: Cannot allocate output\n"); intResult = 1; }
-
-                            if (intResult == 0)
-                            {
-                                memcpy(byFinal, arrRawHeader, HEADER_RAW_SIZE);
-                                memcpy(byFinal + HEADER_RAW_SIZE, byEncZoscii, intEncZosciiLen);
-
-                                // Write via tmp then rename
-                                char strOutPath[FILENAME_MAX];
-                                char strTmpPath[FILENAME_MAX + 4];
-                                snprintf(strOutPath, FILENAME_MAX, "%s/%s.ztb",
-                                         strWorkDir_a, strNewBlockID_a);
-                                snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutPath);
-
-                                FILE *fOut = fopen(strTmpPath, "wb");
-                                if (!fOut)
-                                {
-                                    fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
-                                    intResult = 1;
-                                }
-                                else
-                                {
-                                    if (fwrite(byFinal, 1, intFinalLen, fOut) != (size_t)intFinalLen)
-                                    {
-                                        fprintf(stderr, "Error: Write failed\n");
-                                        intResult = 1;
-                                    }
-                                    fclose(fOut);
-
-                                    if (intResult == 0)
-                                    {
-                                        remove(strOutPath);
-                                        if (rename(strTmpPath, strOutPath) != 0)
-                                        {
-                                            fprintf(stderr, "Error: Cannot rename tmp\n");
-                                            intResult = 1;
-                                        }
-                                    }
-                                }
-
-                                if (intResult == 0)
-                                {
-                                    printf("+ Block created: %s/%s.ztb\n",
-                                           strWorkDir_a, strNewBlockID_a);
-                                    printf("  Chain:        %s\n", strChainID_a);
-                                    printf("  Block ID:     %s\n", strNewBlockID_a);
-                                    printf("  Prev ID:      %s\n",
-                                           strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
-                                    printf("  Hash:         0x%08X\n", intHash);
-                                    printf("  PrevHash:     0x%08X\n", intPrevHash);
-                                    printf("  PayloadLen:   %d\n", intPayloadLen);
-                                    printf("  PaddedLen:    %d\n", intPaddedLen);
-                                }
-                            }
-                        }
-                    }
-                }
+                printf("  DataLen:      %llu (lz4)\n", (unsigned long long)objWrite.intDataLen);
             }
+            printf("  PaddedLen:    %llu\n", (unsigned long long)objWrite.intPaddedLen);
         }
     }
 
-    if (byPayload)    { free(byPayload); }
-    if (byPadded)     { free(byPadded); }
-    if (byRollingRom) { free(byRollingRom); }
-    if (byEncRaw)     { free(byEncRaw); }
-    if (byEncZoscii)  { free(byEncZoscii); }
-    if (byFinal)      { free(byFinal); }
+    if (fPayload) { fclose(fPayload); }
+    ztb_close(objChain);
 
     return intResult;
 }
\ No newline at end of file
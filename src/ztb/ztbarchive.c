@@ -0,0 +1,1116 @@
+// Cyborg ZTB Archive v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Packs a chain segment left behind by ztbtruncate into one archive file and takes
+// its loose block files out of the workdir, so the workdir keeps only live chains.
+//
+// Usage: ztbarchive <workdir> -severed
+//        ztbarchive <workdir> <top_block_id> <archive> [-keep]
+//        ztbarchive -list <archive>
+//        ztbarchive -verify <archive>
+//        ztbarchive -fetch <archive> <block_id> [-o <file>]
+//        ztbarchive -extract <archive> <workdir>
+//
+// -severed lists the tops of the segments no chain reaches any more: blocks that are
+// neither on the walk back from a tip in chains.idx nor the prev of another block.
+// A segment is the top and everything below it, down to the start of the chain, down
+// to (and including) the truncation block it began from, or down to the first block
+// still on a live chain or built on by another block too (a dead fork: that block
+// stays, and the archive's base ROM is the ROM as of it). A block two dead forks
+// share joins the segment of whichever is left once the other is packed.
+//
+// Packing takes the same segment, and refuses it if any of its blocks is still on a
+// live chain or is the prev of a block outside it. The archive is written via
+// <archive>.tmp (fsynced, then renamed), read back and verified on its own, and only
+// then are the block files and their ROM snapshots and .mrk leaves removed (-keep
+// leaves them).
+//
+// -fetch writes the payload to stdout (report on stderr), or to <file> via <file>.tmp,
+// renamed only if the block checks out. -extract puts the block files back into a
+// workdir, leaving any that are already there.
+//
+// Archive layout (little-endian):
+//   Header:  ARCHIVE_MAGIC, uint32 block count, base prev ID (36), uint32 base slices,
+//            uint32 base prev CRC, uint64 base ROM stream length, then the base ROM as
+//            an LZ4 stream -- or nothing (length 0) when the segment starts from a
+//            truncation block, whose payload is that ROM already
+//   Blocks:  each block file, oldest first, as an LZ4 stream (see lz4_stream_write)
+//   Index:   per block its ID (36), uint32 block type, uint64 stream offset,
+//            uint64 stream length, uint64 file length, uint32 file CRC32; then a
+//            uint32 CRC32 of the index
+//   Trailer: uint64 index offset, uint32 block count, ARCHIVE_MAGIC
+// The base ROM is the rolling ROM the oldest encoded block was written with, so every
+// block decodes and checks out from the archive alone. A block's ROM is rebuilt from
+// the base, or once it is MAX_HISTORY_BLOCKS in from the first 1 KB of the blocks
+// before it alone, so -fetch decompresses at most MAX_HISTORY_BLOCKS + 1 streams
+// however large the archive is.
+//
+// ZOSCII-encoded bodies are random ROM addresses and do not shrink: their frames are
+// stored as they are. Payloads written with ztbaddblock -z keep their saving, and the
+// truncation block's ROM and the headers are what the archive compresses itself.
+
+#include "ztbcommon.h"
+
+#define ARCHIVE_MAGIC           "ZTBARC01"
+#define ARCHIVE_MAGIC_LEN       8
+#define ARCHIVE_OFF_COUNT       8
+#define ARCHIVE_OFF_BASE_PREV   12
+#define ARCHIVE_OFF_SLICES      48
+#define ARCHIVE_OFF_PREV_CRC    52
+#define ARCHIVE_OFF_BASE_LEN    56
+#define ARCHIVE_PREFIX_SIZE     64          // the base ROM stream follows
+#define ARCHIVE_ENTRY_SIZE      68
+#define ARCHIVE_ENT_OFF_TYPE    36
+#define ARCHIVE_ENT_OFF_OFFSET  40
+#define ARCHIVE_ENT_OFF_STORED  48
+#define ARCHIVE_ENT_OFF_LEN     56
+#define ARCHIVE_ENT_OFF_CRC     64
+#define ARCHIVE_TRAILER_SIZE    20
+#define ARCHIVE_MAX_BLOCKS      (1 << 24)
+
+typedef struct
+{
+    char     strID[GUID_LEN];
+    int      intBlockType;
+    uint64_t intOffset;                     // of its LZ4 stream
+    uint64_t intStored;                     // stream length
+    uint64_t intFileLen;
+    uint32_t intFileCrc;
+} ZTBArchiveEntry;
+
+typedef struct
+{
+    FILE            *f;
+    int              intCount;
+    int              intFirst;              // first encoded entry (1 after a truncation block)
+    char             strBasePrev[GUID_LEN];
+    int              intBaseSlices;
+    uint32_t         intBasePrevCrc;
+    uint8_t         *arrBaseRom;
+    ZTBArchiveEntry *arrEntries;            // oldest first
+} ZTBArchive;
+
+static const char *arrTypeNames[] = { "genesis", "normal", "checkpoint", "truncation", "finalise", "bridge" };
+
+static void put_le(uint8_t *byOut_a, uint64_t intValue_a, int intBytes_a)
+{
+    int intI;
+    for (intI = 0; intI < intBytes_a; intI++) { byOut_a[intI] = (uint8_t)(intValue_a >> (8 * intI)); }
+}
+
+static uint64_t get_le(const uint8_t *byIn_a, int intBytes_a)
+{
+    uint64_t intValue = 0;
+    int intI;
+    for (intI = intBytes_a - 1; intI >= 0; intI--) { intValue = (intValue << 8) | byIn_a[intI]; }
+    return intValue;
+}
+
+// --- Every block on the walk back from a recorded tip (down to a truncation block) ---
+static int live_blocks(const char *strWorkDir_a, ZTBIdSet *objLive_a)
+{
+    int intResult = 1;
+    ZTBChainIndex objIndex;
+    int intI;
+
+    if (!idset_init(objLive_a, 1024)) { return 0; }
+    if (!chains_index_load(strWorkDir_a, &objIndex)) { return 1; }
+
+    for (intI = 0; intI < objIndex.intCount && intResult; intI++)
+    {
+        char strCurrentID[GUID_LEN];
+        snprintf(strCurrentID, GUID_LEN, "%s", objIndex.arrChains[intI].strTip);
+
+        while (intResult && strCurrentID[0] && strcmp(strCurrentID, NULL_GUID) != 0 &&
+               !idset_has(objLive_a, strCurrentID))
+        {
+            ZTBBlockHeader objHeader;
+            if (!block_header(strWorkDir_a, strCurrentID, &objHeader)) { break; }
+
+            intResult = (idset_add(objLive_a, strCurrentID) >= 0);
+            if (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION) { break; }
+            snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
+        }
+    }
+
+    chains_index_free(&objIndex);
+    return intResult;
+}
+
+// --- Every block in the workdir with its header, and how the chains reach them ---
+typedef struct
+{
+    char          (*arrIDs)[GUID_LEN];      // from list_blocks
+    ZTBBlockHeader *arrHeaders;
+    int             intCount;
+    ZTBIdSet        objLive;                // on the walk back from a recorded tip
+    ZTBIdSet        objPrevs;               // the prev of some block
+    ZTBIdSet        objShared;              // the prev of more than one block
+} ZTBWorkdirView;
+
+static void view_free(ZTBWorkdirView *objView_a)
+{
+    idset_free(&objView_a->objLive);
+    idset_free(&objView_a->objPrevs);
+    idset_free(&objView_a->objShared);
+    if (objView_a->arrHeaders) { free(objView_a->arrHeaders); }
+    if (objView_a->arrIDs)     { free(objView_a->arrIDs); }
+    memset(objView_a, 0, sizeof(ZTBWorkdirView));
+}
+
+// --- Load the view; 1 on success ---
+static int view_load(const char *strWorkDir_a, ZTBWorkdirView *objView_a)
+{
+    int intResult = 1;
+    int intI;
+
+    memset(objView_a, 0, sizeof(ZTBWorkdirView));
+    objView_a->intCount = list_blocks(strWorkDir_a, &objView_a->arrIDs);
+    if (objView_a->intCount < 0)
+    {
+        fprintf(stderr, "Error: Cannot read workdir %s\n", strWorkDir_a);
+        objView_a->intCount = 0;
+        intResult = 0;
+    }
+    else
+    {
+        objView_a->arrHeaders = (ZTBBlockHeader*)calloc((size_t)objView_a->intCount + 1, sizeof(ZTBBlockHeader));
+        intResult = (objView_a->arrHeaders != NULL && live_blocks(strWorkDir_a, &objView_a->objLive) &&
+                     idset_init(&objView_a->objPrevs, objView_a->intCount) &&
+                     idset_init(&objView_a->objShared, 16));
+    }
+
+    for (intI = 0; intI < objView_a->intCount && intResult; intI++)
+    {
+        ZTBBlockHeader *objHeader = &objView_a->arrHeaders[intI];
+        if (!block_header(strWorkDir_a, objView_a->arrIDs[intI], objHeader))
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", objView_a->arrIDs[intI]);
+            intResult = 0;
+        }
+        else
+        {
+            int intAdded = idset_add(&objView_a->objPrevs, objHeader->strPrevID);
+            if (intAdded == 0) { intAdded = idset_add(&objView_a->objShared, objHeader->strPrevID); }
+            if (intAdded < 0)  { intResult = 0; }
+        }
+    }
+
+    if (!intResult) { view_free(objView_a); }
+    return intResult;
+}
+
+// --- The segment below strTopID_a, newest first ---
+// Walks down to the start of the chain, to the truncation block it began from
+// (included), or to the first block that is still on a live chain or that another
+// block also builds on (excluded). A dead fork thus stops at its fork point, and the
+// archive carries the ROM as of that block; a block two dead forks share stays until
+// only one of them is left.
+static int segment_ids(const char *strWorkDir_a, const ZTBWorkdirView *objView_a, const char *strTopID_a,
+                       char (**arrIDs_a)[GUID_LEN])
+{
+    int intCount = 0;
+    int intCap   = 0;
+    int blnEnd   = 0;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    char strCurrentID[GUID_LEN];
+    snprintf(strCurrentID, GUID_LEN, "%s", strTopID_a);
+
+    while (!blnEnd && intCount >= 0 && strcmp(strCurrentID, NULL_GUID) != 0 &&
+           !idset_has(&objView_a->objLive, strCurrentID) &&
+           (intCount == 0 || !idset_has(&objView_a->objShared, strCurrentID)))
+    {
+        ZTBBlockHeader objHeader;
+        if (!block_header(strWorkDir_a, strCurrentID, &objHeader))
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", strCurrentID);
+            intCount = -1;
+        }
+        else
+        {
+            if (intCount == intCap)
+            {
+                intCap = intCap ? intCap * 2 : 256;
+                char (*arrNew)[GUID_LEN] = (char (*)[GUID_LEN])realloc(arrIDs, (size_t)intCap * GUID_LEN);
+                if (arrNew) { arrIDs = arrNew; }
+                else
+                {
+                    fprintf(stderr, "Error: Cannot allocate block list\n");
+                    intCount = -1;
+                }
+            }
+            if (intCount >= 0)
+            {
+                snprintf(arrIDs[intCount++], GUID_LEN, "%s", strCurrentID);
+                blnEnd = (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION);
+                snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
+            }
+        }
+    }
+
+    if (intCount < 0 && arrIDs) { free(arrIDs); arrIDs = NULL; }
+    *arrIDs_a = arrIDs;
+    return intCount;
+}
+
+// --- List the tops of the severed segments ---
+static int list_severed(const char *strWorkDir_a)
+{
+    int intResult = 0;
+    ZTBWorkdirView objView;
+    int intSegments = 0;
+    int intI;
+
+    if (!view_load(strWorkDir_a, &objView)) { intResult = 1; }
+
+    for (intI = 0; intI < objView.intCount && intResult == 0; intI++)
+    {
+        if (!idset_has(&objView.objLive, objView.arrIDs[intI]) && !idset_has(&objView.objPrevs, objView.arrIDs[intI]))
+        {
+            char (*arrSegment)[GUID_LEN] = NULL;
+            int intBlocks = segment_ids(strWorkDir_a, &objView, objView.arrIDs[intI], &arrSegment);
+            if (intBlocks < 0) { intResult = 1; }
+            else
+            {
+                printf("%s  %d block%s\n", objView.arrIDs[intI], intBlocks, intBlocks == 1 ? "" : "s");
+                intSegments++;
+            }
+            if (arrSegment) { free(arrSegment); }
+        }
+    }
+
+    if (intResult == 0) { printf("Severed segments: %d\n", intSegments); }
+
+    view_free(&objView);
+    return intResult;
+}
+
+// --- Refuse a segment that a live chain or another block still reaches ---
+static int check_severed(const ZTBWorkdirView *objView_a, char (*arrSegment_a)[GUID_LEN], int intSegment_a)
+{
+    int intResult = 1;
+    ZTBIdSet objSegment;
+    int intI;
+
+    memset(&objSegment, 0, sizeof(objSegment));
+    if (!idset_init(&objSegment, intSegment_a)) { intResult = 0; }
+
+    for (intI = 0; intI < intSegment_a && intResult; intI++)
+    {
+        if (idset_has(&objView_a->objLive, arrSegment_a[intI]))
+        {
+            fprintf(stderr, "Error: Block '%s' is still on a live chain\n", arrSegment_a[intI]);
+            intResult = 0;
+        }
+        else if (idset_add(&objSegment, arrSegment_a[intI]) < 0) { intResult = 0; }
+    }
+
+    for (intI = 0; intI < objView_a->intCount && intResult; intI++)
+    {
+        if (!idset_has(&objSegment, objView_a->arrIDs[intI]) &&
+            idset_has(&objSegment, objView_a->arrHeaders[intI].strPrevID))
+        {
+            fprintf(stderr, "Error: Block '%s' still builds on '%s'\n",
+                    objView_a->arrIDs[intI], objView_a->arrHeaders[intI].strPrevID);
+            intResult = 0;
+        }
+    }
+
+    idset_free(&objSegment);
+    return intResult;
+}
+
+// --- Write the archive for arrSegment_a (newest first) to fOut_a ---
+static int write_archive(FILE *fOut_a, const char *strWorkDir_a, char (*arrSegment_a)[GUID_LEN],
+                         int intCount_a, uint64_t *intBytes_a)
+{
+    int intResult = 1;
+    ZTBArchiveEntry *arrEntries = (ZTBArchiveEntry*)calloc((size_t)intCount_a + 1, sizeof(ZTBArchiveEntry));
+    uint8_t *arrIndex = (uint8_t*)calloc((size_t)intCount_a * ARCHIVE_ENTRY_SIZE + 4, 1);
+    uint8_t arrPrefix[ARCHIVE_PREFIX_SIZE];
+    uint8_t arrTrailer[ARCHIVE_TRAILER_SIZE];
+    ZTBRollingRom *objRom = NULL;
+    ZTBBlockHeader objHeader;
+    int intFirst = 0;
+    int intI;
+
+    *intBytes_a = 0;
+    if (!arrEntries || !arrIndex)
+    {
+        fprintf(stderr, "Error: Cannot allocate archive index\n");
+        intResult = 0;
+    }
+
+    // --- 1. Entries oldest first ---
+    for (intI = 0; intI < intCount_a && intResult; intI++)
+    {
+        snprintf(arrEntries[intI].strID, GUID_LEN, "%s", arrSegment_a[intCount_a - 1 - intI]);
+        if (!block_header(strWorkDir_a, arrEntries[intI].strID, &objHeader))
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", arrEntries[intI].strID);
+            intResult = 0;
+        }
+        else
+        {
+            arrEntries[intI].intBlockType = objHeader.intBlockType;
+            if (intI == 0 && objHeader.intBlockType == BLOCK_TYPE_TRUNCATION) { intFirst = 1; }
+        }
+    }
+
+    // --- 2. Header with the ROM the oldest encoded block was written with ---
+    if (intResult)
+    {
+        const char *strBasePrev = NULL_GUID;
+        if (intFirst < intCount_a)
+        {
+            block_header(strWorkDir_a, arrEntries[intFirst].strID, &objHeader);
+            strBasePrev = objHeader.strPrevID;
+        }
+        objRom = rolling_rom_open(strWorkDir_a, strBasePrev);
+        if (!objRom)
+        {
+            fprintf(stderr, "Error: Cannot build rolling ROM for '%s'\n", strBasePrev);
+            intResult = 0;
+        }
+    }
+
+    if (intResult)
+    {
+        memset(arrPrefix, 0, sizeof(arrPrefix));
+        memcpy(arrPrefix, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN);
+        put_le(arrPrefix + ARCHIVE_OFF_COUNT, (uint32_t)intCount_a, 4);
+        write_fixed_string(arrPrefix, ARCHIVE_OFF_BASE_PREV, 36, objRom->strPrevID);
+        put_le(arrPrefix + ARCHIVE_OFF_SLICES, (uint32_t)objRom->intSlices, 4);
+        put_le(arrPrefix + ARCHIVE_OFF_PREV_CRC, objRom->intPrevCrc, 4);
+        intResult = (fwrite(arrPrefix, 1, sizeof(arrPrefix), fOut_a) == sizeof(arrPrefix));
+    }
+
+    if (intResult && !intFirst)
+    {
+        uint64_t intBaseLen = 0;
+        uint64_t intRomLen  = 0;
+        uint32_t intRomCrc  = 0;
+        ZTBSource objSrc;
+
+        source_from_memory(&objSrc, objRom->arrRom, ROM_SIZE);
+        put_le(arrPrefix, 0, 8);
+        intResult = (lz4_stream_write(fOut_a, &objSrc, &intBaseLen, &intRomLen, &intRomCrc) &&
+                     ZTB_FSEEK(fOut_a, ARCHIVE_OFF_BASE_LEN, SEEK_SET) == 0);
+        if (intResult)
+        {
+            put_le(arrPrefix, intBaseLen, 8);
+            intResult = (fwrite(arrPrefix, 1, 8, fOut_a) == 8 && ZTB_FSEEK(fOut_a, 0, SEEK_END) == 0);
+        }
+    }
+
+    // --- 3. Each block file as an LZ4 stream ---
+    for (intI = 0; intI < intCount_a && intResult; intI++)
+    {
+        ZTBArchiveEntry *objEntry = &arrEntries[intI];
+        char strPath[FILENAME_MAX];
+        ZTBSource objSrc;
+        FILE *fBlock;
+
+        block_file_path(strWorkDir_a, objEntry->strID, ".ztb", strPath);
+        fBlock = fopen(strPath, "rb");
+        if (!fBlock)
+        {
+            fprintf(stderr, "Error: Cannot open: %s\n", strPath);
+            intResult = 0;
+        }
+        else
+        {
+            source_from_file(&objSrc, fBlock);
+            objEntry->intOffset = (uint64_t)ZTB_FTELL(fOut_a);
+            intResult = lz4_stream_write(fOut_a, &objSrc, &objEntry->intStored,
+                                         &objEntry->intFileLen, &objEntry->intFileCrc);
+            *intBytes_a += objEntry->intFileLen;
+            fclose(fBlock);
+        }
+    }
+
+    // --- 4. Index, then the trailer pointing at it ---
+    if (intResult)
+    {
+        uint64_t intIndexOffset = (uint64_t)ZTB_FTELL(fOut_a);
+        size_t intIndexLen = (size_t)intCount_a * ARCHIVE_ENTRY_SIZE;
+
+        for (intI = 0; intI < intCount_a; intI++)
+        {
+            uint8_t *byEntry = arrIndex + (size_t)intI * ARCHIVE_ENTRY_SIZE;
+            write_fixed_string(byEntry, 0, 36, arrEntries[intI].strID);
+            put_le(byEntry + ARCHIVE_ENT_OFF_TYPE,   (uint32_t)arrEntries[intI].intBlockType, 4);
+            put_le(byEntry + ARCHIVE_ENT_OFF_OFFSET, arrEntries[intI].intOffset, 8);
+            put_le(byEntry + ARCHIVE_ENT_OFF_STORED, arrEntries[intI].intStored, 8);
+            put_le(byEntry + ARCHIVE_ENT_OFF_LEN,    arrEntries[intI].intFileLen, 8);
+            put_le(byEntry + ARCHIVE_ENT_OFF_CRC,    arrEntries[intI].intFileCrc, 4);
+        }
+        put_le(arrIndex + intIndexLen, crc32_update(CRC32_INIT, arrIndex, intIndexLen) ^ CRC32_INIT, 4);
+
+        put_le(arrTrailer, intIndexOffset, 8);
+        put_le(arrTrailer + 8, (uint32_t)intCount_a, 4);
+        memcpy(arrTrailer + 12, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN);
+
+        intResult = (fwrite(arrIndex, 1, intIndexLen + 4, fOut_a) == intIndexLen + 4 &&
+                     fwrite(arrTrailer, 1, sizeof(arrTrailer), fOut_a) == sizeof(arrTrailer));
+        if (!intResult) { fprintf(stderr, "Error: Cannot write archive index\n"); }
+    }
+
+    rolling_rom_close(objRom);
+    if (arrIndex)   { free(arrIndex); }
+    if (arrEntries) { free(arrEntries); }
+    return intResult;
+}
+
+static void archive_close(ZTBArchive *objArc_a)
+{
+    if (objArc_a->f)          { fclose(objArc_a->f); }
+    if (objArc_a->arrBaseRom) { free(objArc_a->arrBaseRom); }
+    if (objArc_a->arrEntries) { free(objArc_a->arrEntries); }
+    memset(objArc_a, 0, sizeof(ZTBArchive));
+}
+
+// --- Find a block in the archive; index or -1 ---
+static int archive_find(const ZTBArchive *objArc_a, const char *strBlockID_a)
+{
+    int intResult = -1;
+    int intI;
+    for (intI = 0; intI < objArc_a->intCount && intResult < 0; intI++)
+    {
+        if (strcmp(objArc_a->arrEntries[intI].strID, strBlockID_a) == 0) { intResult = intI; }
+    }
+    return intResult;
+}
+
+// --- Decompressing a block file: copied to f (may be NULL) and checked as it goes ---
+typedef struct
+{
+    FILE     *f;
+    uint32_t  intCrc;
+    uint64_t  intLen;
+    uint8_t   arrHead[ROM_ENTRY_SIZE];
+    int       intHeadLen;
+    int       blnHeadOnly;                  // stop once arrHead is full
+} ZTBArchiveSink;
+
+static int sink_chunk(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    ZTBArchiveSink *objSink = (ZTBArchiveSink*)objCtx_a;
+    size_t intRoom = (size_t)(ROM_ENTRY_SIZE - objSink->intHeadLen);
+    size_t intCopy = intLen_a < intRoom ? intLen_a : intRoom;
+
+    memcpy(objSink->arrHead + objSink->intHeadLen, byData_a, intCopy);
+    objSink->intHeadLen += (int)intCopy;
+    objSink->intCrc      = crc32_update(objSink->intCrc, byData_a, intLen_a);
+    objSink->intLen     += intLen_a;
+
+    if (objSink->f && fwrite(byData_a, 1, intLen_a, objSink->f) != intLen_a) { return 0; }
+    return !(objSink->blnHeadOnly && objSink->intHeadLen == ROM_ENTRY_SIZE);
+}
+
+// --- Decompress entry intIndex_a into fOut_a (NULL = first ROM_ENTRY_SIZE bytes only) ---
+static int archive_read_block(ZTBArchive *objArc_a, int intIndex_a, FILE *fOut_a, ZTBArchiveSink *objSink_a)
+{
+    int intResult = 1;
+    const ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intIndex_a];
+
+    memset(objSink_a, 0, sizeof(ZTBArchiveSink));
+    objSink_a->f           = fOut_a;
+    objSink_a->intCrc      = CRC32_INIT;
+    objSink_a->blnHeadOnly = (fOut_a == NULL);
+
+    if (ZTB_FSEEK(objArc_a->f, (int64_t)objEntry->intOffset, SEEK_SET) != 0 ||
+        (!lz4_stream_read(objArc_a->f, objEntry->intStored, sink_chunk, objSink_a) &&
+         !(objSink_a->blnHeadOnly && objSink_a->intHeadLen == ROM_ENTRY_SIZE)))
+    {
+        intResult = 0;
+    }
+    else if (fOut_a)
+    {
+        intResult = ((objSink_a->intCrc ^ CRC32_INIT) == objEntry->intFileCrc &&
+                     objSink_a->intLen == objEntry->intFileLen);
+    }
+    else
+    {
+        intResult = ((uint64_t)objSink_a->intHeadLen ==
+                     (objEntry->intFileLen < ROM_ENTRY_SIZE ? objEntry->intFileLen : ROM_ENTRY_SIZE));
+    }
+
+    if (!intResult) { fprintf(stderr, "Error: Block '%s' in the archive is damaged\n", objEntry->strID); }
+    return intResult;
+}
+
+// --- The rolling ROM for encoded entry intIndex_a, rebuilt from the archive alone ---
+static ZTBRollingRom* archive_rom(ZTBArchive *objArc_a, int intIndex_a)
+{
+    ZTBRollingRom *objRom = NULL;
+    int intFrom = objArc_a->intFirst;
+    int intI;
+
+    if (intIndex_a - intFrom >= MAX_HISTORY_BLOCKS)
+    {
+        // Past MAX_HISTORY_BLOCKS blocks every slice of the ROM is one of theirs
+        uint8_t *arrZero = (uint8_t*)calloc(ROM_SIZE, 1);
+        if (arrZero) { objRom = rolling_rom_load(arrZero, MAX_HISTORY_BLOCKS, 0, NULL_GUID); }
+        if (arrZero) { free(arrZero); }
+        intFrom = intIndex_a - MAX_HISTORY_BLOCKS;
+    }
+    else
+    {
+        objRom = rolling_rom_load(objArc_a->arrBaseRom, objArc_a->intBaseSlices,
+                                  objArc_a->intBasePrevCrc, objArc_a->strBasePrev);
+    }
+
+    for (intI = intFrom; intI < intIndex_a && objRom; intI++)
+    {
+        ZTBArchiveSink objSink;
+        const ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intI];
+
+        if (!archive_read_block(objArc_a, intI, NULL, &objSink) ||
+            !rolling_rom_advance(objRom, objSink.arrHead, objSink.intHeadLen, objEntry->strID,
+                                 objEntry->intFileCrc))
+        {
+            rolling_rom_close(objRom);
+            objRom = NULL;
+        }
+    }
+
+    if (!objRom) { fprintf(stderr, "Error: Cannot build rolling ROM for '%s'\n", objArc_a->arrEntries[intIndex_a].strID); }
+    return objRom;
+}
+
+// --- Decompress entry intIndex_a and check it: CRC and length, then its raw header ---
+// Returns the block file in a tmpfile positioned at its start, or NULL.
+static FILE* archive_block_file(ZTBArchive *objArc_a, int intIndex_a, const char *strPrevID_a)
+{
+    const ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intIndex_a];
+    ZTBArchiveSink objSink;
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    char strID[GUID_LEN];
+    char strPrev[GUID_LEN];
+    FILE *fBlock = tmpfile();
+
+    if (!fBlock)
+    {
+        fprintf(stderr, "Error: Cannot create temporary file\n");
+    }
+    else if (!archive_read_block(objArc_a, intIndex_a, fBlock, &objSink))
+    {
+        fclose(fBlock);
+        fBlock = NULL;
+    }
+    else
+    {
+        memcpy(arrHeader, objSink.arrHead, HEADER_RAW_SIZE);
+        read_fixed_string(arrHeader, RAW_OFF_BLOCK_ID, 36, strID);
+        read_fixed_string(arrHeader, RAW_OFF_PREV_ID, 36, strPrev);
+
+        if (objSink.intHeadLen < HEADER_RAW_SIZE || arrHeader[RAW_OFF_BLOCK_TYPE] != objEntry->intBlockType ||
+            strcmp(strID, objEntry->strID) != 0 || (strPrevID_a && strcmp(strPrev, strPrevID_a) != 0) ||
+            fflush(fBlock) != 0 || ZTB_FSEEK(fBlock, 0, SEEK_SET) != 0)
+        {
+            fprintf(stderr, "Error: Block '%s' in the archive does not follow '%s'\n", objEntry->strID,
+                    strPrevID_a ? strPrevID_a : "");
+            fclose(fBlock);
+            fBlock = NULL;
+        }
+    }
+    return fBlock;
+}
+
+// --- The base ROM, decompressed into memory ---
+typedef struct
+{
+    uint8_t *byRom;
+    size_t   intLen;
+} ZTBRomSink;
+
+static int rom_chunk(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    ZTBRomSink *objSink = (ZTBRomSink*)objCtx_a;
+    int intResult = (intLen_a <= ROM_SIZE - objSink->intLen);
+    if (intResult)
+    {
+        memcpy(objSink->byRom + objSink->intLen, byData_a, intLen_a);
+        objSink->intLen += intLen_a;
+    }
+    return intResult;
+}
+
+// --- Load the base ROM: its own stream, or the leading truncation block's payload ---
+static int archive_base_rom(ZTBArchive *objArc_a, uint64_t intBaseLen_a)
+{
+    int intResult = 0;
+    ZTBRomSink objSink;
+
+    objArc_a->arrBaseRom = (uint8_t*)malloc(ROM_SIZE);
+    objSink.byRom  = objArc_a->arrBaseRom;
+    objSink.intLen = 0;
+
+    if (!objArc_a->arrBaseRom)
+    {
+        intResult = 0;
+    }
+    else if (objArc_a->intFirst)
+    {
+        FILE *fBlock = archive_block_file(objArc_a, 0, NULL_GUID);
+        intResult = (fBlock && intBaseLen_a == 0 && objArc_a->intBaseSlices == 0 &&
+                     objArc_a->intBasePrevCrc == objArc_a->arrEntries[0].intFileCrc &&
+                     strcmp(objArc_a->strBasePrev, objArc_a->arrEntries[0].strID) == 0 &&
+                     ZTB_FSEEK(fBlock, HEADER_RAW_SIZE, SEEK_SET) == 0 &&
+                     fread(objArc_a->arrBaseRom, 1, ROM_SIZE, fBlock) == ROM_SIZE);
+        if (fBlock) { fclose(fBlock); }
+    }
+    else
+    {
+        intResult = (intBaseLen_a > 0 &&
+                     ZTB_FSEEK(objArc_a->f, ARCHIVE_PREFIX_SIZE, SEEK_SET) == 0 &&
+                     lz4_stream_read(objArc_a->f, intBaseLen_a, rom_chunk, &objSink) &&
+                     objSink.intLen == ROM_SIZE);
+    }
+    return intResult;
+}
+
+// --- Open an archive: trailer, header, index and base ROM, all checked ---
+static int archive_open(ZTBArchive *objArc_a, const char *strPath_a)
+{
+    int intResult = 1;
+    uint8_t arrTrailer[ARCHIVE_TRAILER_SIZE];
+    uint8_t arrPrefix[ARCHIVE_PREFIX_SIZE];
+    uint8_t *arrIndex = NULL;
+    uint64_t intIndexOffset = 0;
+    uint64_t intBaseLen = 0;
+    size_t intIndexLen = 0;
+    int64_t intSize = 0;
+    int intI;
+
+    memset(objArc_a, 0, sizeof(ZTBArchive));
+    objArc_a->f = fopen(strPath_a, "rb");
+    if (!objArc_a->f)
+    {
+        fprintf(stderr, "Error: Cannot open: %s\n", strPath_a);
+        return 0;
+    }
+
+    // --- 1. Trailer and header agree ---
+    intResult = (ZTB_FSEEK(objArc_a->f, 0, SEEK_END) == 0 &&
+                 (intSize = ZTB_FTELL(objArc_a->f)) >= ARCHIVE_PREFIX_SIZE + ARCHIVE_TRAILER_SIZE &&
+                 ZTB_FSEEK(objArc_a->f, intSize - ARCHIVE_TRAILER_SIZE, SEEK_SET) == 0 &&
+                 fread(arrTrailer, 1, sizeof(arrTrailer), objArc_a->f) == sizeof(arrTrailer) &&
+                 ZTB_FSEEK(objArc_a->f, 0, SEEK_SET) == 0 &&
+                 fread(arrPrefix, 1, sizeof(arrPrefix), objArc_a->f) == sizeof(arrPrefix));
+
+    if (intResult)
+    {
+        objArc_a->intCount = (int)get_le(arrPrefix + ARCHIVE_OFF_COUNT, 4);
+        intBaseLen         = get_le(arrPrefix + ARCHIVE_OFF_BASE_LEN, 8);
+        intIndexOffset     = get_le(arrTrailer, 8);
+        intIndexLen        = (size_t)objArc_a->intCount * ARCHIVE_ENTRY_SIZE;
+        intResult = (memcmp(arrPrefix, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN) == 0 &&
+                     memcmp(arrTrailer + 12, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN) == 0 &&
+                     get_le(arrTrailer + 8, 4) == (uint64_t)objArc_a->intCount &&
+                     objArc_a->intCount > 0 && objArc_a->intCount <= ARCHIVE_MAX_BLOCKS &&
+                     intBaseLen <= intIndexOffset - ARCHIVE_PREFIX_SIZE &&
+                     intIndexOffset + intIndexLen + 4 + ARCHIVE_TRAILER_SIZE == (uint64_t)intSize);
+    }
+
+    if (intResult)
+    {
+        read_fixed_string(arrPrefix, ARCHIVE_OFF_BASE_PREV, 36, objArc_a->strBasePrev);
+        objArc_a->intBaseSlices  = (int)get_le(arrPrefix + ARCHIVE_OFF_SLICES, 4);
+        objArc_a->intBasePrevCrc = (uint32_t)get_le(arrPrefix + ARCHIVE_OFF_PREV_CRC, 4);
+        objArc_a->arrEntries = (ZTBArchiveEntry*)calloc((size_t)objArc_a->intCount, sizeof(ZTBArchiveEntry));
+        arrIndex             = (uint8_t*)malloc(intIndexLen + 4);
+        intResult = (objArc_a->arrEntries && arrIndex &&
+                     objArc_a->intBaseSlices <= MAX_HISTORY_BLOCKS &&
+                     ZTB_FSEEK(objArc_a->f, (int64_t)intIndexOffset, SEEK_SET) == 0 &&
+                     fread(arrIndex, 1, intIndexLen + 4, objArc_a->f) == intIndexLen + 4 &&
+                     (crc32_update(CRC32_INIT, arrIndex, intIndexLen) ^ CRC32_INIT) ==
+                         (uint32_t)get_le(arrIndex + intIndexLen, 4));
+    }
+
+    // --- 2. Entries: streams inside the block area, a truncation block only first ---
+    for (intI = 0; intI < objArc_a->intCount && intResult; intI++)
+    {
+        const uint8_t *byEntry = arrIndex + (size_t)intI * ARCHIVE_ENTRY_SIZE;
+        ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intI];
+
+        read_fixed_string(byEntry, 0, 36, objEntry->strID);
+        objEntry->intBlockType = (int)get_le(byEntry + ARCHIVE_ENT_OFF_TYPE, 4);
+        objEntry->intOffset    = get_le(byEntry + ARCHIVE_ENT_OFF_OFFSET, 8);
+        objEntry->intStored    = get_le(byEntry + ARCHIVE_ENT_OFF_STORED, 8);
+        objEntry->intFileLen   = get_le(byEntry + ARCHIVE_ENT_OFF_LEN, 8);
+        objEntry->intFileCrc   = (uint32_t)get_le(byEntry + ARCHIVE_ENT_OFF_CRC, 4);
+
+        intResult = (objEntry->intOffset >= ARCHIVE_PREFIX_SIZE + intBaseLen &&
+                     objEntry->intOffset <= intIndexOffset &&
+                     objEntry->intStored <= intIndexOffset - objEntry->intOffset &&
+                     objEntry->intBlockType >= BLOCK_TYPE_NORMAL && objEntry->intBlockType <= BLOCK_TYPE_BRIDGE &&
+                     (objEntry->intBlockType != BLOCK_TYPE_TRUNCATION || intI == 0));
+    }
+
+    // --- 3. Base ROM ---
+    if (intResult)
+    {
+        objArc_a->intFirst = (objArc_a->arrEntries[0].intBlockType == BLOCK_TYPE_TRUNCATION);
+        intResult = archive_base_rom(objArc_a, intBaseLen);
+    }
+
+    if (!intResult)
+    {
+        fprintf(stderr, "Error: Not a ZTB archive, or its header is damaged: %s\n", strPath_a);
+        archive_close(objArc_a);
+    }
+
+    if (arrIndex) { free(arrIndex); }
+    return intResult;
+}
+
+// --- Decode and check every block in order; count verified or -1 ---
+static int archive_verify(ZTBArchive *objArc_a)
+{
+    int intVerified = 0;
+    ZTBRollingRom *objRom = rolling_rom_load(objArc_a->arrBaseRom, objArc_a->intBaseSlices,
+                                             objArc_a->intBasePrevCrc, objArc_a->strBasePrev);
+    int intI;
+
+    if (!objRom)
+    {
+        fprintf(stderr, "Error: Cannot load the archive's base ROM\n");
+        intVerified = -1;
+    }
+
+    // A leading truncation block is not encoded: its CRC and header are all there is to check
+    if (intVerified == 0 && objArc_a->intFirst)
+    {
+        FILE *fBlock = archive_block_file(objArc_a, 0, NULL_GUID);
+        if (fBlock) { fclose(fBlock); intVerified++; }
+        else        { intVerified = -1; }
+    }
+
+    for (intI = objArc_a->intFirst; intI < objArc_a->intCount && intVerified >= 0; intI++)
+    {
+        const ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intI];
+        FILE *fBlock = archive_block_file(objArc_a, intI, objRom->strPrevID);
+        int blnIntact = 0;
+
+        if (!fBlock ||
+            !read_run_stream(fBlock, objRom, objEntry->strID, intI == 1 && objArc_a->intFirst, NULL, NULL, &blnIntact) ||
+            !blnIntact)
+        {
+            if (fBlock) { fprintf(stderr, "Error: Block '%s' in the archive fails verification\n", objEntry->strID); }
+            intVerified = -1;
+        }
+        else
+        {
+            intVerified++;
+        }
+    }
+
+    rolling_rom_close(objRom);
+    return intVerified;
+}
+
+// --- Pack the segment below strTopID_a into strArchive_a ---
+static int pack_segment(const char *strWorkDir_a, const char *strTopID_a, const char *strArchive_a,
+                        int blnKeep_a)
+{
+    int intResult = 0;
+    char (*arrSegment)[GUID_LEN] = NULL;
+    char strTmpPath[FILENAME_MAX + 4];
+    uint64_t intBytes = 0;
+    int intCount;
+    int intI;
+
+    // --- 1. The segment (bounded as for -severed), and proof nothing reaches it ---
+    ZTBWorkdirView objView;
+    intCount = view_load(strWorkDir_a, &objView) ? segment_ids(strWorkDir_a, &objView, strTopID_a, &arrSegment) : -1;
+
+    if (intCount == 0) { fprintf(stderr, "Error: Block '%s' is still on a live chain\n", strTopID_a); }
+    if (intCount <= 0 || !check_severed(&objView, arrSegment, intCount)) { intResult = 1; }
+    view_free(&objView);
+
+    // --- 2. Write <archive>.tmp, make it durable, rename ---
+    if (intResult == 0)
+    {
+        snprintf(strTmpPath, sizeof(strTmpPath), "%s.tmp", strArchive_a);
+        FILE *fOut = fopen(strTmpPath, "w+b");
+        if (!fOut)
+        {
+            fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+            intResult = 1;
+        }
+        else
+        {
+            if (!write_archive(fOut, strWorkDir_a, arrSegment, intCount, &intBytes) || !sync_stream(fOut))
+            {
+                intResult = 1;
+            }
+            if (fclose(fOut) != 0) { intResult = 1; }
+            if (intResult == 0 && !rename_block_file(strTmpPath, strArchive_a, 1)) { intResult = 1; }
+            if (intResult != 0) { remove(strTmpPath); }
+        }
+    }
+
+    // --- 3. Read it back on its own before anything is removed ---
+    if (intResult == 0)
+    {
+        ZTBArchive objArc;
+        int intVerified = archive_open(&objArc, strArchive_a) ? archive_verify(&objArc) : -1;
+        int64_t intSize = 0;
+
+        if (objArc.f && ZTB_FSEEK(objArc.f, 0, SEEK_END) == 0) { intSize = ZTB_FTELL(objArc.f); }
+        archive_close(&objArc);
+
+        if (intVerified != intCount)
+        {
+            fprintf(stderr, "Error: Archive %s does not verify; block files left in place\n", strArchive_a);
+            intResult = 1;
+        }
+        else
+        {
+            printf("Top:      %s\n", strTopID_a);
+            printf("Blocks:   %d\n", intCount);
+            printf("Bytes:    %llu -> %lld\n", (unsigned long long)intBytes, (long long)intSize);
+            printf("Archive:  %s\n", strArchive_a);
+        }
+    }
+
+    // --- 4. Take the block files, their ROM snapshots and .mrk leaves out of the workdir ---
+    if (intResult == 0 && !blnKeep_a)
+    {
+        for (intI = 0; intI < intCount; intI++)
+        {
+            char strPath[FILENAME_MAX];
+            block_file_path(strWorkDir_a, arrSegment[intI], ".ztb", strPath);
+            if (remove(strPath) != 0) { fprintf(stderr, "Warning: Cannot remove %s\n", strPath); }
+            rom_snapshot_remove(strWorkDir_a, arrSegment[intI]);
+            merkle_leaves_remove(strWorkDir_a, arrSegment[intI]);
+        }
+        printf("Removed:  %d block files\n", intCount);
+    }
+
+    if (arrSegment) { free(arrSegment); }
+    return intResult;
+}
+
+// --- Copy the payload to the output stream ---
+static int write_payload(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    return fwrite(byData_a, 1, intLen_a, (FILE*)objCtx_a) == intLen_a;
+}
+
+// --- Decode one block's payload to strOutFile_a (NULL = stdout) ---
+static int fetch_block(ZTBArchive *objArc_a, const char *strBlockID_a, const char *strOutFile_a)
+{
+    int intResult = 0;
+    int intIndex = archive_find(objArc_a, strBlockID_a);
+    char strTmpPath[FILENAME_MAX + 4];
+    ZTBRollingRom *objRom = NULL;
+    FILE *fBlock = NULL;
+    FILE *fOut = stdout;
+    int blnIntact = 0;
+
+    if (intIndex < 0)
+    {
+        fprintf(stderr, "Error: Block '%s' is not in the archive\n", strBlockID_a);
+        intResult = 1;
+    }
+    else if (intIndex < objArc_a->intFirst)
+    {
+        fprintf(stderr, "Error: Truncation block has no encoded payload\n");
+        intResult = 1;
+    }
+    else if (!(objRom = archive_rom(objArc_a, intIndex)) ||
+             !(fBlock = archive_block_file(objArc_a, intIndex, objRom->strPrevID)))
+    {
+        intResult = 1;
+    }
+
+    if (intResult == 0)
+    {
+        if (strOutFile_a)
+        {
+            snprintf(strTmpPath, sizeof(strTmpPath), "%s.tmp", strOutFile_a);
+            fOut = fopen(strTmpPath, "wb");
+            if (!fOut)
+            {
+                fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+                intResult = 1;
+            }
+        }
+        else
+        {
+#ifdef _WIN32
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        }
+    }
+
+    if (intResult == 0)
+    {
+        int blnPrevTrunc = (intIndex == 1 && objArc_a->intFirst);
+        if (!read_run_stream(fBlock, objRom, strBlockID_a, blnPrevTrunc, write_payload, fOut, &blnIntact) ||
+            fflush(fOut) != 0)
+        {
+            intResult = 1;
+        }
+        fBlock = NULL;
+        if (intResult == 0 && !blnIntact)
+        {
+            fprintf(stderr, "Error: Block '%s' fails verification\n", strBlockID_a);
+            intResult = 1;
+        }
+
+        if (strOutFile_a)
+        {
+            if (fclose(fOut) != 0) { intResult = 1; }
+            if (intResult == 0 && !rename_block_file(strTmpPath, strOutFile_a, 0)) { intResult = 1; }
+            if (intResult != 0) { remove(strTmpPath); }
+        }
+    }
+
+    if (intResult == 0)
+    {
+        fprintf(stderr, "Block:    %s\n", strBlockID_a);
+        fprintf(stderr, "Position: %d of %d\n", intIndex + 1, objArc_a->intCount);
+        fprintf(stderr, "Status:   intact\n");
+    }
+
+    if (fBlock) { fclose(fBlock); }
+    rolling_rom_close(objRom);
+    return intResult;
+}
+
+// --- Put every block file back into strWorkDir_a ---
+static int extract_blocks(ZTBArchive *objArc_a, const char *strWorkDir_a)
+{
+    int intResult = 0;
+    int intWritten = 0;
+    int intI;
+
+    for (intI = 0; intI < objArc_a->intCount && intResult == 0; intI++)
+    {
+        const char *strBlockID = objArc_a->arrEntries[intI].strID;
+        char strTmpPath[FILENAME_MAX];
+        ZTBArchiveSink objSink;
+
+        if (block_exists(strWorkDir_a, strBlockID))
+        {
+            fprintf(stderr, "Warning: Block '%s' is already in the workdir; left as it is\n", strBlockID);
+        }
+        else
+        {
+            block_file_path(strWorkDir_a, strBlockID, ".ztb.tmp", strTmpPath);
+            FILE *fTmp = block_file_dirs(strWorkDir_a, -1, strBlockID) ? create_block_tmp(strTmpPath) : NULL;
+            if (!fTmp)
+            {
+                fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+                intResult = 1;
+            }
+            else
+            {
+                int blnOK = archive_read_block(objArc_a, intI, fTmp, &objSink);
+                if (fclose(fTmp) != 0) { blnOK = 0; }
+                if (blnOK && publish_block(strWorkDir_a, strBlockID, NULL)) { intWritten++; }
+                else
+                {
+                    remove(strTmpPath);
+                    intResult = 1;
+                }
+            }
+        }
+    }
+
+    printf("Blocks:   %d\n", objArc_a->intCount);
+    printf("Restored: %d\n", intWritten);
+    return intResult;
+}
+
+// --- Archive summary and index ---
+static void list_archive(const ZTBArchive *objArc_a, const char *strPath_a)
+{
+    uint64_t intBytes  = 0;
+    uint64_t intStored = 0;
+    int intI;
+
+    printf("Archive:  %s\n", strPath_a);
+    printf("Blocks:   %d\n", objArc_a->intCount);
+    printf("Base:     %s (%d history slices)\n", objArc_a->strBasePrev, objArc_a->intBaseSlices);
+    for (intI = 0; intI < objArc_a->intCount; intI++)
+    {
+        const ZTBArchiveEntry *objEntry = &objArc_a->arrEntries[intI];
+        printf("  %s  %-10s  %llu -> %llu\n", objEntry->strID, arrTypeNames[objEntry->intBlockType],
+               (unsigned long long)objEntry->intFileLen, (unsigned long long)objEntry->intStored);
+        intBytes  += objEntry->intFileLen;
+        intStored += objEntry->intStored;
+    }
+    printf("Bytes:    %llu -> %llu\n", (unsigned long long)intBytes, (unsigned long long)intStored);
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    int blnArchiveMode = (argc >= 3 && argv[1][0] == '-');
+    FILE *fBanner = (blnArchiveMode && strcmp(argv[1], "-fetch") == 0) ? stderr : stdout;   // payload on stdout
+
+    fprintf(fBanner, "ZTB Archive v20261019\n");
+    fprintf(fBanner, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (argc == 3 && strcmp(argv[2], "-severed") == 0)
+    {
+        intResult = list_severed(argv[1]);
+    }
+    else if (!blnArchiveMode && (argc == 4 || (argc == 5 && strcmp(argv[4], "-keep") == 0)))
+    {
+        intResult = pack_segment(argv[1], argv[2], argv[3], argc == 5);
+    }
+    else if (blnArchiveMode &&
+             ((argc == 3 && (strcmp(argv[1], "-list") == 0 || strcmp(argv[1], "-verify") == 0)) ||
+              (strcmp(argv[1], "-fetch") == 0 && (argc == 4 || (argc == 6 && strcmp(argv[4], "-o") == 0))) ||
+              (argc == 4 && strcmp(argv[1], "-extract") == 0)))
+    {
+        ZTBArchive objArc;
+        if (!archive_open(&objArc, argv[2]))
+        {
+            intResult = 1;
+        }
+        else
+        {
+            if (strcmp(argv[1], "-list") == 0)
+            {
+                list_archive(&objArc, argv[2]);
+            }
+            else if (strcmp(argv[1], "-verify") == 0)
+            {
+                int intVerified = archive_verify(&objArc);
+                printf("Blocks:   %d\n", objArc.intCount);
+                printf("Verified: %d\n", intVerified < 0 ? 0 : intVerified);
+                printf(intVerified == objArc.intCount ? "+++ ARCHIVE INTACT +++\n" : "--- ARCHIVE DAMAGED ---\n");
+                intResult = (intVerified == objArc.intCount) ? 0 : 1;
+            }
+            else if (strcmp(argv[1], "-fetch") == 0)
+            {
+                intResult = fetch_block(&objArc, argv[3], argc == 6 ? argv[5] : NULL);
+            }
+            else
+            {
+                intResult = extract_blocks(&objArc, argv[3]);
+            }
+            archive_close(&objArc);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s <workdir> -severed\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> <top_block_id> <archive> [-keep]\n", argv[0]);
+        fprintf(stderr, "       %s -list <archive>\n", argv[0]);
+        fprintf(stderr, "       %s -verify <archive>\n", argv[0]);
+        fprintf(stderr, "       %s -fetch <archive> <block_id> [-o <file>]\n", argv[0]);
+        fprintf(stderr, "       %s -extract <archive> <workdir>\n", argv[0]);
+        intResult = 1;
+    }
+
+    return intResult;
+}
\ No newline at end of file
@@ -0,0 +1,567 @@
+// Cyborg ZTB Bench v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Builds a synthetic workdir and benchmarks it, with the results as JSON on stdout.
+//
+// Usage: ztbbench <workdir> [-n <blocks>] [-size <dist>] [-branches <count>]
+//                 [-checkpoint <every>] [-fetch <count>] [-rom <count>] [-seed <n>]
+//                 [-fanout] [-z] [-sync <policy>]
+//
+// <workdir> must exist and hold no genesis; it is left behind for other tools (the
+// "bench" target in ztb.mk runs this in a scratch directory and removes it).
+//
+//   -n           blocks on the trunk chain "bench" (default 1000)
+//   -size        payload sizes: fixed:<n>, uniform:<min>:<max>, or pareto:<min>:<max>
+//                (alpha 1: most payloads near min, a long tail up to max);
+//                default uniform:256:4096
+//   -branches    branches forked off random trunk blocks as the trunk grows, each of
+//                BENCH_BRANCH_LEN blocks (default 0)
+//   -checkpoint  a checkpoint (with ROM snapshot) every <every> trunk blocks (default 0)
+//   -fetch       random blocks fetched and decoded (default 1000)
+//   -rom         random rolling ROM builds, each with the block cache emptied (default 200)
+//   -seed        seed for the genesis, sizes, payloads and picks (default 1)
+//   -fanout      fanout block file layout
+//   -z           LZ4-compressed payloads (the payload bytes are text-like)
+//   -sync        none (default), block or group[:count[:ms]], as ztbaddblock
+//
+// The genesis is random bytes from the seed, so runs with one seed build the same
+// workdir, block IDs aside. Everything goes through libztb as an embedding application
+// would:
+//   append     ztb_append + ztb_commit per block, trunk and branches alike
+//   fetch      ztb_fetch of random blocks, payload decoded and discarded
+//   verify     ztb_verify of the whole trunk after emptying the block cache
+//   rom_build  build_rolling_rom for random blocks, the block cache emptied each time
+// Latencies are in microseconds (p50, p99, mean, max). The OS file cache is not
+// dropped, so the numbers are warm-disk figures unless the caller drops it first.
+//
+// Exit status: 0 = benchmark ran, 1 = error.
+
+#include "ztbcommon.h"
+#include "libztb.h"
+
+#define BENCH_CHAIN         "bench"
+#define BENCH_BRANCH_LEN    16
+#define BENCH_DEFAULT_N     1000
+#define BENCH_MAX_BLOCKS    10000000
+
+#define SIZE_FIXED          0
+#define SIZE_UNIFORM        1
+#define SIZE_PARETO         2
+
+typedef struct
+{
+    int      intKind;
+    uint32_t intMin;
+    uint32_t intMax;
+} BenchSizes;
+
+typedef struct
+{
+    uint64_t *arrNs;
+    int       intCount;
+    int       intCap;
+} BenchSamples;
+
+typedef struct
+{
+    int         intBlocks;
+    BenchSizes  objSizes;
+    const char *strSizes;
+    int         intBranches;
+    int         intCheckpointEvery;
+    int         intFetches;
+    int         intRomBuilds;
+    uint32_t    intSeed;
+    int         blnFanout;
+    int         blnCompress;
+    const char *strSync;
+} BenchConfig;
+
+// --- Monotonic clock in nanoseconds ---
+static uint64_t now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER objCount;
+    LARGE_INTEGER objFreq;
+    QueryPerformanceCounter(&objCount);
+    QueryPerformanceFrequency(&objFreq);
+    return (uint64_t)((double)objCount.QuadPart * 1e9 / (double)objFreq.QuadPart);
+#else
+    struct timespec objTs;
+    clock_gettime(CLOCK_MONOTONIC, &objTs);
+    return (uint64_t)objTs.tv_sec * 1000000000ULL + (uint64_t)objTs.tv_nsec;
+#endif
+}
+
+static uint32_t bench_rand(uint32_t *intState_a)
+{
+    *intState_a = xorshift32(*intState_a);
+    return *intState_a;
+}
+
+// --- Next payload size from the distribution ---
+static uint32_t bench_size(const BenchSizes *objSizes_a, uint32_t *intState_a)
+{
+    uint32_t intResult = objSizes_a->intMin;
+    uint64_t intSpan   = (uint64_t)objSizes_a->intMax - objSizes_a->intMin + 1;
+
+    if (objSizes_a->intKind == SIZE_UNIFORM)
+    {
+        intResult = objSizes_a->intMin + (uint32_t)(bench_rand(intState_a) % intSpan);
+    }
+    else if (objSizes_a->intKind == SIZE_PARETO)
+    {
+        // Inverse CDF of Pareto(alpha 1): min / (1 - u), u uniform in [0, 1)
+        double dblU    = (double)(bench_rand(intState_a) >> 8) / 16777216.0;
+        double dblSize = (double)objSizes_a->intMin / (1.0 - dblU);
+        intResult = dblSize > (double)objSizes_a->intMax ? objSizes_a->intMax : (uint32_t)dblSize;
+    }
+
+    return intResult;
+}
+
+// --- fixed:<n> | uniform:<min>:<max> | pareto:<min>:<max> ---
+static int parse_sizes(const char *strSpec_a, BenchSizes *objSizes_a)
+{
+    int intResult = 0;
+    unsigned long intMin = 0;
+    unsigned long intMax = 0;
+    char chExtra;
+
+    if (sscanf(strSpec_a, "fixed:%lu%c", &intMin, &chExtra) == 1)
+    {
+        objSizes_a->intKind = SIZE_FIXED;
+        intMax    = intMin;
+        intResult = 1;
+    }
+    else if (sscanf(strSpec_a, "uniform:%lu:%lu%c", &intMin, &intMax, &chExtra) == 2)
+    {
+        objSizes_a->intKind = SIZE_UNIFORM;
+        intResult = 1;
+    }
+    else if (sscanf(strSpec_a, "pareto:%lu:%lu%c", &intMin, &intMax, &chExtra) == 2)
+    {
+        objSizes_a->intKind = SIZE_PARETO;
+        intResult = (intMin > 0);
+    }
+
+    intResult = intResult && intMin <= intMax && intMax <= MAX_PAYLOAD_LEN;
+    objSizes_a->intMin = (uint32_t)intMin;
+    objSizes_a->intMax = (uint32_t)intMax;
+    return intResult;
+}
+
+// --- Latency samples ---
+static int samples_add(BenchSamples *objSamples_a, uint64_t intNs_a)
+{
+    int intResult = 1;
+    if (objSamples_a->intCount == objSamples_a->intCap)
+    {
+        int intCap = objSamples_a->intCap ? objSamples_a->intCap * 2 : 1024;
+        uint64_t *arrNew = (uint64_t*)realloc(objSamples_a->arrNs, (size_t)intCap * sizeof(uint64_t));
+        if (!arrNew) { intResult = 0; }
+        else
+        {
+            objSamples_a->arrNs  = arrNew;
+            objSamples_a->intCap = intCap;
+        }
+    }
+    if (intResult) { objSamples_a->arrNs[objSamples_a->intCount++] = intNs_a; }
+    return intResult;
+}
+
+static int compare_ns(const void *objA_a, const void *objB_a)
+{
+    uint64_t intA = *(const uint64_t*)objA_a;
+    uint64_t intB = *(const uint64_t*)objB_a;
+    return (intA > intB) - (intA < intB);
+}
+
+// --- "count", "p50_us", "p99_us", "mean_us", "max_us" (sorts the samples) ---
+static void print_latency(BenchSamples *objSamples_a)
+{
+    int intCount = objSamples_a->intCount;
+    uint64_t intTotal = 0;
+    int intI;
+
+    printf("\"count\": %d", intCount);
+    if (intCount > 0)
+    {
+        qsort(objSamples_a->arrNs, (size_t)intCount, sizeof(uint64_t), compare_ns);
+        for (intI = 0; intI < intCount; intI++) { intTotal += objSamples_a->arrNs[intI]; }
+        printf(", \"p50_us\": %.1f, \"p99_us\": %.1f, \"mean_us\": %.1f, \"max_us\": %.1f",
+               objSamples_a->arrNs[(intCount - 1) * 50 / 100] / 1e3,
+               objSamples_a->arrNs[(intCount - 1) * 99 / 100] / 1e3,
+               (double)intTotal / intCount / 1e3, objSamples_a->arrNs[intCount - 1] / 1e3);
+    }
+}
+
+static void json_string(const char *strValue_a)
+{
+    const unsigned char *byC;
+    putchar('"');
+    for (byC = (const unsigned char*)strValue_a; *byC; byC++)
+    {
+        if (*byC == '"' || *byC == '\\') { printf("\\%c", *byC); }
+        else if (*byC < 0x20)            { printf("\\u%04x", *byC); }
+        else                             { putchar(*byC); }
+    }
+    putchar('"');
+}
+
+// --- A random genesis from the seed (byte 0 is the genesis type, as ztbcreate) ---
+static int write_genesis(const char *strWorkDir_a, int blnFanout_a, uint32_t *intState_a)
+{
+    int intResult = 1;
+    char strGenesisID[GUID_LEN];
+    char strPath[FILENAME_MAX];
+    char strTmp[FILENAME_MAX + 4];
+    ZTBWorkdirMeta objMeta;
+    uint8_t *arrGen = (uint8_t*)malloc(ROM_SIZE);
+    int intI;
+
+    if (find_genesis_id(strWorkDir_a, strGenesisID))
+    {
+        fprintf(stderr, "Error: %s already holds a workdir; give an empty directory\n", strWorkDir_a);
+        intResult = 0;
+    }
+    else if (!arrGen)
+    {
+        fprintf(stderr, "Error: Cannot allocate genesis\n");
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        arrGen[0] = BLOCK_TYPE_GENESIS;
+        for (intI = 1; intI < ROM_SIZE; intI++) { arrGen[intI] = (uint8_t)(bench_rand(intState_a) >> 24); }
+
+        generate_guid(strGenesisID);
+        memset(&objMeta, 0, sizeof(objMeta));
+        objMeta.intLayout = blnFanout_a ? LAYOUT_FANOUT : LAYOUT_FLAT;
+        snprintf(objMeta.strGenesis, GUID_LEN, "%s", strGenesisID);
+        block_file_path_in(strWorkDir_a, objMeta.intLayout, strGenesisID, ".ztb", strPath);
+        snprintf(strTmp, FILENAME_MAX + 4, "%s.tmp", strPath);
+
+        FILE *fOut = (workdir_meta_save(strWorkDir_a, &objMeta) &&
+                      block_file_dirs(strWorkDir_a, objMeta.intLayout, strGenesisID)) ? fopen(strTmp, "wb") : NULL;
+        if (!fOut)
+        {
+            fprintf(stderr, "Error: Cannot create genesis in %s\n", strWorkDir_a);
+            intResult = 0;
+        }
+        else
+        {
+            if (fwrite(arrGen, 1, ROM_SIZE, fOut) != ROM_SIZE) { intResult = 0; }
+            if (fclose(fOut) != 0)                             { intResult = 0; }
+            if (intResult) { intResult = rename_block_file(strTmp, strPath, 0); }
+            else           { fprintf(stderr, "Error: Write failed\n"); remove(strTmp); }
+        }
+    }
+
+    if (arrGen) { free(arrGen); }
+    return intResult;
+}
+
+// --- Append one block and time it, commit included ---
+static int bench_append(ZTBChain *objChain_a, ZTBAppend *objAppend_a, BenchSamples *objSamples_a,
+                        char *strNewID_a)
+{
+    ZTBAppendResult objResult;
+    uint64_t intStart = now_ns();
+    int intResult = ztb_append(objChain_a, objAppend_a, &objResult) && ztb_commit(objChain_a);
+    uint64_t intEnd = now_ns();
+
+    if (intResult)
+    {
+        snprintf(strNewID_a, GUID_LEN, "%s", objResult.strBlockID);
+        intResult = samples_add(objSamples_a, intEnd - intStart);
+    }
+    return intResult;
+}
+
+// --- Text-like payload bytes, so -z has something to compress ---
+static void fill_payload(uint8_t *byData_a, uint32_t intLen_a, uint32_t *intState_a)
+{
+    static const char strAlphabet[] = "etaoin shrdlu cmfwyp vbgkqj xz ETAOIN 0123456789\n";
+    uint32_t intI;
+    for (intI = 0; intI < intLen_a; intI++)
+    {
+        byData_a[intI] = (uint8_t)strAlphabet[bench_rand(intState_a) % (sizeof(strAlphabet) - 1)];
+    }
+}
+
+static int discard_payload(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    (void)byData_a;
+    *(uint64_t*)objCtx_a += intLen_a;
+    return 1;
+}
+
+// --- Run the whole benchmark; the JSON report goes to stdout ---
+static int run_bench(const char *strWorkDir_a, const BenchConfig *objConfig_a)
+{
+    int intResult = 1;
+    uint32_t intState = objConfig_a->intSeed ? objConfig_a->intSeed : 1;
+    int intMaxIDs = objConfig_a->intBlocks + objConfig_a->intBranches * BENCH_BRANCH_LEN;
+    char (*arrIDs)[GUID_LEN] = (char (*)[GUID_LEN])malloc((size_t)intMaxIDs * GUID_LEN);
+    uint8_t *byPayload = (uint8_t*)malloc((size_t)objConfig_a->objSizes.intMax + 1);
+    char strTip[GUID_LEN];
+    char strBranchTip[GUID_LEN];
+    char strLabel[64];
+    int intIDs = 0;
+    int intNextBranch = 0;
+    uint64_t intPayloadBytes = 0;
+    uint64_t intTrunkBytes   = 0;
+    BenchSamples objAppends;
+    BenchSamples objFetches;
+    BenchSamples objRoms;
+    ZTBChain *objChain = NULL;
+    int intI;
+
+    memset(&objAppends, 0, sizeof(objAppends));
+    memset(&objFetches, 0, sizeof(objFetches));
+    memset(&objRoms, 0, sizeof(objRoms));
+    snprintf(strTip, GUID_LEN, "%s", NULL_GUID);
+
+    // --- 1. Genesis and the chain handle ---
+    if (!arrIDs || !byPayload)
+    {
+        fprintf(stderr, "Error: Cannot allocate benchmark buffers\n");
+        intResult = 0;
+    }
+    if (intResult && !write_genesis(strWorkDir_a, objConfig_a->blnFanout, &intState)) { intResult = 0; }
+    if (intResult)
+    {
+        objChain = ztb_open(strWorkDir_a);
+        if (!objChain || (objConfig_a->strSync && !ztb_set_sync(objChain, objConfig_a->strSync))) { intResult = 0; }
+    }
+
+    // --- 2. Appends: the trunk, with checkpoints and branches forked off as it grows ---
+    uint64_t intAppendStart = now_ns();
+    for (intI = 0; intI < objConfig_a->intBlocks && intResult; intI++)
+    {
+        ZTBAppend objAppend;
+        memset(&objAppend, 0, sizeof(objAppend));
+        objAppend.strChain    = BENCH_CHAIN;
+        objAppend.strPrevID   = strTip;
+        objAppend.blnCompress = objConfig_a->blnCompress;
+
+        if (objConfig_a->intCheckpointEvery > 0 && (intI + 1) % objConfig_a->intCheckpointEvery == 0)
+        {
+            snprintf(strLabel, sizeof(strLabel), "bench checkpoint %d", intI + 1);
+            objAppend.intKind     = ZTB_APPEND_CHECKPOINT;
+            objAppend.byData      = (const uint8_t*)strLabel;
+            objAppend.intDataLen  = strlen(strLabel);
+            objAppend.blnSnapshot = 1;
+            objAppend.blnCompress = 0;
+        }
+        else
+        {
+            uint32_t intLen = bench_size(&objConfig_a->objSizes, &intState);
+            fill_payload(byPayload, intLen, &intState);
+            objAppend.byData     = byPayload;
+            objAppend.intDataLen = intLen;
+        }
+        intPayloadBytes += objAppend.intDataLen;
+
+        intResult = bench_append(objChain, &objAppend, &objAppends, strTip);
+        if (intResult)
+        {
+            ZTBBlockInfo objInfo;
+            snprintf(arrIDs[intIDs++], GUID_LEN, "%s", strTip);
+            if (ztb_block_info(objChain, strTip, &objInfo)) { intTrunkBytes += objInfo.intFileLen; }
+        }
+
+        // Branches fork at even intervals along the trunk, off a random trunk block so far
+        while (intResult && intNextBranch < objConfig_a->intBranches &&
+               (int64_t)(intI + 1) * (objConfig_a->intBranches + 1) >=
+               (int64_t)(intNextBranch + 1) * objConfig_a->intBlocks)
+        {
+            char strBranch[GUID_LEN];
+            int intJ;
+            snprintf(strBranch, GUID_LEN, "%s-b%d", BENCH_CHAIN, intNextBranch + 1);
+            snprintf(strBranchTip, GUID_LEN, "%s", arrIDs[bench_rand(&intState) % (uint32_t)(intI + 1)]);
+
+            for (intJ = 0; intJ < BENCH_BRANCH_LEN && intResult; intJ++)
+            {
+                uint32_t intLen = bench_size(&objConfig_a->objSizes, &intState);
+                fill_payload(byPayload, intLen, &intState);
+                memset(&objAppend, 0, sizeof(objAppend));
+                objAppend.intKind     = intJ == 0 ? ZTB_APPEND_BRANCH : ZTB_APPEND_BLOCK;
+                objAppend.strChain    = strBranch;
+                objAppend.strTrunk    = BENCH_CHAIN;
+                objAppend.strPrevID   = strBranchTip;
+                objAppend.byData      = byPayload;
+                objAppend.intDataLen  = intLen;
+                objAppend.blnCompress = objConfig_a->blnCompress;
+                intPayloadBytes += intLen;
+
+                intResult = bench_append(objChain, &objAppend, &objAppends, strBranchTip);
+                if (intResult) { snprintf(arrIDs[intIDs++], GUID_LEN, "%s", strBranchTip); }
+            }
+            intNextBranch++;
+        }
+    }
+    double dblAppendSecs = (now_ns() - intAppendStart) / 1e9;
+
+    // --- 3. Fetch random blocks ---
+    uint64_t intFetched = 0;
+    uint64_t intFetchStart = now_ns();
+    for (intI = 0; intI < objConfig_a->intFetches && intResult && intIDs > 0; intI++)
+    {
+        const char *strID = arrIDs[bench_rand(&intState) % (uint32_t)intIDs];
+        uint64_t intStart = now_ns();
+        intResult = ztb_fetch(objChain, strID, discard_payload, &intFetched, NULL) &&
+                    samples_add(&objFetches, now_ns() - intStart);
+    }
+    double dblFetchSecs = (now_ns() - intFetchStart) / 1e9;
+
+    // --- 4. Verify the whole trunk from a cold block cache ---
+    ZTBVerifyResult objVerify;
+    memset(&objVerify, 0, sizeof(objVerify));
+    double dblVerifySecs = 0;
+    if (intResult && strcmp(strTip, NULL_GUID) != 0)
+    {
+        block_cache_clear();
+        uint64_t intStart = now_ns();
+        intResult = ztb_verify(objChain, strTip, NULL, &objVerify);
+        dblVerifySecs = (now_ns() - intStart) / 1e9;
+        if (!intResult) { fprintf(stderr, "Error: Verify failed at %s\n", objVerify.strFailedID); }
+    }
+
+    // --- 5. Rolling ROM builds, each from an empty block cache ---
+    for (intI = 0; intI < objConfig_a->intRomBuilds && intResult && intIDs > 0; intI++)
+    {
+        const char *strID = arrIDs[bench_rand(&intState) % (uint32_t)intIDs];
+        block_cache_clear();
+        uint64_t intStart = now_ns();
+        uint8_t *byRom = build_rolling_rom(strWorkDir_a, strID);
+        uint64_t intEnd = now_ns();
+        if (!byRom)
+        {
+            fprintf(stderr, "Error: Cannot build rolling ROM for '%s'\n", strID);
+            intResult = 0;
+        }
+        else
+        {
+            free(byRom);
+            intResult = samples_add(&objRoms, intEnd - intStart);
+        }
+    }
+
+    // --- 6. Report ---
+    if (intResult)
+    {
+        printf("{\n  \"workdir\": ");
+        json_string(strWorkDir_a);
+        printf(",\n  \"config\": {\"blocks\": %d, \"size\": ", objConfig_a->intBlocks);
+        json_string(objConfig_a->strSizes);
+        printf(", \"branches\": %d, \"branch_blocks\": %d, \"checkpoint_every\": %d,\n",
+               objConfig_a->intBranches, BENCH_BRANCH_LEN, objConfig_a->intCheckpointEvery);
+        printf("             \"layout\": \"%s\", \"compress\": %s, \"sync\": ",
+               objConfig_a->blnFanout ? "fanout" : "flat", objConfig_a->blnCompress ? "true" : "false");
+        json_string(objConfig_a->strSync ? objConfig_a->strSync : "none");
+        printf(", \"seed\": %u},\n", (unsigned)objConfig_a->intSeed);
+        printf("  \"blocks_written\": %d,\n  \"payload_bytes\": %llu,\n", intIDs, (unsigned long long)intPayloadBytes);
+
+        printf("  \"append\": {");
+        print_latency(&objAppends);
+        printf(", \"blocks_per_s\": %.1f, \"payload_mb_per_s\": %.2f},\n",
+               dblAppendSecs > 0 ? intIDs / dblAppendSecs : 0.0,
+               dblAppendSecs > 0 ? intPayloadBytes / dblAppendSecs / 1048576.0 : 0.0);
+
+        printf("  \"fetch\": {");
+        print_latency(&objFetches);
+        printf(", \"payload_bytes\": %llu, \"payload_mb_per_s\": %.2f},\n", (unsigned long long)intFetched,
+               dblFetchSecs > 0 ? intFetched / dblFetchSecs / 1048576.0 : 0.0);
+
+        printf("  \"verify\": {\"blocks\": %d, \"bytes\": %llu, \"seconds\": %.3f, \"blocks_per_s\": %.1f, \"mb_per_s\": %.2f},\n",
+               objVerify.intVerified, (unsigned long long)intTrunkBytes, dblVerifySecs,
+               dblVerifySecs > 0 ? objVerify.intVerified / dblVerifySecs : 0.0,
+               dblVerifySecs > 0 ? intTrunkBytes / dblVerifySecs / 1048576.0 : 0.0);
+
+        printf("  \"rom_build\": {");
+        print_latency(&objRoms);
+        printf("}\n}\n");
+    }
+
+    ztb_close(objChain);
+    if (objAppends.arrNs) { free(objAppends.arrNs); }
+    if (objFetches.arrNs) { free(objFetches.arrNs); }
+    if (objRoms.arrNs)    { free(objRoms.arrNs); }
+    if (arrIDs)    { free(arrIDs); }
+    if (byPayload) { free(byPayload); }
+    return intResult;
+}
+
+// --- A whole-number option value in [intMin_a, intMax_a] ---
+static int parse_count(const char *strValue_a, long intMin_a, long intMax_a, int *intOut_a)
+{
+    char *strEnd = NULL;
+    long intValue = strtol(strValue_a, &strEnd, 10);
+    int intResult = (strEnd != strValue_a && *strEnd == '\0' && intValue >= intMin_a && intValue <= intMax_a);
+    if (intResult) { *intOut_a = (int)intValue; }
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    BenchConfig objConfig;
+    int intSeed = 1;
+    int intArg;
+
+    fprintf(stderr, "ZTB Bench v20261019\n");
+    fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    memset(&objConfig, 0, sizeof(objConfig));
+    objConfig.intBlocks    = BENCH_DEFAULT_N;
+    objConfig.strSizes     = "uniform:256:4096";
+    objConfig.intFetches   = 1000;
+    objConfig.intRomBuilds = 200;
+    parse_sizes(objConfig.strSizes, &objConfig.objSizes);
+
+    if (argc < 2) { intResult = 1; }
+    for (intArg = 2; intArg < argc && intResult == 0; intArg++)
+    {
+        int blnValue = (intArg + 1 < argc);
+        const char *strValue = blnValue ? argv[intArg + 1] : "";
+
+        if (strcmp(argv[intArg], "-fanout") == 0)  { objConfig.blnFanout = 1; }
+        else if (strcmp(argv[intArg], "-z") == 0)  { objConfig.blnCompress = 1; }
+        else if (!blnValue)                        { intResult = 1; }
+        else
+        {
+            if (strcmp(argv[intArg], "-n") == 0)               { intResult = !parse_count(strValue, 1, BENCH_MAX_BLOCKS, &objConfig.intBlocks); }
+            else if (strcmp(argv[intArg], "-size") == 0)       { objConfig.strSizes = strValue;
+                                                                 intResult = !parse_sizes(strValue, &objConfig.objSizes); }
+            else if (strcmp(argv[intArg], "-branches") == 0)   { intResult = !parse_count(strValue, 0, 100000, &objConfig.intBranches); }
+            else if (strcmp(argv[intArg], "-checkpoint") == 0) { intResult = !parse_count(strValue, 0, BENCH_MAX_BLOCKS, &objConfig.intCheckpointEvery); }
+            else if (strcmp(argv[intArg], "-fetch") == 0)      { intResult = !parse_count(strValue, 0, BENCH_MAX_BLOCKS, &objConfig.intFetches); }
+            else if (strcmp(argv[intArg], "-rom") == 0)        { intResult = !parse_count(strValue, 0, BENCH_MAX_BLOCKS, &objConfig.intRomBuilds); }
+            else if (strcmp(argv[intArg], "-seed") == 0)       { intResult = !parse_count(strValue, 1, 0x7FFFFFFF, &intSeed); }
+            else if (strcmp(argv[intArg], "-sync") == 0)       { objConfig.strSync = strValue; }
+            else                                               { intResult = 1; }
+            intArg++;
+        }
+    }
+    objConfig.intSeed = (uint32_t)intSeed;
+
+    if (intResult)
+    {
+        fprintf(stderr, "Usage: %s <workdir> [-n <blocks>] [-size <dist>] [-branches <count>]\n", argv[0]);
+        fprintf(stderr, "       [-checkpoint <every>] [-fetch <count>] [-rom <count>] [-seed <n>]\n");
+        fprintf(stderr, "       [-fanout] [-z] [-sync none|block|group[:count[:ms]]]\n");
+        fprintf(stderr, "\n  <dist>: fixed:<n> | uniform:<min>:<max> | pareto:<min>:<max> (default %s)\n",
+                "uniform:256:4096");
+        fprintf(stderr, "  <workdir> must exist and be empty\n");
+    }
+    else
+    {
+        intResult = run_bench(argv[1], &objConfig) ? 0 : 1;
+    }
+
+    return intResult;
+}
\ No newline at end of file
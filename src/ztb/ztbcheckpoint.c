@@ -1,4 +1,4 @@
-// Cyborg ZTB Checkpoint v20260618
+// Cyborg ZTB Checkpoint v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
@@ -6,32 +6,52 @@
 // A checkpoint block is identical to a normal block except block_type=Checkpoint
 // and the payload is a label string.
 //
-// Usage: ztbcheckpoint <workdir> <chain_id> <new_block_id> <prev_block_id> <label>
+// Also saves <new_block_id>.rom, a snapshot of the rolling ROM as of the checkpoint,
+// so later ROM builds and ztbverify -checkpoint can stop at this block instead of
+// walking the full 64-block window. -nosnapshot skips it.
+//
+// -merkle also commits to every block below the checkpoint (back to the start of the
+// chain or its last truncation): the payload becomes the label followed by a line
+// "ZTBMERKLE1 <blocks> <root>", the SHA-256 root of an RFC 6962 Merkle tree over the
+// block files, and the leaves are kept in <new_block_id>.mrk so the next Merkle
+// checkpoint only hashes the blocks added since. ztbprove turns it into inclusion proofs.
+//
+// Usage: ztbcheckpoint <workdir> <chain_id> <new_block_id> <prev_block_id> <label> [-nosnapshot] [-merkle] [-sync <policy>]
 //
 // prev_block_id: use 00000000-0000-0000-0000-000000000000 for the first block
+// policy: none (default), block or group[:count[:ms]] (see ztbaddblock)
+// Concurrent writers on the chain take turns and rebase as in ztbaddblock.
 
-#include "ztbcommon.c"
+#include "ztbcommon.h"
+#include "libztb.h"
 
 int main(int argc, char *argv[])
 {
     int intResult = 0;
 
-    printf("ZTB Checkpoint v20260618\n");
+    printf("ZTB Checkpoint v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
-    if (argc != 6)
+    const char *strSync = sync_option(&argc, argv);
+    int blnSnapshot = 1;
+    int blnMerkle   = 0;
+    int intArg;
+    for (intArg = 6; intArg < argc; intArg++)
+    {
+        if (strcmp(argv[intArg], "-nosnapshot") == 0 && blnSnapshot)  { blnSnapshot = 0; }
+        else if (strcmp(argv[intArg], "-merkle") == 0 && !blnMerkle)  { blnMerkle = 1; }
+        else                                                          { argc = 0; }
+    }
+
+    if (argc < 6)
     {
-        fprintf(stderr, "Usage: %s <workdir> <chain_id> <new_block_id> <prev_block_id> <label>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <workdir> <chain_id> <new_block_id> <prev_block_id> <label> [-nosnapshot] [-merkle]\n", argv[0]);
+        fprintf(stderr, "       (optionally followed by -sync none|block|group[:count[:ms]])\n");
         fprintf(stderr, "\n  prev_block_id: %s for first block\n", NULL_GUID);
         intResult = 1;
     }
 
-    uint8_t *byPayload    = NULL;
-    uint8_t *byPadded     = NULL;
-    uint8_t *byRollingRom = NULL;
-    uint8_t *byEncRaw     = NULL;
-    uint8_t *byEncZoscii  = NULL;
-    uint8_t *byFinal      = NULL;
+    ZTBChain *objChain = NULL;
 
     if (intResult == 0)
     {
@@ -41,200 +61,64 @@ int main(int argc, char *argv[])
         const char *strPrevBlockID_a = argv[4];
         const char *strLabel_a       = argv[5];
 
-        // --- 1. Load payload (label text, matches AddCheckpoint exactly) ---
-        int intPayloadLen = (int)strlen(strLabel_a);
-        byPayload         = (uint8_t*)malloc(intPayloadLen > 0 ? intPayloadLen : 1);
-        if (!byPayload) { fprintf(stderr, "Error: Cannot allocate payload\n"); intResult = 1; }
-        if (intResult == 0 && intPayloadLen > 0)
+        // --- 1. Open the workdir and set the sync policy ---
+        objChain = ztb_open(strWorkDir_a);
+        if (!objChain || (strSync && !ztb_set_sync(objChain, strSync))) { intResult = 1; }
+
+        // --- 2. Checkpoint block; the payload is the label text (matches AddCheckpoint exactly) ---
+        ZTBAppend objAppend;
+        memset(&objAppend, 0, sizeof(objAppend));
+        objAppend.intKind     = ZTB_APPEND_CHECKPOINT;
+        objAppend.strChain    = strChainID_a;
+        objAppend.strBlockID  = strNewBlockID_a;
+        objAppend.strPrevID   = strPrevBlockID_a;
+        objAppend.byData      = (const uint8_t*)strLabel_a;
+        objAppend.intDataLen  = strlen(strLabel_a);
+        objAppend.blnSnapshot = blnSnapshot;
+        objAppend.blnMerkle   = blnMerkle;
+
+        // --- 3. Pad, hash, ZOSCII encode and write, snapshot the ROM, then commit and record the tip ---
+        // The snapshot is only a cache; failing to write it leaves a valid checkpoint.
+        ZTBAppendResult objWrite;
+        if (intResult == 0 &&
+            (!ztb_append(objChain, &objAppend, &objWrite) || !ztb_commit(objChain)))
         {
-            memcpy(byPayload, strLabel_a, intPayloadLen);
+            intResult = 1;
         }
 
-        // --- 2. Pad payload so the COMPLETE on-disk block reaches at least ROM_ENTRY_SIZE
-        //        (1024) bytes. See ztbaddblock.c for the full rationale. (matches C# exactly)
         if (intResult == 0)
         {
-            int intPaddedLen = intPayloadLen;
-            int intTotalSize = HEADER_RAW_SIZE + 2 * (ENC_HEADER_SIZE + intPaddedLen);
-
-            if (intTotalSize <= ROM_ENTRY_SIZE)
+            printf("+ Checkpoint created: %s/%s.ztb\n",
+                   strWorkDir_a, strNewBlockID_a);
+            printf("  Chain:        %s\n", strChainID_a);
+            printf("  Block ID:     %s\n", strNewBlockID_a);
+            printf("  Prev ID:      %s\n", objWrite.strPrevID);
+            if (objWrite.blnRebased)
             {
-                intPaddedLen = (ROM_ENTRY_SIZE - HEADER_RAW_SIZE) / 2 - ENC_HEADER_SIZE + 1;
-                if (intPaddedLen < intPayloadLen) { intPaddedLen = intPayloadLen; }
+                printf("  Rebased from: %s (chain moved on)\n", strPrevBlockID_a);
             }
-
-            byPadded         = (uint8_t*)malloc(intPaddedLen);
-            if (!byPadded) { fprintf(stderr, "Error: Cannot allocate padded buffer\n"); intResult = 1; }
-
-            if (intResult == 0)
+            printf("  Hash:         0x%08X\n", objWrite.intHash);
+            printf("  PrevHash:     0x%08X\n", objWrite.intPrevHash);
+            printf("  Label:        %s\n", strLabel_a);
+            printf("  PayloadLen:   %llu\n", (unsigned long long)objWrite.intPayloadLen);
+            printf("  PaddedLen:    %llu\n", (unsigned long long)objWrite.intPaddedLen);
+            if (objWrite.blnSnapshot)
             {
-                memset(byPadded, 0, intPaddedLen);
-                if (intPayloadLen > 0) { memcpy(byPadded, byPayload, intPayloadLen); }
-
-                // Fill padding with XorShift32 (matches C# WriteBlock padding)
-                if (intPaddedLen > intPayloadLen)
-                {
-                    uint32_t intSeed = (uint32_t)(time(NULL) & 0xFFFFFFFF);
-                    intSeed          = xorshift32(intSeed);
-                    int intI         = intPayloadLen;
-                    while (intI < intPaddedLen)
-                    {
-                        intSeed        = xorshift32(intSeed);
-                        byPadded[intI] = (uint8_t)(intSeed & 0xFF);
-                        intI++;
-                    }
-                }
-
-                // --- 3. Build raw header (block_type=Checkpoint, matches WriteRawHeader) ---
-                uint8_t arrRawHeader[HEADER_RAW_SIZE];
-                memset(arrRawHeader, 0, HEADER_RAW_SIZE);
-                arrRawHeader[RAW_OFF_BLOCK_TYPE] = BLOCK_TYPE_CHECKPOINT;
-                arrRawHeader[RAW_OFF_BLOCK_VER]  = BLOCK_VERSION;
-                arrRawHeader[RAW_OFF_IS_BRANCH]  = 0;
-                write_fixed_string(arrRawHeader, RAW_OFF_TRUNK_ID, 36, NULL_GUID);
-                write_fixed_string(arrRawHeader, RAW_OFF_BLOCK_ID, 36, strNewBlockID_a);
-                write_fixed_string(arrRawHeader, RAW_OFF_PREV_ID,  36,
-                                   strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
-
-                // --- 4. Build rolling ROM ---
-                byRollingRom = build_rolling_rom(strWorkDir_a, strPrevBlockID_a);
-                if (!byRollingRom)
-                {
-                    fprintf(stderr, "Error: Cannot build rolling ROM\n");
-                    intResult = 1;
-                }
-
-                if (intResult == 0)
-                {
-                    // --- 5. Compute prev_hash ---
-                    uint32_t intPrevHash = 0;
-                    if (strPrevBlockID_a != NULL && strcmp(strPrevBlockID_a, NULL_GUID) != 0)
-                    {
-                        int intPrevLen = 0;
-                        uint8_t *byPrev = load_block(strWorkDir_a, strPrevBlockID_a, &intPrevLen);
-                        if (byPrev)
-                        {
-                            intPrevHash = hash_bytes(HASH_TYPE_CRC32_FULL, byPrev, 0, intPrevLen);
-                            free(byPrev);
-                        }
-                    }
-
-                    // --- 6. Build encoded section with hash=0, compute hash, rebuild ---
-                    int intEncRawLen = ENC_HEADER_SIZE + intPaddedLen;
-                    byEncRaw         = (uint8_t*)malloc(intEncRawLen);
-                    if (!byEncRaw) { fprintf(stderr, "Error: Cannot allocate enc raw\n"); intResult = 1; }
-
-                    if (intResult == 0)
-                    {
-                        // Current block hash covers the payload ONLY (not header/metadata).
-                        // This keeps the payload hashable independently of the header, which
-                        // matters once payload hashing is streamed -- the header is always
-                        // small and fully in-memory, so it must never be folded into a hash
-                        // that the payload portion needs to compute incrementally.
-                        uint32_t intHash = hash_bytes(HASH_TYPE_CRC32_FULL, byPadded, 0, intPaddedLen);
-
-                        byEncRaw[ENC_OFF_HASH_TYPE]     = HASH_TYPE_CRC32_FULL;
-                        byEncRaw[ENC_OFF_HASH]          = (uint8_t)(intHash & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 1]      = (uint8_t)((intHash >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 2]      = (uint8_t)((intHash >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_HASH + 3]      = (uint8_t)((intHash >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH]     = (uint8_t)(intPrevHash & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 1] = (uint8_t)((intPrevHash >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 2] = (uint8_t)((intPrevHash >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PREV_HASH + 3] = (uint8_t)((intPrevHash >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN]     = (uint8_t)(intPayloadLen & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 1] = (uint8_t)((intPayloadLen >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 2] = (uint8_t)((intPayloadLen >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PAYLOAD_LEN + 3] = (uint8_t)((intPayloadLen >> 24) & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN]     = (uint8_t)(intPaddedLen & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 1] = (uint8_t)((intPaddedLen >> 8)  & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 2] = (uint8_t)((intPaddedLen >> 16) & 0xFF);
-                        byEncRaw[ENC_OFF_PADDED_LEN + 3] = (uint8_t)((intPaddedLen >> 24) & 0xFF);
-                        memcpy(byEncRaw + ENC_OFF_PAYLOAD, byPadded, intPaddedLen);
-
-                        // ZOSCII encode the encoded section
-                        int intEncZosciiLen = 0;
-                        byEncZoscii = zoscii_encode(byRollingRom, byEncRaw,
-                                                    intEncRawLen, &intEncZosciiLen);
-                        if (!byEncZoscii)
-                        {
-                            fprintf(stderr, "Error: ZOSCII encoding failed\n");
-                            intResult = 1;
-                        }
-
-                        if (intResult == 0)
-                        {
-                            // Assemble final output: raw header + ZOSCII encoded section
-                            int intFinalLen = HEADER_RAW_SIZE + intEncZosciiLen;
-                            byFinal         = (uint8_t*)malloc(intFinalLen);
-                            if (!byFinal) { fprintf(stderr, "Error: Cannot allocate output\n"); intResult = 1; }
-
-                            if (intResult == 0)
-                            {
-                                memcpy(byFinal, arrRawHeader, HEADER_RAW_SIZE);
-                                memcpy(byFinal + HEADER_RAW_SIZE, byEncZoscii, intEncZosciiLen);
-
-                                // Write via tmp then rename
-                                char strOutPath[FILENAME_MAX];
-                                char strTmpPath[FILENAME_MAX + 4];
-                                snprintf(strOutPath, FILENAME_MAX, "%s/%s.ztb",
-                                         strWorkDir_a, strNewBlockID_a);
-                                snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutPath);
-
-                                FILE *fOut = fopen(strTmpPath, "wb");
-                                if (!fOut)
-                                {
-                                    fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
-                                    intResult = 1;
-                                }
-                                else
-                                {
-                                    if (fwrite(byFinal, 1, intFinalLen, fOut) != (size_t)intFinalLen)
-                                    {
-                                        fprintf(stderr, "Error: Write failed\n");
-                                        intResult = 1;
-                                    }
-                                    fclose(fOut);
-
-                                    if (intResult == 0)
-                                    {
-                                        remove(strOutPath);
-                                        if (rename(strTmpPath, strOutPath) != 0)
-                                        {
-                                            fprintf(stderr, "Error: Cannot rename tmp\n");
-                                            intResult = 1;
-                                        }
-                                    }
-                                }
-
-                                if (intResult == 0)
-                                {
-                                    printf("+ Checkpoint created: %s/%s.ztb\n",
-                                           strWorkDir_a, strNewBlockID_a);
-                                    printf("  Chain:        %s\n", strChainID_a);
-                                    printf("  Block ID:     %s\n", strNewBlockID_a);
-                                    printf("  Prev ID:      %s\n",
-                                           strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
-                                    printf("  Hash:         0x%08X\n", intHash);
-                                    printf("  PrevHash:     0x%08X\n", intPrevHash);
-                                    printf("  Label:        %s\n", strLabel_a);
-                                    printf("  PayloadLen:   %d\n", intPayloadLen);
-                                    printf("  PaddedLen:    %d\n", intPaddedLen);
-                                }
-                            }
-                        }
-                    }
-                }
+                char strSnapPath[FILENAME_MAX];
+                block_file_path(strWorkDir_a, strNewBlockID_a, ROM_SNAPSHOT_EXT, strSnapPath);
+                printf("  Snapshot:     %s\n", strSnapPath);
+            }
+            if (blnMerkle)
+            {
+                char strRoot[SHA256_LEN * 2 + 1];
+                hex_encode(objWrite.arrMerkleRoot, SHA256_LEN, strRoot);
+                printf("  Merkle:       %u blocks\n", (unsigned)objWrite.intMerkleLeaves);
+                printf("  Root:         %s\n", strRoot);
             }
         }
     }
 
-    if (byPayload)    { free(byPayload); }
-    if (byPadded)     { free(byPadded); }
-    if (byRollingRom) { free(byRollingRom); }
-    if (byEncRaw)     { free(byEncRaw); }
-    if (byEncZoscii)  { free(byEncZoscii); }
-    if (byFinal)      { free(byFinal); }
+    ztb_close(objChain);
 
     return intResult;
 }
\ No newline at end of file
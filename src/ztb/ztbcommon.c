@@ -1,30 +1,142 @@
-// Cyborg ZTB Common Functions v20260618
+// Cyborg ZTB Common Functions v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 
 #include "ztbcommon.h"
 
+// --- CRC32 table (reflected polynomial 0xEDB88320, same as the bitwise loop in clsZTB) ---
+static const uint32_t arrCrcTable[256] =
+{
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+// --- Streaming CRC32 update ---
+uint32_t crc32_update(uint32_t intCrc_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    uint32_t intCrc = intCrc_a;
+    size_t intI     = 0;
+
+    while (intI < intLen_a)
+    {
+        intCrc = arrCrcTable[(intCrc ^ byData_a[intI]) & 0xFF] ^ (intCrc >> 8);
+        intI++;
+    }
+
+    return intCrc;
+}
+
 // --- CRC32 (matches clsZTB.CalculateCRC32) ---
 uint32_t calculate_crc32(const uint8_t *byData_a, int intOffset_a, int intLen_a)
 {
-    uint32_t intCrc = 0xFFFFFFFF;
-    int intI        = intOffset_a;
-    int intEnd      = intOffset_a + intLen_a;
+    uint32_t intCrc = CRC32_INIT;
+    if (intLen_a > 0) { intCrc = crc32_update(intCrc, byData_a + intOffset_a, (size_t)intLen_a); }
+    return intCrc ^ CRC32_INIT;
+}
 
-    while (intI < intEnd)
+// --- GF(2) matrix helpers for crc32_combine ---
+static uint32_t gf2_matrix_times(const uint32_t *arrMat_a, uint32_t intVec_a)
+{
+    uint32_t intSum = 0;
+    int intI        = 0;
+    while (intVec_a)
     {
-        intCrc ^= byData_a[intI];
-        int intJ = 0;
-        while (intJ < 8)
-        {
-            if (intCrc & 1) { intCrc = (intCrc >> 1) ^ 0xEDB88320; }
-            else            { intCrc =  intCrc >> 1; }
-            intJ++;
-        }
+        if (intVec_a & 1) { intSum ^= arrMat_a[intI]; }
+        intVec_a >>= 1;
         intI++;
     }
+    return intSum;
+}
+
+static void gf2_matrix_square(uint32_t *arrSquare_a, const uint32_t *arrMat_a)
+{
+    int intI;
+    for (intI = 0; intI < 32; intI++)
+    {
+        arrSquare_a[intI] = gf2_matrix_times(arrMat_a, arrMat_a[intI]);
+    }
+}
+
+// --- CRC32 of A+B given CRC32(A), CRC32(B) and len(B) (zlib crc32_combine method) ---
+// Lets the block writer fold the encoded header, which is only known once the whole
+// payload has streamed past, in front of the payload's CRC without re-reading the file.
+uint32_t crc32_combine(uint32_t intCrc1_a, uint32_t intCrc2_a, uint64_t intLen2_a)
+{
+    uint32_t arrEven[32];
+    uint32_t arrOdd[32];
+    uint32_t intCrc1 = intCrc1_a;
+
+    if (intLen2_a == 0) { return intCrc1; }
+
+    // Operator for one zero bit in arrOdd
+    arrOdd[0] = 0xEDB88320;
+    uint32_t intRow = 1;
+    int intI;
+    for (intI = 1; intI < 32; intI++)
+    {
+        arrOdd[intI] = intRow;
+        intRow <<= 1;
+    }
+
+    gf2_matrix_square(arrEven, arrOdd);     // 2 zero bits
+    gf2_matrix_square(arrOdd, arrEven);     // 4 zero bits
+
+    // Apply len2 zero bytes to crc1 (first square puts the operator for one zero byte in arrEven)
+    do
+    {
+        gf2_matrix_square(arrEven, arrOdd);
+        if (intLen2_a & 1) { intCrc1 = gf2_matrix_times(arrEven, intCrc1); }
+        intLen2_a >>= 1;
+        if (intLen2_a == 0) { break; }
+
+        gf2_matrix_square(arrOdd, arrEven);
+        if (intLen2_a & 1) { intCrc1 = gf2_matrix_times(arrOdd, intCrc1); }
+        intLen2_a >>= 1;
+    }
+    while (intLen2_a != 0);
 
-    return intCrc ^ 0xFFFFFFFF;
+    return intCrc1 ^ intCrc2_a;
 }
 
 // --- XorShift32 (matches clsZTB.XorShift32) ---
@@ -37,6 +149,144 @@ uint32_t xorshift32(uint32_t intState_a)
     return intX;
 }
 
+// --- SHA-256 (FIPS 180-4) ---
+static const uint32_t arrSha256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROR(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t *arrState_a, const uint8_t *byBlock_a)
+{
+    uint32_t arrW[64];
+    uint32_t arrV[8];
+    int intI;
+
+    for (intI = 0; intI < 16; intI++)
+    {
+        arrW[intI] = ((uint32_t)byBlock_a[intI * 4] << 24) | ((uint32_t)byBlock_a[intI * 4 + 1] << 16) |
+                     ((uint32_t)byBlock_a[intI * 4 + 2] << 8) | (uint32_t)byBlock_a[intI * 4 + 3];
+    }
+    for (intI = 16; intI < 64; intI++)
+    {
+        uint32_t intS0 = SHA256_ROR(arrW[intI - 15], 7) ^ SHA256_ROR(arrW[intI - 15], 18) ^ (arrW[intI - 15] >> 3);
+        uint32_t intS1 = SHA256_ROR(arrW[intI - 2], 17) ^ SHA256_ROR(arrW[intI - 2], 19) ^ (arrW[intI - 2] >> 10);
+        arrW[intI] = arrW[intI - 16] + intS0 + arrW[intI - 7] + intS1;
+    }
+
+    memcpy(arrV, arrState_a, sizeof(arrV));
+    for (intI = 0; intI < 64; intI++)
+    {
+        uint32_t intS1  = SHA256_ROR(arrV[4], 6) ^ SHA256_ROR(arrV[4], 11) ^ SHA256_ROR(arrV[4], 25);
+        uint32_t intCh  = (arrV[4] & arrV[5]) ^ (~arrV[4] & arrV[6]);
+        uint32_t intT1  = arrV[7] + intS1 + intCh + arrSha256K[intI] + arrW[intI];
+        uint32_t intS0  = SHA256_ROR(arrV[0], 2) ^ SHA256_ROR(arrV[0], 13) ^ SHA256_ROR(arrV[0], 22);
+        uint32_t intMaj = (arrV[0] & arrV[1]) ^ (arrV[0] & arrV[2]) ^ (arrV[1] & arrV[2]);
+        memmove(arrV + 1, arrV, 7 * sizeof(uint32_t));
+        arrV[4] += intT1;
+        arrV[0]  = intT1 + intS0 + intMaj;
+    }
+    for (intI = 0; intI < 8; intI++) { arrState_a[intI] += arrV[intI]; }
+}
+
+void sha256_init(ZTBSha256 *objSha_a)
+{
+    static const uint32_t arrInit[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(objSha_a->arrState, arrInit, sizeof(arrInit));
+    objSha_a->intLen    = 0;
+    objSha_a->intBufLen = 0;
+}
+
+void sha256_update(ZTBSha256 *objSha_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    objSha_a->intLen += intLen_a;
+    while (intLen_a > 0)
+    {
+        if (objSha_a->intBufLen == 0 && intLen_a >= 64)
+        {
+            sha256_block(objSha_a->arrState, byData_a);
+            byData_a += 64;
+            intLen_a -= 64;
+        }
+        else
+        {
+            size_t intTake = 64 - objSha_a->intBufLen;
+            if (intTake > intLen_a) { intTake = intLen_a; }
+            memcpy(objSha_a->arrBuf + objSha_a->intBufLen, byData_a, intTake);
+            objSha_a->intBufLen += intTake;
+            byData_a += intTake;
+            intLen_a -= intTake;
+            if (objSha_a->intBufLen == 64)
+            {
+                sha256_block(objSha_a->arrState, objSha_a->arrBuf);
+                objSha_a->intBufLen = 0;
+            }
+        }
+    }
+}
+
+void sha256_final(ZTBSha256 *objSha_a, uint8_t *byDigest_a)
+{
+    uint64_t intBits = objSha_a->intLen * 8;
+    uint8_t arrPad[72];
+    size_t intPad = (objSha_a->intBufLen < 56) ? 56 - objSha_a->intBufLen : 120 - objSha_a->intBufLen;
+    int intI;
+
+    memset(arrPad, 0, sizeof(arrPad));
+    arrPad[0] = 0x80;
+    for (intI = 0; intI < 8; intI++) { arrPad[intPad + intI] = (uint8_t)(intBits >> (56 - intI * 8)); }
+    sha256_update(objSha_a, arrPad, intPad + 8);
+
+    for (intI = 0; intI < 8; intI++)
+    {
+        byDigest_a[intI * 4]     = (uint8_t)(objSha_a->arrState[intI] >> 24);
+        byDigest_a[intI * 4 + 1] = (uint8_t)(objSha_a->arrState[intI] >> 16);
+        byDigest_a[intI * 4 + 2] = (uint8_t)(objSha_a->arrState[intI] >> 8);
+        byDigest_a[intI * 4 + 3] = (uint8_t)(objSha_a->arrState[intI]);
+    }
+}
+
+// --- Hex strings ---
+void hex_encode(const uint8_t *byData_a, int intLen_a, char *strHex_a)
+{
+    static const char strDigits[] = "0123456789abcdef";
+    int intI;
+    for (intI = 0; intI < intLen_a; intI++)
+    {
+        strHex_a[intI * 2]     = strDigits[byData_a[intI] >> 4];
+        strHex_a[intI * 2 + 1] = strDigits[byData_a[intI] & 0x0F];
+    }
+    strHex_a[intLen_a * 2] = '\0';
+}
+
+// Returns 1 if strHex_a is exactly intLen_a bytes of hex digits (either case)
+int hex_decode(const char *strHex_a, uint8_t *byData_a, int intLen_a)
+{
+    int intResult = (strlen(strHex_a) == (size_t)intLen_a * 2);
+    int intI;
+    for (intI = 0; intResult && intI < intLen_a * 2; intI++)
+    {
+        char chDigit = (char)tolower((unsigned char)strHex_a[intI]);
+        int intNibble = (chDigit >= '0' && chDigit <= '9') ? chDigit - '0' :
+                        (chDigit >= 'a' && chDigit <= 'f') ? chDigit - 'a' + 10 : -1;
+        if (intNibble < 0) { intResult = 0; }
+        else if (intI % 2 == 0) { byData_a[intI / 2] = (uint8_t)(intNibble << 4); }
+        else { byData_a[intI / 2] |= (uint8_t)intNibble; }
+    }
+    return intResult;
+}
+
 // --- Hash bytes (matches clsZTB.HashBytes) ---
 // Only CRC32 variants implemented; rolling hash is a stub returning 0.
 uint32_t hash_bytes(int intHashType_a, const uint8_t *byData_a, int intOffset_a,
@@ -88,94 +338,93 @@ void write_fixed_string(uint8_t *byData_a, int intOffset_a, int intLen_a,
     }
 }
 
-// --- ZOSCII encode (matches ZEncode.Bytes) ---
-// Each raw byte is replaced by a 2-byte little-endian ROM address whose value equals that byte.
-// A random address is chosen among all addresses in the ROM that hold that value.
-// The RNG seed used here mirrors the C# pattern: seeded from time millis per call.
-uint8_t* zoscii_encode(const uint8_t *byRom_a, const uint8_t *byData_a,
-                       int intLen_a, int *intEncodedLen_a)
+// --- ZOSCII encoder index ---
+// Groups every ROM address by the byte value it holds (ascending address order within a
+// value), so a chunked encode can reuse one index instead of rebuilding it per call.
+// Seeded from time like the C# encoder (DateTimeOffset.UtcNow millis seed).
+void encoder_init(ZTBEncoder *objEnc_a, const uint8_t *byRom_a)
 {
-    *intEncodedLen_a = 0;
-
-    // Build lookup: for each byte value, collect all ROM addresses that hold it
-    int arrCounts[256];
-    memset(arrCounts, 0, sizeof(arrCounts));
+    objEnc_a->byRom = byRom_a;
+    memset(objEnc_a->arrCount, 0, sizeof(objEnc_a->arrCount));
 
     int intIdx;
     for (intIdx = 0; intIdx < ROM_SIZE; intIdx++)
     {
-        arrCounts[byRom_a[intIdx]]++;
+        objEnc_a->arrCount[byRom_a[intIdx]]++;
     }
 
-    uint32_t *arrLookup[256];
+    int intNext[256];
+    int intStart = 0;
     int intV;
     for (intV = 0; intV < 256; intV++)
     {
-        arrLookup[intV] = NULL;
-        if (arrCounts[intV] > 0)
-        {
-            arrLookup[intV] = (uint32_t*)malloc(arrCounts[intV] * sizeof(uint32_t));
-            if (!arrLookup[intV])
-            {
-                int intFree;
-                for (intFree = 0; intFree < intV; intFree++)
-                {
-                    if (arrLookup[intFree]) { free(arrLookup[intFree]); }
-                }
-                return NULL;
-            }
-            arrCounts[intV] = 0;
-        }
+        objEnc_a->arrStart[intV] = intStart;
+        intNext[intV]            = intStart;
+        intStart                += objEnc_a->arrCount[intV];
     }
 
     for (intIdx = 0; intIdx < ROM_SIZE; intIdx++)
     {
-        uint8_t byVal = byRom_a[intIdx];
-        arrLookup[byVal][arrCounts[byVal]++] = (uint32_t)intIdx;
+        objEnc_a->arrAddr[intNext[byRom_a[intIdx]]++] = (uint16_t)intIdx;
     }
 
-    int intOutLen  = intLen_a * 2;
-    uint8_t *byOut = (uint8_t*)malloc(intOutLen);
-
-    if (!byOut)
-    {
-        for (intV = 0; intV < 256; intV++) { if (arrLookup[intV]) { free(arrLookup[intV]); } }
-        return NULL;
-    }
+    objEnc_a->intSeed = xorshift32((uint32_t)time(NULL));
+}
 
-    // Seed xorshift from current time (matches C# DateTimeOffset.UtcNow millis seed)
-    uint32_t intSeed = (uint32_t)time(NULL);
-    intSeed = xorshift32(intSeed);
+// --- Encode intLen_a bytes into 2*intLen_a bytes of little-endian ROM addresses ---
+// Returns 1 on success, 0 if a byte value does not occur in the ROM.
+int encoder_encode(ZTBEncoder *objEnc_a, const uint8_t *byData_a, size_t intLen_a,
+                   uint8_t *byOut_a)
+{
+    int intResult  = 1;
+    uint32_t intSeed = objEnc_a->intSeed;
+    size_t intI;
 
-    int intFailed = 0;
-    int intI;
-    for (intI = 0; intI < intLen_a && !intFailed; intI++)
+    for (intI = 0; intI < intLen_a && intResult; intI++)
     {
         uint8_t byVal = byData_a[intI];
-        if (arrCounts[byVal] == 0)
+        if (objEnc_a->arrCount[byVal] == 0)
         {
             fprintf(stderr, "Error: byte 0x%02X not in ROM\n", byVal);
-            intFailed = 1;
+            intResult = 0;
         }
         else
         {
             intSeed = xorshift32(intSeed);
-            uint32_t intRandIdx  = intSeed % (uint32_t)arrCounts[byVal];
-            uint32_t intAddr     = arrLookup[byVal][intRandIdx];
-            byOut[intI * 2]     = (uint8_t)(intAddr & 0xFF);
-            byOut[intI * 2 + 1] = (uint8_t)((intAddr >> 8) & 0xFF);
+            uint32_t intRandIdx = intSeed % (uint32_t)objEnc_a->arrCount[byVal];
+            uint16_t intAddr    = objEnc_a->arrAddr[objEnc_a->arrStart[byVal] + intRandIdx];
+            byOut_a[intI * 2]     = (uint8_t)(intAddr & 0xFF);
+            byOut_a[intI * 2 + 1] = (uint8_t)((intAddr >> 8) & 0xFF);
         }
     }
 
-    for (intV = 0; intV < 256; intV++) { if (arrLookup[intV]) { free(arrLookup[intV]); } }
+    objEnc_a->intSeed = intSeed;
+    return intResult;
+}
+
+// --- ZOSCII encode (matches ZEncode.Bytes) ---
+// Each raw byte is replaced by a 2-byte little-endian ROM address whose value equals that byte.
+// A random address is chosen among all addresses in the ROM that hold that value.
+uint8_t* zoscii_encode(const uint8_t *byRom_a, const uint8_t *byData_a,
+                       int intLen_a, int *intEncodedLen_a)
+{
+    *intEncodedLen_a = 0;
+
+    ZTBEncoder *objEnc = (ZTBEncoder*)malloc(sizeof(ZTBEncoder));
+    if (!objEnc) { return NULL; }
+    encoder_init(objEnc, byRom_a);
+
+    int intOutLen  = intLen_a * 2;
+    uint8_t *byOut = (uint8_t*)malloc(intOutLen > 0 ? intOutLen : 1);
 
-    if (intFailed)
+    if (byOut && !encoder_encode(objEnc, byData_a, (size_t)intLen_a, byOut))
     {
         free(byOut);
-        return NULL;
+        byOut = NULL;
     }
+    free(objEnc);
 
-    *intEncodedLen_a = intOutLen;
+    if (byOut) { *intEncodedLen_a = intOutLen; }
     return byOut;
 }
 
@@ -210,244 +459,4749 @@ uint8_t* zoscii_decode(const uint8_t *byRom_a, const uint8_t *byData_a,
     return byOut;
 }
 
-// --- Load block file: <workdir>/<blockID>.ztb ---
-uint8_t* load_block(const char *strWorkDir_a, const char *strBlockID_a, int *intLen_a)
+// --- Workdir layout (see ZTBWorkdirMeta) ---
+#define META_CACHE_SIZE     8
+
+typedef struct
+{
+    char           strWorkDir[FILENAME_MAX];
+    ZTBWorkdirMeta objMeta;
+} ZTBMetaCacheEntry;
+
+// Block paths are resolved from worker threads too, so the cache has a static lock
+static ZTBMetaCacheEntry arrMetaCache[META_CACHE_SIZE];
+static int intMetaCached = 0;
+#ifdef _WIN32
+static SRWLOCK objMetaLock = SRWLOCK_INIT;
+#define META_LOCK()     AcquireSRWLockExclusive(&objMetaLock)
+#define META_UNLOCK()   ReleaseSRWLockExclusive(&objMetaLock)
+#else
+static pthread_mutex_t objMetaLock = PTHREAD_MUTEX_INITIALIZER;
+#define META_LOCK()     pthread_mutex_lock(&objMetaLock)
+#define META_UNLOCK()   pthread_mutex_unlock(&objMetaLock)
+#endif
+
+// --- Read <workdir>/ztb.meta. Returns 1 if read, 0 if absent (objMeta_a = flat, no genesis) ---
+int workdir_meta_load(const char *strWorkDir_a, ZTBWorkdirMeta *objMeta_a)
 {
+    int intResult = 0;
     char strPath[FILENAME_MAX];
-    snprintf(strPath, FILENAME_MAX, "%s/%s.ztb", strWorkDir_a, strBlockID_a);
+    char strLine[128];
+    snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, WORKDIR_META_FILE);
 
-    uint8_t *byResult = NULL;
-    FILE *f = fopen(strPath, "rb");
+    memset(objMeta_a, 0, sizeof(*objMeta_a));
+    objMeta_a->intLayout = LAYOUT_FLAT;
+
+    FILE *f = fopen(strPath, "r");
     if (f)
     {
-        fseek(f, 0, SEEK_END);
-        long lngSize = ftell(f);
-        fseek(f, 0, SEEK_SET);
-
-        if (lngSize > 0)
+        if (!fgets(strLine, sizeof(strLine), f) ||
+            strncmp(strLine, WORKDIR_META_MAGIC, strlen(WORKDIR_META_MAGIC)) != 0)
+        {
+            fprintf(stderr, "Warning: %s is not a workdir metadata file, ignored\n", strPath);
+        }
+        else
         {
-            byResult = (uint8_t*)malloc(lngSize);
-            if (byResult)
+            intResult = 1;
+            while (fgets(strLine, sizeof(strLine), f))
             {
-                if (fread(byResult, 1, lngSize, f) == (size_t)lngSize)
+                char strKey[16];
+                char strValue[GUID_LEN];
+                int intGot = sscanf(strLine, "%15s %36s", strKey, strValue);
+
+                if (intGot == 2 && strcmp(strKey, "layout") == 0)
+                {
+                    objMeta_a->intLayout = (strcmp(strValue, "fanout") == 0) ? LAYOUT_FANOUT : LAYOUT_FLAT;
+                }
+                else if (intGot == 2 && strcmp(strKey, "genesis") == 0 && is_valid_guid(strValue))
                 {
-                    *intLen_a = (int)lngSize;
+                    snprintf(objMeta_a->strGenesis, GUID_LEN, "%s", strValue);
                 }
-                else
+                else if (intGot >= 1 && strcmp(strKey, "migrating") == 0)
                 {
-                    free(byResult);
-                    byResult  = NULL;
-                    *intLen_a = 0;
+                    objMeta_a->blnMigrating = 1;
                 }
             }
         }
         fclose(f);
     }
 
-    return byResult;
+    return intResult;
 }
 
-// --- Find genesis: scan workdir for a .ztb file of exactly ROM_SIZE bytes ---
-uint8_t* find_genesis(const char *strWorkDir_a)
+// --- Write <workdir>/ztb.meta via tmp then rename, and refresh this process's cache ---
+int workdir_meta_save(const char *strWorkDir_a, const ZTBWorkdirMeta *objMeta_a)
 {
-    uint8_t *byResult = NULL;
+    int intResult = 1;
+    char strPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, WORKDIR_META_FILE);
+    snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strPath);
 
-#ifdef _WIN32
-    char strPattern[FILENAME_MAX];
-    snprintf(strPattern, FILENAME_MAX, "%s/*.ztb", strWorkDir_a);
-    WIN32_FIND_DATAA objFind;
-    HANDLE hFind = FindFirstFileA(strPattern, &objFind);
-    if (hFind != INVALID_HANDLE_VALUE)
+    FILE *f = fopen(strTmpPath, "w");
+    if (!f)
     {
-        do
+        fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+        intResult = 0;
+    }
+    else
+    {
+        fprintf(f, "%s\n", WORKDIR_META_MAGIC);
+        fprintf(f, "layout %s\n", objMeta_a->intLayout == LAYOUT_FANOUT ? "fanout" : "flat");
+        if (objMeta_a->strGenesis[0]) { fprintf(f, "genesis %s\n", objMeta_a->strGenesis); }
+        if (objMeta_a->blnMigrating)  { fprintf(f, "migrating\n"); }
+
+        if (ferror(f)) { intResult = 0; }
+        if (fclose(f) != 0) { intResult = 0; }
+        if (intResult) { intResult = rename_block_file(strTmpPath, strPath, 1); }
+        else
         {
-            if (objFind.nFileSizeHigh == 0 && objFind.nFileSizeLow == ROM_SIZE)
-            {
-                char strPath[FILENAME_MAX];
-                snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, objFind.cFileName);
-                FILE *f = fopen(strPath, "rb");
-                if (f)
-                {
-                    byResult = (uint8_t*)malloc(ROM_SIZE);
-                    if (byResult)
-                    {
-                        if (fread(byResult, 1, ROM_SIZE, f) != ROM_SIZE)
-                        {
-                            free(byResult);
-                            byResult = NULL;
-                        }
-                    }
-                    fclose(f);
-                }
-            }
+            fprintf(stderr, "Error: Write failed\n");
+            remove(strTmpPath);
         }
-        while (byResult == NULL && FindNextFileA(hFind, &objFind) != 0);
-        FindClose(hFind);
     }
-#else
-    DIR *d = opendir(strWorkDir_a);
-    if (d)
+
+    if (intResult)
     {
-        struct dirent *dir;
-        while (byResult == NULL && (dir = readdir(d)) != NULL)
+        int intI;
+        META_LOCK();
+        for (intI = 0; intI < intMetaCached; intI++)
         {
-            int intNameLen = (int)strlen(dir->d_name);
-            if (intNameLen > 4 && strcmp(dir->d_name + intNameLen - 4, ".ztb") == 0)
+            if (strcmp(arrMetaCache[intI].strWorkDir, strWorkDir_a) == 0)
             {
-                char strPath[FILENAME_MAX];
-                snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, dir->d_name);
-                struct stat objStat;
-                if (stat(strPath, &objStat) == 0 && objStat.st_size == ROM_SIZE)
-                {
-                    FILE *f = fopen(strPath, "rb");
-                    if (f)
-                    {
-                        byResult = (uint8_t*)malloc(ROM_SIZE);
-                        if (byResult)
-                        {
-                            if (fread(byResult, 1, ROM_SIZE, f) != ROM_SIZE)
-                            {
-                                free(byResult);
-                                byResult = NULL;
-                            }
-                        }
-                        fclose(f);
-                    }
-                }
+                arrMetaCache[intI].objMeta = *objMeta_a;
             }
         }
-        closedir(d);
+        META_UNLOCK();
     }
-#endif
-
-    return byResult;
+    return intResult;
 }
 
-// --- Build rolling ROM (matches clsZTB.BuildRollingROM exactly) ---
-// Walks back from strPrevBlockID_a via prev_block_id in the raw header,
-// collecting up to MAX_HISTORY_BLOCKS blocks.
-// Copies first ROM_ENTRY_SIZE bytes of each block into the ROM buffer.
-// If a truncation block is found at the bottom, its payload (bytes 111..111+65535) is used
-// as the fill source instead of the genesis.
-// Remainder is filled from the fill source (truncation payload or genesis).
-uint8_t* build_rolling_rom(const char *strWorkDir_a, const char *strPrevBlockID_a)
+// --- Cached metadata for a workdir ---
+static void workdir_meta(const char *strWorkDir_a, ZTBWorkdirMeta *objMeta_a)
 {
-    uint8_t *arrROM        = (uint8_t*)malloc(ROM_SIZE);
-    if (!arrROM) { return NULL; }
-    memset(arrROM, 0, ROM_SIZE);
-
-    int intBytesCopied   = 0;
-    int intSamples       = 0;
-    uint8_t *byTruncPayload = NULL;
+    int blnFound = 0;
+    int intI;
 
-    if (strPrevBlockID_a != NULL && strcmp(strPrevBlockID_a, NULL_GUID) != 0)
+    META_LOCK();
+    for (intI = 0; intI < intMetaCached && !blnFound; intI++)
     {
-        // Walk back up to MAX_HISTORY_BLOCKS, collecting block bytes oldest-first
-        // We walk forward first to collect, then copy oldest first — match C# WalkBack
-        // which does Insert(0, ...) so result is oldest-first.
-        uint8_t *arrHistory[MAX_HISTORY_BLOCKS];
-        int      arrHistoryLen[MAX_HISTORY_BLOCKS];
-        int      intHistCount = 0;
+        if (strcmp(arrMetaCache[intI].strWorkDir, strWorkDir_a) == 0)
+        {
+            *objMeta_a = arrMetaCache[intI].objMeta;
+            blnFound   = 1;
+        }
+    }
+    META_UNLOCK();
 
-        char strCurrentID[GUID_LEN];
-        strncpy(strCurrentID, strPrevBlockID_a, GUID_LEN - 1);
-        strCurrentID[GUID_LEN - 1] = '\0';
+    if (!blnFound)
+    {
+        workdir_meta_load(strWorkDir_a, objMeta_a);
 
-        while (strcmp(strCurrentID, NULL_GUID) != 0 &&
-               strlen(strCurrentID) > 0 &&
-               intHistCount < MAX_HISTORY_BLOCKS)
+        META_LOCK();
+        if (intMetaCached < META_CACHE_SIZE && strlen(strWorkDir_a) < FILENAME_MAX)
         {
-            int intBlockLen = 0;
-            uint8_t *byBlock = load_block(strWorkDir_a, strCurrentID, &intBlockLen);
-            if (!byBlock || intBlockLen < HEADER_RAW_SIZE) 
-            { 
-                if (byBlock) { free(byBlock); }
-                break; 
-            }
+            snprintf(arrMetaCache[intMetaCached].strWorkDir, FILENAME_MAX, "%s", strWorkDir_a);
+            arrMetaCache[intMetaCached].objMeta = *objMeta_a;
+            intMetaCached++;
+        }
+        META_UNLOCK();
+    }
+}
 
-            // Insert at front (shift existing entries right) to match C# Insert(0, ...)
-            int intShift;
-            for (intShift = intHistCount; intShift > 0; intShift--)
-            {
-                arrHistory[intShift]    = arrHistory[intShift - 1];
-                arrHistoryLen[intShift] = arrHistoryLen[intShift - 1];
-            }
-            arrHistory[0]    = byBlock;
-            arrHistoryLen[0] = intBlockLen;
-            intHistCount++;
+static int path_exists(const char *strPath_a)
+{
+#ifdef _WIN32
+    return GetFileAttributesA(strPath_a) != INVALID_FILE_ATTRIBUTES;
+#else
+    struct stat objStat;
+    return stat(strPath_a, &objStat) == 0;
+#endif
+}
 
-            // Stop walking at truncation block
-            if (byBlock[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION) { break; }
+// --- Path of a block's file (strExt_a = ".ztb", ROM_SNAPSHOT_EXT, ...) in a given layout ---
+void block_file_path_in(const char *strWorkDir_a, int intLayout_a, const char *strBlockID_a,
+                        const char *strExt_a, char *strPath_a)
+{
+    if (intLayout_a == LAYOUT_FANOUT && strlen(strBlockID_a) >= 4)
+    {
+        snprintf(strPath_a, FILENAME_MAX, "%s/%.2s/%.2s/%s%s", strWorkDir_a, strBlockID_a,
+                 strBlockID_a + 2, strBlockID_a, strExt_a);
+    }
+    else
+    {
+        snprintf(strPath_a, FILENAME_MAX, "%s/%s%s", strWorkDir_a, strBlockID_a, strExt_a);
+    }
+}
 
-            read_fixed_string(byBlock, RAW_OFF_PREV_ID, 36, strCurrentID);
-        }
+// --- Path of a block's file in the workdir's layout (or where it is, mid-migration) ---
+void block_file_path(const char *strWorkDir_a, const char *strBlockID_a, const char *strExt_a,
+                     char *strPath_a)
+{
+    ZTBWorkdirMeta objMeta;
+    workdir_meta(strWorkDir_a, &objMeta);
+    block_file_path_in(strWorkDir_a, objMeta.intLayout, strBlockID_a, strExt_a, strPath_a);
 
-        // Check if oldest block is truncation — extract its ROM payload
-        if (intHistCount > 0 &&
-            arrHistory[0][RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION)
-        {
-            if (arrHistoryLen[0] >= HEADER_RAW_SIZE + ROM_SIZE)
-            {
-                byTruncPayload = (uint8_t*)malloc(ROM_SIZE);
-                if (byTruncPayload)
-                {
-                    memcpy(byTruncPayload, arrHistory[0] + HEADER_RAW_SIZE, ROM_SIZE);
-                }
-            }
-            free(arrHistory[0]);
-            // Shift remaining entries down
-            int intShift;
-            for (intShift = 0; intShift < intHistCount - 1; intShift++)
-            {
-                arrHistory[intShift]    = arrHistory[intShift + 1];
-                arrHistoryLen[intShift] = arrHistoryLen[intShift + 1];
-            }
-            intHistCount--;
-        }
+    if (objMeta.blnMigrating && !path_exists(strPath_a))
+    {
+        char strOther[FILENAME_MAX];
+        block_file_path_in(strWorkDir_a, objMeta.intLayout == LAYOUT_FANOUT ? LAYOUT_FLAT : LAYOUT_FANOUT,
+                           strBlockID_a, strExt_a, strOther);
+        if (path_exists(strOther)) { memcpy(strPath_a, strOther, FILENAME_MAX); }
+    }
+}
 
-        // Copy first ROM_ENTRY_SIZE bytes of each block into ROM
-        int intI;
-        for (intI = 0; intI < intHistCount; intI++)
-        {
-            if (intBytesCopied + ROM_ENTRY_SIZE > ROM_SIZE) { break; }
-            if (intSamples >= MAX_HISTORY_BLOCKS)           { break; }
-            int intCopy = arrHistoryLen[intI] < ROM_ENTRY_SIZE
-                          ? arrHistoryLen[intI] : ROM_ENTRY_SIZE;
-            memcpy(arrROM + intBytesCopied, arrHistory[intI], intCopy);
-            intBytesCopied += ROM_ENTRY_SIZE;
-            intSamples++;
-        }
+static int make_dir(const char *strPath_a)
+{
+#ifdef _WIN32
+    return CreateDirectoryA(strPath_a, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(strPath_a, 0777) == 0 || errno == EEXIST;
+#endif
+}
 
-        for (intI = 0; intI < intHistCount; intI++) { free(arrHistory[intI]); }
-    }
+// --- Create the directories a block's files go in (intLayout_a < 0 = the workdir's) ---
+int block_file_dirs(const char *strWorkDir_a, int intLayout_a, const char *strBlockID_a)
+{
+    int intResult = 1;
 
-    // Fill remainder from truncation payload or genesis
-    if (intBytesCopied < ROM_SIZE)
+    if (intLayout_a < 0)
     {
-        uint8_t *byFill = byTruncPayload;
-        if (byFill == NULL)
-        {
-            byFill = find_genesis(strWorkDir_a);
-        }
+        ZTBWorkdirMeta objMeta;
+        workdir_meta(strWorkDir_a, &objMeta);
+        intLayout_a = objMeta.intLayout;
+    }
 
-        if (byFill != NULL && byFill != byTruncPayload)
-        {
-            // byFill is genesis — check length
-            memcpy(arrROM + intBytesCopied, byFill, ROM_SIZE - intBytesCopied);
-            free(byFill);
-        }
-        else if (byFill != NULL)
-        {
-            memcpy(arrROM + intBytesCopied, byFill, ROM_SIZE - intBytesCopied);
-        }
-        else
-        {
-            free(arrROM);
-            if (byTruncPayload) { free(byTruncPayload); }
-            return NULL;
-        }
+    if (intLayout_a == LAYOUT_FANOUT && strlen(strBlockID_a) >= 4)
+    {
+        char strDir[FILENAME_MAX];
+        snprintf(strDir, FILENAME_MAX, "%s/%.2s", strWorkDir_a, strBlockID_a);
+        intResult = make_dir(strDir);
+        snprintf(strDir, FILENAME_MAX, "%s/%.2s/%.2s", strWorkDir_a, strBlockID_a, strBlockID_a + 2);
+        intResult = intResult && make_dir(strDir);
+        if (!intResult) { fprintf(stderr, "Error: Cannot create directory %s\n", strDir); }
+    }
+
+    return intResult;
+}
+
+// --- Block cache (see ZTBCacheStats) ---
+#define CACHE_BUCKETS_MIN   1024
+
+// --- One version of a file: a rewrite changes the size, the mtime or the inode ---
+typedef struct
+{
+    uint64_t intSize;
+    uint64_t intTime;
+    uint64_t intFile;
+} ZTBFileStamp;
+
+typedef struct ZTBCacheEntry
+{
+    struct ZTBCacheEntry *objNext;          // hash chain
+    struct ZTBCacheEntry *objNewer;         // LRU list
+    struct ZTBCacheEntry *objOlder;
+    uint32_t       intHash;
+    char          *strWorkDir;
+    char           strID[GUID_LEN];
+    ZTBFileStamp   objStamp;
+    uint8_t       *byData;                  // the file's leading intDataLen bytes
+    int            intDataLen;
+    int            blnCrc;
+    uint32_t       intCrc;
+    ZTBBlockHeader objHeader;
+    uint64_t       intCost;
+} ZTBCacheEntry;
+
+// Worker threads share the cache, so it has a static lock like the meta cache
+static ZTBCacheEntry **arrCacheBuckets  = NULL;
+static uint32_t        intCacheBuckets  = 0;
+static ZTBCacheEntry  *objCacheNewest   = NULL;
+static ZTBCacheEntry  *objCacheOldest   = NULL;
+static ZTBCacheStats   objCacheStats;
+static int             blnCacheBudgetSet = 0;
+#ifdef _WIN32
+static SRWLOCK objCacheLock = SRWLOCK_INIT;
+#define CACHE_LOCK()    AcquireSRWLockExclusive(&objCacheLock)
+#define CACHE_UNLOCK()  ReleaseSRWLockExclusive(&objCacheLock)
+#else
+static pthread_mutex_t objCacheLock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK()    pthread_mutex_lock(&objCacheLock)
+#define CACHE_UNLOCK()  pthread_mutex_unlock(&objCacheLock)
+#endif
+
+// --- Stamp of a regular file. Returns 1 if it exists ---
+static int file_stamp(const char *strPath_a, ZTBFileStamp *objStamp_a)
+{
+    int intResult = 0;
+    memset(objStamp_a, 0, sizeof(ZTBFileStamp));
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA objData;
+    if (GetFileAttributesExA(strPath_a, GetFileExInfoStandard, &objData) &&
+        !(objData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        objStamp_a->intSize = ((uint64_t)objData.nFileSizeHigh << 32) | objData.nFileSizeLow;
+        objStamp_a->intTime = ((uint64_t)objData.ftLastWriteTime.dwHighDateTime << 32) |
+                              objData.ftLastWriteTime.dwLowDateTime;
+        intResult = 1;
+    }
+#else
+    struct stat objStat;
+    if (stat(strPath_a, &objStat) == 0 && S_ISREG(objStat.st_mode))
+    {
+        objStamp_a->intSize = (uint64_t)objStat.st_size;
+        objStamp_a->intTime = (uint64_t)objStat.st_mtim.tv_sec * 1000000000ULL +
+                              (uint64_t)objStat.st_mtim.tv_nsec;
+        objStamp_a->intFile = (uint64_t)objStat.st_ino;
+        intResult = 1;
+    }
+#endif
+    return intResult;
+}
+
+// --- Parse the raw header at the start of a block file ---
+static void parse_raw_header(const uint8_t *byHeader_a, uint64_t intFileLen_a,
+                             ZTBBlockHeader *objHeader_a)
+{
+    objHeader_a->intBlockType = byHeader_a[RAW_OFF_BLOCK_TYPE];
+    objHeader_a->intVersion   = byHeader_a[RAW_OFF_BLOCK_VER];
+    objHeader_a->blnIsBranch  = byHeader_a[RAW_OFF_IS_BRANCH];
+    read_fixed_string(byHeader_a, RAW_OFF_TRUNK_ID, 36, objHeader_a->strTrunkID);
+    read_fixed_string(byHeader_a, RAW_OFF_BLOCK_ID, 36, objHeader_a->strBlockID);
+    read_fixed_string(byHeader_a, RAW_OFF_PREV_ID, 36, objHeader_a->strPrevID);
+    objHeader_a->intFileLen   = intFileLen_a;
+}
+
+// --- The rest of the cache runs under CACHE_LOCK ---
+static void cache_budget_init(void)
+{
+    if (!blnCacheBudgetSet)
+    {
+        const char *strMB = getenv("ZTB_CACHE_MB");
+        uint64_t intMB    = (strMB && strMB[0]) ? strtoull(strMB, NULL, 10) : BLOCK_CACHE_DEFAULT_MB;
+        objCacheStats.intBudget = intMB << 20;
+        blnCacheBudgetSet = 1;
+    }
+}
+
+static uint32_t cache_hash(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    uint32_t intHash = 2166136261u;
+    const char *strC;
+    for (strC = strWorkDir_a; *strC; strC++) { intHash = (intHash ^ (uint8_t)*strC) * 16777619u; }
+    intHash = (intHash ^ '/') * 16777619u;
+    for (strC = strBlockID_a; *strC; strC++) { intHash = (intHash ^ (uint8_t)*strC) * 16777619u; }
+    return intHash;
+}
+
+static ZTBCacheEntry* cache_find(const char *strWorkDir_a, const char *strBlockID_a, uint32_t intHash_a)
+{
+    ZTBCacheEntry *objEntry = intCacheBuckets ? arrCacheBuckets[intHash_a & (intCacheBuckets - 1)] : NULL;
+    while (objEntry && (objEntry->intHash != intHash_a || strcmp(objEntry->strID, strBlockID_a) != 0 ||
+                        strcmp(objEntry->strWorkDir, strWorkDir_a) != 0))
+    {
+        objEntry = objEntry->objNext;
+    }
+    return objEntry;
+}
+
+static void cache_unlink_lru(ZTBCacheEntry *objEntry_a)
+{
+    if (objEntry_a->objNewer) { objEntry_a->objNewer->objOlder = objEntry_a->objOlder; }
+    else                      { objCacheNewest = objEntry_a->objOlder; }
+    if (objEntry_a->objOlder) { objEntry_a->objOlder->objNewer = objEntry_a->objNewer; }
+    else                      { objCacheOldest = objEntry_a->objNewer; }
+}
+
+static void cache_push_lru(ZTBCacheEntry *objEntry_a)
+{
+    objEntry_a->objNewer = NULL;
+    objEntry_a->objOlder = objCacheNewest;
+    if (objCacheNewest) { objCacheNewest->objNewer = objEntry_a; }
+    else                { objCacheOldest = objEntry_a; }
+    objCacheNewest = objEntry_a;
+}
+
+static void cache_remove(ZTBCacheEntry *objEntry_a)
+{
+    ZTBCacheEntry **objLink = &arrCacheBuckets[objEntry_a->intHash & (intCacheBuckets - 1)];
+    while (*objLink != objEntry_a) { objLink = &(*objLink)->objNext; }
+    *objLink = objEntry_a->objNext;
+    cache_unlink_lru(objEntry_a);
+
+    objCacheStats.intBytes -= objEntry_a->intCost;
+    objCacheStats.intEntries--;
+    free(objEntry_a->byData);
+    free(objEntry_a->strWorkDir);
+    free(objEntry_a);
+}
+
+// --- Drop the least recently used entries until the cache is within its budget ---
+static void cache_evict(void)
+{
+    while (objCacheOldest && objCacheStats.intBytes > objCacheStats.intBudget)
+    {
+        cache_remove(objCacheOldest);
+        objCacheStats.intEvictions++;
+    }
+}
+
+// --- Double the hash table once it holds as many entries as buckets ---
+static void cache_grow(void)
+{
+    uint32_t intBuckets = intCacheBuckets ? intCacheBuckets * 2 : CACHE_BUCKETS_MIN;
+    ZTBCacheEntry **arrNew = (ZTBCacheEntry**)calloc(intBuckets, sizeof(ZTBCacheEntry*));
+    ZTBCacheEntry *objEntry;
+
+    if (arrNew)
+    {
+        for (objEntry = objCacheNewest; objEntry; objEntry = objEntry->objOlder)
+        {
+            ZTBCacheEntry **objBucket = &arrNew[objEntry->intHash & (intBuckets - 1)];
+            objEntry->objNext = *objBucket;
+            *objBucket = objEntry;
+        }
+        free(arrCacheBuckets);
+        arrCacheBuckets = arrNew;
+        intCacheBuckets = intBuckets;
+    }
+}
+
+// --- Cache the leading intLen_a bytes of a block file just read ---
+// An entry may take at most an eighth of the budget; a larger file keeps only its
+// first HEADER_RAW_SIZE + ROM_SIZE bytes (all the rolling ROM walk ever needs).
+static void cache_add(const char *strWorkDir_a, const char *strBlockID_a, uint32_t intHash_a,
+                      const ZTBFileStamp *objStamp_a, const uint8_t *byData_a, int intLen_a,
+                      int blnCrc_a, uint32_t intCrc_a, const ZTBBlockHeader *objHeader_a)
+{
+    size_t intDirLen = strlen(strWorkDir_a) + 1;
+    uint64_t intFixed = sizeof(ZTBCacheEntry) + intDirLen;
+
+    CACHE_LOCK();
+    uint64_t intMax = objCacheStats.intBudget / 8;
+    if (intFixed + (uint64_t)intLen_a > intMax && intLen_a > HEADER_RAW_SIZE + ROM_SIZE)
+    {
+        intLen_a = HEADER_RAW_SIZE + ROM_SIZE;
+    }
+
+    if (intFixed + (uint64_t)intLen_a <= intMax &&
+        intCacheBuckets <= (uint32_t)objCacheStats.intEntries)
+    {
+        cache_grow();
+    }
+
+    if (intFixed + (uint64_t)intLen_a <= intMax && intCacheBuckets > 0)
+    {
+        ZTBCacheEntry *objEntry = (ZTBCacheEntry*)calloc(1, sizeof(ZTBCacheEntry));
+        char *strWorkDir        = (char*)malloc(intDirLen);
+        uint8_t *byData         = (uint8_t*)malloc((size_t)intLen_a);
+
+        if (objEntry && strWorkDir && byData)
+        {
+            ZTBCacheEntry *objOld = cache_find(strWorkDir_a, strBlockID_a, intHash_a);
+            if (objOld) { cache_remove(objOld); }
+
+            memcpy(strWorkDir, strWorkDir_a, intDirLen);
+            memcpy(byData, byData_a, (size_t)intLen_a);
+            snprintf(objEntry->strID, GUID_LEN, "%s", strBlockID_a);
+            objEntry->intHash    = intHash_a;
+            objEntry->strWorkDir = strWorkDir;
+            objEntry->objStamp   = *objStamp_a;
+            objEntry->byData     = byData;
+            objEntry->intDataLen = intLen_a;
+            objEntry->blnCrc     = blnCrc_a;
+            objEntry->intCrc     = intCrc_a;
+            objEntry->objHeader  = *objHeader_a;
+            objEntry->intCost    = intFixed + (uint64_t)intLen_a;
+
+            ZTBCacheEntry **objBucket = &arrCacheBuckets[intHash_a & (intCacheBuckets - 1)];
+            objEntry->objNext = *objBucket;
+            *objBucket = objEntry;
+            cache_push_lru(objEntry);
+            objCacheStats.intBytes += objEntry->intCost;
+            objCacheStats.intEntries++;
+            cache_evict();
+        }
+        else
+        {
+            if (objEntry)   { free(objEntry); }
+            if (strWorkDir) { free(strWorkDir); }
+            if (byData)     { free(byData); }
+        }
+    }
+    CACHE_UNLOCK();
+}
+
+// --- Read the leading bytes of a block file through the cache ---
+// Copies at most intMax_a leading bytes into byBuf_a and returns how many (0 if the
+// block is missing, empty or unreadable), with the file size in *intFileLen_a. If
+// intCrc_a is not NULL it also gets the whole file's CRC32 (the next block's
+// prev_hash), and objHeader_a (if not NULL) the parsed raw header. A miss reads at
+// least BLOCK_CACHE_MIN_READ bytes, and at least as many as a too-short entry held,
+// so an entry only ever grows.
+static int block_cache_read(const char *strWorkDir_a, const char *strBlockID_a, uint8_t *byBuf_a,
+                            int intMax_a, uint64_t *intFileLen_a, uint32_t *intCrc_a,
+                            ZTBBlockHeader *objHeader_a)
+{
+    char strPath[FILENAME_MAX];
+    ZTBFileStamp objStamp;
+    int intRead    = 0;
+    int blnHit     = 0;
+    int intHave    = 0;
+    int blnHaveCrc = 0;
+    uint32_t intHaveCrc = 0;
+
+    *intFileLen_a = 0;
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    if (!file_stamp(strPath, &objStamp) || objStamp.intSize == 0) { return 0; }
+
+    uint32_t intHash = cache_hash(strWorkDir_a, strBlockID_a);
+    int intAvail     = (objStamp.intSize < (uint64_t)intMax_a) ? (int)objStamp.intSize : intMax_a;
+
+    // --- 1. Hit: an entry for this version of the file holding enough of it ---
+    CACHE_LOCK();
+    cache_budget_init();
+    ZTBCacheEntry *objEntry = cache_find(strWorkDir_a, strBlockID_a, intHash);
+    if (objEntry && memcmp(&objEntry->objStamp, &objStamp, sizeof(ZTBFileStamp)) != 0)
+    {
+        cache_remove(objEntry);
+        objEntry = NULL;
+    }
+    if (objEntry)
+    {
+        if (intCrc_a && !objEntry->blnCrc && (uint64_t)objEntry->intDataLen == objStamp.intSize)
+        {
+            objEntry->intCrc = crc32_update(CRC32_INIT, objEntry->byData, objEntry->intDataLen) ^ CRC32_INIT;
+            objEntry->blnCrc = 1;
+        }
+
+        if (objEntry->intDataLen >= intAvail && (!intCrc_a || objEntry->blnCrc))
+        {
+            memcpy(byBuf_a, objEntry->byData, intAvail);
+            if (intCrc_a)    { *intCrc_a = objEntry->intCrc; }
+            if (objHeader_a) { *objHeader_a = objEntry->objHeader; }
+            cache_unlink_lru(objEntry);
+            cache_push_lru(objEntry);
+            intRead = intAvail;
+            blnHit  = 1;
+        }
+        else
+        {
+            intHave    = objEntry->intDataLen;
+            blnHaveCrc = objEntry->blnCrc;
+            intHaveCrc = objEntry->intCrc;
+        }
+    }
+    if (blnHit) { objCacheStats.intHits++; }
+    else        { objCacheStats.intMisses++; }
+    CACHE_UNLOCK();
+
+    // --- 2. Miss: read the file, hand the caller its part and cache the lot ---
+    if (!blnHit)
+    {
+        int intWant = intMax_a;
+        if (intWant < BLOCK_CACHE_MIN_READ) { intWant = BLOCK_CACHE_MIN_READ; }
+        if (intWant < intHave)              { intWant = intHave; }
+        if ((uint64_t)intWant > objStamp.intSize) { intWant = (int)objStamp.intSize; }
+
+        uint8_t *byRead  = (intWant <= intMax_a) ? byBuf_a : (uint8_t*)malloc((size_t)intWant);
+        uint32_t intCrc  = intHaveCrc;
+        int blnCrc       = blnHaveCrc;
+        int blnOK        = 0;
+        FILE *f          = byRead ? fopen(strPath, "rb") : NULL;
+
+        if (f)
+        {
+            blnOK = (fread(byRead, 1, (size_t)intWant, f) == (size_t)intWant);
+            if (blnOK && intCrc_a && !blnCrc)
+            {
+                uint8_t *byChunk = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+                intCrc = crc32_update(CRC32_INIT, byRead, (size_t)intWant);
+                if (byChunk)
+                {
+                    size_t intChunk;
+                    while ((intChunk = fread(byChunk, 1, STREAM_CHUNK_SIZE, f)) > 0)
+                    {
+                        intCrc = crc32_update(intCrc, byChunk, intChunk);
+                    }
+                    free(byChunk);
+                }
+                intCrc ^= CRC32_INIT;
+                blnOK   = (byChunk && !ferror(f));
+                blnCrc  = blnOK;
+            }
+            fclose(f);
+        }
+
+        if (blnOK)
+        {
+            ZTBBlockHeader objHeader;
+            memset(&objHeader, 0, sizeof(objHeader));
+            if (intWant >= HEADER_RAW_SIZE) { parse_raw_header(byRead, objStamp.intSize, &objHeader); }
+
+            if (byRead != byBuf_a) { memcpy(byBuf_a, byRead, intAvail); }
+            if (intCrc_a)    { *intCrc_a = intCrc; }
+            if (objHeader_a) { *objHeader_a = objHeader; }
+            intRead = intAvail;
+
+            cache_add(strWorkDir_a, strBlockID_a, intHash, &objStamp, byRead, intWant,
+                      blnCrc, intCrc, &objHeader);
+        }
+        if (byRead && byRead != byBuf_a) { free(byRead); }
+    }
+
+    if (intRead > 0) { *intFileLen_a = objStamp.intSize; }
+    return intRead;
+}
+
+// --- Set the cache's byte budget, evicting down to it (0 = no caching) ---
+void block_cache_set_budget(uint64_t intBytes_a)
+{
+    CACHE_LOCK();
+    objCacheStats.intBudget = intBytes_a;
+    blnCacheBudgetSet = 1;
+    cache_evict();
+    CACHE_UNLOCK();
+}
+
+// --- Hit/miss counters and current size ---
+void block_cache_stats(ZTBCacheStats *objStats_a)
+{
+    CACHE_LOCK();
+    cache_budget_init();
+    *objStats_a = objCacheStats;
+    CACHE_UNLOCK();
+}
+
+// --- Drop every entry (the counters are kept) ---
+void block_cache_clear(void)
+{
+    CACHE_LOCK();
+    while (objCacheOldest) { cache_remove(objCacheOldest); }
+    free(arrCacheBuckets);
+    arrCacheBuckets = NULL;
+    intCacheBuckets = 0;
+    CACHE_UNLOCK();
+}
+
+// --- Load block file: <workdir>/<blockID>.ztb ---
+uint8_t* load_block(const char *strWorkDir_a, const char *strBlockID_a, int *intLen_a)
+{
+    char strPath[FILENAME_MAX];
+    ZTBFileStamp objStamp;
+    uint8_t *byResult = NULL;
+
+    *intLen_a = 0;
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    if (file_stamp(strPath, &objStamp) && objStamp.intSize > 0 && objStamp.intSize <= 0x7FFFFFFF)
+    {
+        byResult = (uint8_t*)malloc((size_t)objStamp.intSize);
+        if (byResult)
+        {
+            uint64_t intFileLen = 0;
+            int intRead = block_cache_read(strWorkDir_a, strBlockID_a, byResult, (int)objStamp.intSize,
+                                           &intFileLen, NULL, NULL);
+            if (intRead > 0 && (uint64_t)intRead == intFileLen)
+            {
+                *intLen_a = intRead;
+            }
+            else
+            {
+                free(byResult);         // missing, or rewritten to another size meanwhile
+                byResult = NULL;
+            }
+        }
+    }
+
+    return byResult;
+}
+
+// --- Read at most intMax_a leading bytes of a block file ---
+// Returns the number of bytes read (0 if the block is missing or empty) and the
+// full file size in *intFileLen_a, so callers that only need the header or the
+// first ROM_ENTRY_SIZE bytes never pull a large payload into memory.
+int read_block_prefix(const char *strWorkDir_a, const char *strBlockID_a,
+                      uint8_t *byBuf_a, int intMax_a, uint64_t *intFileLen_a)
+{
+    return block_cache_read(strWorkDir_a, strBlockID_a, byBuf_a, intMax_a, intFileLen_a,
+                            NULL, NULL);
+}
+
+// --- Parsed raw header of a block. Returns 1 on success, 0 if it cannot be read ---
+int block_header(const char *strWorkDir_a, const char *strBlockID_a, ZTBBlockHeader *objHeader_a)
+{
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint64_t intFileLen = 0;
+    return block_cache_read(strWorkDir_a, strBlockID_a, arrHeader, HEADER_RAW_SIZE, &intFileLen,
+                            NULL, objHeader_a) == HEADER_RAW_SIZE;
+}
+
+// --- CRC32 of a complete block file (the next block's prev_hash), streamed ---
+// Returns 1 on success, 0 if the block cannot be read.
+int block_crc32(const char *strWorkDir_a, const char *strBlockID_a, uint32_t *intCrc_a)
+{
+    uint8_t arrHead[BLOCK_CACHE_MIN_READ];
+    uint64_t intFileLen = 0;
+    *intCrc_a = 0;
+    return block_cache_read(strWorkDir_a, strBlockID_a, arrHead, BLOCK_CACHE_MIN_READ, &intFileLen,
+                            intCrc_a, NULL) > 0;
+}
+
+// --- 1 if the stored prev_hash matches the previous block (or is not checked) ---
+// Skipped for the first block, a zero prev_hash, a missing prev and a truncation prev
+// (matches C#). The prev block is hashed streamed, never loaded whole.
+int block_prev_hash_ok(const char *strWorkDir_a, const char *strPrevID_a, int intHashType_a,
+                       uint32_t intStoredPrevHash_a)
+{
+    int intResult = 1;
+    uint8_t arrHead[ROM_ENTRY_SIZE];
+    uint64_t intPrevLen = 0;
+
+    if (intStoredPrevHash_a != 0 && strcmp(strPrevID_a, NULL_GUID) != 0)
+    {
+        int intRead = read_block_prefix(strWorkDir_a, strPrevID_a, arrHead, ROM_ENTRY_SIZE,
+                                        &intPrevLen);
+        if (intRead >= HEADER_RAW_SIZE &&
+            arrHead[RAW_OFF_BLOCK_TYPE] != BLOCK_TYPE_TRUNCATION)
+        {
+            uint32_t intCalcPrev = 0;
+            if (intHashType_a == HASH_TYPE_CRC32_FULL)
+            {
+                block_crc32(strWorkDir_a, strPrevID_a, &intCalcPrev);
+            }
+            else
+            {
+                intCalcPrev = hash_bytes(intHashType_a, arrHead, 0, intRead);
+            }
+            intResult = (intCalcPrev == intStoredPrevHash_a);
+        }
+    }
+
+    return intResult;
+}
+
+typedef int (*ZTBFileFn)(void *objCtx_a, const char *strName_a, uint64_t intSize_a);
+
+static int is_shard_name(const char *strName_a)
+{
+    return strlen(strName_a) == 2 && isxdigit((unsigned char)strName_a[0]) &&
+           isxdigit((unsigned char)strName_a[1]);
+}
+
+static int is_block_file_name(const char *strName_a)
+{
+    return strlen(strName_a) == GUID_LEN - 1 + 4 && strcmp(strName_a + GUID_LEN - 1, ".ztb") == 0;
+}
+
+// intDepth_a: 0 = workdir, 1 = first-level shard, 2 = second-level shard
+static int walk_block_dir(const char *strDir_a, int intDepth_a, ZTBFileFn fnFile_a,
+                          void *objCtx_a, int *blnStop_a)
+{
+    int intOK = 0;
+
+#ifdef _WIN32
+    char strPattern[FILENAME_MAX];
+    snprintf(strPattern, FILENAME_MAX, "%s/*", strDir_a);
+    WIN32_FIND_DATAA objFind;
+    HANDLE hFind = FindFirstFileA(strPattern, &objFind);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        intOK = 1;
+        do
+        {
+            const char *strName = objFind.cFileName;
+            int blnDir = (objFind.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            if (blnDir && intDepth_a < 2 && is_shard_name(strName))
+            {
+                char strSub[FILENAME_MAX];
+                snprintf(strSub, FILENAME_MAX, "%s/%s", strDir_a, strName);
+                intOK = walk_block_dir(strSub, intDepth_a + 1, fnFile_a, objCtx_a, blnStop_a);
+            }
+            else if (!blnDir && is_block_file_name(strName))
+            {
+                uint64_t intSize = ((uint64_t)objFind.nFileSizeHigh << 32) | objFind.nFileSizeLow;
+                *blnStop_a = !fnFile_a(objCtx_a, strName, intSize);
+            }
+        }
+        while (intOK && !*blnStop_a && FindNextFileA(hFind, &objFind) != 0);
+        FindClose(hFind);
+    }
+#else
+    DIR *d = opendir(strDir_a);
+    if (d)
+    {
+        struct dirent *dir;
+        intOK = 1;
+        while (intOK && !*blnStop_a && (dir = readdir(d)) != NULL)
+        {
+            const char *strName = dir->d_name;
+            int blnShard = (intDepth_a < 2 && is_shard_name(strName));
+            if (blnShard || is_block_file_name(strName))
+            {
+                char strPath[FILENAME_MAX];
+                struct stat objStat;
+                snprintf(strPath, FILENAME_MAX, "%s/%s", strDir_a, strName);
+                if (stat(strPath, &objStat) != 0) { continue; }
+
+                if (blnShard && S_ISDIR(objStat.st_mode))
+                {
+                    intOK = walk_block_dir(strPath, intDepth_a + 1, fnFile_a, objCtx_a, blnStop_a);
+                }
+                else if (!blnShard && S_ISREG(objStat.st_mode))
+                {
+                    *blnStop_a = !fnFile_a(objCtx_a, strName, (uint64_t)objStat.st_size);
+                }
+            }
+        }
+        closedir(d);
+    }
+#endif
+
+    // A shard directory removed under us is not an error
+    return intOK || intDepth_a > 0;
+}
+
+// --- Visit every <guid>.ztb file of a workdir, flat and fanout alike ---
+// fnFile_a gets each block file's name and size and returns 1 to go on, 0 to stop.
+// Returns 1 if the walk finished or was stopped, 0 if the workdir cannot be read.
+static int walk_block_files(const char *strWorkDir_a, ZTBFileFn fnFile_a, void *objCtx_a)
+{
+    int blnStop = 0;
+    return walk_block_dir(strWorkDir_a, 0, fnFile_a, objCtx_a, &blnStop);
+}
+
+// --- walk_block_files callback: take the first ROM_SIZE block file as the genesis ---
+static int find_genesis_file(void *objCtx_a, const char *strName_a, uint64_t intSize_a)
+{
+    int blnGoOn = 1;
+    if (intSize_a == ROM_SIZE)
+    {
+        snprintf((char*)objCtx_a, GUID_LEN, "%.36s", strName_a);
+        blnGoOn = 0;
+    }
+    return blnGoOn;
+}
+
+// --- Genesis block ID: from ztb.meta, else by scanning for a ROM_SIZE block file ---
+// Returns 1 if found.
+int find_genesis_id(const char *strWorkDir_a, char *strGenesisID_a)
+{
+    ZTBWorkdirMeta objMeta;
+    workdir_meta(strWorkDir_a, &objMeta);
+
+    strGenesisID_a[0] = '\0';
+    if (objMeta.strGenesis[0])
+    {
+        snprintf(strGenesisID_a, GUID_LEN, "%s", objMeta.strGenesis);
+    }
+    else
+    {
+        walk_block_files(strWorkDir_a, find_genesis_file, strGenesisID_a);
+    }
+    return strGenesisID_a[0] != '\0';
+}
+
+// --- Find genesis: the block named in ztb.meta, else a .ztb file of exactly ROM_SIZE bytes ---
+uint8_t* find_genesis(const char *strWorkDir_a)
+{
+    uint8_t *byResult = NULL;
+    char strGenesisID[GUID_LEN];
+
+    if (find_genesis_id(strWorkDir_a, strGenesisID))
+    {
+        uint64_t intFileLen = 0;
+        byResult = (uint8_t*)malloc(ROM_SIZE);
+
+        // Exactly ROM_SIZE bytes: a shorter or longer file is not a genesis
+        if (byResult &&
+            (read_block_prefix(strWorkDir_a, strGenesisID, byResult, ROM_SIZE, &intFileLen) != ROM_SIZE ||
+             intFileLen != ROM_SIZE))
+        {
+            free(byResult);
+            byResult = NULL;
+        }
+    }
+
+    return byResult;
+}
+
+// --- qsort order for list_blocks ---
+int compare_ids(const void *objA_a, const void *objB_a)
+{
+    return strcmp((const char*)objA_a, (const char*)objB_a);
+}
+
+typedef struct
+{
+    char (*arrIDs)[GUID_LEN];
+    int    intCount;
+    int    intCap;
+    int    blnFailed;
+} ZTBBlockList;
+
+// --- walk_block_files callback: add a non-genesis block file's ID ---
+static int list_blocks_add(void *objCtx_a, const char *strName_a, uint64_t intSize_a)
+{
+    ZTBBlockList *objList = (ZTBBlockList*)objCtx_a;
+    char strID[GUID_LEN];
+    memcpy(strID, strName_a, GUID_LEN - 1);
+    strID[GUID_LEN - 1] = 0;
+
+    if (intSize_a != ROM_SIZE && is_valid_guid(strID))
+    {
+        if (objList->intCount == objList->intCap)
+        {
+            int intCap = objList->intCap ? objList->intCap * 2 : 256;
+            char (*arrNew)[GUID_LEN] = (char (*)[GUID_LEN])realloc(objList->arrIDs, (size_t)intCap * GUID_LEN);
+            if (!arrNew) { objList->blnFailed = 1; }
+            else
+            {
+                objList->arrIDs = arrNew;
+                objList->intCap = intCap;
+            }
+        }
+        if (!objList->blnFailed) { memcpy(objList->arrIDs[objList->intCount++], strID, GUID_LEN); }
+    }
+
+    return !objList->blnFailed;
+}
+
+// --- IDs of every block in the workdir (genesis excluded), sorted ---
+// Only <guid>.ztb names count, so .tmp files and sidecars are skipped.
+// Returns the number found, -1 on error.
+int list_blocks(const char *strWorkDir_a, char (**arrIDs_a)[GUID_LEN])
+{
+    ZTBBlockList objList;
+    memset(&objList, 0, sizeof(objList));
+
+    int intCount = -1;
+    if (walk_block_files(strWorkDir_a, list_blocks_add, &objList) && !objList.blnFailed)
+    {
+        intCount = objList.intCount;
+        if (intCount > 1) { qsort(objList.arrIDs, (size_t)intCount, GUID_LEN, compare_ids); }
+    }
+    else if (objList.arrIDs)
+    {
+        free(objList.arrIDs);
+        objList.arrIDs = NULL;
+    }
+
+    *arrIDs_a = objList.arrIDs;
+    return intCount;
+}
+
+#define ROM_SLABS   (ROM_SIZE / ROM_ENTRY_SIZE)
+
+// --- Move a logical rolling ROM on by one block (see ZTBRollingRom) ---
+// Below MAX_HISTORY_BLOCKS slices the new slice goes in after the last slice and the
+// fill moves up one slab; at MAX_HISTORY_BLOCKS the oldest slice drops off the front.
+static void rom_shift_in(uint8_t *arrRom_a, int *intSlices_a, const uint8_t *arrSlice_a)
+{
+    if (*intSlices_a < MAX_HISTORY_BLOCKS)
+    {
+        memmove(arrRom_a + (*intSlices_a + 1) * ROM_ENTRY_SIZE,
+                arrRom_a + *intSlices_a * ROM_ENTRY_SIZE,
+                (ROM_SLABS - 1 - *intSlices_a) * ROM_ENTRY_SIZE);
+        memcpy(arrRom_a + *intSlices_a * ROM_ENTRY_SIZE, arrSlice_a, ROM_ENTRY_SIZE);
+        (*intSlices_a)++;
+    }
+    else
+    {
+        memmove(arrRom_a, arrRom_a + ROM_ENTRY_SIZE, (ROM_SLABS - 1) * ROM_ENTRY_SIZE);
+        memcpy(arrRom_a + (ROM_SLABS - 1) * ROM_ENTRY_SIZE, arrSlice_a, ROM_ENTRY_SIZE);
+    }
+}
+
+static uint32_t get_uint32_le(const uint8_t *byIn_a)
+{
+    return (uint32_t)byIn_a[0] | ((uint32_t)byIn_a[1] << 8) |
+           ((uint32_t)byIn_a[2] << 16) | ((uint32_t)byIn_a[3] << 24);
+}
+
+// --- Load <workdir>/<blockID>.rom if it matches the block ---
+// The snapshot is only used if its magic, block ID and ROM CRC are intact and the
+// block file's CRC is still the one recorded when the snapshot was taken.
+// Returns 1 and fills arrRom_a / *intSlices_a if usable, 0 otherwise.
+static int rom_snapshot_load(const char *strWorkDir_a, const char *strBlockID_a,
+                             uint32_t intBlockCrc_a, uint8_t *arrRom_a, int *intSlices_a)
+{
+    int intResult = 0;
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ROM_SNAPSHOT_EXT, strPath);
+
+    FILE *f = fopen(strPath, "rb");
+    if (f)
+    {
+        uint8_t arrHead[SNAP_HEADER_SIZE];
+        if (fread(arrHead, 1, SNAP_HEADER_SIZE, f) == SNAP_HEADER_SIZE &&
+            fread(arrRom_a, 1, ROM_SIZE, f) == ROM_SIZE)
+        {
+            char strID[GUID_LEN];
+            read_fixed_string(arrHead, SNAP_OFF_BLOCK_ID, 36, strID);
+            int intSlices = (int)get_uint32_le(arrHead + SNAP_OFF_SLICES);
+
+            intResult = (memcmp(arrHead, SNAP_MAGIC, SNAP_MAGIC_LEN) == 0 &&
+                         strcmp(strID, strBlockID_a) == 0 &&
+                         intSlices >= 1 && intSlices <= MAX_HISTORY_BLOCKS &&
+                         get_uint32_le(arrHead + SNAP_OFF_BLOCK_CRC) == intBlockCrc_a &&
+                         get_uint32_le(arrHead + SNAP_OFF_ROM_CRC) ==
+                             (crc32_update(CRC32_INIT, arrRom_a, ROM_SIZE) ^ CRC32_INIT));
+            if (intResult) { *intSlices_a = intSlices; }
+        }
+        fclose(f);
+    }
+
+    return intResult;
+}
+
+// --- Walk the history and fill a rolling ROM (matches clsZTB.BuildRollingROM exactly) ---
+// Walks back from strPrevBlockID_a via prev_block_id in the raw header,
+// collecting up to MAX_HISTORY_BLOCKS blocks.
+// Copies first ROM_ENTRY_SIZE bytes of each block into the ROM buffer.
+// If a truncation block is found at the bottom, its payload (bytes 111..111+65535) is used
+// as the fill source instead of the genesis.
+// Remainder is filled from the fill source (truncation payload or genesis).
+// Only the first ROM_ENTRY_SIZE bytes of each block are read (a truncation block's ROM
+// payload too), through the block cache, never the whole payload.
+// If the walk reaches a checkpoint with a valid ROM snapshot it stops there: the
+// snapshot is the ROM as of the checkpoint, and the newer slices are shifted into it,
+// which gives the same ROM as walking the full window.
+// *intSlices_a receives the number of history slices; if intPrevCrc_a is not NULL it
+// receives the CRC32 of the whole prev block, taken during the same read.
+// Returns 1 on success, 0 on failure.
+static int fill_rolling_rom(const char *strWorkDir_a, const char *strPrevBlockID_a,
+                            uint8_t *arrROM_a, int *intSlices_a, uint32_t *intPrevCrc_a)
+{
+    int intResult = 1;
+    memset(arrROM_a, 0, ROM_SIZE);
+    *intSlices_a = 0;
+    if (intPrevCrc_a) { *intPrevCrc_a = 0; }
+
+    int intBytesCopied   = 0;
+    uint8_t *byTruncPayload = NULL;
+
+    if (strPrevBlockID_a != NULL && strcmp(strPrevBlockID_a, NULL_GUID) != 0)
+    {
+        // Slices are collected newest-first while walking and copied oldest-first below,
+        // matching C# WalkBack which does Insert(0, ...) so its result is oldest-first.
+        // The truncation block (if reached) counts towards MAX_HISTORY_BLOCKS, as in C#.
+        uint8_t *arrSlices  = (uint8_t*)malloc(MAX_HISTORY_BLOCKS * ROM_ENTRY_SIZE);
+        uint8_t *byScratch  = (uint8_t*)malloc(HEADER_RAW_SIZE + ROM_SIZE);
+        int      intWalked  = 0;
+        int      intSlices  = 0;
+        int      blnSnapshot = 0;
+        int      intSnapSlices = 0;
+
+        if (!arrSlices || !byScratch)
+        {
+            intResult = 0;
+        }
+        else
+        {
+            memset(arrSlices, 0, MAX_HISTORY_BLOCKS * ROM_ENTRY_SIZE);
+
+            char strCurrentID[GUID_LEN];
+            strncpy(strCurrentID, strPrevBlockID_a, GUID_LEN - 1);
+            strCurrentID[GUID_LEN - 1] = '\0';
+
+            while (strcmp(strCurrentID, NULL_GUID) != 0 &&
+                   strlen(strCurrentID) > 0 &&
+                   intWalked < MAX_HISTORY_BLOCKS)
+            {
+                uint64_t intBlockLen = 0;
+                int intRead = block_cache_read(strWorkDir_a, strCurrentID, byScratch, ROM_ENTRY_SIZE,
+                                               &intBlockLen, intWalked == 0 ? intPrevCrc_a : NULL, NULL);
+                if (intRead < HEADER_RAW_SIZE) { break; }
+                intWalked++;
+
+                // Stop walking at truncation block; its raw ROM becomes the fill source
+                if (byScratch[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION)
+                {
+                    intRead = read_block_prefix(strWorkDir_a, strCurrentID, byScratch,
+                                                HEADER_RAW_SIZE + ROM_SIZE, &intBlockLen);
+                    if (intRead >= HEADER_RAW_SIZE + ROM_SIZE)
+                    {
+                        byTruncPayload = (uint8_t*)malloc(ROM_SIZE);
+                        if (byTruncPayload)
+                        {
+                            memcpy(byTruncPayload, byScratch + HEADER_RAW_SIZE, ROM_SIZE);
+                        }
+                    }
+                    break;
+                }
+
+                // Stop walking at a checkpoint whose ROM snapshot is still valid
+                if (byScratch[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_CHECKPOINT)
+                {
+                    uint32_t intBlockCrc = 0;
+                    if ((uint64_t)intRead == intBlockLen)
+                    {
+                        intBlockCrc = crc32_update(CRC32_INIT, byScratch, intRead) ^ CRC32_INIT;
+                    }
+                    else
+                    {
+                        block_crc32(strWorkDir_a, strCurrentID, &intBlockCrc);
+                    }
+
+                    if (rom_snapshot_load(strWorkDir_a, strCurrentID, intBlockCrc,
+                                          arrROM_a, &intSnapSlices))
+                    {
+                        blnSnapshot = 1;
+                        break;
+                    }
+                }
+
+                int intCopy = intRead < ROM_ENTRY_SIZE ? intRead : ROM_ENTRY_SIZE;
+                memcpy(arrSlices + intSlices * ROM_ENTRY_SIZE, byScratch, intCopy);
+                intSlices++;
+
+                read_fixed_string(byScratch, RAW_OFF_PREV_ID, 36, strCurrentID);
+            }
+
+            int intI;
+            if (blnSnapshot)
+            {
+                // Shift the newer slices into the snapshot, oldest first
+                for (intI = intSlices - 1; intI >= 0; intI--)
+                {
+                    rom_shift_in(arrROM_a, &intSnapSlices, arrSlices + intI * ROM_ENTRY_SIZE);
+                }
+                *intSlices_a   = intSnapSlices;
+                intBytesCopied = ROM_SIZE;
+            }
+            else
+            {
+                // Copy first ROM_ENTRY_SIZE bytes of each block into ROM, oldest first
+                for (intI = 0; intI < intSlices; intI++)
+                {
+                    memcpy(arrROM_a + intBytesCopied,
+                           arrSlices + (intSlices - 1 - intI) * ROM_ENTRY_SIZE, ROM_ENTRY_SIZE);
+                    intBytesCopied += ROM_ENTRY_SIZE;
+                }
+                *intSlices_a = intSlices;
+            }
+        }
+
+        if (arrSlices) { free(arrSlices); }
+        if (byScratch) { free(byScratch); }
+    }
+
+    // Fill remainder from truncation payload or genesis
+    if (intResult && intBytesCopied < ROM_SIZE)
+    {
+        uint8_t *byFill = byTruncPayload;
+        if (byFill == NULL)
+        {
+            byFill = find_genesis(strWorkDir_a);
+        }
+
+        if (byFill != NULL)
+        {
+            memcpy(arrROM_a + intBytesCopied, byFill, ROM_SIZE - intBytesCopied);
+            if (byFill != byTruncPayload) { free(byFill); }
+        }
+        else
+        {
+            intResult = 0;
+        }
+    }
+
+    if (byTruncPayload) { free(byTruncPayload); }
+    return intResult;
+}
+
+// --- Build rolling ROM (matches clsZTB.BuildRollingROM exactly) ---
+uint8_t* build_rolling_rom(const char *strWorkDir_a, const char *strPrevBlockID_a)
+{
+    uint8_t *arrROM = (uint8_t*)malloc(ROM_SIZE);
+    int intSlices   = 0;
+
+    if (arrROM && !fill_rolling_rom(strWorkDir_a, strPrevBlockID_a, arrROM, &intSlices, NULL))
+    {
+        free(arrROM);
+        arrROM = NULL;
     }
 
-    if (byTruncPayload) { free(byTruncPayload); }
     return arrROM;
+}
+
+// --- Rolling ROM object ---
+// Keeps the ROM for the next block plus its encode index in memory so consecutive
+// appends derive ROM N+1 from ROM N instead of re-walking 64 files and re-indexing.
+//
+// Appending block N+1 always moves the ROM by exactly one ROM_ENTRY_SIZE slab:
+//   fewer than MAX_HISTORY_BLOCKS slices: the new slice is inserted after the last
+//     slice, the fill (genesis/truncation ROM) moves up one slab and its last slab drops;
+//   MAX_HISTORY_BLOCKS slices: the oldest slice drops, everything moves down one slab.
+// Either way only one physical slab changes contents, so the index is kept over
+// physical addresses and a 64-entry slab table maps them to logical addresses. An
+// advance updates ROM_ENTRY_SIZE index entries instead of rebuilding all ROM_SIZE.
+
+static int rolling_rom_index_add(ZTBRollingRom *objRom_a, uint16_t intPhys_a, uint8_t byVal_a)
+{
+    if (objRom_a->arrCount[byVal_a] == objRom_a->arrCap[byVal_a])
+    {
+        int intCap      = objRom_a->arrCap[byVal_a] ? objRom_a->arrCap[byVal_a] * 2 : 64;
+        uint16_t *arrNew = (uint16_t*)realloc(objRom_a->arrList[byVal_a],
+                                              intCap * sizeof(uint16_t));
+        if (!arrNew) { return 0; }
+        objRom_a->arrList[byVal_a] = arrNew;
+        objRom_a->arrCap[byVal_a]  = intCap;
+    }
+
+    objRom_a->arrWhere[intPhys_a] = (uint16_t)objRom_a->arrCount[byVal_a];
+    objRom_a->arrList[byVal_a][objRom_a->arrCount[byVal_a]++] = intPhys_a;
+    return 1;
+}
+
+static void rolling_rom_index_remove(ZTBRollingRom *objRom_a, uint16_t intPhys_a, uint8_t byVal_a)
+{
+    // Swap with the last entry for that value
+    int intIdx  = objRom_a->arrWhere[intPhys_a];
+    int intLast = --objRom_a->arrCount[byVal_a];
+    uint16_t intMoved = objRom_a->arrList[byVal_a][intLast];
+    objRom_a->arrList[byVal_a][intIdx] = intMoved;
+    objRom_a->arrWhere[intMoved]       = (uint16_t)intIdx;
+}
+
+// --- Identity slab table and a full encode index over a freshly filled arrRom ---
+static int rolling_rom_index(ZTBRollingRom *objRom_a)
+{
+    int intOK = 1;
+    int intI;
+
+    memcpy(objRom_a->arrPhys, objRom_a->arrRom, ROM_SIZE);
+    for (intI = 0; intI < ROM_SLABS; intI++)
+    {
+        objRom_a->arrSlabPhys[intI] = intI;
+        objRom_a->arrPhysSlab[intI] = intI;
+    }
+    for (intI = 0; intI < ROM_SIZE && intOK; intI++)
+    {
+        intOK = rolling_rom_index_add(objRom_a, (uint16_t)intI, objRom_a->arrPhys[intI]);
+    }
+    objRom_a->intSeed = xorshift32((uint32_t)time(NULL));
+    return intOK;
+}
+
+// --- Open a rolling ROM as of strPrevBlockID_a (the ROM the next block encodes with) ---
+ZTBRollingRom* rolling_rom_open(const char *strWorkDir_a, const char *strPrevBlockID_a)
+{
+    ZTBRollingRom *objRom = (ZTBRollingRom*)calloc(1, sizeof(ZTBRollingRom));
+    int intOK = (objRom != NULL &&
+                 fill_rolling_rom(strWorkDir_a, strPrevBlockID_a, objRom->arrRom,
+                                  &objRom->intSlices, &objRom->intPrevCrc));
+
+    if (intOK)
+    {
+        snprintf(objRom->strPrevID, GUID_LEN, "%s", strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
+        intOK = rolling_rom_index(objRom);
+    }
+
+    if (!intOK)
+    {
+        rolling_rom_close(objRom);
+        objRom = NULL;
+    }
+
+    return objRom;
+}
+
+// --- A rolling ROM from a saved logical ROM (an archive's base ROM, say) ---
+ZTBRollingRom* rolling_rom_load(const uint8_t *arrRom_a, int intSlices_a, uint32_t intPrevCrc_a,
+                                const char *strPrevBlockID_a)
+{
+    ZTBRollingRom *objRom = (ZTBRollingRom*)calloc(1, sizeof(ZTBRollingRom));
+    int intOK = (objRom != NULL && intSlices_a >= 0 && intSlices_a <= MAX_HISTORY_BLOCKS);
+
+    if (intOK)
+    {
+        memcpy(objRom->arrRom, arrRom_a, ROM_SIZE);
+        objRom->intSlices  = intSlices_a;
+        objRom->intPrevCrc = intPrevCrc_a;
+        snprintf(objRom->strPrevID, GUID_LEN, "%s", strPrevBlockID_a);
+        intOK = rolling_rom_index(objRom);
+    }
+
+    if (!intOK)
+    {
+        rolling_rom_close(objRom);
+        objRom = NULL;
+    }
+
+    return objRom;
+}
+
+void rolling_rom_close(ZTBRollingRom *objRom_a)
+{
+    if (objRom_a)
+    {
+        int intV;
+        for (intV = 0; intV < 256; intV++)
+        {
+            if (objRom_a->arrList[intV]) { free(objRom_a->arrList[intV]); }
+        }
+        free(objRom_a);
+    }
+}
+
+// --- Advance the ROM past a newly written block ---
+// byBlockHead_a holds the block's first min(size, ROM_ENTRY_SIZE) bytes, intBlockCrc_a
+// the CRC32 of the whole block file (the next block's prev_hash).
+// Returns 1 on success, 0 on failure (the object must then be discarded).
+int rolling_rom_advance(ZTBRollingRom *objRom_a, const uint8_t *byBlockHead_a,
+                        int intHeadLen_a, const char *strBlockID_a, uint32_t intBlockCrc_a)
+{
+    uint8_t arrSlice[ROM_ENTRY_SIZE];
+    memset(arrSlice, 0, ROM_ENTRY_SIZE);
+    memcpy(arrSlice, byBlockHead_a, intHeadLen_a < ROM_ENTRY_SIZE ? intHeadLen_a : ROM_ENTRY_SIZE);
+
+    int intSlices = objRom_a->intSlices;
+    int intDrop;
+    int intI;
+
+    // --- 1. Logical ROM and slab table ---
+    rom_shift_in(objRom_a->arrRom, &objRom_a->intSlices, arrSlice);
+
+    if (intSlices < MAX_HISTORY_BLOCKS)
+    {
+        intDrop = objRom_a->arrSlabPhys[ROM_SLABS - 1];
+        for (intI = ROM_SLABS - 1; intI > intSlices; intI--)
+        {
+            objRom_a->arrSlabPhys[intI] = objRom_a->arrSlabPhys[intI - 1];
+        }
+        objRom_a->arrSlabPhys[intSlices] = intDrop;
+    }
+    else
+    {
+        intDrop = objRom_a->arrSlabPhys[0];
+        for (intI = 0; intI < ROM_SLABS - 1; intI++)
+        {
+            objRom_a->arrSlabPhys[intI] = objRom_a->arrSlabPhys[intI + 1];
+        }
+        objRom_a->arrSlabPhys[ROM_SLABS - 1] = intDrop;
+    }
+
+    for (intI = 0; intI < ROM_SLABS; intI++)
+    {
+        objRom_a->arrPhysSlab[objRom_a->arrSlabPhys[intI]] = intI;
+    }
+
+    // --- 2. Re-index only the physical slab whose contents changed ---
+    int intOK = 1;
+    int intBase = intDrop * ROM_ENTRY_SIZE;
+    for (intI = 0; intI < ROM_ENTRY_SIZE && intOK; intI++)
+    {
+        uint16_t intPhys = (uint16_t)(intBase + intI);
+        uint8_t byOld    = objRom_a->arrPhys[intPhys];
+        if (byOld != arrSlice[intI])
+        {
+            rolling_rom_index_remove(objRom_a, intPhys, byOld);
+            objRom_a->arrPhys[intPhys] = arrSlice[intI];
+            intOK = rolling_rom_index_add(objRom_a, intPhys, arrSlice[intI]);
+        }
+    }
+
+    snprintf(objRom_a->strPrevID, GUID_LEN, "%s", strBlockID_a);
+    objRom_a->intPrevCrc = intBlockCrc_a;
+
+    return intOK;
+}
+
+// --- Encode intLen_a bytes against the rolling ROM (logical little-endian addresses) ---
+// Returns 1 on success, 0 if a byte value does not occur in the ROM.
+int rolling_rom_encode(ZTBRollingRom *objRom_a, const uint8_t *byData_a, size_t intLen_a,
+                       uint8_t *byOut_a)
+{
+    int intResult    = 1;
+    uint32_t intSeed = objRom_a->intSeed;
+    size_t intI;
+
+    for (intI = 0; intI < intLen_a && intResult; intI++)
+    {
+        uint8_t byVal = byData_a[intI];
+        if (objRom_a->arrCount[byVal] == 0)
+        {
+            fprintf(stderr, "Error: byte 0x%02X not in ROM\n", byVal);
+            intResult = 0;
+        }
+        else
+        {
+            intSeed = xorshift32(intSeed);
+            uint32_t intRandIdx = intSeed % (uint32_t)objRom_a->arrCount[byVal];
+            uint16_t intPhys    = objRom_a->arrList[byVal][intRandIdx];
+            uint32_t intAddr    = (uint32_t)objRom_a->arrPhysSlab[intPhys / ROM_ENTRY_SIZE] *
+                                  ROM_ENTRY_SIZE + (intPhys % ROM_ENTRY_SIZE);
+            byOut_a[intI * 2]     = (uint8_t)(intAddr & 0xFF);
+            byOut_a[intI * 2 + 1] = (uint8_t)((intAddr >> 8) & 0xFF);
+        }
+    }
+
+    objRom_a->intSeed = intSeed;
+    return intResult;
+}
+
+// --- Payload sources for the streaming block writer ---
+void source_from_memory(ZTBSource *objSrc_a, const uint8_t *byData_a, uint64_t intLen_a)
+{
+    objSrc_a->f      = NULL;
+    objSrc_a->byData = byData_a;
+    objSrc_a->intLen = intLen_a;
+    objSrc_a->intPos = 0;
+    objSrc_a->blnCompress = 0;
+}
+
+void source_from_file(ZTBSource *objSrc_a, FILE *f_a)
+{
+    objSrc_a->f      = f_a;
+    objSrc_a->byData = NULL;
+    objSrc_a->intLen = SOURCE_UNBOUNDED;
+    objSrc_a->intPos = 0;
+    objSrc_a->blnCompress = 0;
+}
+
+// Exactly intLen_a bytes from the current position of f_a (one record of a stream)
+void source_from_file_range(ZTBSource *objSrc_a, FILE *f_a, uint64_t intLen_a)
+{
+    objSrc_a->f      = f_a;
+    objSrc_a->byData = NULL;
+    objSrc_a->intLen = intLen_a;
+    objSrc_a->intPos = 0;
+    objSrc_a->blnCompress = 0;
+}
+
+// Returns the number of bytes read; 0 at end of source.
+size_t source_read(ZTBSource *objSrc_a, uint8_t *byBuf_a, size_t intMax_a)
+{
+    size_t intRead = 0;
+
+    if (objSrc_a->f)
+    {
+        uint64_t intLeft = objSrc_a->intLen - objSrc_a->intPos;
+        size_t intWant   = (intLeft < (uint64_t)intMax_a) ? (size_t)intLeft : intMax_a;
+        if (intWant > 0)
+        {
+            intRead = fread(byBuf_a, 1, intWant, objSrc_a->f);
+        }
+    }
+    else if (objSrc_a->byData && objSrc_a->intPos < objSrc_a->intLen)
+    {
+        uint64_t intLeft = objSrc_a->intLen - objSrc_a->intPos;
+        intRead          = (intLeft < (uint64_t)intMax_a) ? (size_t)intLeft : intMax_a;
+        memcpy(byBuf_a, objSrc_a->byData + objSrc_a->intPos, intRead);
+    }
+
+    objSrc_a->intPos += intRead;
+    return intRead;
+}
+
+// --- Build raw header (matches WriteRawHeader) ---
+void build_raw_header(uint8_t *byHeader_a, int intBlockType_a, int blnIsBranch_a,
+                      const char *strTrunkID_a, const char *strBlockID_a,
+                      const char *strPrevBlockID_a)
+{
+    memset(byHeader_a, 0, HEADER_RAW_SIZE);
+    byHeader_a[RAW_OFF_BLOCK_TYPE] = (uint8_t)intBlockType_a;
+    byHeader_a[RAW_OFF_BLOCK_VER]  = BLOCK_VERSION;
+    byHeader_a[RAW_OFF_IS_BRANCH]  = blnIsBranch_a ? 1 : 0;
+    write_fixed_string(byHeader_a, RAW_OFF_TRUNK_ID, 36, strTrunkID_a ? strTrunkID_a : NULL_GUID);
+    write_fixed_string(byHeader_a, RAW_OFF_BLOCK_ID, 36, strBlockID_a);
+    write_fixed_string(byHeader_a, RAW_OFF_PREV_ID,  36,
+                       strPrevBlockID_a ? strPrevBlockID_a : NULL_GUID);
+}
+
+// --- GUID helpers ---
+// 8-4-4-4-12 hex digits, either case
+int is_valid_guid(const char *strGuid_a)
+{
+    int intResult = (strGuid_a != NULL && strlen(strGuid_a) >= 36);
+    int intI;
+
+    for (intI = 0; intI < 36 && intResult; intI++)
+    {
+        char ch = strGuid_a[intI];
+        if (intI == 8 || intI == 13 || intI == 18 || intI == 23)
+        {
+            intResult = (ch == '-');
+        }
+        else
+        {
+            intResult = ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') ||
+                         (ch >= 'A' && ch <= 'F'));
+        }
+    }
+
+    return intResult;
+}
+
+// Random version 4 GUID (lower case, like Guid.NewGuid().ToString()). The 16 bytes come
+// from the OS (BCryptGenRandom, /dev/urandom); block IDs name files that are created
+// exclusively, so a repeat fails the write rather than replacing a block. Only if the OS
+// source is unavailable does it fall back to the XorShift32 state seeded from the clock.
+// The source and state are shared by every thread appending through its own handle.
+static uint32_t intGuidState = 0;
+#ifdef _WIN32
+#include <bcrypt.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "bcrypt.lib")
+#endif
+static SRWLOCK objGuidLock = SRWLOCK_INIT;
+#define GUID_LOCK()     AcquireSRWLockExclusive(&objGuidLock)
+#define GUID_UNLOCK()   ReleaseSRWLockExclusive(&objGuidLock)
+#else
+static FILE *fGuidRandom = NULL;
+static pthread_mutex_t objGuidLock = PTHREAD_MUTEX_INITIALIZER;
+#define GUID_LOCK()     pthread_mutex_lock(&objGuidLock)
+#define GUID_UNLOCK()   pthread_mutex_unlock(&objGuidLock)
+#endif
+
+// --- Fill arrBytes_a from the OS random source; 1 = ok (caller holds GUID_LOCK) ---
+static int os_random_bytes(uint8_t *arrBytes_a, size_t intLen_a)
+{
+#ifdef _WIN32
+    return BCryptGenRandom(NULL, arrBytes_a, (ULONG)intLen_a, BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0;
+#else
+    if (!fGuidRandom) { fGuidRandom = fopen("/dev/urandom", "rb"); }
+    return fGuidRandom && fread(arrBytes_a, 1, intLen_a, fGuidRandom) == intLen_a;
+#endif
+}
+
+void generate_guid(char *strOut_a)
+{
+    uint8_t arrBytes[16];
+    int intI;
+
+    GUID_LOCK();
+    if (!os_random_bytes(arrBytes, sizeof(arrBytes)))
+    {
+        uint32_t intState = intGuidState;
+        if (intState == 0)
+        {
+            intState = (uint32_t)time(NULL) ^ ((uint32_t)clock() << 16) ^
+                       (uint32_t)(uintptr_t)&arrBytes;
+            if (intState == 0) { intState = 0x2545F491; }
+        }
+
+        for (intI = 0; intI < 16; intI++)
+        {
+            intState       = xorshift32(intState);
+            arrBytes[intI] = (uint8_t)(intState >> 8);
+        }
+        intGuidState = intState;
+    }
+    GUID_UNLOCK();
+
+    arrBytes[6] = (uint8_t)((arrBytes[6] & 0x0F) | 0x40);
+    arrBytes[8] = (uint8_t)((arrBytes[8] & 0x3F) | 0x80);
+
+    snprintf(strOut_a, GUID_LEN,
+             "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+             arrBytes[0], arrBytes[1], arrBytes[2],  arrBytes[3],  arrBytes[4],  arrBytes[5],
+             arrBytes[6], arrBytes[7], arrBytes[8],  arrBytes[9],  arrBytes[10], arrBytes[11],
+             arrBytes[12], arrBytes[13], arrBytes[14], arrBytes[15]);
+}
+
+// --- 1 if <workdir>/<blockID>.ztb exists ---
+int block_exists(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+
+    FILE *f = fopen(strPath, "rb");
+    if (f) { fclose(f); }
+    return f != NULL;
+}
+
+// --- Walk back from strTipID_a collecting block IDs (newest first) ---
+// Stops after intMax_a blocks, at strStopID_a (included), at a truncation block
+// (excluded) or at the start of the chain. Returns the number collected, -1 on error.
+int collect_chain(const char *strWorkDir_a, const char *strTipID_a,
+                  const char *strStopID_a, int intMax_a, char (**arrIDs_a)[GUID_LEN])
+{
+    int intCount = 0;
+    int intCap   = 0;
+    int blnStop  = 0;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    char strCurrentID[GUID_LEN];
+    snprintf(strCurrentID, GUID_LEN, "%s", strTipID_a);
+
+    while (!blnStop && strcmp(strCurrentID, NULL_GUID) != 0 &&
+           (intMax_a <= 0 || intCount < intMax_a))
+    {
+        ZTBBlockHeader objHeader;
+        if (!block_header(strWorkDir_a, strCurrentID, &objHeader))
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", strCurrentID);
+            intCount = -1;
+            break;
+        }
+        if (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION) { break; }
+
+        if (intCount == intCap)
+        {
+            intCap = intCap ? intCap * 2 : 256;
+            char (*arrNew)[GUID_LEN] = (char (*)[GUID_LEN])realloc(arrIDs, (size_t)intCap * GUID_LEN);
+            if (!arrNew)
+            {
+                fprintf(stderr, "Error: Cannot allocate block list\n");
+                intCount = -1;
+                break;
+            }
+            arrIDs = arrNew;
+        }
+        snprintf(arrIDs[intCount++], GUID_LEN, "%s", strCurrentID);
+
+        blnStop = (strStopID_a && strcmp(strCurrentID, strStopID_a) == 0);
+        snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
+    }
+
+    if (intCount >= 0 && strStopID_a && !blnStop)
+    {
+        fprintf(stderr, "Error: '%s' is not an ancestor of '%s'\n", strStopID_a, strTipID_a);
+        intCount = -1;
+    }
+    if (intCount < 0 && arrIDs) { free(arrIDs); arrIDs = NULL; }
+
+    *arrIDs_a = arrIDs;
+    return intCount;
+}
+
+// --- Set of block IDs (open addressing, FNV-1a) ---
+static uint32_t idset_hash(const char *strID_a)
+{
+    uint32_t intHash = 2166136261u;
+    while (*strID_a)
+    {
+        intHash = (intHash ^ (uint8_t)*strID_a++) * 16777619u;
+    }
+    return intHash;
+}
+
+int idset_init(ZTBIdSet *objSet_a, int intExpected_a)
+{
+    int intCap = 64;
+    while (intCap < intExpected_a * 2) { intCap *= 2; }
+
+    objSet_a->intCount = 0;
+    objSet_a->intCap   = intCap;
+    objSet_a->arrSlots = (char (*)[GUID_LEN])calloc((size_t)intCap, GUID_LEN);
+    return objSet_a->arrSlots != NULL;
+}
+
+static int idset_find(const ZTBIdSet *objSet_a, const char *strID_a)
+{
+    int intSlot = (int)(idset_hash(strID_a) & (uint32_t)(objSet_a->intCap - 1));
+    while (objSet_a->arrSlots[intSlot][0] && strcmp(objSet_a->arrSlots[intSlot], strID_a) != 0)
+    {
+        intSlot = (intSlot + 1) & (objSet_a->intCap - 1);
+    }
+    return intSlot;
+}
+
+int idset_has(const ZTBIdSet *objSet_a, const char *strID_a)
+{
+    return objSet_a->arrSlots[idset_find(objSet_a, strID_a)][0] != 0;
+}
+
+int idset_add(ZTBIdSet *objSet_a, const char *strID_a)
+{
+    int intResult = 1;
+
+    // Keep the table at most half full
+    if ((objSet_a->intCount + 1) * 2 > objSet_a->intCap)
+    {
+        ZTBIdSet objBigger;
+        objBigger.intCount = 0;
+        objBigger.intCap   = objSet_a->intCap * 2;
+        objBigger.arrSlots = (char (*)[GUID_LEN])calloc((size_t)objBigger.intCap, GUID_LEN);
+        if (!objBigger.arrSlots)
+        {
+            intResult = -1;
+        }
+        else
+        {
+            int intI;
+            for (intI = 0; intI < objSet_a->intCap; intI++)
+            {
+                if (objSet_a->arrSlots[intI][0])
+                {
+                    memcpy(objBigger.arrSlots[idset_find(&objBigger, objSet_a->arrSlots[intI])],
+                           objSet_a->arrSlots[intI], GUID_LEN);
+                    objBigger.intCount++;
+                }
+            }
+            free(objSet_a->arrSlots);
+            *objSet_a = objBigger;
+        }
+    }
+
+    if (intResult == 1)
+    {
+        int intSlot = idset_find(objSet_a, strID_a);
+        if (objSet_a->arrSlots[intSlot][0])
+        {
+            intResult = 0;
+        }
+        else
+        {
+            snprintf(objSet_a->arrSlots[intSlot], GUID_LEN, "%s", strID_a);
+            objSet_a->intCount++;
+        }
+    }
+
+    return intResult;
+}
+
+void idset_free(ZTBIdSet *objSet_a)
+{
+    if (objSet_a->arrSlots) { free(objSet_a->arrSlots); }
+    objSet_a->arrSlots = NULL;
+    objSet_a->intCount = 0;
+}
+
+// --- Plan runs of consecutive blocks covering every tip's chain, each block once ---
+// Each tip is walked back over raw headers until the start of the chain, a truncation
+// block (excluded) or a block an earlier tip already took, so the blocks shared by
+// branches below a fork go with the first tip only. Every walk becomes one segment,
+// stored oldest first in *arrIDs_a. Segments are cut into runs short enough to keep
+// intWorkers_a workers busy and long enough that the rolling ROM opened at the start
+// of each run (rolling_rom_open_before) is paid for by the blocks decoded after it.
+// Returns the number of blocks, -1 on error.
+int plan_runs(const char *strWorkDir_a, char (*arrTips_a)[GUID_LEN], int intTips_a,
+              int intWorkers_a, char (**arrIDs_a)[GUID_LEN], ZTBRun **arrRuns_a, int *intRuns_a)
+{
+    int intCount  = 0;
+    int intCap    = 0;
+    int intOK     = 1;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    ZTBRun *arrSegs = (ZTBRun*)malloc((size_t)(intTips_a + 1) * sizeof(ZTBRun));
+    ZTBRun *arrRuns = NULL;
+    int intSegs   = 0;
+    ZTBIdSet objTaken;
+
+    objTaken.arrSlots = NULL;
+    *intRuns_a        = 0;
+    if (!arrSegs || !idset_init(&objTaken, 1024)) { intOK = 0; }
+
+    int intT;
+    for (intT = 0; intT < intTips_a && intOK; intT++)
+    {
+        int intFirst = intCount;
+        char strCurrentID[GUID_LEN];
+        snprintf(strCurrentID, GUID_LEN, "%s", arrTips_a[intT]);
+
+        // --- 1. Walk back, newest first ---
+        while (intOK && strcmp(strCurrentID, NULL_GUID) != 0 &&
+               !idset_has(&objTaken, strCurrentID))
+        {
+            ZTBBlockHeader objHeader;
+            if (!block_header(strWorkDir_a, strCurrentID, &objHeader))
+            {
+                fprintf(stderr, "Error: Cannot load block '%s'\n", strCurrentID);
+                intOK = 0;
+                break;
+            }
+            if (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION) { break; }
+
+            if (intCount == intCap)
+            {
+                intCap = intCap ? intCap * 2 : 256;
+                char (*arrNew)[GUID_LEN] = (char (*)[GUID_LEN])realloc(arrIDs, (size_t)intCap * GUID_LEN);
+                if (!arrNew) { intOK = 0; break; }
+                arrIDs = arrNew;
+            }
+            if (idset_add(&objTaken, strCurrentID) < 0) { intOK = 0; break; }
+            snprintf(arrIDs[intCount++], GUID_LEN, "%s", strCurrentID);
+            snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
+        }
+
+        // --- 2. Oldest first ---
+        int intLo = intFirst;
+        int intHi = intCount - 1;
+        while (intLo < intHi)
+        {
+            char strSwap[GUID_LEN];
+            memcpy(strSwap, arrIDs[intLo], GUID_LEN);
+            memcpy(arrIDs[intLo++], arrIDs[intHi], GUID_LEN);
+            memcpy(arrIDs[intHi--], strSwap, GUID_LEN);
+        }
+        if (intOK && intCount > intFirst)
+        {
+            arrSegs[intSegs].intFirst = intFirst;
+            arrSegs[intSegs].intCount = intCount - intFirst;
+            intSegs++;
+        }
+    }
+
+    // --- 3. Cut the segments into runs ---
+    int intRunLen = intCount / ((intWorkers_a > 0 ? intWorkers_a : 1) * 4);
+    if (intRunLen < RUN_BLOCKS_MIN) { intRunLen = RUN_BLOCKS_MIN; }
+    if (intRunLen > RUN_BLOCKS_MAX) { intRunLen = RUN_BLOCKS_MAX; }
+
+    if (intOK)
+    {
+        int intMaxRuns = intSegs + intCount / intRunLen + 1;
+        arrRuns = (ZTBRun*)malloc((size_t)intMaxRuns * sizeof(ZTBRun));
+        if (!arrRuns) { intOK = 0; }
+    }
+
+    int intS;
+    for (intS = 0; intS < intSegs && intOK; intS++)
+    {
+        int intAt  = arrSegs[intS].intFirst;
+        int intEnd = intAt + arrSegs[intS].intCount;
+        while (intAt < intEnd)
+        {
+            ZTBRun *objRun   = &arrRuns[(*intRuns_a)++];
+            objRun->intFirst = intAt;
+            objRun->intCount = (intEnd - intAt < intRunLen) ? intEnd - intAt : intRunLen;
+            intAt += objRun->intCount;
+        }
+    }
+
+    if (arrSegs) { free(arrSegs); }
+    if (objTaken.arrSlots) { idset_free(&objTaken); }
+    if (!intOK)
+    {
+        if (arrIDs)  { free(arrIDs); }
+        if (arrRuns) { free(arrRuns); }
+        arrIDs     = NULL;
+        arrRuns    = NULL;
+        intCount   = -1;
+        *intRuns_a = 0;
+    }
+
+    *arrIDs_a  = arrIDs;
+    *arrRuns_a = arrRuns;
+    return intCount;
+}
+
+static void put_uint32_le(uint8_t *byOut_a, uint32_t intValue_a)
+{
+    byOut_a[0] = (uint8_t)(intValue_a & 0xFF);
+    byOut_a[1] = (uint8_t)((intValue_a >> 8)  & 0xFF);
+    byOut_a[2] = (uint8_t)((intValue_a >> 16) & 0xFF);
+    byOut_a[3] = (uint8_t)((intValue_a >> 24) & 0xFF);
+}
+
+static void put_uint64_le(uint8_t *byOut_a, uint64_t intValue_a)
+{
+    put_uint32_le(byOut_a,     (uint32_t)(intValue_a & 0xFFFFFFFF));
+    put_uint32_le(byOut_a + 4, (uint32_t)(intValue_a >> 32));
+}
+
+static uint64_t get_uint64_le(const uint8_t *byIn_a)
+{
+    return (uint64_t)get_uint32_le(byIn_a) | ((uint64_t)get_uint32_le(byIn_a + 4) << 32);
+}
+
+// --- Encode one raw chunk, append it to the block file and fold it into the CRCs ---
+static int write_encoded_chunk(FILE *fOut_a, ZTBRollingRom *objRom_a, const uint8_t *byRaw_a,
+                               size_t intLen_a, uint8_t *byEncBuf_a, uint32_t *intHash_a,
+                               uint32_t *intBodyCrc_a)
+{
+    int intResult = rolling_rom_encode(objRom_a, byRaw_a, intLen_a, byEncBuf_a);
+    if (intResult)
+    {
+        *intHash_a    = crc32_update(*intHash_a, byRaw_a, intLen_a);
+        *intBodyCrc_a = crc32_update(*intBodyCrc_a, byEncBuf_a, intLen_a * 2);
+        if (fwrite(byEncBuf_a, 1, intLen_a * 2, fOut_a) != intLen_a * 2)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+    }
+    return intResult;
+}
+
+// --- Durability helpers ---
+static uint64_t now_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec objTs;
+    clock_gettime(CLOCK_MONOTONIC, &objTs);
+    return (uint64_t)objTs.tv_sec * 1000 + (uint64_t)(objTs.tv_nsec / 1000000);
+#endif
+}
+
+// fsync an open stream (flushes the stdio buffer first)
+int sync_stream(FILE *f_a)
+{
+    int intResult = (fflush(f_a) == 0);
+#ifdef _WIN32
+    if (intResult) { intResult = (_commit(_fileno(f_a)) == 0); }
+#else
+    if (intResult) { intResult = (fsync(fileno(f_a)) == 0); }
+#endif
+    return intResult;
+}
+
+// fsync a file by path (used for tmp files already closed by write_block)
+static int sync_path(const char *strPath_a)
+{
+    int intResult = 0;
+    FILE *f = fopen(strPath_a, "ab");
+    if (f)
+    {
+        intResult = sync_stream(f);
+        if (fclose(f) != 0) { intResult = 0; }
+    }
+    return intResult;
+}
+
+// fsync the directory so renames into it survive a crash. Windows has no directory
+// fsync; renames there use MOVEFILE_WRITE_THROUGH instead (see rename_block_file).
+static int sync_dir(const char *strWorkDir_a)
+{
+    int intResult = 1;
+#ifndef _WIN32
+    int fd = open(strWorkDir_a, O_RDONLY);
+    if (fd < 0)
+    {
+        intResult = 0;
+    }
+    else
+    {
+        // Some filesystems cannot fsync a directory; their renames are already durable
+        if (fsync(fd) != 0 && errno != EINVAL) { intResult = 0; }
+        close(fd);
+    }
+#else
+    (void)strWorkDir_a;
+#endif
+    return intResult;
+}
+
+// --- Rename a finished tmp over its final path (write-through if blnDurable_a) ---
+int rename_block_file(const char *strTmpPath_a, const char *strOutPath_a, int blnDurable_a)
+{
+    int intResult = 1;
+#ifdef _WIN32
+    DWORD intFlags = MOVEFILE_REPLACE_EXISTING | (blnDurable_a ? MOVEFILE_WRITE_THROUGH : 0);
+    intResult = MoveFileExA(strTmpPath_a, strOutPath_a, intFlags) ? 1 : 0;
+#else
+    (void)blnDurable_a;
+    intResult = (rename(strTmpPath_a, strOutPath_a) == 0);
+#endif
+    if (!intResult) { fprintf(stderr, "Error: Cannot rename tmp\n"); }
+    return intResult;
+}
+
+// --- Create a block's tmp file for writing; fails if it already exists ---
+// Two writers given one block ID cannot share a tmp: the second fails here rather than
+// truncating the first's. A tmp left by a crash holds its ID until it is removed.
+FILE* create_block_tmp(const char *strTmpPath_a)
+{
+    FILE *fResult = NULL;
+#ifdef _WIN32
+    int fd = _open(strTmpPath_a, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = open(strTmpPath_a, O_WRONLY | O_CREAT | O_EXCL, 0666);
+#endif
+
+    if (fd < 0)
+    {
+        if (errno == EEXIST) { fprintf(stderr, "Error: %s exists (another writer, or left by a crash)\n", strTmpPath_a); }
+    }
+    else
+    {
+#ifdef _WIN32
+        fResult = _fdopen(fd, "wb");
+        if (!fResult) { _close(fd); }
+#else
+        fResult = fdopen(fd, "wb");
+        if (!fResult) { close(fd); }
+#endif
+    }
+
+    return fResult;
+}
+
+// --- Rename a finished block tmp into place, unless a block file of its ID exists ---
+// POSIX: link() then unlink(), which fails atomically on an existing name; where the
+// filesystem has no hard links, an existence check then rename(). Windows: MoveFileEx
+// without MOVEFILE_REPLACE_EXISTING. On a collision the tmp is removed.
+int rename_new_block_file(const char *strTmpPath_a, const char *strOutPath_a, int blnDurable_a)
+{
+    int intResult = 1;
+    int blnExists = 0;
+#ifdef _WIN32
+    DWORD intFlags = blnDurable_a ? MOVEFILE_WRITE_THROUGH : 0;
+    if (!MoveFileExA(strTmpPath_a, strOutPath_a, intFlags))
+    {
+        DWORD intError = GetLastError();
+        blnExists = (intError == ERROR_ALREADY_EXISTS || intError == ERROR_FILE_EXISTS);
+        intResult = 0;
+    }
+#else
+    (void)blnDurable_a;
+    if (link(strTmpPath_a, strOutPath_a) == 0)
+    {
+        unlink(strTmpPath_a);
+    }
+    else if (errno == EEXIST)
+    {
+        blnExists = 1;
+        intResult = 0;
+    }
+    else if (errno == EPERM || errno == ENOTSUP || errno == EOPNOTSUPP || errno == ENOSYS)
+    {
+        struct stat objStat;
+        if (stat(strOutPath_a, &objStat) == 0) { blnExists = 1; intResult = 0; }
+        else                                   { intResult = (rename(strTmpPath_a, strOutPath_a) == 0); }
+    }
+    else
+    {
+        intResult = 0;
+    }
+#endif
+
+    if (blnExists)
+    {
+        fprintf(stderr, "Error: Block file already exists: %s\n", strOutPath_a);
+        remove(strTmpPath_a);
+    }
+    else if (!intResult)
+    {
+        fprintf(stderr, "Error: Cannot rename tmp\n");
+    }
+    return intResult;
+}
+
+static void block_paths(const char *strWorkDir_a, const char *strBlockID_a,
+                        char *strOutPath_a, char *strTmpPath_a)
+{
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strOutPath_a);
+    snprintf(strTmpPath_a, FILENAME_MAX + 4, "%s.tmp", strOutPath_a);
+}
+
+void sync_init(ZTBSync *objSync_a)
+{
+    memset(objSync_a, 0, sizeof(ZTBSync));
+    objSync_a->intPolicy   = SYNC_NONE;
+    objSync_a->intGroupMax = SYNC_GROUP_MAX;
+    objSync_a->intGroupMs  = SYNC_GROUP_MS;
+}
+
+// --- Parse "none", "block" or "group[:count[:ms]]" ---
+int sync_parse(ZTBSync *objSync_a, const char *strSpec_a)
+{
+    int intResult = 1;
+
+    if (strcmp(strSpec_a, "none") == 0)
+    {
+        objSync_a->intPolicy = SYNC_NONE;
+    }
+    else if (strcmp(strSpec_a, "block") == 0)
+    {
+        objSync_a->intPolicy = SYNC_BLOCK;
+    }
+    else if (strncmp(strSpec_a, "group", 5) == 0 &&
+             (strSpec_a[5] == '\0' || strSpec_a[5] == ':'))
+    {
+        objSync_a->intPolicy = SYNC_GROUP;
+        if (strSpec_a[5] == ':')
+        {
+            int intMax = 0;
+            int intMs  = objSync_a->intGroupMs;
+            int intGot = sscanf(strSpec_a + 6, "%d:%d", &intMax, &intMs);
+            if (intGot < 1 || intMax < 1 || intMs < 0) { intResult = 0; }
+            else
+            {
+                objSync_a->intGroupMax = intMax;
+                objSync_a->intGroupMs  = intMs;
+            }
+        }
+    }
+    else
+    {
+        intResult = 0;
+    }
+
+    if (!intResult)
+    {
+        fprintf(stderr, "Error: Bad sync policy '%s' (none, block, group[:count[:ms]])\n", strSpec_a);
+    }
+    return intResult;
+}
+
+// --- Strip a trailing "-sync <policy>" from the command line; the policy or NULL ---
+const char* sync_option(int *argc_a, char *argv_a[])
+{
+    const char *strResult = NULL;
+
+    if (*argc_a > 2 && strcmp(argv_a[*argc_a - 2], "-sync") == 0)
+    {
+        strResult = argv_a[*argc_a - 1];
+        *argc_a  -= 2;
+    }
+    return strResult;
+}
+
+// --- Strip and parse a trailing "-sync <policy>" ---
+// Returns 1 if absent or valid, 0 if the policy is invalid.
+int sync_take_option(ZTBSync *objSync_a, int *argc_a, char *argv_a[])
+{
+    const char *strPolicy = sync_option(argc_a, argv_a);
+    return !strPolicy || sync_parse(objSync_a, strPolicy);
+}
+
+// --- Group commit timer: commits the group once its window closes, with or without a next block ---
+// Everything in the ZTBSync that the thread reads or changes is under lockSync once the
+// timer exists; before that only the caller's thread touches it.
+struct ZTBSyncTimer
+{
+    ZTBThread objThread;
+    ZTBMutex  lockSync;
+    ZTBCond   condSync;                     // signalled on a new group and on stop
+    int       blnStop;
+    char      strWorkDir[FILENAME_MAX];
+};
+
+static void sync_lock(ZTBSync *objSync_a)
+{
+    if (objSync_a->objTimer) { mutex_lock(&objSync_a->objTimer->lockSync); }
+}
+
+static void sync_unlock(ZTBSync *objSync_a)
+{
+    if (objSync_a->objTimer) { mutex_unlock(&objSync_a->objTimer->lockSync); }
+}
+
+// --- Group commit: fsync every pending tmp, rename them in order, fsync the directory ---
+// A failure part way leaves the blocks already renamed in place (a prefix of the group,
+// made durable if the directory syncs) and keeps the rest pending as .tmp for the next
+// commit. After a collision (which removes that block's tmp) the rest follow a block
+// that is not there, so they are left as .tmp but not kept. Locked by the caller.
+static int sync_commit_group(ZTBSync *objSync_a, const char *strWorkDir_a)
+{
+    int intResult = 1;
+    int intSynced = 0;
+    int intDone   = 0;
+    int intKeep   = 0;
+    int intI;
+    char strOutPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+
+    for (intSynced = 0; intSynced < objSync_a->intPending && intResult; intSynced++)
+    {
+        block_paths(strWorkDir_a, objSync_a->arrPending[intSynced], strOutPath, strTmpPath);
+        if (!sync_path(strTmpPath))
+        {
+            fprintf(stderr, "Error: Cannot sync %s\n", strTmpPath);
+            intResult = 0;
+        }
+    }
+
+    // Rename in chain order, so a crash part way leaves a prefix of the group visible
+    while (intResult && intDone < objSync_a->intPending)
+    {
+        block_paths(strWorkDir_a, objSync_a->arrPending[intDone], strOutPath, strTmpPath);
+        intResult = rename_new_block_file(strTmpPath, strOutPath, 1);
+        if (intResult) { intDone++; }
+    }
+
+    if (intDone > 0)
+    {
+        if (!sync_dir(strWorkDir_a))
+        {
+            fprintf(stderr, "Error: Cannot sync directory %s\n", strWorkDir_a);
+            intResult = 0;
+        }
+        else if (objSync_a->fnDurable)
+        {
+            for (intI = 0; intI < intDone; intI++) { objSync_a->fnDurable(objSync_a->arrPending[intI]); }
+        }
+    }
+
+    // --- Keep the tail that did not make it, unless its first block's tmp is gone ---
+    if (intDone < objSync_a->intPending)
+    {
+        block_paths(strWorkDir_a, objSync_a->arrPending[intDone], strOutPath, strTmpPath);
+        if (path_exists(strTmpPath))
+        {
+            intKeep = objSync_a->intPending - intDone;
+            memmove(objSync_a->arrPending, objSync_a->arrPending + intDone, (size_t)intKeep * GUID_LEN);
+            fprintf(stderr, "Error: %d block(s) still pending, from %s\n", intKeep, objSync_a->arrPending[0]);
+        }
+        else if (intDone + 1 < objSync_a->intPending)
+        {
+            fprintf(stderr, "Error: %d block(s) after %s left as .tmp (they follow a block that was not written)\n",
+                    objSync_a->intPending - intDone - 1, objSync_a->arrPending[intDone]);
+        }
+    }
+    objSync_a->intPending = intKeep;
+
+    return intResult;
+}
+
+// --- Commit the pending group now; 0 if it, or a timer commit since the last call, failed ---
+int sync_commit(ZTBSync *objSync_a, const char *strWorkDir_a)
+{
+    int intResult = 1;
+
+    if (objSync_a)
+    {
+        sync_lock(objSync_a);
+        if (objSync_a->intPending > 0) { intResult = sync_commit_group(objSync_a, strWorkDir_a); }
+        if (objSync_a->blnFailed)
+        {
+            objSync_a->blnFailed = 0;
+            intResult = 0;
+        }
+        sync_unlock(objSync_a);
+    }
+
+    return intResult;
+}
+
+// --- Timer thread: sleep until the oldest pending block's window closes, then commit ---
+// A failed commit is not retried here (the tail stays pending for the caller's commit).
+static void sync_timer_run(void *objArg_a)
+{
+    ZTBSync *objSync = (ZTBSync*)objArg_a;
+    struct ZTBSyncTimer *objTimer = objSync->objTimer;
+
+    mutex_lock(&objTimer->lockSync);
+    while (!objTimer->blnStop)
+    {
+        int64_t intWait = -1;               // nothing to time: sleep until signalled
+
+        if (objSync->intPending > 0 && !objSync->blnFailed)
+        {
+            uint64_t intDue = objSync->intFirstPendingMs + (uint64_t)objSync->intGroupMs;
+            uint64_t intNow = now_ms();
+
+            if (intNow < intDue) { intWait = (int64_t)(intDue - intNow); }
+            else
+            {
+                if (!sync_commit_group(objSync, objTimer->strWorkDir)) { objSync->blnFailed = 1; }
+                intWait = 0;
+            }
+        }
+
+        if (intWait != 0) { cond_wait_ms(&objTimer->condSync, &objTimer->lockSync, intWait); }
+    }
+    mutex_unlock(&objTimer->lockSync);
+}
+
+// --- Start the timer thread (caller's thread, before any other thread sees the ZTBSync) ---
+static void sync_timer_start(ZTBSync *objSync_a)
+{
+    struct ZTBSyncTimer *objTimer = (struct ZTBSyncTimer*)calloc(1, sizeof(struct ZTBSyncTimer));
+
+    if (objTimer)
+    {
+        mutex_init(&objTimer->lockSync);
+        cond_init(&objTimer->condSync);
+        objSync_a->objTimer = objTimer;
+        if (!thread_start(&objTimer->objThread, sync_timer_run, objSync_a))
+        {
+            objSync_a->objTimer = NULL;
+            cond_destroy(&objTimer->condSync);
+            mutex_destroy(&objTimer->lockSync);
+            free(objTimer);
+            objTimer = NULL;
+        }
+    }
+
+    if (!objTimer)
+    {
+        fprintf(stderr, "Warning: No group commit timer; pending blocks wait for the next append or commit\n");
+    }
+}
+
+void sync_free(ZTBSync *objSync_a)
+{
+    struct ZTBSyncTimer *objTimer = objSync_a->objTimer;
+
+    if (objTimer)
+    {
+        mutex_lock(&objTimer->lockSync);
+        objTimer->blnStop = 1;
+        cond_signal(&objTimer->condSync);
+        mutex_unlock(&objTimer->lockSync);
+
+        thread_join(objTimer->objThread);
+        cond_destroy(&objTimer->condSync);
+        mutex_destroy(&objTimer->lockSync);
+        free(objTimer);
+        objSync_a->objTimer = NULL;
+    }
+    if (objSync_a->arrPending) { free(objSync_a->arrPending); }
+    objSync_a->arrPending = NULL;
+    objSync_a->intPending = 0;
+}
+
+// --- Queue a written tmp for the next group commit; commits if the group is full or old ---
+// The first block of a group wakes the timer thread, which commits it when the window closes.
+static int sync_defer(ZTBSync *objSync_a, const char *strWorkDir_a, const char *strBlockID_a)
+{
+    int intResult = 1;
+
+    if (!objSync_a->arrPending)
+    {
+        objSync_a->arrPending = (char (*)[GUID_LEN])malloc((size_t)objSync_a->intGroupMax * GUID_LEN);
+        if (!objSync_a->arrPending)
+        {
+            fprintf(stderr, "Error: Cannot allocate sync group\n");
+            intResult = 0;
+        }
+        else if (objSync_a->intGroupMs > 0)
+        {
+            sync_timer_start(objSync_a);
+        }
+    }
+
+    if (intResult)
+    {
+        sync_lock(objSync_a);
+        if (objSync_a->objTimer) { snprintf(objSync_a->objTimer->strWorkDir, FILENAME_MAX, "%s", strWorkDir_a); }
+
+        if (objSync_a->intPending == 0)
+        {
+            objSync_a->intFirstPendingMs = now_ms();
+            if (objSync_a->objTimer) { cond_signal(&objSync_a->objTimer->condSync); }
+        }
+        // A tail kept by a failed commit can fill the group: try it again first
+        if (objSync_a->intPending >= objSync_a->intGroupMax) { sync_commit_group(objSync_a, strWorkDir_a); }
+        if (objSync_a->intPending >= objSync_a->intGroupMax)
+        {
+            fprintf(stderr, "Error: Sync group is full of blocks that cannot be committed\n");
+            intResult = 0;
+        }
+        else
+        {
+            snprintf(objSync_a->arrPending[objSync_a->intPending++], GUID_LEN, "%s", strBlockID_a);
+        }
+
+        if (intResult &&
+            (objSync_a->intPending >= objSync_a->intGroupMax ||
+             now_ms() - objSync_a->intFirstPendingMs >= (uint64_t)objSync_a->intGroupMs))
+        {
+            intResult = sync_commit_group(objSync_a, strWorkDir_a);
+        }
+        sync_unlock(objSync_a);
+    }
+
+    return intResult;
+}
+
+// --- LZ4 block codec ---
+// A greedy single-probe matcher over a 4096-entry hash table: well short of lz4 -9 on
+// ratio, but it keeps to the block format, so any LZ4 decoder reads what it writes.
+#define LZ4_HASH_BITS       12
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5               // the block must end with 5 literals ...
+#define LZ4_MATCH_LIMIT     12              // ... and no match may start in the last 12 bytes
+#define LZ4_MAX_OFFSET      65535
+
+static uint32_t lz4_read32(const uint8_t *byIn_a)
+{
+    return (uint32_t)byIn_a[0] | ((uint32_t)byIn_a[1] << 8) |
+           ((uint32_t)byIn_a[2] << 16) | ((uint32_t)byIn_a[3] << 24);
+}
+
+// --- Emit one sequence: token, literals, and (if intOffset_a) the match ---
+// Returns the new output position, or -1 if it would not fit.
+static int lz4_put_sequence(uint8_t *byDst_a, int intOut_a, int intDstCap_a,
+                            const uint8_t *byLit_a, int intLitLen_a, int intOffset_a,
+                            int intMatchLen_a)
+{
+    int intNeed = 1 + intLitLen_a + intLitLen_a / 255 + 1 +
+                  (intOffset_a ? 2 + intMatchLen_a / 255 + 1 : 0);
+    if (intOut_a < 0 || intOut_a + intNeed > intDstCap_a) { return -1; }
+
+    int intMatchCode = intMatchLen_a - LZ4_MIN_MATCH;
+    uint8_t *byToken = byDst_a + intOut_a++;
+    *byToken = (uint8_t)((intLitLen_a < 15 ? intLitLen_a : 15) << 4);
+
+    if (intLitLen_a >= 15)
+    {
+        int intLeft = intLitLen_a - 15;
+        for (; intLeft >= 255; intLeft -= 255) { byDst_a[intOut_a++] = 255; }
+        byDst_a[intOut_a++] = (uint8_t)intLeft;
+    }
+    memcpy(byDst_a + intOut_a, byLit_a, (size_t)intLitLen_a);
+    intOut_a += intLitLen_a;
+
+    if (intOffset_a)
+    {
+        byDst_a[intOut_a++] = (uint8_t)(intOffset_a & 0xFF);
+        byDst_a[intOut_a++] = (uint8_t)(intOffset_a >> 8);
+        *byToken |= (uint8_t)(intMatchCode < 15 ? intMatchCode : 15);
+        if (intMatchCode >= 15)
+        {
+            int intLeft = intMatchCode - 15;
+            for (; intLeft >= 255; intLeft -= 255) { byDst_a[intOut_a++] = 255; }
+            byDst_a[intOut_a++] = (uint8_t)intLeft;
+        }
+    }
+    return intOut_a;
+}
+
+int lz4_compress(const uint8_t *bySrc_a, int intSrcLen_a, uint8_t *byDst_a, int intDstCap_a)
+{
+    int arrTable[1 << LZ4_HASH_BITS];
+    int intPos    = 0;
+    int intAnchor = 0;
+    int intOut    = 0;
+    int intMisses = 0;
+    int intLimit  = intSrcLen_a - LZ4_MATCH_LIMIT;
+    int intI;
+
+    for (intI = 0; intI < (1 << LZ4_HASH_BITS); intI++) { arrTable[intI] = -1; }
+
+    // --- Find a match at each position; skip faster through data that has none ---
+    while (intPos < intLimit && intOut >= 0)
+    {
+        uint32_t intWord = lz4_read32(bySrc_a + intPos);
+        uint32_t intSlot = (intWord * 2654435761U) >> (32 - LZ4_HASH_BITS);
+        int intCand      = arrTable[intSlot];
+        arrTable[intSlot] = intPos;
+
+        if (intCand >= 0 && intPos - intCand <= LZ4_MAX_OFFSET &&
+            lz4_read32(bySrc_a + intCand) == intWord)
+        {
+            int intEnd = intPos + LZ4_MIN_MATCH;
+            int intMax = intSrcLen_a - LZ4_LAST_LITERALS;
+            while (intEnd < intMax && bySrc_a[intEnd] == bySrc_a[intCand + (intEnd - intPos)]) { intEnd++; }
+
+            intOut    = lz4_put_sequence(byDst_a, intOut, intDstCap_a, bySrc_a + intAnchor,
+                                         intPos - intAnchor, intPos - intCand, intEnd - intPos);
+            intPos    = intEnd;
+            intAnchor = intEnd;
+            intMisses = 0;
+        }
+        else
+        {
+            intPos += 1 + (intMisses++ >> 6);
+        }
+    }
+
+    // --- The rest goes out as literals ---
+    intOut = lz4_put_sequence(byDst_a, intOut, intDstCap_a, bySrc_a + intAnchor,
+                              intSrcLen_a - intAnchor, 0, 0);
+    return intOut < 0 ? 0 : intOut;
+}
+
+int lz4_decompress(const uint8_t *bySrc_a, int intSrcLen_a, uint8_t *byDst_a, int intDstLen_a)
+{
+    int intResult = 1;
+    int intIn     = 0;
+    int intOut    = 0;
+
+    while (intResult && intIn < intSrcLen_a)
+    {
+        int intToken  = bySrc_a[intIn++];
+        int intLitLen = intToken >> 4;
+        int intByte   = 255;
+
+        if (intLitLen == 15)
+        {
+            while (intByte == 255 && intIn < intSrcLen_a) { intByte = bySrc_a[intIn++]; intLitLen += intByte; }
+            if (intByte == 255) { intResult = 0; }
+        }
+        if (!intResult || intLitLen > intSrcLen_a - intIn || intLitLen > intDstLen_a - intOut)
+        {
+            intResult = 0;
+            break;
+        }
+        memcpy(byDst_a + intOut, bySrc_a + intIn, (size_t)intLitLen);
+        intIn  += intLitLen;
+        intOut += intLitLen;
+
+        if (intIn == intSrcLen_a) { break; }       // the last sequence has no match
+
+        // --- Match: offset back into what is already out, copied forwards (may overlap) ---
+        int intOffset   = 0;
+        int intMatchLen = intToken & 15;
+        if (intSrcLen_a - intIn < 2) { intResult = 0; break; }
+        intOffset = bySrc_a[intIn] | (bySrc_a[intIn + 1] << 8);
+        intIn    += 2;
+
+        if (intMatchLen == 15)
+        {
+            intByte = 255;
+            while (intByte == 255 && intIn < intSrcLen_a) { intByte = bySrc_a[intIn++]; intMatchLen += intByte; }
+            if (intByte == 255) { intResult = 0; break; }
+        }
+        intMatchLen += LZ4_MIN_MATCH;
+
+        if (intOffset == 0 || intOffset > intOut || intMatchLen > intDstLen_a - intOut)
+        {
+            intResult = 0;
+        }
+        else if (intOffset >= intMatchLen)
+        {
+            memcpy(byDst_a + intOut, byDst_a + intOut - intOffset, (size_t)intMatchLen);
+            intOut += intMatchLen;
+        }
+        else
+        {
+            int intI;
+            for (intI = 0; intI < intMatchLen; intI++, intOut++) { byDst_a[intOut] = byDst_a[intOut - intOffset]; }
+        }
+    }
+
+    return intResult && intOut == intDstLen_a;
+}
+
+// --- Compress one chunk into a frame (see ENC_FLAG_LZ4); returns the frame length ---
+// byFrame_a holds LZ4_FRAME_HEADER + intLen_a bytes: a chunk that does not shrink is
+// stored as it is.
+static size_t lz4_frame(const uint8_t *byRaw_a, size_t intLen_a, uint8_t *byFrame_a)
+{
+    int intStored = lz4_compress(byRaw_a, (int)intLen_a, byFrame_a + LZ4_FRAME_HEADER,
+                                 (int)intLen_a - 1);
+    if (intStored == 0)
+    {
+        memcpy(byFrame_a + LZ4_FRAME_HEADER, byRaw_a, intLen_a);
+        intStored = (int)intLen_a;
+    }
+    put_uint32_le(byFrame_a,     (uint32_t)intLen_a);
+    put_uint32_le(byFrame_a + 4, (uint32_t)intStored);
+    return LZ4_FRAME_HEADER + (size_t)intStored;
+}
+
+// --- Decompression of a stored payload fed in arbitrary pieces ---
+typedef struct
+{
+    ZTBChunkFn fnChunk;                     // decompressed data goes here (may be NULL)
+    void      *objCtx;
+    uint8_t    arrHeader[LZ4_STREAM_HEADER];
+    int        intHeaderHave;               // header bytes collected: stream, then frame
+    int        blnStream;                   // stream header done; collecting frames
+    uint32_t   intRawLen;
+    uint32_t   intStoredLen;
+    uint32_t   intHave;                     // stored bytes of the current frame collected
+    uint8_t   *byStored;
+    uint8_t   *byRaw;
+    uint64_t   intDataLen;                  // from the stream header
+    uint32_t   intDataCrc;
+    uint64_t   intOut;                      // decompressed so far
+    uint32_t   intCrc;
+    int        blnCorrupt;
+} ZTBInflate;
+
+static int lz4_inflate_init(ZTBInflate *objInf_a, ZTBChunkFn fnChunk_a, void *objCtx_a)
+{
+    memset(objInf_a, 0, sizeof(*objInf_a));
+    objInf_a->fnChunk  = fnChunk_a;
+    objInf_a->objCtx   = objCtx_a;
+    objInf_a->intCrc   = CRC32_INIT;
+    objInf_a->byStored = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    objInf_a->byRaw    = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    return objInf_a->byStored && objInf_a->byRaw;
+}
+
+static void lz4_inflate_free(ZTBInflate *objInf_a)
+{
+    if (objInf_a->byStored) { free(objInf_a->byStored); }
+    if (objInf_a->byRaw)    { free(objInf_a->byRaw); }
+}
+
+// --- A whole frame is in: decompress it and pass it on ---
+static int lz4_inflate_frame(ZTBInflate *objInf_a)
+{
+    int intResult     = 1;
+    const uint8_t *by = objInf_a->byStored;
+
+    if (objInf_a->intStoredLen < objInf_a->intRawLen)
+    {
+        intResult = lz4_decompress(objInf_a->byStored, (int)objInf_a->intStoredLen,
+                                   objInf_a->byRaw, (int)objInf_a->intRawLen);
+        by        = objInf_a->byRaw;
+        if (!intResult) { objInf_a->blnCorrupt = 1; }
+    }
+
+    if (intResult)
+    {
+        objInf_a->intCrc  = crc32_update(objInf_a->intCrc, by, objInf_a->intRawLen);
+        objInf_a->intOut += objInf_a->intRawLen;
+        if (objInf_a->fnChunk) { intResult = objInf_a->fnChunk(objInf_a->objCtx, by, objInf_a->intRawLen); }
+    }
+
+    objInf_a->intHeaderHave = 0;
+    objInf_a->intHave       = 0;
+    return intResult;
+}
+
+// --- ZTBChunkFn over the stored payload ---
+static int lz4_inflate_chunk(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    int intResult       = 1;
+    ZTBInflate *objInf  = (ZTBInflate*)objCtx_a;
+
+    while (intResult && intLen_a > 0)
+    {
+        int intHeaderLen = objInf->blnStream ? LZ4_FRAME_HEADER : LZ4_STREAM_HEADER;
+
+        if (objInf->intHeaderHave < intHeaderLen)
+        {
+            // --- Collect the stream header, then each frame's header ---
+            size_t intCopy = (size_t)(intHeaderLen - objInf->intHeaderHave);
+            if (intCopy > intLen_a) { intCopy = intLen_a; }
+            memcpy(objInf->arrHeader + objInf->intHeaderHave, byData_a, intCopy);
+            objInf->intHeaderHave += (int)intCopy;
+            byData_a  += intCopy;
+            intLen_a  -= intCopy;
+
+            if (objInf->intHeaderHave == intHeaderLen && !objInf->blnStream)
+            {
+                objInf->intDataLen    = get_uint64_le(objInf->arrHeader);
+                objInf->intDataCrc    = get_uint32_le(objInf->arrHeader + 8);
+                objInf->blnStream     = 1;
+                objInf->intHeaderHave = 0;
+            }
+            else if (objInf->intHeaderHave == intHeaderLen)
+            {
+                objInf->intRawLen    = get_uint32_le(objInf->arrHeader);
+                objInf->intStoredLen = get_uint32_le(objInf->arrHeader + 4);
+                if (objInf->intRawLen == 0 || objInf->intRawLen > STREAM_CHUNK_SIZE ||
+                    objInf->intStoredLen == 0 || objInf->intStoredLen > objInf->intRawLen)
+                {
+                    objInf->blnCorrupt = 1;
+                    intResult = 0;
+                }
+            }
+        }
+        else
+        {
+            // --- Collect the frame body ---
+            size_t intCopy = objInf->intStoredLen - objInf->intHave;
+            if (intCopy > intLen_a) { intCopy = intLen_a; }
+            memcpy(objInf->byStored + objInf->intHave, byData_a, intCopy);
+            objInf->intHave += (uint32_t)intCopy;
+            byData_a  += intCopy;
+            intLen_a  -= intCopy;
+
+            if (objInf->intHave == objInf->intStoredLen) { intResult = lz4_inflate_frame(objInf); }
+        }
+    }
+
+    return intResult;
+}
+
+// --- The stored payload has all gone in: it must have ended on a frame boundary ---
+static int lz4_inflate_done(ZTBInflate *objInf_a)
+{
+    if (!objInf_a->blnStream || objInf_a->intHeaderHave != 0 ||
+        objInf_a->intOut != objInf_a->intDataLen ||
+        (objInf_a->intCrc ^ CRC32_INIT) != objInf_a->intDataCrc)
+    {
+        objInf_a->blnCorrupt = 1;
+    }
+    return !objInf_a->blnCorrupt;
+}
+
+int lz4_payload_inflate(const uint8_t *byStored_a, size_t intLen_a, ZTBChunkFn fnChunk_a,
+                        void *objCtx_a)
+{
+    int intResult = 0;
+    ZTBInflate objInf;
+
+    if (lz4_inflate_init(&objInf, fnChunk_a, objCtx_a))
+    {
+        intResult = lz4_inflate_chunk(&objInf, byStored_a, intLen_a) && lz4_inflate_done(&objInf);
+    }
+    if (objInf.blnCorrupt) { fprintf(stderr, "Error: Compressed data is corrupt\n"); }
+
+    lz4_inflate_free(&objInf);
+    return intResult;
+}
+
+int lz4_stream_write(FILE *fOut_a, ZTBSource *objSrc_a, uint64_t *intStoredLen_a,
+                     uint64_t *intDataLen_a, uint32_t *intDataCrc_a)
+{
+    int intResult     = 1;
+    uint8_t *byRaw    = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    uint8_t *byFrame  = (uint8_t*)malloc(LZ4_FRAME_HEADER + STREAM_CHUNK_SIZE);
+    uint8_t arrHeader[LZ4_STREAM_HEADER];
+    int64_t intStart  = ZTB_FTELL(fOut_a);
+    uint64_t intStored = LZ4_STREAM_HEADER;
+    uint64_t intData   = 0;
+    uint32_t intCrc    = CRC32_INIT;
+
+    memset(arrHeader, 0, sizeof(arrHeader));
+    if (!byRaw || !byFrame || intStart < 0 || fwrite(arrHeader, 1, sizeof(arrHeader), fOut_a) != sizeof(arrHeader))
+    {
+        intResult = 0;
+    }
+
+    // --- 1. Frames, one per chunk read ---
+    while (intResult)
+    {
+        size_t intRead = source_read(objSrc_a, byRaw, STREAM_CHUNK_SIZE);
+        if (intRead == 0) { break; }
+
+        size_t intFrame = lz4_frame(byRaw, intRead, byFrame);
+        intCrc     = crc32_update(intCrc, byRaw, intRead);
+        intData   += intRead;
+        intStored += intFrame;
+        intResult  = (fwrite(byFrame, 1, intFrame, fOut_a) == intFrame);
+    }
+    if (intResult && objSrc_a->f && ferror(objSrc_a->f)) { intResult = 0; }
+    intCrc ^= CRC32_INIT;
+
+    // --- 2. Patch the stream header in, then go back to the end ---
+    if (intResult)
+    {
+        put_uint64_le(arrHeader,     intData);
+        put_uint32_le(arrHeader + 8, intCrc);
+        intResult = (ZTB_FSEEK(fOut_a, intStart, SEEK_SET) == 0 &&
+                     fwrite(arrHeader, 1, sizeof(arrHeader), fOut_a) == sizeof(arrHeader) &&
+                     ZTB_FSEEK(fOut_a, 0, SEEK_END) == 0);
+    }
+    if (!intResult) { fprintf(stderr, "Error: Cannot write compressed stream\n"); }
+
+    *intStoredLen_a = intStored;
+    *intDataLen_a   = intData;
+    *intDataCrc_a   = intCrc;
+
+    if (byRaw)   { free(byRaw); }
+    if (byFrame) { free(byFrame); }
+    return intResult;
+}
+
+int lz4_stream_read(FILE *fIn_a, uint64_t intStoredLen_a, ZTBChunkFn fnChunk_a, void *objCtx_a)
+{
+    int intResult  = 0;
+    uint8_t *byBuf = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    ZTBInflate objInf;
+
+    if (lz4_inflate_init(&objInf, fnChunk_a, objCtx_a) && byBuf)
+    {
+        intResult = 1;
+        while (intResult && intStoredLen_a > 0)
+        {
+            size_t intWant = intStoredLen_a < STREAM_CHUNK_SIZE ? (size_t)intStoredLen_a : STREAM_CHUNK_SIZE;
+            if (fread(byBuf, 1, intWant, fIn_a) != intWant)
+            {
+                fprintf(stderr, "Error: Read failed\n");
+                intResult = 0;
+            }
+            else
+            {
+                intResult       = lz4_inflate_chunk(&objInf, byBuf, intWant);
+                intStoredLen_a -= intWant;
+            }
+        }
+        if (intResult) { intResult = lz4_inflate_done(&objInf); }
+    }
+    if (objInf.blnCorrupt) { fprintf(stderr, "Error: Compressed data is corrupt\n"); }
+
+    lz4_inflate_free(&objInf);
+    if (byBuf) { free(byBuf); }
+    return intResult;
+}
+
+// --- Keep the first ROM_ENTRY_SIZE bytes of the block as its body is written ---
+static void capture_head(uint8_t *arrHead_a, int *intHeadLen_a, const uint8_t *byData_a,
+                         size_t intLen_a)
+{
+    size_t intRoom = (size_t)(ROM_ENTRY_SIZE - *intHeadLen_a);
+    size_t intCopy = intLen_a < intRoom ? intLen_a : intRoom;
+    if (intCopy > 0)
+    {
+        memcpy(arrHead_a + *intHeadLen_a, byData_a, intCopy);
+        *intHeadLen_a += (int)intCopy;
+    }
+}
+
+// --- Streaming block writer (same on-disk layout as ZTBChain.WriteBlock) ---
+// Writes <workdir>/<block_id>.ztb.tmp as: raw header, a placeholder for the encoded
+// section header, then the payload ZOSCII-encoded STREAM_CHUNK_SIZE bytes at a time
+// while its CRC is accumulated. Padding is appended once the payload length is known
+// (so the COMPLETE on-disk block reaches at least ROM_ENTRY_SIZE bytes -- the rolling ROM
+// copies ROM_ENTRY_SIZE bytes from every historical block), then the encoded section
+// header is encoded and patched in at offset HEADER_RAW_SIZE and the tmp is renamed.
+// Memory use is bounded by the chunk buffers regardless of payload size; lengths are
+// 64-bit internally and limited only by the uint32 payload_len field on disk.
+// The current block hash covers the padded payload ONLY, never the header, which is
+// what allows it to be computed incrementally here.
+// The payload is encoded against objRom_a (whose strPrevID must be this block's prev),
+// prev_hash is taken from it, and on success it is advanced past the new block using the
+// block's first ROM_ENTRY_SIZE bytes, captured as they are written.
+// With objSrc_a->blnCompress each chunk is written as an LZ4 frame instead (see
+// ENC_FLAG_LZ4). The stream header ahead of the frames is only known at the end, so it
+// is patched in with the encoded section header and folded into the hash and file CRC
+// with crc32_combine.
+// Returns 1 on success, 0 on failure.
+int write_block(const char *strWorkDir_a, const uint8_t *byRawHeader_a,
+                ZTBRollingRom *objRom_a, ZTBSource *objSrc_a, ZTBSync *objSync_a,
+                ZTBWriteResult *objResult_a)
+{
+    int intResult = 1;
+    memset(objResult_a, 0, sizeof(ZTBWriteResult));
+
+    char strBlockID[GUID_LEN];
+    char strPrevID[GUID_LEN];
+    read_fixed_string(byRawHeader_a, RAW_OFF_BLOCK_ID, 36, strBlockID);
+    read_fixed_string(byRawHeader_a, RAW_OFF_PREV_ID,  36, strPrevID);
+
+    if (strcmp(strPrevID, objRom_a->strPrevID) != 0)
+    {
+        fprintf(stderr, "Error: Rolling ROM is at %s, not %s\n", objRom_a->strPrevID, strPrevID);
+        intResult = 0;
+    }
+
+    // First ROM_ENTRY_SIZE bytes of the new block, for advancing the rolling ROM
+    int blnCompress = objSrc_a->blnCompress;
+    int intLead     = blnCompress ? LZ4_STREAM_HEADER : 0;     // payload bytes patched in at the end
+    uint8_t arrHead[ROM_ENTRY_SIZE];
+    int intHeadLen = HEADER_RAW_SIZE + (ENC_HEADER_SIZE + intLead) * 2;
+    memcpy(arrHead, byRawHeader_a, HEADER_RAW_SIZE);
+
+    char strOutPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    block_paths(strWorkDir_a, strBlockID, strOutPath, strTmpPath);
+    int intPolicy = objSync_a ? objSync_a->intPolicy : SYNC_NONE;
+
+    uint8_t *byRaw     = intResult ? (uint8_t*)malloc(STREAM_CHUNK_SIZE) : NULL;
+    uint8_t *byEnc     = intResult ? (uint8_t*)malloc(STREAM_CHUNK_SIZE * 2) : NULL;
+    uint8_t *byFrame   = intResult && blnCompress ? (uint8_t*)malloc(LZ4_FRAME_HEADER + STREAM_CHUNK_SIZE) : NULL;
+    FILE *fOut         = NULL;
+
+    if (intResult && (!byRaw || !byEnc || (blnCompress && !byFrame)))
+    {
+        fprintf(stderr, "Error: Cannot allocate stream buffers\n");
+        intResult = 0;
+    }
+
+    if (intResult && block_file_dirs(strWorkDir_a, -1, strBlockID))
+    {
+        fOut = create_block_tmp(strTmpPath);
+        if (!fOut)
+        {
+            fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+            intResult = 0;
+        }
+    }
+    else
+    {
+        intResult = 0;
+    }
+
+    // --- 1. Raw header + placeholder for the encoded section (and stream) header ---
+    if (intResult)
+    {
+        uint8_t arrPlaceholder[(ENC_HEADER_SIZE + LZ4_STREAM_HEADER) * 2];
+        size_t intPlaceholder = (size_t)(ENC_HEADER_SIZE + intLead) * 2;
+        memset(arrPlaceholder, 0, sizeof(arrPlaceholder));
+        if (fwrite(byRawHeader_a, 1, HEADER_RAW_SIZE, fOut) != HEADER_RAW_SIZE ||
+            fwrite(arrPlaceholder, 1, intPlaceholder, fOut) != intPlaceholder)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+    }
+
+    // --- 2. Stream payload (or its LZ4 frames): hash raw bytes, encode, write ---
+    uint64_t intPayloadLen = (uint64_t)intLead;
+    uint64_t intDataLen    = 0;
+    uint32_t intDataCrc    = CRC32_INIT;
+    uint32_t intHash       = CRC32_INIT;
+    uint32_t intBodyCrc    = CRC32_INIT;
+
+    while (intResult)
+    {
+        size_t intRead = source_read(objSrc_a, byRaw, STREAM_CHUNK_SIZE);
+        if (intRead == 0) { break; }
+
+        const uint8_t *byStore = byRaw;
+        size_t intStore        = intRead;
+        intDataLen += intRead;
+        if (blnCompress)
+        {
+            intDataCrc = crc32_update(intDataCrc, byRaw, intRead);
+            intStore   = lz4_frame(byRaw, intRead, byFrame);
+            byStore    = byFrame;
+        }
+
+        intPayloadLen += intStore;
+        if (intPayloadLen > MAX_PAYLOAD_LEN)
+        {
+            fprintf(stderr, "Error: Payload exceeds %llu bytes\n",
+                    (unsigned long long)MAX_PAYLOAD_LEN);
+            intResult = 0;
+        }
+
+        // A frame can run a header past STREAM_CHUNK_SIZE, so it goes in pieces
+        while (intResult && intStore > 0)
+        {
+            size_t intPiece = intStore < STREAM_CHUNK_SIZE ? intStore : STREAM_CHUNK_SIZE;
+            intResult = write_encoded_chunk(fOut, objRom_a, byStore, intPiece, byEnc,
+                                            &intHash, &intBodyCrc);
+            capture_head(arrHead, &intHeadLen, byEnc, intPiece * 2);
+            byStore  += intPiece;
+            intStore -= intPiece;
+        }
+    }
+
+    if (intResult && objSrc_a->f && ferror(objSrc_a->f))
+    {
+        fprintf(stderr, "Error: Cannot read payload\n");
+        intResult = 0;
+    }
+    else if (intResult && objSrc_a->f && objSrc_a->intLen != SOURCE_UNBOUNDED &&
+             objSrc_a->intPos != objSrc_a->intLen)
+    {
+        fprintf(stderr, "Error: Payload truncated (%llu of %llu bytes)\n",
+                (unsigned long long)objSrc_a->intPos, (unsigned long long)objSrc_a->intLen);
+        intResult = 0;
+    }
+
+    // --- 3. Pad small payloads with XorShift32 (matches C# WriteBlock padding) ---
+    uint64_t intPaddedLen = intPayloadLen;
+    if (intResult && HEADER_RAW_SIZE + 2 * (ENC_HEADER_SIZE + intPayloadLen) <= ROM_ENTRY_SIZE)
+    {
+        intPaddedLen = (ROM_ENTRY_SIZE - HEADER_RAW_SIZE) / 2 - ENC_HEADER_SIZE + 1;
+
+        size_t intPadLen = (size_t)(intPaddedLen - intPayloadLen);
+        uint32_t intSeed = xorshift32((uint32_t)(time(NULL) & 0xFFFFFFFF));
+        size_t intI;
+        for (intI = 0; intI < intPadLen; intI++)
+        {
+            intSeed     = xorshift32(intSeed);
+            byRaw[intI] = (uint8_t)(intSeed & 0xFF);
+        }
+        intResult = write_encoded_chunk(fOut, objRom_a, byRaw, intPadLen, byEnc,
+                                        &intHash, &intBodyCrc);
+        capture_head(arrHead, &intHeadLen, byEnc, intPadLen * 2);
+    }
+    intHash    ^= CRC32_INIT;
+    intBodyCrc ^= CRC32_INIT;
+
+    // --- 4. Compressed: the stream header goes in front of the hash and body CRC ---
+    uint8_t arrStreamZ[LZ4_STREAM_HEADER * 2];
+    if (intResult && blnCompress)
+    {
+        uint8_t arrStream[LZ4_STREAM_HEADER];
+        put_uint64_le(arrStream,     intDataLen);
+        put_uint32_le(arrStream + 8, intDataCrc ^ CRC32_INIT);
+
+        intResult = rolling_rom_encode(objRom_a, arrStream, LZ4_STREAM_HEADER, arrStreamZ);
+        if (intResult)
+        {
+            intHash    = crc32_combine(calculate_crc32(arrStream, 0, LZ4_STREAM_HEADER), intHash,
+                                       intPaddedLen - LZ4_STREAM_HEADER);
+            intBodyCrc = crc32_combine(calculate_crc32(arrStreamZ, 0, sizeof(arrStreamZ)), intBodyCrc,
+                                       (intPaddedLen - LZ4_STREAM_HEADER) * 2);
+            memcpy(arrHead + HEADER_RAW_SIZE + ENC_HEADER_SIZE * 2, arrStreamZ, sizeof(arrStreamZ));
+        }
+        else
+        {
+            fprintf(stderr, "Error: ZOSCII encoding failed\n");
+        }
+    }
+
+    // --- 5. Encode the encoded section header and patch it in ---
+    if (intResult)
+    {
+        uint8_t arrEncHeader[ENC_HEADER_SIZE];
+        uint8_t arrEncHeaderZ[ENC_HEADER_SIZE * 2];
+        arrEncHeader[ENC_OFF_HASH_TYPE] = (uint8_t)(HASH_TYPE_CRC32_FULL | (blnCompress ? ENC_FLAG_LZ4 : 0));
+        put_uint32_le(arrEncHeader + ENC_OFF_HASH,        intHash);
+        put_uint32_le(arrEncHeader + ENC_OFF_PREV_HASH,   objRom_a->intPrevCrc);
+        put_uint32_le(arrEncHeader + ENC_OFF_PAYLOAD_LEN, (uint32_t)intPayloadLen);
+        put_uint32_le(arrEncHeader + ENC_OFF_PADDED_LEN,  (uint32_t)intPaddedLen);
+
+        intResult = rolling_rom_encode(objRom_a, arrEncHeader, ENC_HEADER_SIZE, arrEncHeaderZ);
+        if (intResult)
+        {
+            memcpy(arrHead + HEADER_RAW_SIZE, arrEncHeaderZ, sizeof(arrEncHeaderZ));
+            if (ZTB_FSEEK(fOut, HEADER_RAW_SIZE, SEEK_SET) != 0 ||
+                fwrite(arrEncHeaderZ, 1, sizeof(arrEncHeaderZ), fOut) != sizeof(arrEncHeaderZ) ||
+                (blnCompress && fwrite(arrStreamZ, 1, sizeof(arrStreamZ), fOut) != sizeof(arrStreamZ)))
+            {
+                fprintf(stderr, "Error: Write failed\n");
+                intResult = 0;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Error: ZOSCII encoding failed\n");
+        }
+
+        if (intResult)
+        {
+            // Whole-file CRC = CRC(raw header + encoded header) combined with the body CRC
+            uint32_t intHeadCrc = crc32_update(CRC32_INIT, byRawHeader_a, HEADER_RAW_SIZE);
+            intHeadCrc          = crc32_update(intHeadCrc, arrEncHeaderZ, sizeof(arrEncHeaderZ));
+            intHeadCrc         ^= CRC32_INIT;
+
+            objResult_a->intHash       = intHash;
+            objResult_a->intPrevHash   = objRom_a->intPrevCrc;
+            objResult_a->intPayloadLen = intPayloadLen;
+            objResult_a->intPaddedLen  = intPaddedLen;
+            objResult_a->intDataLen    = intDataLen;
+            objResult_a->intFileCrc    = crc32_combine(intHeadCrc, intBodyCrc, intPaddedLen * 2);
+        }
+    }
+
+    // --- 6. Close, then rename into place per the sync policy ---
+    if (fOut)
+    {
+        if (intResult && intPolicy == SYNC_BLOCK && !sync_stream(fOut))
+        {
+            fprintf(stderr, "Error: Cannot sync %s\n", strTmpPath);
+            intResult = 0;
+        }
+
+        if (fclose(fOut) != 0 && intResult)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+
+        // SYNC_GROUP leaves the tmp for the group commit (after the ROM advance below)
+        if (intResult && intPolicy != SYNC_GROUP)
+        {
+            intResult = rename_new_block_file(strTmpPath, strOutPath, intPolicy == SYNC_BLOCK);
+            if (intResult && intPolicy == SYNC_BLOCK && !sync_dir(strWorkDir_a))
+            {
+                fprintf(stderr, "Error: Cannot sync directory %s\n", strWorkDir_a);
+                intResult = 0;
+            }
+        }
+        else if (!intResult)
+        {
+            remove(strTmpPath);
+        }
+    }
+
+    if (byRaw)   { free(byRaw); }
+    if (byEnc)   { free(byEnc); }
+    if (byFrame) { free(byFrame); }
+
+    // --- 7. Move the rolling ROM on to the block just written ---
+    if (intResult)
+    {
+        intResult = rolling_rom_advance(objRom_a, arrHead, intHeadLen, strBlockID,
+                                        objResult_a->intFileCrc);
+        if (!intResult) { fprintf(stderr, "Error: Cannot advance rolling ROM\n"); }
+    }
+
+    // --- 8. Hand the block to the group commit, or report it durable now ---
+    if (intResult && intPolicy == SYNC_GROUP)
+    {
+        intResult = sync_defer(objSync_a, strWorkDir_a, strBlockID);
+    }
+    else if (intResult && objSync_a && objSync_a->fnDurable)
+    {
+        objSync_a->fnDurable(strBlockID);
+    }
+
+    return intResult;
+}
+
+// --- Publish a block written and checked as <workdir>/<blockID>.ztb.tmp ---
+// Same durability as write_block: SYNC_BLOCK fsyncs it, renames it and fsyncs the
+// directory; SYNC_GROUP queues it for the group commit; SYNC_NONE just renames it.
+// Returns 1 on success, 0 on failure.
+int publish_block(const char *strWorkDir_a, const char *strBlockID_a, ZTBSync *objSync_a)
+{
+    int intResult = 1;
+    int intPolicy = objSync_a ? objSync_a->intPolicy : SYNC_NONE;
+    char strOutPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    block_paths(strWorkDir_a, strBlockID_a, strOutPath, strTmpPath);
+
+    if (intPolicy == SYNC_GROUP)
+    {
+        intResult = sync_defer(objSync_a, strWorkDir_a, strBlockID_a);
+    }
+    else
+    {
+        if (intPolicy == SYNC_BLOCK && !sync_path(strTmpPath))
+        {
+            fprintf(stderr, "Error: Cannot sync %s\n", strTmpPath);
+            intResult = 0;
+        }
+        if (intResult)
+        {
+            intResult = rename_new_block_file(strTmpPath, strOutPath, intPolicy == SYNC_BLOCK);
+        }
+        if (intResult && intPolicy == SYNC_BLOCK && !sync_dir(strWorkDir_a))
+        {
+            fprintf(stderr, "Error: Cannot sync directory %s\n", strWorkDir_a);
+            intResult = 0;
+        }
+        if (intResult && objSync_a && objSync_a->fnDurable)
+        {
+            objSync_a->fnDurable(strBlockID_a);
+        }
+    }
+
+    return intResult;
+}
+
+// --- ROM snapshots ---
+// Write <workdir>/<blockID>.rom: the ROM as of the block (what its children encode with),
+// its slice count and the CRC32 of the block file, via tmp then rename.
+// Returns 1 on success, 0 on failure.
+int rom_snapshot_write(const char *strWorkDir_a, const char *strBlockID_a,
+                       const uint8_t *arrRom_a, int intSlices_a, uint32_t intBlockCrc_a)
+{
+    int intResult = 1;
+    char strOutPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    block_file_path(strWorkDir_a, strBlockID_a, ROM_SNAPSHOT_EXT, strOutPath);
+    snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutPath);
+
+    uint8_t arrHead[SNAP_HEADER_SIZE];
+    memset(arrHead, 0, SNAP_HEADER_SIZE);
+    memcpy(arrHead, SNAP_MAGIC, SNAP_MAGIC_LEN);
+    write_fixed_string(arrHead, SNAP_OFF_BLOCK_ID, 36, strBlockID_a);
+    put_uint32_le(arrHead + SNAP_OFF_SLICES,    (uint32_t)intSlices_a);
+    put_uint32_le(arrHead + SNAP_OFF_BLOCK_CRC, intBlockCrc_a);
+    put_uint32_le(arrHead + SNAP_OFF_ROM_CRC,
+                  crc32_update(CRC32_INIT, arrRom_a, ROM_SIZE) ^ CRC32_INIT);
+
+    FILE *fOut = block_file_dirs(strWorkDir_a, -1, strBlockID_a) ? fopen(strTmpPath, "wb") : NULL;
+    if (!fOut)
+    {
+        fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+        intResult = 0;
+    }
+    else
+    {
+        if (fwrite(arrHead, 1, SNAP_HEADER_SIZE, fOut) != SNAP_HEADER_SIZE ||
+            fwrite(arrRom_a, 1, ROM_SIZE, fOut) != ROM_SIZE)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+        if (fclose(fOut) != 0) { intResult = 0; }
+
+        if (intResult) { intResult = rename_block_file(strTmpPath, strOutPath, 0); }
+        else           { remove(strTmpPath); }
+    }
+
+    return intResult;
+}
+
+// --- Delete a block's ROM snapshot (if any) ---
+void rom_snapshot_remove(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ROM_SNAPSHOT_EXT, strPath);
+    remove(strPath);
+}
+
+// --- 1 if the block is a checkpoint whose ROM snapshot is present and still matches ---
+int rom_snapshot_valid(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    int intResult    = 0;
+    uint8_t *arrRom  = (uint8_t*)malloc(ROM_SIZE);
+    uint8_t arrHead[HEADER_RAW_SIZE];
+    uint64_t intLen  = 0;
+    uint32_t intCrc  = 0;
+
+    if (arrRom &&
+        block_cache_read(strWorkDir_a, strBlockID_a, arrHead, HEADER_RAW_SIZE,
+                         &intLen, &intCrc, NULL) == HEADER_RAW_SIZE &&
+        arrHead[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_CHECKPOINT)
+    {
+        int intSlices = 0;
+        intResult = rom_snapshot_load(strWorkDir_a, strBlockID_a, intCrc, arrRom, &intSlices);
+    }
+
+    if (arrRom) { free(arrRom); }
+    return intResult;
+}
+
+// --- Merkle checkpoints (RFC 6962 hashing, see ztbcommon.h) ---
+// Leaf hash of a block file, read from the current position to EOF
+int merkle_leaf_file(FILE *f_a, uint8_t *byLeaf_a)
+{
+    int intResult    = 1;
+    uint8_t *byBuf   = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    uint8_t byPrefix = 0x00;
+    ZTBSha256 objSha;
+
+    sha256_init(&objSha);
+    sha256_update(&objSha, &byPrefix, 1);
+    if (!byBuf)
+    {
+        intResult = 0;
+    }
+    else
+    {
+        size_t intRead;
+        while ((intRead = fread(byBuf, 1, STREAM_CHUNK_SIZE, f_a)) > 0)
+        {
+            sha256_update(&objSha, byBuf, intRead);
+        }
+        if (ferror(f_a)) { intResult = 0; }
+        free(byBuf);
+    }
+    if (intResult) { sha256_final(&objSha, byLeaf_a); }
+
+    return intResult;
+}
+
+int merkle_leaf(const char *strWorkDir_a, const char *strBlockID_a, uint8_t *byLeaf_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    FILE *f = fopen(strPath, "rb");
+    int intResult = f && merkle_leaf_file(f, byLeaf_a);
+    if (f) { fclose(f); }
+    if (!intResult) { fprintf(stderr, "Error: Cannot hash block '%s'\n", strBlockID_a); }
+    return intResult;
+}
+
+// byOut_a may be one of the inputs
+static void merkle_node(const uint8_t *byLeft_a, const uint8_t *byRight_a, uint8_t *byOut_a)
+{
+    uint8_t byPrefix = 0x01;
+    ZTBSha256 objSha;
+    sha256_init(&objSha);
+    sha256_update(&objSha, &byPrefix, 1);
+    sha256_update(&objSha, byLeft_a, SHA256_LEN);
+    sha256_update(&objSha, byRight_a, SHA256_LEN);
+    sha256_final(&objSha, byOut_a);
+}
+
+// --- Largest power of two below intCount_a (>= 2): where RFC 6962 splits the tree ---
+static uint32_t merkle_split(uint32_t intCount_a)
+{
+    uint32_t intSplit = 1;
+    while ((uint64_t)intSplit * 2 < intCount_a) { intSplit *= 2; }
+    return intSplit;
+}
+
+void merkle_root(const uint8_t *arrLeaves_a, uint32_t intCount_a, uint8_t *byRoot_a)
+{
+    if (intCount_a == 0)
+    {
+        ZTBSha256 objSha;
+        sha256_init(&objSha);
+        sha256_final(&objSha, byRoot_a);
+    }
+    else if (intCount_a == 1)
+    {
+        memcpy(byRoot_a, arrLeaves_a, SHA256_LEN);
+    }
+    else
+    {
+        uint32_t intSplit = merkle_split(intCount_a);
+        uint8_t arrLeft[SHA256_LEN];
+        uint8_t arrRight[SHA256_LEN];
+        merkle_root(arrLeaves_a, intSplit, arrLeft);
+        merkle_root(arrLeaves_a + (size_t)intSplit * SHA256_LEN, intCount_a - intSplit, arrRight);
+        merkle_node(arrLeft, arrRight, byRoot_a);
+    }
+}
+
+// --- Audit path of leaf intIndex_a (RFC 6962 PATH), lowest sibling first; its length ---
+int merkle_path(const uint8_t *arrLeaves_a, uint32_t intCount_a, uint32_t intIndex_a,
+                uint8_t *arrPath_a)
+{
+    int intLen = 0;
+
+    if (intCount_a > 1)
+    {
+        uint32_t intSplit = merkle_split(intCount_a);
+        const uint8_t *arrRight = arrLeaves_a + (size_t)intSplit * SHA256_LEN;
+        if (intIndex_a < intSplit)
+        {
+            intLen = merkle_path(arrLeaves_a, intSplit, intIndex_a, arrPath_a);
+            merkle_root(arrRight, intCount_a - intSplit, arrPath_a + (size_t)intLen * SHA256_LEN);
+        }
+        else
+        {
+            intLen = merkle_path(arrRight, intCount_a - intSplit, intIndex_a - intSplit, arrPath_a);
+            merkle_root(arrLeaves_a, intSplit, arrPath_a + (size_t)intLen * SHA256_LEN);
+        }
+        intLen++;
+    }
+
+    return intLen;
+}
+
+// --- Check an audit path against a root (RFC 9162 section 2.1.3.2); 1 = included ---
+int merkle_verify(const uint8_t *byLeaf_a, uint32_t intIndex_a, uint32_t intCount_a,
+                  const uint8_t *arrPath_a, int intPathLen_a, const uint8_t *byRoot_a)
+{
+    int intResult = (intIndex_a < intCount_a && intPathLen_a <= MERKLE_MAX_PATH);
+    uint32_t intFn = intIndex_a;
+    uint32_t intSn = intResult ? intCount_a - 1 : 0;
+    uint8_t arrHash[SHA256_LEN];
+    int intI;
+
+    memcpy(arrHash, byLeaf_a, SHA256_LEN);
+    for (intI = 0; intResult && intI < intPathLen_a; intI++)
+    {
+        const uint8_t *bySibling = arrPath_a + (size_t)intI * SHA256_LEN;
+        if (intSn == 0)
+        {
+            intResult = 0;
+        }
+        else if ((intFn & 1) || intFn == intSn)
+        {
+            merkle_node(bySibling, arrHash, arrHash);
+            while (!(intFn & 1) && intFn != 0)
+            {
+                intFn >>= 1;
+                intSn >>= 1;
+            }
+        }
+        else
+        {
+            merkle_node(arrHash, bySibling, arrHash);
+        }
+        intFn >>= 1;
+        intSn >>= 1;
+    }
+
+    return intResult && intSn == 0 && memcmp(arrHash, byRoot_a, SHA256_LEN) == 0;
+}
+
+int merkle_leaves_write(const char *strWorkDir_a, const char *strBlockID_a, uint32_t intBlockCrc_a,
+                        const uint8_t *arrLeaves_a, uint32_t intCount_a, const uint8_t *byRoot_a)
+{
+    int intResult = 1;
+    char strOutPath[FILENAME_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    size_t intLeavesLen = (size_t)intCount_a * SHA256_LEN;
+    block_file_path(strWorkDir_a, strBlockID_a, MERKLE_EXT, strOutPath);
+    snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutPath);
+
+    uint8_t arrHead[MERKLE_HEADER_SIZE];
+    uint8_t arrCrc[4];
+    memset(arrHead, 0, MERKLE_HEADER_SIZE);
+    memcpy(arrHead, MERKLE_MAGIC, MERKLE_MAGIC_LEN);
+    write_fixed_string(arrHead, MERKLE_OFF_BLOCK_ID, 36, strBlockID_a);
+    put_uint32_le(arrHead + MERKLE_OFF_COUNT,     intCount_a);
+    put_uint32_le(arrHead + MERKLE_OFF_BLOCK_CRC, intBlockCrc_a);
+    memcpy(arrHead + MERKLE_OFF_ROOT, byRoot_a, SHA256_LEN);
+    uint32_t intCrc = crc32_update(CRC32_INIT, arrHead, MERKLE_HEADER_SIZE);
+    if (intLeavesLen) { intCrc = crc32_update(intCrc, arrLeaves_a, intLeavesLen); }
+    put_uint32_le(arrCrc, intCrc ^ CRC32_INIT);
+
+    FILE *fOut = block_file_dirs(strWorkDir_a, -1, strBlockID_a) ? fopen(strTmpPath, "wb") : NULL;
+    if (!fOut)
+    {
+        fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+        intResult = 0;
+    }
+    else
+    {
+        if (fwrite(arrHead, 1, MERKLE_HEADER_SIZE, fOut) != MERKLE_HEADER_SIZE ||
+            (intLeavesLen && fwrite(arrLeaves_a, 1, intLeavesLen, fOut) != intLeavesLen) ||
+            fwrite(arrCrc, 1, 4, fOut) != 4)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+        if (fclose(fOut) != 0) { intResult = 0; }
+
+        if (intResult) { intResult = rename_block_file(strTmpPath, strOutPath, 0); }
+        else           { remove(strTmpPath); }
+    }
+
+    return intResult;
+}
+
+// --- Load <workdir>/<blockID>.mrk if it still matches the checkpoint ---
+// Used only if its magic, ID and CRC are intact, the checkpoint block's CRC is the one
+// recorded, and the leaves hash to the recorded root. Leaf count, or -1 if unusable.
+int merkle_leaves_load(const char *strWorkDir_a, const char *strBlockID_a, uint8_t **arrLeaves_a)
+{
+    int intResult   = -1;
+    uint8_t *arrLeaves = NULL;
+    uint8_t arrHead[MERKLE_HEADER_SIZE];
+    uint8_t arrRaw[HEADER_RAW_SIZE];
+    uint64_t intBlockLen = 0;
+    uint32_t intBlockCrc = 0;
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, MERKLE_EXT, strPath);
+
+    FILE *f = fopen(strPath, "rb");
+    if (f && fread(arrHead, 1, MERKLE_HEADER_SIZE, f) == MERKLE_HEADER_SIZE &&
+        block_cache_read(strWorkDir_a, strBlockID_a, arrRaw, HEADER_RAW_SIZE,
+                         &intBlockLen, &intBlockCrc, NULL) == HEADER_RAW_SIZE &&
+        arrRaw[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_CHECKPOINT)
+    {
+        char strID[GUID_LEN];
+        read_fixed_string(arrHead, MERKLE_OFF_BLOCK_ID, 36, strID);
+        uint32_t intCount   = get_uint32_le(arrHead + MERKLE_OFF_COUNT);
+        size_t intLeavesLen = (size_t)intCount * SHA256_LEN;
+        int64_t intFileLen  = -1;
+        if (ZTB_FSEEK(f, 0, SEEK_END) == 0) { intFileLen = (int64_t)ZTB_FTELL(f); }
+
+        if (memcmp(arrHead, MERKLE_MAGIC, MERKLE_MAGIC_LEN) == 0 &&
+            strcmp(strID, strBlockID_a) == 0 && intCount <= INT32_MAX &&
+            get_uint32_le(arrHead + MERKLE_OFF_BLOCK_CRC) == intBlockCrc &&
+            intFileLen == (int64_t)(MERKLE_HEADER_SIZE + intLeavesLen + 4) &&
+            ZTB_FSEEK(f, MERKLE_HEADER_SIZE, SEEK_SET) == 0 &&
+            (arrLeaves = (uint8_t*)malloc(intLeavesLen ? intLeavesLen : 1)) != NULL)
+        {
+            uint8_t arrCrc[4];
+            uint8_t arrRoot[SHA256_LEN];
+            if (fread(arrLeaves, 1, intLeavesLen, f) == intLeavesLen && fread(arrCrc, 1, 4, f) == 4)
+            {
+                uint32_t intCrc = crc32_update(CRC32_INIT, arrHead, MERKLE_HEADER_SIZE);
+                intCrc = crc32_update(intCrc, arrLeaves, intLeavesLen) ^ CRC32_INIT;
+                merkle_root(arrLeaves, intCount, arrRoot);
+                if (get_uint32_le(arrCrc) == intCrc &&
+                    memcmp(arrRoot, arrHead + MERKLE_OFF_ROOT, SHA256_LEN) == 0)
+                {
+                    intResult = (int)intCount;
+                }
+            }
+        }
+    }
+    if (f) { fclose(f); }
+
+    if (intResult < 0 && arrLeaves) { free(arrLeaves); arrLeaves = NULL; }
+    *arrLeaves_a = arrLeaves;
+    return intResult;
+}
+
+void merkle_leaves_remove(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, MERKLE_EXT, strPath);
+    remove(strPath);
+}
+
+// --- Leaves of the chain below a new checkpoint (see ztbcommon.h) ---
+// The newest Merkle checkpoint on the way down whose .mrk holds exactly the blocks
+// before it supplies those leaves; only the blocks after it are read and hashed.
+int merkle_chain_leaves(const char *strWorkDir_a, const char *strTipID_a,
+                        char (**arrIDs_a)[GUID_LEN], uint8_t **arrLeaves_a)
+{
+    char (*arrIDs)[GUID_LEN] = NULL;
+    uint8_t *arrLeaves = NULL;
+    int intFrom  = -1;
+    int intI;
+
+    // --- 1. The blocks, oldest first ---
+    int intCount = collect_chain(strWorkDir_a, strTipID_a, NULL, 0, &arrIDs);
+    for (intI = 0; intI < intCount / 2; intI++)
+    {
+        char strSwap[GUID_LEN];
+        memcpy(strSwap, arrIDs[intI], GUID_LEN);
+        memcpy(arrIDs[intI], arrIDs[intCount - 1 - intI], GUID_LEN);
+        memcpy(arrIDs[intCount - 1 - intI], strSwap, GUID_LEN);
+    }
+    if (intCount > 0 && !(arrLeaves = (uint8_t*)malloc((size_t)intCount * SHA256_LEN)))
+    {
+        fprintf(stderr, "Error: Cannot allocate Merkle leaves\n");
+        intCount = -1;
+    }
+
+    // --- 2. Reuse the leaves of the newest checkpoint below that has them ---
+    for (intI = intCount - 1; intI >= 0 && intFrom < 0; intI--)
+    {
+        ZTBBlockHeader objHeader;
+        if (block_header(strWorkDir_a, arrIDs[intI], &objHeader) &&
+            objHeader.intBlockType == BLOCK_TYPE_CHECKPOINT)
+        {
+            uint8_t *arrCached = NULL;
+            if (merkle_leaves_load(strWorkDir_a, arrIDs[intI], &arrCached) == intI)
+            {
+                memcpy(arrLeaves, arrCached, (size_t)intI * SHA256_LEN);
+                intFrom = intI;
+            }
+            if (arrCached) { free(arrCached); }
+        }
+    }
+
+    // --- 3. Hash the rest ---
+    for (intI = (intFrom < 0 ? 0 : intFrom); intI < intCount; intI++)
+    {
+        if (!merkle_leaf(strWorkDir_a, arrIDs[intI], arrLeaves + (size_t)intI * SHA256_LEN))
+        {
+            intCount = -1;
+        }
+    }
+
+    if (intCount < 0 && arrLeaves) { free(arrLeaves); arrLeaves = NULL; }
+    if ((intCount < 0 || !arrIDs_a) && arrIDs) { free(arrIDs); arrIDs = NULL; }
+    if (arrIDs_a) { *arrIDs_a = arrIDs; }
+    *arrLeaves_a = arrLeaves;
+    return intCount;
+}
+
+int merkle_line(uint32_t intCount_a, const uint8_t *byRoot_a, char *strLine_a)
+{
+    char strRoot[SHA256_LEN * 2 + 1];
+    hex_encode(byRoot_a, SHA256_LEN, strRoot);
+    return snprintf(strLine_a, MERKLE_LINE_MAX, "\n%s %u %s", MERKLE_LINE, (unsigned)intCount_a, strRoot);
+}
+
+// Only an exact, canonical line at the very end of the payload counts
+int merkle_parse(const uint8_t *byPayload_a, size_t intLen_a, uint32_t *intCount_a,
+                 uint8_t *byRoot_a)
+{
+    int intResult = 0;
+    size_t intStart = intLen_a;
+
+    while (intStart > 0 && intLen_a - intStart < MERKLE_LINE_MAX && byPayload_a[intStart - 1] != '\n')
+    {
+        intStart--;
+    }
+    if (intStart > 0 && byPayload_a[intStart - 1] == '\n' && intLen_a - intStart < MERKLE_LINE_MAX)
+    {
+        char strLine[MERKLE_LINE_MAX];
+        char strRoot[MERKLE_LINE_MAX];
+        char strCheck[MERKLE_LINE_MAX];
+        unsigned long intCount = 0;
+        memcpy(strLine, byPayload_a + intStart, intLen_a - intStart);
+        strLine[intLen_a - intStart] = '\0';
+
+        if (sscanf(strLine, MERKLE_LINE " %lu %95s", &intCount, strRoot) == 2 &&
+            intCount <= UINT32_MAX && hex_decode(strRoot, byRoot_a, SHA256_LEN))
+        {
+            int intLineLen = merkle_line((uint32_t)intCount, byRoot_a, strCheck);
+            intResult = ((size_t)intLineLen == intLen_a - intStart + 1 &&
+                         memcmp(strCheck + 1, strLine, (size_t)intLineLen - 1) == 0);
+            if (intResult) { *intCount_a = (uint32_t)intCount; }
+        }
+    }
+
+    return intResult;
+}
+
+// --- Keeps the last MERKLE_LINE_MAX bytes of a payload ---
+typedef struct
+{
+    uint8_t arrTail[MERKLE_LINE_MAX];
+    size_t  intLen;
+} ZTBMerkleTail;
+
+static int merkle_tail_chunk(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    ZTBMerkleTail *objTail = (ZTBMerkleTail*)objCtx_a;
+    if (intLen_a >= MERKLE_LINE_MAX)
+    {
+        memcpy(objTail->arrTail, byData_a + intLen_a - MERKLE_LINE_MAX, MERKLE_LINE_MAX);
+        objTail->intLen = MERKLE_LINE_MAX;
+    }
+    else
+    {
+        size_t intKeep = objTail->intLen + intLen_a > MERKLE_LINE_MAX ? MERKLE_LINE_MAX - intLen_a : objTail->intLen;
+        memmove(objTail->arrTail, objTail->arrTail + objTail->intLen - intKeep, intKeep);
+        memcpy(objTail->arrTail + intKeep, byData_a, intLen_a);
+        objTail->intLen = intKeep + intLen_a;
+    }
+    return 1;
+}
+
+int merkle_checkpoint_root(const char *strWorkDir_a, const char *strBlockID_a,
+                           uint32_t *intCount_a, uint8_t *byRoot_a)
+{
+    int intResult = 0;
+    int blnPrevTrunc = 0;
+    int blnIntact = 0;
+    ZTBBlockHeader objHeader;
+    ZTBMerkleTail objTail;
+    objTail.intLen = 0;
+
+    if (!block_header(strWorkDir_a, strBlockID_a, &objHeader))
+    {
+        fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+    }
+    else if (objHeader.intBlockType != BLOCK_TYPE_CHECKPOINT)
+    {
+        fprintf(stderr, "Error: '%s' is not a checkpoint\n", strBlockID_a);
+    }
+    else
+    {
+        ZTBRollingRom *objRom = rolling_rom_open_before(strWorkDir_a, strBlockID_a, &blnPrevTrunc);
+        if (objRom &&
+            read_run_block(strWorkDir_a, objRom, strBlockID_a, blnPrevTrunc, merkle_tail_chunk,
+                           &objTail, &blnIntact))
+        {
+            if (!blnIntact)
+            {
+                fprintf(stderr, "Error: Checkpoint '%s' fails its hash check\n", strBlockID_a);
+            }
+            else if (!merkle_parse(objTail.arrTail, objTail.intLen, intCount_a, byRoot_a))
+            {
+                fprintf(stderr, "Error: Checkpoint '%s' carries no Merkle root\n", strBlockID_a);
+            }
+            else
+            {
+                intResult = 1;
+            }
+        }
+        if (objRom) { rolling_rom_close(objRom); }
+    }
+
+    return intResult;
+}
+
+// --- Streaming block reader ---
+// Read exactly intLen_a bytes of the block file, folding them into the file CRC and head.
+static int block_reader_read(ZTBBlockReader *objReader_a, uint8_t *byBuf_a, size_t intLen_a)
+{
+    int intResult = (fread(byBuf_a, 1, intLen_a, objReader_a->f) == intLen_a);
+    if (intResult)
+    {
+        objReader_a->intCrc = crc32_update(objReader_a->intCrc, byBuf_a, intLen_a);
+        capture_head(objReader_a->arrHead, &objReader_a->intHeadLen, byBuf_a, intLen_a);
+    }
+    return intResult;
+}
+
+// --- Look each 2-byte little-endian address up in the ROM ---
+static void block_reader_decode(const uint8_t *byRom_a, const uint8_t *byEnc_a,
+                                size_t intCount_a, uint8_t *byOut_a)
+{
+    size_t intI;
+    for (intI = 0; intI < intCount_a; intI++)
+    {
+        byOut_a[intI] = byRom_a[(uint16_t)(byEnc_a[intI * 2] | (byEnc_a[intI * 2 + 1] << 8))];
+    }
+}
+
+int block_reader_open(ZTBBlockReader *objReader_a, const char *strWorkDir_a,
+                      const char *strBlockID_a, const uint8_t *byRom_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    return block_reader_open_path(objReader_a, strPath, byRom_a);
+}
+
+int block_reader_open_path(ZTBBlockReader *objReader_a, const char *strPath_a,
+                           const uint8_t *byRom_a)
+{
+    return block_reader_open_file(objReader_a, fopen(strPath_a, "rb"), byRom_a);
+}
+
+int block_reader_open_file(ZTBBlockReader *objReader_a, FILE *f_a, const uint8_t *byRom_a)
+{
+    int intResult = 1;
+
+    memset(objReader_a, 0, sizeof(*objReader_a));
+    objReader_a->byRom  = byRom_a;
+    objReader_a->intCrc = CRC32_INIT;
+    objReader_a->f      = f_a;
+
+    if (!objReader_a->f || ZTB_FSEEK(objReader_a->f, 0, SEEK_END) != 0)
+    {
+        intResult = 0;
+    }
+    else
+    {
+        objReader_a->intFileLen = (uint64_t)ZTB_FTELL(objReader_a->f);
+        intResult = (ZTB_FSEEK(objReader_a->f, 0, SEEK_SET) == 0 &&
+                     block_reader_read(objReader_a, objReader_a->arrRawHeader, HEADER_RAW_SIZE));
+    }
+
+    if (intResult && objReader_a->arrRawHeader[RAW_OFF_BLOCK_TYPE] != BLOCK_TYPE_TRUNCATION)
+    {
+        uint8_t arrEnc[ENC_HEADER_SIZE * 2];
+        uint8_t arrDec[ENC_HEADER_SIZE];
+
+        if (objReader_a->intFileLen < HEADER_RAW_SIZE + sizeof(arrEnc) ||
+            !byRom_a || !block_reader_read(objReader_a, arrEnc, sizeof(arrEnc)))
+        {
+            intResult = 0;
+        }
+        else
+        {
+            block_reader_decode(byRom_a, arrEnc, ENC_HEADER_SIZE, arrDec);
+            objReader_a->blnEncoded        = 1;
+            objReader_a->byHashType        = arrDec[ENC_OFF_HASH_TYPE] & ENC_HASH_TYPE_MASK;
+            objReader_a->blnCompressed     = (arrDec[ENC_OFF_HASH_TYPE] & ENC_FLAG_LZ4) != 0;
+            objReader_a->intStoredHash     = get_uint32_le(arrDec + ENC_OFF_HASH);
+            objReader_a->intStoredPrevHash = get_uint32_le(arrDec + ENC_OFF_PREV_HASH);
+            objReader_a->intPayloadLen     = get_uint32_le(arrDec + ENC_OFF_PAYLOAD_LEN);
+            objReader_a->intPaddedLen      = get_uint32_le(arrDec + ENC_OFF_PADDED_LEN);
+            objReader_a->intDataLen        = objReader_a->intPayloadLen;
+            // An odd trailing byte is not decoded (same as zoscii_decode)
+            objReader_a->intBodyLen = (objReader_a->intFileLen - HEADER_RAW_SIZE) / 2 -
+                                      ENC_HEADER_SIZE;
+        }
+    }
+
+    // --- Compressed: peek at the stream header for the decompressed length ---
+    if (intResult && objReader_a->blnCompressed)
+    {
+        uint8_t arrEnc[LZ4_STREAM_HEADER * 2];
+        uint8_t arrDec[LZ4_STREAM_HEADER];
+        int64_t intAt = ZTB_FTELL(objReader_a->f);
+
+        if (objReader_a->intPayloadLen < LZ4_STREAM_HEADER ||
+            objReader_a->intBodyLen < LZ4_STREAM_HEADER ||
+            fread(arrEnc, 1, sizeof(arrEnc), objReader_a->f) != sizeof(arrEnc) ||
+            ZTB_FSEEK(objReader_a->f, intAt, SEEK_SET) != 0)
+        {
+            intResult = 0;
+        }
+        else
+        {
+            block_reader_decode(byRom_a, arrEnc, LZ4_STREAM_HEADER, arrDec);
+            objReader_a->intDataLen = get_uint64_le(arrDec);
+            objReader_a->intDataCrc = get_uint32_le(arrDec + 8);
+        }
+    }
+
+    if (!intResult) { block_reader_close(objReader_a); }
+    return intResult;
+}
+
+int block_reader_scan(ZTBBlockReader *objReader_a, ZTBChunkFn fnChunk_a, void *objCtx_a)
+{
+    int intResult  = 1;
+    uint8_t *byEnc = (uint8_t*)malloc(STREAM_CHUNK_SIZE * 2);
+    uint8_t *byDec = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+
+    int blnHashed  = (objReader_a->byHashType == HASH_TYPE_CRC32_FULL ||
+                      objReader_a->byHashType == HASH_TYPE_CRC32_1KB);
+    int bln1KB     = (objReader_a->byHashType == HASH_TYPE_CRC32_1KB ||
+                      objReader_a->byHashType == HASH_TYPE_ROLL_1KB);
+    uint32_t intHash   = CRC32_INIT;
+    uint64_t intDone   = 0;
+
+    // A compressed payload always goes through the inflater, so its data_crc is checked
+    ZTBInflate objInf;
+    memset(&objInf, 0, sizeof(objInf));
+    if (objReader_a->blnCompressed)
+    {
+        if (!lz4_inflate_init(&objInf, fnChunk_a, objCtx_a)) { intResult = 0; }
+        fnChunk_a = lz4_inflate_chunk;
+        objCtx_a  = &objInf;
+    }
+
+    if (!byEnc || !byDec || !objReader_a->f || !objReader_a->blnEncoded)
+    {
+        intResult = 0;
+    }
+    else if (objReader_a->intPayloadLen > objReader_a->intBodyLen)
+    {
+        fprintf(stderr, "Error: Payload length %u exceeds block\n", objReader_a->intPayloadLen);
+        intResult = 0;
+    }
+
+    // --- Decode, hash and emit the padded payload one chunk at a time ---
+    while (intResult && intDone < objReader_a->intBodyLen)
+    {
+        uint64_t intLeft = objReader_a->intBodyLen - intDone;
+        size_t intCount  = intLeft < STREAM_CHUNK_SIZE ? (size_t)intLeft : STREAM_CHUNK_SIZE;
+
+        if (!block_reader_read(objReader_a, byEnc, intCount * 2))
+        {
+            fprintf(stderr, "Error: Read failed\n");
+            intResult = 0;
+            break;
+        }
+        block_reader_decode(objReader_a->byRom, byEnc, intCount, byDec);
+
+        if (blnHashed)
+        {
+            size_t intHashLen = intCount;
+            if (bln1KB)
+            {
+                intHashLen = intDone >= 1024 ? 0 :
+                             (intCount < 1024 - intDone ? intCount : (size_t)(1024 - intDone));
+            }
+            intHash = crc32_update(intHash, byDec, intHashLen);
+        }
+
+        if (fnChunk_a && intDone < objReader_a->intPayloadLen)
+        {
+            uint64_t intWant = objReader_a->intPayloadLen - intDone;
+            size_t intUse    = intWant < intCount ? (size_t)intWant : intCount;
+            intResult = fnChunk_a(objCtx_a, byDec, intUse);
+        }
+        intDone += intCount;
+    }
+
+    // --- Odd trailing byte (not decoded, but part of the file CRC) ---
+    if (intResult && ((objReader_a->intFileLen - HEADER_RAW_SIZE) & 1))
+    {
+        intResult = block_reader_read(objReader_a, byEnc, 1);
+    }
+
+    if (intResult)
+    {
+        objReader_a->intCalcHash = blnHashed ? (intHash ^ CRC32_INIT) : 0;
+        objReader_a->intFileCrc  = objReader_a->intCrc ^ CRC32_INIT;
+    }
+
+    if (objReader_a->blnCompressed)
+    {
+        if (intResult && !lz4_inflate_done(&objInf)) { intResult = 0; }
+        if (objInf.blnCorrupt) { fprintf(stderr, "Error: Compressed data is corrupt\n"); }
+        lz4_inflate_free(&objInf);
+    }
+
+    if (byEnc) { free(byEnc); }
+    if (byDec) { free(byDec); }
+    return intResult;
+}
+
+// --- block_reader_scan callback: append the chunk to a FILE* ---
+static int block_reader_write(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    int intResult = (fwrite(byData_a, 1, intLen_a, (FILE*)objCtx_a) == intLen_a);
+    if (!intResult) { fprintf(stderr, "Error: Write failed\n"); }
+    return intResult;
+}
+
+int block_reader_copy(ZTBBlockReader *objReader_a, FILE *fOut_a)
+{
+    return block_reader_scan(objReader_a, fOut_a ? block_reader_write : NULL, fOut_a);
+}
+
+void block_reader_close(ZTBBlockReader *objReader_a)
+{
+    if (objReader_a->f)
+    {
+        fclose(objReader_a->f);
+        objReader_a->f = NULL;
+    }
+}
+
+// --- Rolling ROM for decoding strBlockID_a, from the prev named in its raw header ---
+// *blnPrevTrunc_a: the prev is a truncation marker, so its prev_hash is not checked.
+ZTBRollingRom* rolling_rom_open_before(const char *strWorkDir_a, const char *strBlockID_a,
+                                       int *blnPrevTrunc_a)
+{
+    ZTBRollingRom *objResult = NULL;
+    ZTBBlockHeader objHeader;
+    ZTBBlockHeader objPrev;
+
+    *blnPrevTrunc_a = 0;
+    if (!block_header(strWorkDir_a, strBlockID_a, &objHeader))
+    {
+        fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+    }
+    else
+    {
+        if (strcmp(objHeader.strPrevID, NULL_GUID) != 0 &&
+            block_header(strWorkDir_a, objHeader.strPrevID, &objPrev))
+        {
+            *blnPrevTrunc_a = (objPrev.intBlockType == BLOCK_TYPE_TRUNCATION);
+        }
+
+        objResult = rolling_rom_open(strWorkDir_a, objHeader.strPrevID);
+        if (!objResult) { fprintf(stderr, "Error: Cannot build rolling ROM for '%s'\n", objHeader.strPrevID); }
+    }
+
+    return objResult;
+}
+
+// --- Decode and check the next block of a run, then advance the ROM past it ---
+// objRom_a must be the ROM for this block (rolling_rom_open_before, then this call
+// block after block). The payload goes to fnChunk_a (may be NULL). Returns 1 if the
+// block was read through, with *blnIntact_a = hash and prev_hash both match; 0 if it
+// could not be read or decoded, or fnChunk_a stopped early.
+int read_run_block(const char *strWorkDir_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                   int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a)
+{
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    return read_run_file(strPath, objRom_a, strBlockID_a, blnPrevTrunc_a, fnChunk_a, objCtx_a,
+                         blnIntact_a);
+}
+
+// --- read_run_block on a file that is not (yet) <workdir>/<blockID>.ztb ---
+int read_run_file(const char *strPath_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                  int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a)
+{
+    return read_run_stream(fopen(strPath_a, "rb"), objRom_a, strBlockID_a, blnPrevTrunc_a,
+                           fnChunk_a, objCtx_a, blnIntact_a);
+}
+
+// --- read_run_block on an open block file (closed when done) ---
+int read_run_stream(FILE *f_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                    int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a)
+{
+    int intResult = 1;
+    ZTBBlockReader objReader;
+
+    *blnIntact_a = 0;
+    if (!block_reader_open_file(&objReader, f_a, objRom_a->arrRom) ||
+        !objReader.blnEncoded)
+    {
+        intResult = 0;
+    }
+    else if (block_reader_scan(&objReader, fnChunk_a, objCtx_a))
+    {
+        int blnPrevHashOK = (objReader.intStoredPrevHash == 0 || blnPrevTrunc_a ||
+                             strcmp(objRom_a->strPrevID, NULL_GUID) == 0 ||
+                             objRom_a->intPrevCrc == objReader.intStoredPrevHash);
+        *blnIntact_a = (objReader.intCalcHash == objReader.intStoredHash && blnPrevHashOK);
+
+        intResult = rolling_rom_advance(objRom_a, objReader.arrHead, objReader.intHeadLen,
+                                        strBlockID_a, objReader.intFileCrc);
+    }
+    else
+    {
+        intResult = 0;
+    }
+
+    block_reader_close(&objReader);
+    return intResult;
+}
+
+// --- Bundles ---
+int bundle_write_header(FILE *fOut_a, const char *strChainID_a,
+                        const ZTBBundleEntry *arrEntries_a, int intCount_a)
+{
+    int intResult = 1;
+    uint8_t arrPrefix[BUNDLE_PREFIX_SIZE];
+    uint8_t arrEntry[BUNDLE_ENTRY_SIZE];
+    uint8_t arrCrc[4];
+    uint32_t intCrc = CRC32_INIT;
+    int intI;
+
+    memset(arrPrefix, 0, sizeof(arrPrefix));
+    memcpy(arrPrefix, BUNDLE_MAGIC, BUNDLE_MAGIC_LEN);
+    put_uint32_le(arrPrefix + BUNDLE_OFF_COUNT, (uint32_t)intCount_a);
+    write_fixed_string(arrPrefix, BUNDLE_OFF_CHAIN, 36, strChainID_a ? strChainID_a : "");
+    intCrc    = crc32_update(intCrc, arrPrefix, sizeof(arrPrefix));
+    intResult = (fwrite(arrPrefix, 1, sizeof(arrPrefix), fOut_a) == sizeof(arrPrefix));
+
+    for (intI = 0; intI < intCount_a && intResult; intI++)
+    {
+        memset(arrEntry, 0, sizeof(arrEntry));
+        write_fixed_string(arrEntry, 0, 36, arrEntries_a[intI].strID);
+        put_uint32_le(arrEntry + BUNDLE_ENT_OFF_FLAGS, arrEntries_a[intI].intFlags);
+        put_uint64_le(arrEntry + BUNDLE_ENT_OFF_LEN,   arrEntries_a[intI].intLen);
+        intCrc    = crc32_update(intCrc, arrEntry, sizeof(arrEntry));
+        intResult = (fwrite(arrEntry, 1, sizeof(arrEntry), fOut_a) == sizeof(arrEntry));
+    }
+
+    put_uint32_le(arrCrc, intCrc ^ CRC32_INIT);
+    if (intResult) { intResult = (fwrite(arrCrc, 1, sizeof(arrCrc), fOut_a) == sizeof(arrCrc)); }
+    if (!intResult) { fprintf(stderr, "Error: Write failed\n"); }
+    return intResult;
+}
+
+// --- Read and check a bundle header; *arrEntries_a is malloc'd (free it) ---
+int bundle_read_header(FILE *fIn_a, char *strChainID_a, ZTBBundleEntry **arrEntries_a,
+                       int *intCount_a)
+{
+    int intResult = 1;
+    uint8_t arrPrefix[BUNDLE_PREFIX_SIZE];
+    uint8_t arrEntry[BUNDLE_ENTRY_SIZE];
+    uint8_t arrCrc[4];
+    uint32_t intCrc = CRC32_INIT;
+    uint32_t intCount = 0;
+    ZTBBundleEntry *arrEntries = NULL;
+    uint32_t intI;
+
+    if (fread(arrPrefix, 1, sizeof(arrPrefix), fIn_a) != sizeof(arrPrefix) ||
+        memcmp(arrPrefix, BUNDLE_MAGIC, BUNDLE_MAGIC_LEN) != 0)
+    {
+        fprintf(stderr, "Error: Not a ZTB bundle\n");
+        intResult = 0;
+    }
+    else
+    {
+        intCrc   = crc32_update(intCrc, arrPrefix, sizeof(arrPrefix));
+        intCount = get_uint32_le(arrPrefix + BUNDLE_OFF_COUNT);
+        read_fixed_string(arrPrefix, BUNDLE_OFF_CHAIN, 36, strChainID_a);
+        if (intCount > BUNDLE_MAX_BLOCKS)
+        {
+            fprintf(stderr, "Error: Bundle block count %u is too large\n", intCount);
+            intResult = 0;
+        }
+    }
+
+    if (intResult)
+    {
+        arrEntries = (ZTBBundleEntry*)malloc(((size_t)intCount + 1) * sizeof(ZTBBundleEntry));
+        if (!arrEntries) { intResult = 0; }
+    }
+
+    for (intI = 0; intI < intCount && intResult; intI++)
+    {
+        if (fread(arrEntry, 1, sizeof(arrEntry), fIn_a) != sizeof(arrEntry))
+        {
+            intResult = 0;
+            break;
+        }
+        intCrc = crc32_update(intCrc, arrEntry, sizeof(arrEntry));
+        read_fixed_string(arrEntry, 0, 36, arrEntries[intI].strID);
+        arrEntries[intI].intFlags = get_uint32_le(arrEntry + BUNDLE_ENT_OFF_FLAGS);
+        arrEntries[intI].intLen   = get_uint64_le(arrEntry + BUNDLE_ENT_OFF_LEN);
+    }
+
+    if (intResult && (fread(arrCrc, 1, sizeof(arrCrc), fIn_a) != sizeof(arrCrc) ||
+                      get_uint32_le(arrCrc) != (intCrc ^ CRC32_INIT)))
+    {
+        intResult = 0;
+    }
+    if (!intResult && arrEntries)
+    {
+        fprintf(stderr, "Error: Bundle header is damaged\n");
+    }
+
+    for (intI = 0; intI < intCount && intResult; intI++)
+    {
+        if (!is_valid_guid(arrEntries[intI].strID))
+        {
+            fprintf(stderr, "Error: Bad block ID '%s' in bundle\n", arrEntries[intI].strID);
+            intResult = 0;
+        }
+    }
+
+    if (!intResult && arrEntries)
+    {
+        free(arrEntries);
+        arrEntries = NULL;
+    }
+    *arrEntries_a = arrEntries;
+    *intCount_a   = intResult ? (int)intCount : 0;
+    return intResult;
+}
+
+// --- Append a block file and its CRC32; the file must still be intLen_a bytes ---
+int bundle_write_block(FILE *fOut_a, const char *strPath_a, uint64_t intLen_a)
+{
+    int intResult = 1;
+    uint8_t *byBuf = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    uint32_t intCrc = CRC32_INIT;
+    uint64_t intDone = 0;
+    FILE *fIn = fopen(strPath_a, "rb");
+
+    if (!byBuf || !fIn)
+    {
+        fprintf(stderr, "Error: Cannot read %s\n", strPath_a);
+        intResult = 0;
+    }
+
+    while (intResult && intDone < intLen_a)
+    {
+        uint64_t intLeft = intLen_a - intDone;
+        size_t intWant   = intLeft < STREAM_CHUNK_SIZE ? (size_t)intLeft : STREAM_CHUNK_SIZE;
+        if (fread(byBuf, 1, intWant, fIn) != intWant)
+        {
+            fprintf(stderr, "Error: %s changed while it was exported\n", strPath_a);
+            intResult = 0;
+        }
+        else if (fwrite(byBuf, 1, intWant, fOut_a) != intWant)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+        else
+        {
+            intCrc   = crc32_update(intCrc, byBuf, intWant);
+            intDone += intWant;
+        }
+    }
+
+    if (intResult)
+    {
+        uint8_t arrCrc[4];
+        put_uint32_le(arrCrc, intCrc ^ CRC32_INIT);
+        intResult = (fwrite(arrCrc, 1, sizeof(arrCrc), fOut_a) == sizeof(arrCrc));
+        if (!intResult) { fprintf(stderr, "Error: Write failed\n"); }
+    }
+
+    if (fIn)   { fclose(fIn); }
+    if (byBuf) { free(byBuf); }
+    return intResult;
+}
+
+// --- Copy the next block of a bundle to fOut_a (NULL = skip it) and check its CRC32 ---
+// The first HEADER_RAW_SIZE bytes also go to arrRawHeader_a (zeroed if the block is
+// shorter). Returns 1 if the block was read whole and its CRC32 matches.
+int bundle_read_block(FILE *fIn_a, uint64_t intLen_a, FILE *fOut_a, uint8_t *arrRawHeader_a,
+                      uint32_t *intCrc_a)
+{
+    int intResult = 1;
+    uint8_t *byBuf = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    uint8_t arrCrc[4];
+    uint32_t intCrc = CRC32_INIT;
+    uint64_t intDone = 0;
+
+    memset(arrRawHeader_a, 0, HEADER_RAW_SIZE);
+    if (!byBuf) { intResult = 0; }
+
+    while (intResult && intDone < intLen_a)
+    {
+        uint64_t intLeft = intLen_a - intDone;
+        size_t intWant   = intLeft < STREAM_CHUNK_SIZE ? (size_t)intLeft : STREAM_CHUNK_SIZE;
+        if (fread(byBuf, 1, intWant, fIn_a) != intWant)
+        {
+            fprintf(stderr, "Error: Bundle ends early\n");
+            intResult = 0;
+        }
+        else if (fOut_a && fwrite(byBuf, 1, intWant, fOut_a) != intWant)
+        {
+            fprintf(stderr, "Error: Write failed\n");
+            intResult = 0;
+        }
+        else
+        {
+            if (intDone < HEADER_RAW_SIZE)
+            {
+                size_t intCopy = HEADER_RAW_SIZE - (size_t)intDone;
+                memcpy(arrRawHeader_a + intDone, byBuf, intCopy < intWant ? intCopy : intWant);
+            }
+            intCrc   = crc32_update(intCrc, byBuf, intWant);
+            intDone += intWant;
+        }
+    }
+
+    intCrc ^= CRC32_INIT;
+    if (intResult && (fread(arrCrc, 1, sizeof(arrCrc), fIn_a) != sizeof(arrCrc) ||
+                      get_uint32_le(arrCrc) != intCrc))
+    {
+        intResult = 0;
+    }
+
+    *intCrc_a = intCrc;
+    if (byBuf) { free(byBuf); }
+    return intResult;
+}
+
+// --- Threads and locks (Win32 or pthreads) ---
+typedef struct
+{
+    ZTBThreadFn fnRun;
+    void       *objArg;
+} ZTBThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID objStart_a)
+#else
+static void* thread_entry(void *objStart_a)
+#endif
+{
+    ZTBThreadStart objStart = *(ZTBThreadStart*)objStart_a;
+    free(objStart_a);
+    objStart.fnRun(objStart.objArg);
+    return 0;
+}
+
+int thread_start(ZTBThread *objThread_a, ZTBThreadFn fnRun_a, void *objArg_a)
+{
+    int intResult = 0;
+    ZTBThreadStart *objStart = (ZTBThreadStart*)malloc(sizeof(ZTBThreadStart));
+
+    if (objStart)
+    {
+        objStart->fnRun  = fnRun_a;
+        objStart->objArg = objArg_a;
+#ifdef _WIN32
+        *objThread_a = CreateThread(NULL, 0, thread_entry, objStart, 0, NULL);
+        intResult    = (*objThread_a != NULL);
+#else
+        intResult = (pthread_create(objThread_a, NULL, thread_entry, objStart) == 0);
+#endif
+        if (!intResult) { free(objStart); }
+    }
+
+    return intResult;
+}
+
+void thread_join(ZTBThread objThread_a)
+{
+#ifdef _WIN32
+    WaitForSingleObject(objThread_a, INFINITE);
+    CloseHandle(objThread_a);
+#else
+    pthread_join(objThread_a, NULL);
+#endif
+}
+
+void mutex_init(ZTBMutex *objMutex_a)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(objMutex_a);
+#else
+    pthread_mutex_init(objMutex_a, NULL);
+#endif
+}
+
+void mutex_lock(ZTBMutex *objMutex_a)
+{
+#ifdef _WIN32
+    EnterCriticalSection(objMutex_a);
+#else
+    pthread_mutex_lock(objMutex_a);
+#endif
+}
+
+void mutex_unlock(ZTBMutex *objMutex_a)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(objMutex_a);
+#else
+    pthread_mutex_unlock(objMutex_a);
+#endif
+}
+
+void mutex_destroy(ZTBMutex *objMutex_a)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(objMutex_a);
+#else
+    pthread_mutex_destroy(objMutex_a);
+#endif
+}
+
+void cond_init(ZTBCond *objCond_a)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(objCond_a);
+#else
+    pthread_cond_init(objCond_a, NULL);
+#endif
+}
+
+void cond_signal(ZTBCond *objCond_a)
+{
+#ifdef _WIN32
+    WakeConditionVariable(objCond_a);
+#else
+    pthread_cond_signal(objCond_a);
+#endif
+}
+
+// --- Wait on a condition (the mutex held) for up to intMs_a, or until signalled if < 0 ---
+void cond_wait_ms(ZTBCond *objCond_a, ZTBMutex *objMutex_a, int64_t intMs_a)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(objCond_a, objMutex_a, intMs_a < 0 ? INFINITE : (DWORD)intMs_a);
+#else
+    if (intMs_a < 0)
+    {
+        pthread_cond_wait(objCond_a, objMutex_a);
+    }
+    else
+    {
+        struct timespec objUntil;
+        clock_gettime(CLOCK_REALTIME, &objUntil);
+        objUntil.tv_sec  += (time_t)(intMs_a / 1000);
+        objUntil.tv_nsec += (long)(intMs_a % 1000) * 1000000L;
+        if (objUntil.tv_nsec >= 1000000000L)
+        {
+            objUntil.tv_sec  += 1;
+            objUntil.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(objCond_a, objMutex_a, &objUntil);
+    }
+#endif
+}
+
+void cond_destroy(ZTBCond *objCond_a)
+{
+#ifdef _WIN32
+    (void)objCond_a;
+#else
+    pthread_cond_destroy(objCond_a);
+#endif
+}
+
+// --- Online CPUs (at least 1) ---
+int cpu_count(void)
+{
+    int intResult = 1;
+#ifdef _WIN32
+    SYSTEM_INFO objInfo;
+    GetSystemInfo(&objInfo);
+    intResult = (int)objInfo.dwNumberOfProcessors;
+#else
+    long lngCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (lngCount > 0) { intResult = (int)lngCount; }
+#endif
+    if (intResult < 1) { intResult = 1; }
+    return intResult;
+}
+
+// --- Run fnRun_a on intThreads_a threads (the caller's included) and wait for all ---
+// Returns the number of threads that ran; fewer than asked if threads cannot start.
+int run_workers(int intThreads_a, ZTBThreadFn fnRun_a, void *objArg_a)
+{
+    ZTBThread arrThreads[MAX_WORKERS];
+    int intStarted = 0;
+    int intI;
+
+    if (intThreads_a > MAX_WORKERS) { intThreads_a = MAX_WORKERS; }
+    while (intStarted < intThreads_a - 1 &&
+           thread_start(&arrThreads[intStarted], fnRun_a, objArg_a))
+    {
+        intStarted++;
+    }
+    fnRun_a(objArg_a);
+    for (intI = 0; intI < intStarted; intI++) { thread_join(arrThreads[intI]); }
+
+    return intStarted + 1;
+}
+
+// --- Readahead of the ancestors of a serial walk (see ztbcommon.h) ---
+struct ZTBReadahead
+{
+    char      strWorkDir[FILENAME_MAX];
+    char      strNextID[GUID_LEN];          // the next block the thread reads ahead
+    int       intDepth;
+    int       intIssued;                    // blocks read ahead so far (thread)
+    int       intReached;                   // blocks the walker has finished
+    int       blnStop;
+    ZTBMutex  objLock;
+    ZTBThread objThread;
+};
+
+int readahead_depth(void)
+{
+    const char *strDepth = getenv("ZTB_READAHEAD");
+    int intDepth = (strDepth && strDepth[0]) ? atoi(strDepth) : READAHEAD_DEPTH;
+    return intDepth < 0 ? 0 : (intDepth > MAX_HISTORY_BLOCKS ? MAX_HISTORY_BLOCKS : intDepth);
+}
+
+void block_readahead(const char *strWorkDir_a, const char *strBlockID_a)
+{
+#if defined(POSIX_FADV_WILLNEED)
+    char strPath[FILENAME_MAX];
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    int intFd = open(strPath, O_RDONLY);
+    if (intFd >= 0)
+    {
+        posix_fadvise(intFd, 0, 0, POSIX_FADV_WILLNEED);
+        close(intFd);
+    }
+#else
+    (void)strWorkDir_a;
+    (void)strBlockID_a;
+#endif
+}
+
+// --- Where there is no readahead advice, read the file so the OS caches it ---
+static void readahead_file(const char *strWorkDir_a, const char *strBlockID_a)
+{
+#if defined(POSIX_FADV_WILLNEED)
+    block_readahead(strWorkDir_a, strBlockID_a);
+#else
+    char strPath[FILENAME_MAX];
+    uint8_t *byBuf = (uint8_t*)malloc(STREAM_CHUNK_SIZE);
+    block_file_path(strWorkDir_a, strBlockID_a, ".ztb", strPath);
+    FILE *f = byBuf ? fopen(strPath, "rb") : NULL;
+    if (f)
+    {
+        while (fread(byBuf, 1, STREAM_CHUNK_SIZE, f) == STREAM_CHUNK_SIZE) { }
+        fclose(f);
+    }
+    if (byBuf) { free(byBuf); }
+#endif
+}
+
+static void readahead_wait(void)
+{
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec objDelay = { 0, 1000000 };
+    nanosleep(&objDelay, NULL);
+#endif
+}
+
+static void readahead_run(void *objArg_a)
+{
+    ZTBReadahead *objRa = (ZTBReadahead*)objArg_a;
+    int blnDone = 0;
+
+    while (!blnDone)
+    {
+        mutex_lock(&objRa->objLock);
+        int blnStop  = objRa->blnStop;
+        int intAhead = objRa->intIssued - objRa->intReached;
+        mutex_unlock(&objRa->objLock);
+
+        ZTBBlockHeader objHeader;
+        if (blnStop)
+        {
+            blnDone = 1;
+        }
+        else if (intAhead >= objRa->intDepth)
+        {
+            readahead_wait();
+        }
+        else if (!block_header(objRa->strWorkDir, objRa->strNextID, &objHeader))
+        {
+            blnDone = 1;                    // missing: the walker reports it
+        }
+        else
+        {
+            readahead_file(objRa->strWorkDir, objRa->strNextID);
+            mutex_lock(&objRa->objLock);
+            objRa->intIssued++;
+            mutex_unlock(&objRa->objLock);
+
+            snprintf(objRa->strNextID, GUID_LEN, "%s", objHeader.strPrevID);
+            blnDone = (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION ||
+                       strcmp(objRa->strNextID, NULL_GUID) == 0);
+        }
+    }
+}
+
+ZTBReadahead* readahead_start(const char *strWorkDir_a, const char *strTipID_a, int intDepth_a)
+{
+    ZTBReadahead *objRa = (intDepth_a > 0 && strcmp(strTipID_a, NULL_GUID) != 0) ?
+                          (ZTBReadahead*)calloc(1, sizeof(ZTBReadahead)) : NULL;
+
+    if (objRa)
+    {
+        snprintf(objRa->strWorkDir, FILENAME_MAX, "%s", strWorkDir_a);
+        snprintf(objRa->strNextID, GUID_LEN, "%s", strTipID_a);
+        objRa->intDepth = intDepth_a;
+        mutex_init(&objRa->objLock);
+        if (!thread_start(&objRa->objThread, readahead_run, objRa))
+        {
+            mutex_destroy(&objRa->objLock);
+            free(objRa);
+            objRa = NULL;
+        }
+    }
+
+    return objRa;
+}
+
+void readahead_step(ZTBReadahead *objReadahead_a)
+{
+    if (objReadahead_a)
+    {
+        mutex_lock(&objReadahead_a->objLock);
+        objReadahead_a->intReached++;
+        mutex_unlock(&objReadahead_a->objLock);
+    }
+}
+
+void readahead_stop(ZTBReadahead *objReadahead_a)
+{
+    if (objReadahead_a)
+    {
+        mutex_lock(&objReadahead_a->objLock);
+        objReadahead_a->blnStop = 1;
+        mutex_unlock(&objReadahead_a->objLock);
+        thread_join(objReadahead_a->objThread);
+        mutex_destroy(&objReadahead_a->objLock);
+        free(objReadahead_a);
+    }
+}
+
+// --- Chains index (<workdir>/chains.idx) ---
+// Chain names are indexed only if they fit the 36-byte trunk_id field and have no
+// whitespace; anything else is left out with a warning (the block is still written).
+static int chains_index_name_ok(const char *strName_a)
+{
+    int intLen = (int)strlen(strName_a);
+    int intOK  = (intLen > 0 && intLen < GUID_LEN);
+    int intI;
+    for (intI = 0; intI < intLen && intOK; intI++)
+    {
+        intOK = (strName_a[intI] > ' ');
+    }
+    return intOK;
+}
+
+static int chains_index_write(const char *strWorkDir_a, const char *strLine_a, ZTBSync *objSync_a)
+{
+    int intResult = 0;
+    char strPath[FILENAME_MAX];
+    snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, CHAINS_INDEX_FILE);
+
+    FILE *f = fopen(strPath, "ab");
+    if (f)
+    {
+        intResult = (fputs(strLine_a, f) >= 0);
+        if (intResult && objSync_a && objSync_a->intPolicy != SYNC_NONE)
+        {
+            intResult = sync_stream(f);
+        }
+        if (fclose(f) != 0) { intResult = 0; }
+    }
+    if (!intResult) { fprintf(stderr, "Warning: Cannot update %s\n", strPath); }
+
+    return intResult;
+}
+
+int chains_index_tip(const char *strWorkDir_a, const char *strChainID_a,
+                     const char *strTipID_a, ZTBSync *objSync_a)
+{
+    int intResult = 0;
+    if (!chains_index_name_ok(strChainID_a))
+    {
+        fprintf(stderr, "Warning: Chain '%s' not indexed (max 36 characters, no spaces)\n",
+                strChainID_a);
+    }
+    else
+    {
+        char strLine[2 * GUID_LEN + 8];
+        snprintf(strLine, sizeof(strLine), "T %s %s\n", strChainID_a, strTipID_a);
+        intResult = chains_index_write(strWorkDir_a, strLine, objSync_a);
+    }
+    return intResult;
+}
+
+int chains_index_branch(const char *strWorkDir_a, const char *strTrunkID_a,
+                        const char *strBranchID_a, const char *strFirstID_a,
+                        const char *strForkID_a, ZTBSync *objSync_a)
+{
+    int intResult = 0;
+    if (!chains_index_name_ok(strTrunkID_a) || !chains_index_name_ok(strBranchID_a))
+    {
+        fprintf(stderr, "Warning: Branch '%s' of '%s' not indexed (max 36 characters, no spaces)\n",
+                strBranchID_a, strTrunkID_a);
+    }
+    else
+    {
+        char strLine[4 * GUID_LEN + 8];
+        snprintf(strLine, sizeof(strLine), "B %s %s %s %s\n", strTrunkID_a, strBranchID_a,
+                 strFirstID_a, strForkID_a);
+        intResult = chains_index_write(strWorkDir_a, strLine, objSync_a);
+    }
+    return intResult;
+}
+
+int chains_index_find(const ZTBChainIndex *objIndex_a, const char *strChainID_a)
+{
+    int intResult = -1;
+    int intI;
+    for (intI = 0; intI < objIndex_a->intCount && intResult < 0; intI++)
+    {
+        if (strcmp(objIndex_a->arrChains[intI].strName, strChainID_a) == 0) { intResult = intI; }
+    }
+    return intResult;
+}
+
+// --- Entry for a chain, added if new. NULL if out of memory ---
+static ZTBChainEntry* chains_index_entry(ZTBChainIndex *objIndex_a, const char *strChainID_a)
+{
+    ZTBChainEntry *objResult = NULL;
+    int intAt = chains_index_find(objIndex_a, strChainID_a);
+
+    if (intAt >= 0)
+    {
+        objResult = &objIndex_a->arrChains[intAt];
+    }
+    else
+    {
+        if (objIndex_a->intCount == objIndex_a->intCap)
+        {
+            int intCap = objIndex_a->intCap ? objIndex_a->intCap * 2 : 16;
+            ZTBChainEntry *arrNew = (ZTBChainEntry*)realloc(objIndex_a->arrChains,
+                                                            (size_t)intCap * sizeof(ZTBChainEntry));
+            if (arrNew)
+            {
+                objIndex_a->arrChains = arrNew;
+                objIndex_a->intCap    = intCap;
+            }
+        }
+        if (objIndex_a->intCount < objIndex_a->intCap)
+        {
+            objResult = &objIndex_a->arrChains[objIndex_a->intCount++];
+            memset(objResult, 0, sizeof(*objResult));
+            snprintf(objResult->strName, GUID_LEN, "%s", strChainID_a);
+        }
+    }
+
+    return objResult;
+}
+
+int chains_index_load(const char *strWorkDir_a, ZTBChainIndex *objIndex_a)
+{
+    int intResult = 1;
+    char strPath[FILENAME_MAX];
+    snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, CHAINS_INDEX_FILE);
+
+    memset(objIndex_a, 0, sizeof(*objIndex_a));
+    FILE *f = fopen(strPath, "rb");
+    if (!f)
+    {
+        intResult = 0;
+    }
+    else
+    {
+        char strLine[256];
+        while (intResult && fgets(strLine, sizeof(strLine), f))
+        {
+            char arrField[4][64];
+            int intFields = sscanf(strLine, "%*s %63s %63s %63s %63s",
+                                   arrField[0], arrField[1], arrField[2], arrField[3]);
+            ZTBChainEntry *objEntry = NULL;
+
+            // Later lines win; a torn last line (no newline) is ignored
+            if (strchr(strLine, '\n') == NULL) { continue; }
+
+            if (strLine[0] == 'T' && intFields == 2 && strlen(arrField[0]) < GUID_LEN &&
+                strlen(arrField[1]) == GUID_LEN - 1)
+            {
+                objEntry  = chains_index_entry(objIndex_a, arrField[0]);
+                intResult = (objEntry != NULL);
+                if (objEntry) { snprintf(objEntry->strTip, GUID_LEN, "%s", arrField[1]); }
+            }
+            else if (strLine[0] == 'B' && intFields == 4 && strlen(arrField[0]) < GUID_LEN &&
+                     strlen(arrField[1]) < GUID_LEN && strlen(arrField[2]) == GUID_LEN - 1 &&
+                     strlen(arrField[3]) == GUID_LEN - 1)
+            {
+                objEntry  = chains_index_entry(objIndex_a, arrField[1]);
+                intResult = (objEntry != NULL);
+                if (objEntry)
+                {
+                    snprintf(objEntry->strTrunk, GUID_LEN, "%s", arrField[0]);
+                    snprintf(objEntry->strFirst, GUID_LEN, "%s", arrField[2]);
+                    snprintf(objEntry->strFork,  GUID_LEN, "%s", arrField[3]);
+                }
+            }
+        }
+        fclose(f);
+    }
+
+    if (!intResult) { chains_index_free(objIndex_a); }
+    return intResult;
+}
+
+void chains_index_free(ZTBChainIndex *objIndex_a)
+{
+    if (objIndex_a->arrChains) { free(objIndex_a->arrChains); }
+    memset(objIndex_a, 0, sizeof(*objIndex_a));
+}
+
+// --- Last recorded tip of one chain. Returns 1 if recorded ---
+// Only the end of chains.idx is read (CHAINS_TAIL_READ bytes), where a chain being
+// appended to has its latest line; the whole index is loaded only if that misses.
+int chains_index_last_tip(const char *strWorkDir_a, const char *strChainID_a, char *strTipID_a)
+{
+    int blnFound   = 0;
+    int blnPartial = 1;
+    char strPath[FILENAME_MAX];
+    snprintf(strPath, FILENAME_MAX, "%s/%s", strWorkDir_a, CHAINS_INDEX_FILE);
+    strTipID_a[0] = '\0';
+
+    FILE *f = fopen(strPath, "rb");
+    if (f && ZTB_FSEEK(f, 0, SEEK_END) == 0)
+    {
+        int64_t intSize = (int64_t)ZTB_FTELL(f);
+        int64_t intFrom = intSize > CHAINS_TAIL_READ ? intSize - CHAINS_TAIL_READ : 0;
+        char *strBuf    = (char*)malloc(CHAINS_TAIL_READ);
+        size_t intLen   = 0;
+
+        if (strBuf && ZTB_FSEEK(f, intFrom, SEEK_SET) == 0)
+        {
+            intLen = fread(strBuf, 1, CHAINS_TAIL_READ, f);
+        }
+        blnPartial = (intFrom > 0);
+
+        if (strBuf)
+        {
+            size_t intNameLen = strlen(strChainID_a);
+            char *strLine = strBuf;
+            char *strEnd  = strBuf + intLen;
+
+            // The window's first line may be cut; a torn last line has no newline
+            if (blnPartial)
+            {
+                while (strLine < strEnd && *strLine != '\n') { strLine++; }
+                strLine++;
+            }
+            while (strLine < strEnd)
+            {
+                char *strNL = (char*)memchr(strLine, '\n', (size_t)(strEnd - strLine));
+                if (!strNL) { break; }
+
+                if ((size_t)(strNL - strLine) == 3 + intNameLen + GUID_LEN - 1 &&
+                    strLine[0] == 'T' && strLine[1] == ' ' &&
+                    memcmp(strLine + 2, strChainID_a, intNameLen) == 0 &&
+                    strLine[2 + intNameLen] == ' ')
+                {
+                    memcpy(strTipID_a, strLine + 3 + intNameLen, GUID_LEN - 1);
+                    strTipID_a[GUID_LEN - 1] = '\0';
+                    blnFound = 1;
+                }
+                strLine = strNL + 1;
+            }
+            free(strBuf);
+        }
+    }
+    if (f) { fclose(f); }
+
+    if (!blnFound && blnPartial)
+    {
+        ZTBChainIndex objIndex;
+        if (chains_index_load(strWorkDir_a, &objIndex))
+        {
+            int intAt = chains_index_find(&objIndex, strChainID_a);
+            if (intAt >= 0 && objIndex.arrChains[intAt].strTip[0])
+            {
+                snprintf(strTipID_a, GUID_LEN, "%s", objIndex.arrChains[intAt].strTip);
+                blnFound = 1;
+            }
+            chains_index_free(&objIndex);
+        }
+    }
+
+    return blnFound;
+}
+
+// --- Chain locks (see ZTBChainLock) ---
+int chain_lock(const char *strWorkDir_a, const char *strChainID_a, ZTBChainLock *objLock_a)
+{
+    int intResult = 0;
+    char strPath[FILENAME_MAX];
+    uint32_t intHash = 2166136261u;
+    const char *strC;
+
+    for (strC = strChainID_a; *strC; strC++) { intHash = (intHash ^ (uint8_t)*strC) * 16777619u; }
+    snprintf(strPath, FILENAME_MAX, CHAIN_LOCK_FMT, strWorkDir_a, intHash);
+
+#ifdef _WIN32
+    objLock_a->hFile = CreateFileA(strPath, GENERIC_READ | GENERIC_WRITE,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (objLock_a->hFile != INVALID_HANDLE_VALUE)
+    {
+        OVERLAPPED objAt;
+        memset(&objAt, 0, sizeof(objAt));
+        intResult = LockFileEx(objLock_a->hFile, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &objAt) ? 1 : 0;
+        if (!intResult)
+        {
+            CloseHandle(objLock_a->hFile);
+            objLock_a->hFile = INVALID_HANDLE_VALUE;
+        }
+    }
+#else
+    objLock_a->intFd = open(strPath, O_RDWR | O_CREAT, 0644);
+    if (objLock_a->intFd >= 0)
+    {
+        struct flock objRange;
+        int intRC;
+        memset(&objRange, 0, sizeof(objRange));
+        objRange.l_type   = F_WRLCK;
+        objRange.l_whence = SEEK_SET;
+        do { intRC = fcntl(objLock_a->intFd, F_SETLKW, &objRange); } while (intRC != 0 && errno == EINTR);
+        intResult = (intRC == 0);
+        if (!intResult)
+        {
+            close(objLock_a->intFd);
+            objLock_a->intFd = -1;
+        }
+    }
+#endif
+
+    if (!intResult) { fprintf(stderr, "Error: Cannot lock chain '%s' (%s)\n", strChainID_a, strPath); }
+    return intResult;
+}
+
+void chain_unlock(ZTBChainLock *objLock_a)
+{
+#ifdef _WIN32
+    if (objLock_a->hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(objLock_a->hFile);
+        objLock_a->hFile = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (objLock_a->intFd >= 0)
+    {
+        close(objLock_a->intFd);
+        objLock_a->intFd = -1;
+    }
+#endif
 }
\ No newline at end of file
@@ -1,10 +1,19 @@
-// Cyborg ZTB Common Definitions v20260618
+// Cyborg ZTB Common Definitions v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 
 #ifndef ZTB_COMMON_H
 #define ZTB_COMMON_H
 
+// 64-bit file offsets (fseeko/ftello) for blocks larger than 2 GB
+#ifndef _WIN32
+    #ifndef _POSIX_C_SOURCE
+        #define _POSIX_C_SOURCE 200809L
+    #endif
+    #define _FILE_OFFSET_BITS 64
+#endif
+
+#include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,13 +24,26 @@
     #include <windows.h>
     #include <io.h>
     #include <fcntl.h>
+    #include <errno.h>
+    #include <sys/stat.h>
     #define FILENAME_MAX 260
 #else
     #include <unistd.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <errno.h>
+    #include <pthread.h>
     #include <sys/stat.h>
 #endif
 
+#ifdef _WIN32
+    #define ZTB_FSEEK _fseeki64
+    #define ZTB_FTELL _ftelli64
+#else
+    #define ZTB_FSEEK fseeko
+    #define ZTB_FTELL ftello
+#endif
+
 // --- Constants (match clsZTB exactly) ---
 #define ROM_SIZE            65536
 #define MIN_PAYLOAD_SIZE    512
@@ -29,6 +51,8 @@
 #define ROM_ENTRY_SIZE      1024
 #define NULL_GUID           "00000000-0000-0000-0000-000000000000"
 #define GUID_LEN            37
+#define STREAM_CHUNK_SIZE   65536
+#define MAX_PAYLOAD_LEN     0xFFFFFFFFULL   // payload_len/padded_len are uint32 on disk
 
 // --- Block type values (match ZTBBlockType enum) ---
 #define BLOCK_TYPE_GENESIS      0
@@ -75,27 +99,533 @@
 #define ENC_OFF_PAYLOAD     17
 #define ENC_HEADER_SIZE     17
 
+// --- Compressed payloads (ENC_FLAG_LZ4 set in hash_type) ---
+// The payload stored in the block (payload_len bytes, padded, hashed and encoded like
+// any other) is then an LZ4 stream rather than the data itself:
+//   bytes 0-7:    data_len (uint64 LE) -- length of the decompressed payload
+//   bytes 8-11:   data_crc (uint32 LE) -- CRC32 of the decompressed payload
+//   then frames:  raw_len (uint32 LE, 1..STREAM_CHUNK_SIZE), stored_len (uint32 LE),
+//                 stored_len bytes: an LZ4 block, or the raw_len bytes as they are
+//                 when stored_len == raw_len (the chunk did not shrink)
+// hash, prev_hash and the file CRC keep their meaning and cover the bytes on disk, so
+// chains link and verify exactly as before; data_crc is checked as readers decompress.
+// Blocks without the flag are read as they always were.
+#define ENC_FLAG_LZ4        0x80
+#define ENC_HASH_TYPE_MASK  0x7F
+#define LZ4_STREAM_HEADER   12
+#define LZ4_FRAME_HEADER    8
+
 // --- CRC32 ---
 uint32_t calculate_crc32(const uint8_t *byData_a, int intOffset_a, int intLen_a);
 
+// --- Streaming CRC32: start from CRC32_INIT, finish with ^ CRC32_INIT ---
+#define CRC32_INIT          0xFFFFFFFF
+uint32_t crc32_update(uint32_t intCrc_a, const uint8_t *byData_a, size_t intLen_a);
+
+// --- CRC32 of A+B from the finished CRCs of A and B (B is intLen2_a bytes) ---
+uint32_t crc32_combine(uint32_t intCrc1_a, uint32_t intCrc2_a, uint64_t intLen2_a);
+
 // --- XorShift32 (matches clsZTB.XorShift32) ---
 uint32_t xorshift32(uint32_t intState_a);
 
+// --- SHA-256 (FIPS 180-4), streaming: init, update any number of times, final ---
+#define SHA256_LEN          32
+typedef struct
+{
+    uint32_t arrState[8];
+    uint64_t intLen;                        // bytes hashed so far
+    uint8_t  arrBuf[64];
+    size_t   intBufLen;
+} ZTBSha256;
+
+void sha256_init(ZTBSha256 *objSha_a);
+void sha256_update(ZTBSha256 *objSha_a, const uint8_t *byData_a, size_t intLen_a);
+void sha256_final(ZTBSha256 *objSha_a, uint8_t *byDigest_a);
+
+// --- Hex strings (lower case) ---
+void hex_encode(const uint8_t *byData_a, int intLen_a, char *strHex_a);    // 2*len + NUL
+int  hex_decode(const char *strHex_a, uint8_t *byData_a, int intLen_a);    // exactly 2*len digits
+
 // --- ZOSCII encode/decode ---
 uint8_t* zoscii_encode(const uint8_t *byRom_a, const uint8_t *byData_a,
                        int intLen_a, int *intEncodedLen_a);
 uint8_t* zoscii_decode(const uint8_t *byRom_a, const uint8_t *byData_a,
                        int intOffset_a, int intLen_a, int *intDecodedLen_a);
 
+// --- ZOSCII encoder with a prebuilt address index (reused across chunks) ---
+typedef struct
+{
+    const uint8_t *byRom;
+    uint16_t       arrAddr[ROM_SIZE];   // ROM addresses grouped by byte value
+    int            arrStart[256];
+    int            arrCount[256];
+    uint32_t       intSeed;
+} ZTBEncoder;
+
+void encoder_init(ZTBEncoder *objEnc_a, const uint8_t *byRom_a);
+int  encoder_encode(ZTBEncoder *objEnc_a, const uint8_t *byData_a, size_t intLen_a,
+                    uint8_t *byOut_a);
+
+// --- Payload source for the streaming block writer (memory buffer or open file) ---
+typedef struct
+{
+    FILE          *f;
+    const uint8_t *byData;
+    uint64_t       intLen;
+    uint64_t       intPos;
+    int            blnCompress;             // store it LZ4-compressed (0 from source_from_*)
+} ZTBSource;
+
+#define SOURCE_UNBOUNDED    UINT64_MAX      // file source read to EOF
+
+void   source_from_memory(ZTBSource *objSrc_a, const uint8_t *byData_a, uint64_t intLen_a);
+void   source_from_file(ZTBSource *objSrc_a, FILE *f_a);
+void   source_from_file_range(ZTBSource *objSrc_a, FILE *f_a, uint64_t intLen_a);
+size_t source_read(ZTBSource *objSrc_a, uint8_t *byBuf_a, size_t intMax_a);
+
+// --- Result of write_block ---
+typedef struct
+{
+    uint32_t intHash;
+    uint32_t intPrevHash;
+    uint64_t intPayloadLen;
+    uint64_t intPaddedLen;
+    uint64_t intDataLen;                    // payload before compression (= intPayloadLen if none)
+    uint32_t intFileCrc;                    // CRC32 of the complete on-disk block
+} ZTBWriteResult;
+
+// --- Rolling ROM held across appends (ROM for the block after strPrevID) ---
+// arrRom is the logical ROM exactly as build_rolling_rom would return it. The encode
+// index is kept over arrPhys, whose ROM_ENTRY_SIZE slabs are mapped to logical slabs
+// via arrSlabPhys/arrPhysSlab, so an advance only re-indexes the one slab it replaces.
+typedef struct
+{
+    uint8_t   arrRom[ROM_SIZE];
+    uint8_t   arrPhys[ROM_SIZE];
+    int       arrSlabPhys[ROM_SIZE / ROM_ENTRY_SIZE];
+    int       arrPhysSlab[ROM_SIZE / ROM_ENTRY_SIZE];
+    uint16_t *arrList[256];                 // physical addresses holding each byte value
+    int       arrCount[256];
+    int       arrCap[256];
+    uint16_t  arrWhere[ROM_SIZE];           // position of each address in its list
+    int       intSlices;                    // history slices in the ROM (<= MAX_HISTORY_BLOCKS)
+    uint32_t  intSeed;
+    uint32_t  intPrevCrc;                   // CRC32 of the whole strPrevID block (0 if none)
+    char      strPrevID[GUID_LEN];
+} ZTBRollingRom;
+
+ZTBRollingRom* rolling_rom_open(const char *strWorkDir_a, const char *strPrevBlockID_a);
+ZTBRollingRom* rolling_rom_load(const uint8_t *arrRom_a, int intSlices_a, uint32_t intPrevCrc_a,
+                                const char *strPrevBlockID_a);
+void rolling_rom_close(ZTBRollingRom *objRom_a);
+int  rolling_rom_advance(ZTBRollingRom *objRom_a, const uint8_t *byBlockHead_a,
+                         int intHeadLen_a, const char *strBlockID_a, uint32_t intBlockCrc_a);
+int  rolling_rom_encode(ZTBRollingRom *objRom_a, const uint8_t *byData_a, size_t intLen_a,
+                        uint8_t *byOut_a);
+
+// --- Build the 111-byte raw header ---
+void build_raw_header(uint8_t *byHeader_a, int intBlockType_a, int blnIsBranch_a,
+                      const char *strTrunkID_a, const char *strBlockID_a,
+                      const char *strPrevBlockID_a);
+
+// --- Durability policy for write_block ---
+// SYNC_NONE:  rename the tmp into place, no fsync (fastest, may lose recent blocks)
+// SYNC_BLOCK: fsync each block before its rename, then fsync the directory
+// SYNC_GROUP: leave blocks as .tmp until the group commits (intGroupMax blocks or the
+//             oldest pending block is intGroupMs old, whether or not another block
+//             comes: a timer thread commits the group when the window closes); the
+//             commit fsyncs the pending files back to back, renames them in chain
+//             order and fsyncs the directory once. Callers must sync_commit() before
+//             exiting, and sync_free() stops the timer thread.
+#define SYNC_NONE           0
+#define SYNC_BLOCK          1
+#define SYNC_GROUP          2
+#define SYNC_GROUP_MAX      64
+#define SYNC_GROUP_MS       100
+
+typedef struct
+{
+    int        intPolicy;
+    int        intGroupMax;
+    int        intGroupMs;
+    int        intPending;
+    char     (*arrPending)[GUID_LEN];       // block IDs waiting for the group commit
+    uint64_t   intFirstPendingMs;
+    int        blnFailed;                   // a timer commit failed (the next sync_commit returns 0)
+    struct ZTBSyncTimer *objTimer;          // group commit thread, started by the first deferred block
+    void     (*fnDurable)(const char *strBlockID_a);   // optional: called once a block is durable
+} ZTBSync;
+
+void sync_init(ZTBSync *objSync_a);
+int  sync_parse(ZTBSync *objSync_a, const char *strSpec_a);    // none | block | group[:count[:ms]]
+int  sync_take_option(ZTBSync *objSync_a, int *argc_a, char *argv_a[]);
+const char* sync_option(int *argc_a, char *argv_a[]);          // strip "-sync <policy>"
+int  sync_commit(ZTBSync *objSync_a, const char *strWorkDir_a);
+void sync_free(ZTBSync *objSync_a);
+
+// --- fflush and fsync an open file ---
+int  sync_stream(FILE *f_a);
+
+// --- Rename a finished .tmp into place (replacing any old file) ---
+int  rename_block_file(const char *strTmpPath_a, const char *strOutPath_a, int blnDurable_a);
+// Block files proper are never replaced: their tmp is created exclusively and renamed
+// into place only if no block file of that ID exists (both fail on a collision)
+FILE* create_block_tmp(const char *strTmpPath_a);
+int  rename_new_block_file(const char *strTmpPath_a, const char *strOutPath_a, int blnDurable_a);
+
+// --- GUIDs ---
+int  is_valid_guid(const char *strGuid_a);
+void generate_guid(char *strOut_a);
+int  block_exists(const char *strWorkDir_a, const char *strBlockID_a);
+
+// --- Streaming block writer: pads, hashes and ZOSCII-encodes the payload in chunks ---
+// On success objRom_a has been advanced past the new block, ready for the next append.
+// objSync_a may be NULL (same as SYNC_NONE).
+int write_block(const char *strWorkDir_a, const uint8_t *byRawHeader_a,
+                ZTBRollingRom *objRom_a, ZTBSource *objSrc_a, ZTBSync *objSync_a,
+                ZTBWriteResult *objResult_a);
+
+// --- Workdir layout ---
+// <workdir>/ztb.meta (optional text file) records how the block files are laid out:
+//   ZTBMETA1
+//   layout flat|fanout
+//   genesis <block_id>
+//   migrating                  (only while ztbmigrate is moving files)
+// flat:   <workdir>/<block_id>.ztb -- also the layout of a workdir without ztb.meta
+// fanout: <workdir>/<id[0..1]>/<id[2..3]>/<block_id>.ztb, so no directory ends up
+//         holding millions of entries
+// .rom snapshots and .tmp files sit beside their block. With a genesis recorded,
+// find_genesis opens it directly instead of scanning the workdir. While "migrating"
+// is set, a file missing from its layout's place is looked up in the other layout,
+// so a workdir stays readable part way through (and after an interrupted) migration.
+// The metadata is cached per workdir for the life of the process.
+#define WORKDIR_META_FILE   "ztb.meta"
+#define WORKDIR_META_MAGIC  "ZTBMETA1"
+#define LAYOUT_FLAT         0
+#define LAYOUT_FANOUT       1
+
+typedef struct
+{
+    int  intLayout;
+    int  blnMigrating;
+    char strGenesis[GUID_LEN];              // "" if not recorded
+} ZTBWorkdirMeta;
+
+int  workdir_meta_load(const char *strWorkDir_a, ZTBWorkdirMeta *objMeta_a);
+int  workdir_meta_save(const char *strWorkDir_a, const ZTBWorkdirMeta *objMeta_a);
+void block_file_path(const char *strWorkDir_a, const char *strBlockID_a, const char *strExt_a,
+                     char *strPath_a);
+void block_file_path_in(const char *strWorkDir_a, int intLayout_a, const char *strBlockID_a,
+                        const char *strExt_a, char *strPath_a);
+int  block_file_dirs(const char *strWorkDir_a, int intLayout_a, const char *strBlockID_a);
+int  find_genesis_id(const char *strWorkDir_a, char *strGenesisID_a);
+
 // --- Load a block file: <workdir>/<blockID>.ztb ---
 uint8_t* load_block(const char *strWorkDir_a, const char *strBlockID_a, int *intLen_a);
 
-// --- Find genesis: scan workdir for a .ztb file of exactly ROM_SIZE bytes ---
+// --- Read at most intMax_a leading bytes of a block; full file size in *intFileLen_a ---
+int read_block_prefix(const char *strWorkDir_a, const char *strBlockID_a,
+                      uint8_t *byBuf_a, int intMax_a, uint64_t *intFileLen_a);
+
+// --- CRC32 of a complete block file, streamed ---
+int block_crc32(const char *strWorkDir_a, const char *strBlockID_a, uint32_t *intCrc_a);
+
+// --- 1 if a block's stored prev_hash matches strPrevID_a (or is not checked) ---
+int block_prev_hash_ok(const char *strWorkDir_a, const char *strPrevID_a, int intHashType_a,
+                       uint32_t intStoredPrevHash_a);
+
+// --- Find genesis: the one in ztb.meta, else the .ztb file of exactly ROM_SIZE bytes ---
 uint8_t* find_genesis(const char *strWorkDir_a);
 
-// --- Build rolling ROM (matches clsZTB.BuildRollingROM) ---
+// --- Block cache ---
+// load_block, read_block_prefix, block_crc32, block_header and find_genesis (and so
+// the rolling ROM walk) all go through one per-process LRU cache of block file bytes,
+// keyed by workdir and block ID. An entry holds the leading bytes read so far (the
+// whole file if it fits in an eighth of the budget, else at most HEADER_RAW_SIZE +
+// ROM_SIZE), the file's CRC32 once taken and its parsed raw header. Every lookup stats
+// the file and drops the entry if its size, mtime or inode changed, so a block
+// rewritten by another process (ztbtruncate) is never served stale. The streaming
+// block reader does not use the cache: payloads are decoded from the file.
+// The budget is BLOCK_CACHE_DEFAULT_MB unless ZTB_CACHE_MB is set; 0 turns it off.
+#define BLOCK_CACHE_DEFAULT_MB  64
+#define BLOCK_CACHE_MIN_READ    ROM_ENTRY_SIZE      // header + ROM slice in one read
+
+typedef struct
+{
+    int      intBlockType;
+    int      intVersion;
+    int      blnIsBranch;
+    char     strTrunkID[GUID_LEN];
+    char     strBlockID[GUID_LEN];
+    char     strPrevID[GUID_LEN];
+    uint64_t intFileLen;
+} ZTBBlockHeader;
+
+typedef struct
+{
+    uint64_t intHits;
+    uint64_t intMisses;
+    uint64_t intEvictions;
+    uint64_t intBytes;                      // entries' data and bookkeeping
+    uint64_t intBudget;
+    int      intEntries;
+} ZTBCacheStats;
+
+int  block_header(const char *strWorkDir_a, const char *strBlockID_a, ZTBBlockHeader *objHeader_a);
+void block_cache_set_budget(uint64_t intBytes_a);  // evicts down to it; 0 = off
+void block_cache_stats(ZTBCacheStats *objStats_a);
+void block_cache_clear(void);
+
+// --- Sorted IDs of every non-genesis block in the workdir; count or -1 ---
+int list_blocks(const char *strWorkDir_a, char (**arrIDs_a)[GUID_LEN]);
+int compare_ids(const void *objA_a, const void *objB_a);       // qsort order of list_blocks
+
+// --- Walk back from a tip over raw headers collecting block IDs (newest first) ---
+// Stops after intMax_a blocks (0 = no limit), at strStopID_a (included; NULL = none),
+// at a truncation block (excluded) or at the start of the chain. Count or -1.
+int collect_chain(const char *strWorkDir_a, const char *strTipID_a,
+                  const char *strStopID_a, int intMax_a, char (**arrIDs_a)[GUID_LEN]);
+
+// --- Set of block IDs ---
+typedef struct
+{
+    char (*arrSlots)[GUID_LEN];             // empty slot = ""
+    int    intCount;
+    int    intCap;                          // power of two
+} ZTBIdSet;
+
+int  idset_init(ZTBIdSet *objSet_a, int intExpected_a);
+int  idset_add(ZTBIdSet *objSet_a, const char *strID_a);        // 1 added, 0 present, -1 no memory
+int  idset_has(const ZTBIdSet *objSet_a, const char *strID_a);
+void idset_free(ZTBIdSet *objSet_a);
+
+// --- Runs of consecutive blocks for the parallel tools (see plan_runs) ---
+typedef struct
+{
+    int intFirst;                           // index into the planned block list
+    int intCount;
+} ZTBRun;
+
+#define RUN_BLOCKS_MIN      16
+#define RUN_BLOCKS_MAX      1024
+
+int plan_runs(const char *strWorkDir_a, char (*arrTips_a)[GUID_LEN], int intTips_a,
+              int intWorkers_a, char (**arrIDs_a)[GUID_LEN], ZTBRun **arrRuns_a, int *intRuns_a);
+
+// --- Chains index: <workdir>/chains.idx, appended to by the append tools ---
+// One text line per event; later lines win:
+//   T <chain_id> <tip_block_id>                                       new tip
+//   B <trunk_chain_id> <branch_chain_id> <first_block_id> <fork_block_id>   new branch
+// The fork block is the trunk block the branch's first block follows. Tips are
+// recorded once the block is durable, so after a crash a tip can lag, never lead.
+#define CHAINS_INDEX_FILE   "chains.idx"
+
+typedef struct
+{
+    char strName[GUID_LEN];
+    char strTip[GUID_LEN];                  // "" if no tip recorded
+    char strTrunk[GUID_LEN];                // "" unless the chain is a branch
+    char strFirst[GUID_LEN];
+    char strFork[GUID_LEN];
+} ZTBChainEntry;
+
+typedef struct
+{
+    ZTBChainEntry *arrChains;
+    int            intCount;
+    int            intCap;
+} ZTBChainIndex;
+
+// --- Build rolling ROM (matches clsZTB.BuildRollingROM; stops early at a ROM snapshot) ---
 uint8_t* build_rolling_rom(const char *strWorkDir_a, const char *strPrevBlockID_a);
 
+// --- ROM snapshot (<workdir>/<blockID>.rom, written at checkpoints) ---
+// The rolling ROM as of a checkpoint, so build_rolling_rom can stop its walk there.
+// bytes  0-7:   magic "ZTBROM01"
+// bytes  8-43:  block_id (36 bytes ASCII)
+// bytes 44-47:  history slices in the ROM (uint32 LE)
+// bytes 48-51:  CRC32 of the whole checkpoint block file (uint32 LE)
+// bytes 52-55:  CRC32 of the ROM bytes (uint32 LE)
+// bytes 56+:    ROM (ROM_SIZE bytes)
+// A snapshot whose block CRC no longer matches the block is ignored.
+#define ROM_SNAPSHOT_EXT    ".rom"
+#define SNAP_MAGIC          "ZTBROM01"
+#define SNAP_MAGIC_LEN      8
+#define SNAP_OFF_BLOCK_ID   8
+#define SNAP_OFF_SLICES     44
+#define SNAP_OFF_BLOCK_CRC  48
+#define SNAP_OFF_ROM_CRC    52
+#define SNAP_HEADER_SIZE    56
+
+int  rom_snapshot_write(const char *strWorkDir_a, const char *strBlockID_a,
+                        const uint8_t *arrRom_a, int intSlices_a, uint32_t intBlockCrc_a);
+void rom_snapshot_remove(const char *strWorkDir_a, const char *strBlockID_a);
+int  rom_snapshot_valid(const char *strWorkDir_a, const char *strBlockID_a);
+
+// --- Merkle checkpoints (ztbcheckpoint -merkle, ztbprove) ---
+// A Merkle checkpoint commits to the blocks below it: every block from its prev back
+// to the start of the chain, or to the newest truncation (excluded), oldest first.
+// Hashing follows RFC 6962 (the Certificate Transparency tree), with SHA-256:
+//   leaf  = SHA-256(0x00 || whole block file)
+//   node  = SHA-256(0x01 || left || right)
+//   root  = MTH over the n leaves, split at the largest power of two below n
+// so an inclusion proof is the RFC 6962 audit path, at most MERKLE_MAX_PATH hashes.
+// The root goes on the end of the checkpoint's payload, after its label:
+//   "<label>\nZTBMERKLE1 <n> <root as 64 hex digits>"
+// The leaves are kept in <workdir>/<blockID>.mrk so the next Merkle checkpoint on the
+// chain only hashes the blocks added since:
+// bytes  0-7:   magic "ZTBMRK01"
+// bytes  8-43:  block_id (36 bytes ASCII)
+// bytes 44-47:  leaf count n (uint32 LE)
+// bytes 48-51:  CRC32 of the whole checkpoint block file (uint32 LE)
+// bytes 52-83:  root
+// bytes 84+:    n leaf hashes (32 bytes each), then a CRC32 of everything before it
+// Like a ROM snapshot it is only a cache: one whose block CRC, count or root no longer
+// matches is ignored and the leaves are hashed again.
+#define MERKLE_EXT          ".mrk"
+#define MERKLE_MAGIC        "ZTBMRK01"
+#define MERKLE_MAGIC_LEN    8
+#define MERKLE_OFF_BLOCK_ID 8
+#define MERKLE_OFF_COUNT    44
+#define MERKLE_OFF_BLOCK_CRC 48
+#define MERKLE_OFF_ROOT     52
+#define MERKLE_HEADER_SIZE  84
+#define MERKLE_LINE         "ZTBMERKLE1"
+#define MERKLE_LINE_MAX     96
+#define MERKLE_MAX_PATH     32
+
+int  merkle_leaf_file(FILE *f_a, uint8_t *byLeaf_a);           // hashes to EOF; 1 = ok
+int  merkle_leaf(const char *strWorkDir_a, const char *strBlockID_a, uint8_t *byLeaf_a);
+void merkle_root(const uint8_t *arrLeaves_a, uint32_t intCount_a, uint8_t *byRoot_a);
+int  merkle_path(const uint8_t *arrLeaves_a, uint32_t intCount_a, uint32_t intIndex_a,
+                 uint8_t *arrPath_a);                           // hashes written to arrPath_a
+int  merkle_verify(const uint8_t *byLeaf_a, uint32_t intIndex_a, uint32_t intCount_a,
+                   const uint8_t *arrPath_a, int intPathLen_a, const uint8_t *byRoot_a);
+
+// Leaves of the chain ending at strTipID_a (the new checkpoint's prev), oldest first,
+// reusing the newest valid .mrk on the way. *arrIDs_a (may be NULL) gets the block IDs
+// in the same order. Count or -1; the arrays are malloc'd (NULL when the count is 0).
+int  merkle_chain_leaves(const char *strWorkDir_a, const char *strTipID_a,
+                         char (**arrIDs_a)[GUID_LEN], uint8_t **arrLeaves_a);
+int  merkle_leaves_write(const char *strWorkDir_a, const char *strBlockID_a, uint32_t intBlockCrc_a,
+                         const uint8_t *arrLeaves_a, uint32_t intCount_a, const uint8_t *byRoot_a);
+int  merkle_leaves_load(const char *strWorkDir_a, const char *strBlockID_a, uint8_t **arrLeaves_a);
+void merkle_leaves_remove(const char *strWorkDir_a, const char *strBlockID_a);
+
+// The "\nZTBMERKLE1 ..." line for a payload, and back; parse returns 0 if there is none
+int  merkle_line(uint32_t intCount_a, const uint8_t *byRoot_a, char *strLine_a);
+int  merkle_parse(const uint8_t *byPayload_a, size_t intLen_a, uint32_t *intCount_a,
+                  uint8_t *byRoot_a);
+// Decode a checkpoint block's payload and parse its root (1 = it is a Merkle checkpoint)
+int  merkle_checkpoint_root(const char *strWorkDir_a, const char *strBlockID_a,
+                            uint32_t *intCount_a, uint8_t *byRoot_a);
+
+// --- Streaming block reader: decodes a block in STREAM_CHUNK_SIZE pieces ---
+// block_reader_open reads the raw header and decodes the 17-byte encoded header;
+// block_reader_copy then decodes the padded payload chunk by chunk, writing the first
+// intPayloadLen bytes to fOut_a (may be NULL) while it hashes the padded payload and
+// CRCs the whole file. Memory use is flat whatever the block size. Truncation blocks
+// are not encoded: open reads only their raw header (blnEncoded = 0). A compressed
+// payload is decompressed on the way to fOut_a / fnChunk_a (and checked against its
+// data_crc even when neither is given); byHashType never carries ENC_FLAG_LZ4.
+// block_reader_scan is the same pass with the payload handed to fnChunk_a instead;
+// the callback returns 0 to stop early (scan then returns 0).
+typedef struct
+{
+    FILE     *f;
+    const uint8_t *byRom;
+    uint8_t   arrRawHeader[HEADER_RAW_SIZE];
+    int       blnEncoded;
+    uint8_t   byHashType;
+    uint32_t  intStoredHash;
+    uint32_t  intStoredPrevHash;
+    uint32_t  intPayloadLen;
+    uint32_t  intPaddedLen;
+    int       blnCompressed;
+    uint64_t  intDataLen;                   // payload bytes once decompressed (= intPayloadLen if not)
+    uint32_t  intDataCrc;                   // compressed only: its data_crc
+    uint64_t  intFileLen;
+    uint64_t  intBodyLen;                   // decoded payload bytes actually in the file
+    uint32_t  intCalcHash;                  // valid after block_reader_copy
+    uint32_t  intFileCrc;                   // valid after block_reader_copy
+    uint32_t  intCrc;                       // running file CRC
+    uint8_t   arrHead[ROM_ENTRY_SIZE];      // first bytes of the file, for rolling_rom_advance
+    int       intHeadLen;
+} ZTBBlockReader;
+
+int  block_reader_open(ZTBBlockReader *objReader_a, const char *strWorkDir_a,
+                       const char *strBlockID_a, const uint8_t *byRom_a);
+int  block_reader_open_path(ZTBBlockReader *objReader_a, const char *strPath_a,
+                            const uint8_t *byRom_a);
+int  block_reader_open_file(ZTBBlockReader *objReader_a, FILE *f_a,      // a block file on its
+                            const uint8_t *byRom_a);                      // own; closed with it
+typedef int (*ZTBChunkFn)(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a);
+
+int  block_reader_copy(ZTBBlockReader *objReader_a, FILE *fOut_a);
+int  block_reader_scan(ZTBBlockReader *objReader_a, ZTBChunkFn fnChunk_a, void *objCtx_a);
+void block_reader_close(ZTBBlockReader *objReader_a);
+
+// --- LZ4 block format (compatible with the reference lz4 block codec) ---
+// lz4_compress returns the compressed length, or 0 if it would not fit in intDstCap_a.
+// lz4_decompress returns 1 only if the input decodes to exactly intDstLen_a bytes.
+// lz4_payload_inflate decompresses a whole stored payload held in memory.
+int lz4_compress(const uint8_t *bySrc_a, int intSrcLen_a, uint8_t *byDst_a, int intDstCap_a);
+int lz4_decompress(const uint8_t *bySrc_a, int intSrcLen_a, uint8_t *byDst_a, int intDstLen_a);
+int lz4_payload_inflate(const uint8_t *byStored_a, size_t intLen_a, ZTBChunkFn fnChunk_a,
+                        void *objCtx_a);
+
+// --- The same stream layout for whole files (ztbarchive) ---
+// lz4_stream_write compresses objSrc_a onto the end of fOut_a (which must be seekable:
+// the stream header is patched in last). lz4_stream_read decompresses the
+// intStoredLen_a-byte stream at the current position of fIn_a. Both return 1 on success.
+int lz4_stream_write(FILE *fOut_a, ZTBSource *objSrc_a, uint64_t *intStoredLen_a,
+                     uint64_t *intDataLen_a, uint32_t *intDataCrc_a);
+int lz4_stream_read(FILE *fIn_a, uint64_t intStoredLen_a, ZTBChunkFn fnChunk_a, void *objCtx_a);
+
+// --- Decoding a run of consecutive blocks with one advancing rolling ROM ---
+ZTBRollingRom* rolling_rom_open_before(const char *strWorkDir_a, const char *strBlockID_a,
+                                       int *blnPrevTrunc_a);
+int read_run_block(const char *strWorkDir_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                   int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a);
+int read_run_file(const char *strPath_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                  int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a);
+int read_run_stream(FILE *f_a, ZTBRollingRom *objRom_a, const char *strBlockID_a,
+                    int blnPrevTrunc_a, ZTBChunkFn fnChunk_a, void *objCtx_a, int *blnIntact_a);
+
+// --- Bundles: a run of block files in one stream (ztbexport / ztbimport) ---
+// Header: BUNDLE_MAGIC, uint32 block count, chain name (36 bytes, "" if unknown), then
+//         per block its ID (36), uint32 flags and uint64 file length, then a uint32
+//         CRC32 of everything before it.
+// Body:   each block file in index order (oldest first), followed by its uint32 CRC32.
+#define BUNDLE_MAGIC            "ZTBBND01"
+#define BUNDLE_MAGIC_LEN        8
+#define BUNDLE_OFF_COUNT        8
+#define BUNDLE_OFF_CHAIN        12
+#define BUNDLE_PREFIX_SIZE      48
+#define BUNDLE_ENTRY_SIZE       48
+#define BUNDLE_ENT_OFF_FLAGS    36
+#define BUNDLE_ENT_OFF_LEN      40
+#define BUNDLE_FLAG_GENESIS     1
+#define BUNDLE_MAX_BLOCKS       (1 << 24)
+
+typedef struct
+{
+    char     strID[GUID_LEN];
+    uint32_t intFlags;
+    uint64_t intLen;
+} ZTBBundleEntry;
+
+int bundle_write_header(FILE *fOut_a, const char *strChainID_a,
+                        const ZTBBundleEntry *arrEntries_a, int intCount_a);
+int bundle_read_header(FILE *fIn_a, char *strChainID_a, ZTBBundleEntry **arrEntries_a,
+                       int *intCount_a);
+int bundle_write_block(FILE *fOut_a, const char *strPath_a, uint64_t intLen_a);
+int bundle_read_block(FILE *fIn_a, uint64_t intLen_a, FILE *fOut_a, uint8_t *arrRawHeader_a,
+                      uint32_t *intCrc_a);
+
+// --- Make a checked <workdir>/<blockID>.ztb.tmp visible under the sync policy ---
+int publish_block(const char *strWorkDir_a, const char *strBlockID_a, ZTBSync *objSync_a);
+
 // --- Read fixed string from raw header ---
 void read_fixed_string(const uint8_t *byData_a, int intOffset_a, int intLen_a,
                        char *strOut_a);
@@ -108,4 +638,88 @@ void write_fixed_string(uint8_t *byData_a, int intOffset_a, int intLen_a,
 uint32_t hash_bytes(int intHashType_a, const uint8_t *byData_a, int intOffset_a,
                     int intLen_a);
 
+// --- Threads and locks for the parallel tools (Win32 threads or pthreads) ---
+#ifdef _WIN32
+typedef HANDLE              ZTBThread;
+typedef CRITICAL_SECTION    ZTBMutex;
+typedef CONDITION_VARIABLE  ZTBCond;
+#else
+typedef pthread_t           ZTBThread;
+typedef pthread_mutex_t     ZTBMutex;
+typedef pthread_cond_t      ZTBCond;
+#endif
+
+typedef void (*ZTBThreadFn)(void *objArg_a);
+
+int  thread_start(ZTBThread *objThread_a, ZTBThreadFn fnRun_a, void *objArg_a);
+void thread_join(ZTBThread objThread_a);
+void mutex_init(ZTBMutex *objMutex_a);
+void mutex_lock(ZTBMutex *objMutex_a);
+void mutex_unlock(ZTBMutex *objMutex_a);
+void mutex_destroy(ZTBMutex *objMutex_a);
+void cond_init(ZTBCond *objCond_a);
+void cond_signal(ZTBCond *objCond_a);
+void cond_wait_ms(ZTBCond *objCond_a, ZTBMutex *objMutex_a, int64_t intMs_a);   // < 0: until signalled
+void cond_destroy(ZTBCond *objCond_a);
+int  cpu_count(void);
+
+// --- Worker pool: fnRun_a on intThreads_a threads including the caller's ---
+#define MAX_WORKERS         64
+int  run_workers(int intThreads_a, ZTBThreadFn fnRun_a, void *objArg_a);
+
+// --- Readahead of the ancestors a serial chain walk reads next ---
+// A walk learns each block's prev only from its header, then waits on a cold read of
+// that block before it can go on. readahead_start runs a thread that follows the prev
+// links over the raw headers (through the block cache, so the rolling ROM walks hit
+// it) up to intDepth_a blocks ahead of the walker, and asks the OS to start reading
+// each whole block file while the walker is still decoding and hashing the one
+// before: posix_fadvise WILLNEED where there is one (block_readahead), else the
+// thread reads the file through itself. The walker calls readahead_step after each
+// block it finishes; the thread never gets more than intDepth_a blocks ahead and ends
+// at a truncation block or the start of the chain. readahead_start returns NULL (walk
+// without it; every call takes NULL) if the depth is 0 or the thread cannot start.
+// The depth is READAHEAD_DEPTH unless ZTB_READAHEAD is set; 0 turns it off.
+#define READAHEAD_DEPTH     8
+typedef struct ZTBReadahead ZTBReadahead;
+
+int  readahead_depth(void);
+ZTBReadahead* readahead_start(const char *strWorkDir_a, const char *strTipID_a, int intDepth_a);
+void readahead_step(ZTBReadahead *objReadahead_a);
+void readahead_stop(ZTBReadahead *objReadahead_a);
+// Hint for a single block whose ID the caller already has; returns at once (no-op
+// where the OS has no readahead advice)
+void block_readahead(const char *strWorkDir_a, const char *strBlockID_a);
+
+// --- Chains index (see CHAINS_INDEX_FILE) ---
+int  chains_index_tip(const char *strWorkDir_a, const char *strChainID_a,
+                      const char *strTipID_a, ZTBSync *objSync_a);
+int  chains_index_branch(const char *strWorkDir_a, const char *strTrunkID_a,
+                         const char *strBranchID_a, const char *strFirstID_a,
+                         const char *strForkID_a, ZTBSync *objSync_a);
+int  chains_index_load(const char *strWorkDir_a, ZTBChainIndex *objIndex_a);
+int  chains_index_find(const ZTBChainIndex *objIndex_a, const char *strChainID_a);
+void chains_index_free(ZTBChainIndex *objIndex_a);
+#define CHAINS_TAIL_READ    65536
+int  chains_index_last_tip(const char *strWorkDir_a, const char *strChainID_a, char *strTipID_a);
+
+// --- Chain locks: <workdir>/chain-<FNV-1a of the chain name>.lock ---
+// An appender holds its chain's lock from picking the prev block until the new tip is
+// in chains.idx, so writers on one chain take turns instead of forking it (see
+// ztb_append). The lock is advisory and dies with its process (fcntl / LockFileEx).
+// fcntl locks belong to the process, so threads of one process must still serialise
+// appends to a chain between themselves, as ztbd does.
+#define CHAIN_LOCK_FMT      "%s/chain-%08x.lock"
+
+typedef struct
+{
+#ifdef _WIN32
+    HANDLE hFile;
+#else
+    int    intFd;
+#endif
+} ZTBChainLock;
+
+int  chain_lock(const char *strWorkDir_a, const char *strChainID_a, ZTBChainLock *objLock_a);
+void chain_unlock(ZTBChainLock *objLock_a);
+
 #endif // ZTB_COMMON_H
\ No newline at end of file
@@ -1,24 +1,129 @@
-// Cyborg ZTB Genesis Block Creator v20260618
+// Cyborg ZTB Genesis Block Creator v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
 // Creates a genesis block (.ztb, exactly 65536 bytes) from 1-3 entropy source files.
 // Matches ZTBChain.Create() exactly.
 //
-// Usage: ztbcreate <source1> [source2] [source3] <workdir> <new_block_id>
+// Usage: ztbcreate <source1> [source2] [source3] <workdir> <new_block_id> [-fanout]
+//
+// The genesis ID (and with -fanout the fanout layout) is recorded in <workdir>/ztb.meta
+// before the block is written; see ZTBWorkdirMeta. -fanout is only accepted for a
+// workdir without blocks -- existing workdirs are converted with ztbmigrate.
+//
+// Each source contributes ROM_SIZE - 1 bytes sampled at a fixed step (length / ROM_SIZE),
+// so only those bytes are read, never the whole file. The sample positions are computed
+// up front; samples less than SAMPLE_GAP apart are fetched together in one read of at
+// most SAMPLE_WINDOW bytes (a page costs the same to read as a byte), wider-spaced ones
+// one unbuffered read each, with the OS told the access is random. A small source is
+// read in a few big pieces; a 30 GB one costs ROM_SIZE - 1 tiny reads. The blend is the
+// same as loading each source whole.
+
+#include "ztbcommon.h"
+
+#define SAMPLE_GAP      4096
+#define SAMPLE_WINDOW   65536
+
+// --- Read the ROM_SIZE - 1 samples of one source into arrSamples_a ---
+// Positions match C# Create exactly: a double stepped by srcLen / ROM_SIZE, clamped to
+// the last byte. Returns 1 on success, 0 on failure.
+static int sample_source(const char *strPath_a, uint8_t *arrSamples_a, int64_t *intLen_a,
+                         int *intReads_a)
+{
+    int intResult = 1;
+    int64_t intLen = 0;
+    int64_t *arrPos  = (int64_t*)malloc(sizeof(int64_t) * (ROM_SIZE - 1));
+    uint8_t *byWindow = (uint8_t*)malloc(SAMPLE_WINDOW);
+    FILE *f = fopen(strPath_a, "rb");
+
+    *intReads_a = 0;
+    if (!f)
+    {
+        fprintf(stderr, "Error: Cannot open source file: %s\n", strPath_a);
+        intResult = 0;
+    }
+    else if (!arrPos || !byWindow)
+    {
+        fprintf(stderr, "Error: Cannot allocate source buffer\n");
+        intResult = 0;
+    }
+    else if (ZTB_FSEEK(f, 0, SEEK_END) != 0 || (intLen = (int64_t)ZTB_FTELL(f)) < 0)
+    {
+        fprintf(stderr, "Error: Cannot read source file: %s\n", strPath_a);
+        intResult = 0;
+    }
+    else if (intLen == 0)
+    {
+        fprintf(stderr, "Error: Source file is empty: %s\n", strPath_a);
+        intResult = 0;
+    }
+
+    // --- 1. Sample positions. Step matches C# exactly: srcLen / ROM_SIZE (not per-source share) ---
+    double dblStep = (double)intLen / (double)ROM_SIZE;
+    double dblPos  = 0.0;
+    int intK;
 
-#include "ztbcommon.c"
+    for (intK = 0; intK < ROM_SIZE - 1 && intResult; intK++)
+    {
+        arrPos[intK] = (int64_t)dblPos;
+        if (arrPos[intK] >= intLen) { arrPos[intK] = intLen - 1; }
+        dblPos += dblStep;
+    }
+
+    if (intResult)
+    {
+        // Our own window is the buffer; stdio would read BUFSIZ around every sample
+        setvbuf(f, NULL, _IONBF, 0);
+#if !defined(_WIN32) && defined(POSIX_FADV_RANDOM)
+        if (dblStep > SAMPLE_GAP) { posix_fadvise(fileno(f), 0, 0, POSIX_FADV_RANDOM); }
+#endif
+    }
+
+    // --- 2. One read per run of close samples ---
+    intK = 0;
+    while (intK < ROM_SIZE - 1 && intResult)
+    {
+        int64_t intStart = arrPos[intK];
+        int intEnd       = intK + 1;
+        while (intEnd < ROM_SIZE - 1 && arrPos[intEnd] - arrPos[intEnd - 1] <= SAMPLE_GAP &&
+               arrPos[intEnd] - intStart < SAMPLE_WINDOW)
+        {
+            intEnd++;
+        }
+
+        size_t intSpan = (size_t)(arrPos[intEnd - 1] - intStart + 1);
+        if (ZTB_FSEEK(f, intStart, SEEK_SET) != 0 || fread(byWindow, 1, intSpan, f) != intSpan)
+        {
+            fprintf(stderr, "Error: Cannot read source file: %s\n", strPath_a);
+            intResult = 0;
+        }
+        else
+        {
+            (*intReads_a)++;
+            for (; intK < intEnd; intK++) { arrSamples_a[intK] = byWindow[arrPos[intK] - intStart]; }
+        }
+    }
+
+    if (f) { fclose(f); }
+    if (arrPos) { free(arrPos); }
+    if (byWindow) { free(byWindow); }
+    *intLen_a = intLen;
+    return intResult;
+}
 
 int main(int argc, char *argv[])
 {
     int intResult = 0;
 
-    printf("ZTB Genesis Block Creator v20260618\n");
+    printf("ZTB Genesis Block Creator v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
+    int blnFanout = (argc > 1 && strcmp(argv[argc - 1], "-fanout") == 0);
+    if (blnFanout) { argc--; }
+
     if (argc < 4 || argc > 6)
     {
-        fprintf(stderr, "Usage: %s <source1> [source2] [source3] <workdir> <new_block_id>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <source1> [source2] [source3] <workdir> <new_block_id> [-fanout]\n", argv[0]);
         fprintf(stderr, "Example: %s photo.jpg music.mp3 . A1B2C3D4-E5F6-4A7B-8C9D-E0F1A2B3C4D5\n", argv[0]);
         intResult = 1;
     }
@@ -30,12 +135,30 @@ int main(int argc, char *argv[])
         const char *strWorkDir_a   = argv[argc - 2];
         const char *strNewBlockID_a = argv[argc - 1];
 
+        // Layout: the workdir's if it has ztb.meta, else flat or -fanout for a new workdir
+        ZTBWorkdirMeta objMeta;
+        int blnHasMeta = workdir_meta_load(strWorkDir_a, &objMeta);
+        char (*arrIDs)[GUID_LEN] = NULL;
+        char strGenesisID[GUID_LEN];
+
+        if (blnFanout && objMeta.intLayout != LAYOUT_FANOUT)
+        {
+            int intBlocks = blnHasMeta ? 1 : list_blocks(strWorkDir_a, &arrIDs);
+            if (intBlocks != 0 || find_genesis_id(strWorkDir_a, strGenesisID))
+            {
+                fprintf(stderr, "Error: %s already has blocks; convert it with ztbmigrate\n", strWorkDir_a);
+                intResult = 1;
+            }
+            objMeta.intLayout = LAYOUT_FANOUT;
+            if (arrIDs) { free(arrIDs); }
+        }
+
         // Build output path
         char strOutputPath[FILENAME_MAX];
-        snprintf(strOutputPath, FILENAME_MAX, "%s/%s.ztb", strWorkDir_a, strNewBlockID_a);
+        block_file_path_in(strWorkDir_a, objMeta.intLayout, strNewBlockID_a, ".ztb", strOutputPath);
 
         // Refuse duplicate (matches C# behaviour)
-        FILE *fCheck = fopen(strOutputPath, "rb");
+        FILE *fCheck = (intResult == 0) ? fopen(strOutputPath, "rb") : NULL;
         if (fCheck)
         {
             fclose(fCheck);
@@ -45,55 +168,23 @@ int main(int argc, char *argv[])
 
         if (intResult == 0)
         {
-            // Load source files
-            uint8_t *arrSrc[3]  = {NULL, NULL, NULL};
-            long     arrLen[3]  = {0,    0,    0};
-            double   arrStep[3] = {0.0,  0.0,  0.0};
-            double   arrPos[3]  = {0.0,  0.0,  0.0};
-            int      intValid   = 1;
+            // Sample the sources
+            uint8_t *arrSamples = (uint8_t*)malloc((size_t)3 * ROM_SIZE);
+            int      intValid   = (arrSamples != NULL);
+
+            if (!intValid) { fprintf(stderr, "Error: Cannot allocate source buffer\n"); }
 
             int intI;
             for (intI = 0; intI < intSourceCount && intValid; intI++)
             {
+                int64_t intLen = 0;
+                int intReads   = 0;
                 printf("Loading source %d: %s\n", intI + 1, argv[intI + 1]);
-                FILE *f = fopen(argv[intI + 1], "rb");
-                if (!f)
+                intValid = sample_source(argv[intI + 1], arrSamples + (size_t)intI * ROM_SIZE,
+                                         &intLen, &intReads);
+                if (intValid)
                 {
-                    fprintf(stderr, "Error: Cannot open source file: %s\n", argv[intI + 1]);
-                    intValid = 0;
-                }
-                else
-                {
-                    fseek(f, 0, SEEK_END);
-                    arrLen[intI] = ftell(f);
-                    fseek(f, 0, SEEK_SET);
-
-                    if (arrLen[intI] == 0)
-                    {
-                        fprintf(stderr, "Error: Source file is empty: %s\n", argv[intI + 1]);
-                        intValid = 0;
-                    }
-                    else
-                    {
-                        arrSrc[intI] = (uint8_t*)malloc(arrLen[intI]);
-                        if (!arrSrc[intI])
-                        {
-                            fprintf(stderr, "Error: Cannot allocate source buffer\n");
-                            intValid = 0;
-                        }
-                        else if (fread(arrSrc[intI], 1, arrLen[intI], f) != (size_t)arrLen[intI])
-                        {
-                            fprintf(stderr, "Error: Cannot read source file: %s\n", argv[intI + 1]);
-                            intValid = 0;
-                        }
-                        else
-                        {
-                            // Step matches C# exactly: step = srcLen / ROM_SIZE (not per-source share)
-                            arrStep[intI] = (double)arrLen[intI] / (double)ROM_SIZE;
-                            printf("  Loaded %ld bytes\n", arrLen[intI]);
-                        }
-                    }
-                    fclose(f);
+                    printf("  Sampled %lld bytes (%d reads)\n", (long long)intLen, intReads);
                 }
             }
 
@@ -115,10 +206,7 @@ int main(int argc, char *argv[])
                     int intJ      = 0;
                     while (intJ < intSourceCount)
                     {
-                        long lngPos = (long)arrPos[intJ];
-                        if (lngPos >= arrLen[intJ]) { lngPos = arrLen[intJ] - 1; }
-                        byVal       ^= arrSrc[intJ][lngPos];
-                        arrPos[intJ] += arrStep[intJ];
+                        byVal ^= arrSamples[(size_t)intJ * ROM_SIZE + (intOutI - 1)];
                         intJ++;
                     }
                     arrGenBlock[intOutI] = byVal;
@@ -129,7 +217,18 @@ int main(int argc, char *argv[])
                 char strTmp[FILENAME_MAX + 4];
                 snprintf(strTmp, FILENAME_MAX + 4, "%s.tmp", strOutputPath);
 
-                FILE *fOut = fopen(strTmp, "wb");
+                // Metadata first: a genesis named there but never written is simply created
+                // again by a rerun, whereas one written without it would have to be scanned for
+                if (!objMeta.strGenesis[0] || !blnHasMeta)
+                {
+                    snprintf(objMeta.strGenesis, GUID_LEN, "%s", strNewBlockID_a);
+                }
+                FILE *fOut = NULL;
+                if (workdir_meta_save(strWorkDir_a, &objMeta) &&
+                    block_file_dirs(strWorkDir_a, objMeta.intLayout, strNewBlockID_a))
+                {
+                    fOut = fopen(strTmp, "wb");
+                }
                 if (!fOut)
                 {
                     fprintf(stderr, "Error: Cannot create output file: %s\n", strTmp);
@@ -166,10 +265,7 @@ int main(int argc, char *argv[])
                 }
             }
 
-            for (intI = 0; intI < 3; intI++)
-            {
-                if (arrSrc[intI]) { free(arrSrc[intI]); }
-            }
+            if (arrSamples) { free(arrSamples); }
         }
     }
 
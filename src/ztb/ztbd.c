@@ -0,0 +1,886 @@
+// Cyborg ZTB Daemon v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Long-running chain service. Owns one or more workdirs and serves append, fetch,
+// verify and tail over a local Unix domain socket, so appending a small block costs
+// one encode and one file write instead of a process start, a genesis lookup and a
+// 64-block rolling ROM build.
+//
+// Usage: ztbd <socket> <workdir> [<workdir> ...] [-z] [-sync <policy>]
+//        ztbd -client <socket> <request ...>
+//
+// Every chain gets its own ZTBChain handle (see libztb.h) for appends, so its tip,
+// rolling ROM and prev CRC stay in memory from one append to the next. Appends to one
+// chain are serialised on that chain's lock; appends to other chains and all reads go
+// ahead meanwhile. Each connection reads through its own handles, one per workdir,
+// sharing the process-wide block cache. A chain's tip is loaded from chains.idx the
+// first time it is named, and every append is committed under the sync policy (see
+// ztbaddblock) and recorded in chains.idx before it is answered, so the other tools
+// see the same chains. Other processes may append too: every append takes the chain's
+// lock file (see ztb_append) and goes on the tip recorded in chains.idx. TIP, TAIL and
+// VERIFY by chain name use ztbd's in-memory tip, which follows another process's
+// appends only once ztbd next appends to that chain. With -z every appended payload is
+// stored LZ4-compressed (see ztbaddblock); FETCH returns it decompressed either way.
+//
+// Protocol: one request line, answered by "OK ..." or "ERR <message>" (LF endings).
+// <wd> is a workdir exactly as given on the ztbd command line.
+//   PING                                        OK ztbd <version>
+//   TIP <wd> <chain>                            OK <tip_id>
+//   APPEND <wd> <chain> <len> [<prev_id>|- [<block_id>]]
+//                                               followed by <len> payload bytes;
+//                                               OK <block_id> <hash> <prev_hash>
+//   FETCH <wd> <block_id>                       OK <len>, then <len> payload bytes
+//   VERIFY <wd> <chain|tip_id>                  OK <blocks verified>
+//   TAIL <wd> <chain> <count> [-f]              OK, the chain's last <count> block IDs
+//                                               oldest first, then END; with -f new
+//                                               blocks follow as they are appended
+//                                               until the client sends a line or hangs up
+//   QUIT
+// An APPEND without prev_id (or with "-") goes on the chain's tip. A given prev_id must
+// be the tip, or start a chain that has none yet, so two clients cannot fork a chain
+// by accident. The block ID is generated unless given.
+//
+// -client sends one request and prints the reply (banner and errors on stderr). For
+// APPEND leave out <len>: the payload is read from stdin. FETCH writes the raw payload
+// to stdout. The exit status is 0 for OK.
+//
+// Unix domain sockets are only built on Linux and other POSIX systems.
+
+#include "ztbcommon.h"
+#include "libztb.h"
+
+#ifndef _WIN32
+
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define ZTBD_LINE_MAX       (FILENAME_MAX + 4 * GUID_LEN + 64)
+#define ZTBD_MAX_ARGS       8
+#define ZTBD_BACKLOG        16
+#define ZTBD_IO_CHUNK       65536
+#define ZTBD_TAIL_MAX       4096            // IDs sent per TAIL batch at most
+
+// --- A chain the daemon has seen: its append handle and in-memory tip ---
+typedef struct ZTBDChain
+{
+    char              strName[GUID_LEN];
+    char              strTip[GUID_LEN];     // "" until its first block (under lockState)
+    pthread_mutex_t   lockAppend;           // held for a whole append
+    ZTBChain         *objHandle;            // rolling ROM follows the tip
+    struct ZTBDChain *objNext;
+} ZTBDChain;
+
+typedef struct
+{
+    const char       *strWorkDir;
+    ZTBDChain        *objChains;
+    pthread_mutex_t   lockState;            // chain list and tips
+    pthread_cond_t    condTip;              // broadcast on every new tip (TAIL -f)
+} ZTBDWorkdir;
+
+typedef struct
+{
+    int        intFd;
+    FILE      *fIn;
+    FILE      *fOut;
+    ZTBChain **arrRead;                     // per workdir, opened on first read
+} ZTBDConn;
+
+// --- IDs from a ztb_iterate walk, newest first ---
+typedef struct
+{
+    const char *strStop;                    // stop before this ID (NULL = none)
+    char      (*arrIDs)[GUID_LEN];
+    int         intCount;
+    int         intMax;
+} ZTBDWalk;
+
+// --- A growing payload buffer for FETCH ---
+typedef struct
+{
+    uint8_t *byData;
+    size_t   intLen;
+    size_t   intCap;
+} ZTBDBuffer;
+
+static ZTBDWorkdir *arrWorkdirs  = NULL;
+static int          intWorkdirs  = 0;
+static const char  *strSyncPolicy = NULL;
+static int          blnCompress   = 0;
+static volatile sig_atomic_t blnStop = 0;
+
+static void on_stop_signal(int intSignal_a)
+{
+    (void)intSignal_a;
+    blnStop = 1;
+}
+
+static void reply(ZTBDConn *objConn_a, const char *strFormat_a, ...)
+{
+    va_list objArgs;
+    va_start(objArgs, strFormat_a);
+    vfprintf(objConn_a->fOut, strFormat_a, objArgs);
+    va_end(objArgs);
+    fflush(objConn_a->fOut);
+}
+
+static ZTBDWorkdir* find_workdir(const char *strWorkDir_a)
+{
+    ZTBDWorkdir *objResult = NULL;
+    int intI;
+    for (intI = 0; intI < intWorkdirs && !objResult; intI++)
+    {
+        if (strcmp(arrWorkdirs[intI].strWorkDir, strWorkDir_a) == 0) { objResult = &arrWorkdirs[intI]; }
+    }
+    return objResult;
+}
+
+// --- The chain named strName_a, added (tip from chains.idx) the first time it is named ---
+static ZTBDChain* find_chain(ZTBDWorkdir *objWd_a, const char *strName_a)
+{
+    ZTBDChain *objChain = NULL;
+
+    if (strlen(strName_a) >= GUID_LEN) { return NULL; }
+
+    pthread_mutex_lock(&objWd_a->lockState);
+    for (objChain = objWd_a->objChains; objChain && strcmp(objChain->strName, strName_a) != 0;
+         objChain = objChain->objNext) { }
+
+    if (!objChain)
+    {
+        objChain = (ZTBDChain*)calloc(1, sizeof(ZTBDChain));
+        if (objChain)
+        {
+            objChain->objHandle = ztb_open(objWd_a->strWorkDir);
+            if (!objChain->objHandle ||
+                (strSyncPolicy && !ztb_set_sync(objChain->objHandle, strSyncPolicy)))
+            {
+                ztb_close(objChain->objHandle);
+                free(objChain);
+                objChain = NULL;
+            }
+        }
+        if (objChain)
+        {
+            snprintf(objChain->strName, GUID_LEN, "%s", strName_a);
+            ztb_tip(objChain->objHandle, strName_a, objChain->strTip);
+            pthread_mutex_init(&objChain->lockAppend, NULL);
+            objChain->objNext  = objWd_a->objChains;
+            objWd_a->objChains = objChain;
+        }
+    }
+    pthread_mutex_unlock(&objWd_a->lockState);
+
+    return objChain;
+}
+
+static void chain_tip(ZTBDWorkdir *objWd_a, ZTBDChain *objChain_a, char *strTip_a)
+{
+    pthread_mutex_lock(&objWd_a->lockState);
+    snprintf(strTip_a, GUID_LEN, "%s", objChain_a->strTip);
+    pthread_mutex_unlock(&objWd_a->lockState);
+}
+
+// --- This connection's read handle for a workdir ---
+static ZTBChain* read_handle(ZTBDConn *objConn_a, ZTBDWorkdir *objWd_a)
+{
+    int intAt = (int)(objWd_a - arrWorkdirs);
+    if (!objConn_a->arrRead[intAt]) { objConn_a->arrRead[intAt] = ztb_open(objWd_a->strWorkDir); }
+    return objConn_a->arrRead[intAt];
+}
+
+// --- Skip a payload that will not be appended. Returns 1 if it was all there ---
+static int drain(FILE *fIn_a, uint64_t intLen_a)
+{
+    uint8_t arrBuf[4096];
+    while (intLen_a > 0)
+    {
+        size_t intWant = intLen_a < sizeof(arrBuf) ? (size_t)intLen_a : sizeof(arrBuf);
+        size_t intGot  = fread(arrBuf, 1, intWant, fIn_a);
+        if (intGot == 0) { return 0; }
+        intLen_a -= intGot;
+    }
+    return 1;
+}
+
+static int parse_len(const char *strLen_a, uint64_t *intLen_a)
+{
+    char *strEnd = NULL;
+    if (!isdigit((unsigned char)strLen_a[0])) { return 0; }
+    *intLen_a = (uint64_t)strtoull(strLen_a, &strEnd, 10);
+    return *strEnd == '\0';
+}
+
+static int walk_block(void *objCtx_a, const ZTBBlockInfo *objInfo_a)
+{
+    ZTBDWalk *objWalk = (ZTBDWalk*)objCtx_a;
+    if (objWalk->strStop && strcmp(objInfo_a->strBlockID, objWalk->strStop) == 0) { return 0; }
+    snprintf(objWalk->arrIDs[objWalk->intCount++], GUID_LEN, "%s", objInfo_a->strBlockID);
+    return objWalk->intCount < objWalk->intMax;
+}
+
+static int buffer_payload(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    ZTBDBuffer *objBuf = (ZTBDBuffer*)objCtx_a;
+    if (objBuf->intLen + intLen_a > objBuf->intCap)
+    {
+        size_t intCap = objBuf->intCap ? objBuf->intCap : ZTBD_IO_CHUNK;
+        while (intCap < objBuf->intLen + intLen_a) { intCap *= 2; }
+        uint8_t *byNew = (uint8_t*)realloc(objBuf->byData, intCap);
+        if (!byNew) { return 0; }
+        objBuf->byData = byNew;
+        objBuf->intCap = intCap;
+    }
+    memcpy(objBuf->byData + objBuf->intLen, byData_a, intLen_a);
+    objBuf->intLen += intLen_a;
+    return 1;
+}
+
+// --- APPEND <wd> <chain> <len> [<prev_id>|- [<block_id>]] ---
+// Returns 0 if the connection has to close (the payload could not be skipped).
+static int do_append(ZTBDConn *objConn_a, char **arrArgs_a, int intArgs_a)
+{
+    uint64_t intLen = 0;
+
+    if (intArgs_a < 4 || intArgs_a > 6 || !parse_len(arrArgs_a[3], &intLen))
+    {
+        reply(objConn_a, "ERR Usage: APPEND <wd> <chain> <len> [<prev_id>|- [<block_id>]]\n");
+        return 0;
+    }
+
+    const char *strPrev  = (intArgs_a >= 5 && strcmp(arrArgs_a[4], "-") != 0) ? arrArgs_a[4] : NULL;
+    const char *strID    = (intArgs_a == 6) ? arrArgs_a[5] : NULL;
+    ZTBDWorkdir *objWd   = find_workdir(arrArgs_a[1]);
+    ZTBDChain *objChain  = objWd ? find_chain(objWd, arrArgs_a[2]) : NULL;
+    char strError[ZTBD_LINE_MAX] = "";
+
+    if (!objWd)                              { snprintf(strError, sizeof(strError), "Unknown workdir '%s'", arrArgs_a[1]); }
+    else if (!objChain)                      { snprintf(strError, sizeof(strError), "Bad chain name '%s'", arrArgs_a[2]); }
+    else if (strPrev && !is_valid_guid(strPrev) && strcmp(strPrev, NULL_GUID) != 0)
+    {
+        snprintf(strError, sizeof(strError), "Bad prev_id '%s'", strPrev);
+    }
+    else if (strID && (!is_valid_guid(strID) || strcmp(strID, NULL_GUID) == 0))
+    {
+        snprintf(strError, sizeof(strError), "Bad block_id '%s'", strID);
+    }
+    else if (strID && block_exists(objWd->strWorkDir, strID))
+    {
+        snprintf(strError, sizeof(strError), "Block '%s' already exists", strID);
+    }
+
+    if (strError[0])
+    {
+        reply(objConn_a, "ERR %s\n", strError);
+        return drain(objConn_a->fIn, intLen);
+    }
+
+    // --- The chain's lock is held from the tip check to the new tip ---
+    int intResult = 1;
+    char strTip[GUID_LEN];
+    pthread_mutex_lock(&objChain->lockAppend);
+    chain_tip(objWd, objChain, strTip);
+    if (!strTip[0]) { chains_index_last_tip(objWd->strWorkDir, objChain->strName, strTip); }
+
+    if (!strPrev && !strTip[0])
+    {
+        reply(objConn_a, "ERR Chain '%s' has no blocks yet: give a prev_id\n", objChain->strName);
+        intResult = drain(objConn_a->fIn, intLen);
+    }
+    else
+    {
+        ZTBAppend objAppend;
+        ZTBAppendResult objWrite;
+        memset(&objAppend, 0, sizeof(objAppend));
+        objAppend.intKind    = ZTB_APPEND_BLOCK;
+        objAppend.strChain   = objChain->strName;
+        objAppend.strBlockID = strID;
+        objAppend.strPrevID  = strPrev ? strPrev : strTip;
+        objAppend.fData      = objConn_a->fIn;
+        objAppend.intDataLen = intLen;
+        objAppend.blnStrict  = (strPrev != NULL);
+        objAppend.blnCompress = blnCompress;
+
+        // A given prev_id must still be the tip (the library checks it under the chain
+        // lock file); without one a tip moved on by another process is simply followed.
+        // Any other failed append may stop part way through the payload: the connection closes.
+        int blnAppended = ztb_append(objChain->objHandle, &objAppend, &objWrite);
+        if (!blnAppended && objWrite.blnConflict && strcmp(objAppend.strPrevID, NULL_GUID) == 0)
+        {
+            reply(objConn_a, "ERR Chain '%s' is not empty: tip is %s\n", objChain->strName, objWrite.strPrevID);
+            intResult = drain(objConn_a->fIn, intLen);
+        }
+        else if (!blnAppended && objWrite.blnConflict)
+        {
+            reply(objConn_a, "ERR Stale prev_id: chain '%s' tip is %s\n", objChain->strName, objWrite.strPrevID);
+            intResult = drain(objConn_a->fIn, intLen);
+        }
+        else if (!blnAppended)
+        {
+            reply(objConn_a, "ERR Append failed\n");
+            intResult = 0;
+        }
+        else if (!ztb_commit(objChain->objHandle))
+        {
+            reply(objConn_a, "ERR Commit failed\n");
+        }
+        else
+        {
+            pthread_mutex_lock(&objWd->lockState);
+            snprintf(objChain->strTip, GUID_LEN, "%s", objWrite.strBlockID);
+            pthread_cond_broadcast(&objWd->condTip);
+            pthread_mutex_unlock(&objWd->lockState);
+
+            reply(objConn_a, "OK %s 0x%08X 0x%08X\n", objWrite.strBlockID,
+                  objWrite.intHash, objWrite.intPrevHash);
+        }
+    }
+
+    pthread_mutex_unlock(&objChain->lockAppend);
+    return intResult;
+}
+
+// --- FETCH <wd> <block_id> ---
+static void do_fetch(ZTBDConn *objConn_a, char **arrArgs_a, int intArgs_a)
+{
+    ZTBDWorkdir *objWd = (intArgs_a == 3) ? find_workdir(arrArgs_a[1]) : NULL;
+    ZTBChain *objRead  = objWd ? read_handle(objConn_a, objWd) : NULL;
+    ZTBDBuffer objBuf;
+    memset(&objBuf, 0, sizeof(objBuf));
+
+    if (!objRead)
+    {
+        reply(objConn_a, "ERR Usage: FETCH <wd> <block_id>\n");
+    }
+    else if (!ztb_fetch(objRead, arrArgs_a[2], buffer_payload, &objBuf, NULL))
+    {
+        reply(objConn_a, "ERR Cannot fetch block '%s'\n", arrArgs_a[2]);
+    }
+    else
+    {
+        reply(objConn_a, "OK %llu\n", (unsigned long long)objBuf.intLen);
+        if (objBuf.intLen > 0) { fwrite(objBuf.byData, 1, objBuf.intLen, objConn_a->fOut); }
+        fflush(objConn_a->fOut);
+    }
+
+    if (objBuf.byData) { free(objBuf.byData); }
+}
+
+// --- The tip for a chain name or block ID argument ("" if none) ---
+static void resolve_tip(ZTBDWorkdir *objWd_a, const char *strArg_a, char *strTip_a)
+{
+    strTip_a[0] = '\0';
+    if (is_valid_guid(strArg_a))
+    {
+        snprintf(strTip_a, GUID_LEN, "%s", strArg_a);
+    }
+    else
+    {
+        ZTBDChain *objChain = find_chain(objWd_a, strArg_a);
+        if (objChain) { chain_tip(objWd_a, objChain, strTip_a); }
+    }
+}
+
+// --- VERIFY <wd> <chain|tip_id> ---
+static void do_verify(ZTBDConn *objConn_a, char **arrArgs_a, int intArgs_a)
+{
+    ZTBDWorkdir *objWd = (intArgs_a == 3) ? find_workdir(arrArgs_a[1]) : NULL;
+    ZTBChain *objRead  = objWd ? read_handle(objConn_a, objWd) : NULL;
+    char strTip[GUID_LEN];
+
+    if (!objRead)
+    {
+        reply(objConn_a, "ERR Usage: VERIFY <wd> <chain|tip_id>\n");
+        return;
+    }
+
+    resolve_tip(objWd, arrArgs_a[2], strTip);
+    if (!strTip[0])
+    {
+        reply(objConn_a, "ERR Chain '%s' has no blocks\n", arrArgs_a[2]);
+    }
+    else
+    {
+        ZTBVerifyResult objVerify;
+        if (ztb_verify(objRead, strTip, NULL, &objVerify))
+        {
+            reply(objConn_a, "OK %d\n", objVerify.intVerified);
+        }
+        else if (objVerify.strFailedID[0])
+        {
+            reply(objConn_a, "ERR Verification failed at %s (%d blocks verified)\n",
+                  objVerify.strFailedID, objVerify.intVerified);
+        }
+        else
+        {
+            reply(objConn_a, "ERR Cannot walk the chain from %s\n", strTip);
+        }
+    }
+}
+
+// --- Send the blocks from strTip_a back to (not including) strStop_a, oldest first ---
+static int send_ids(ZTBDConn *objConn_a, ZTBChain *objRead_a, const char *strTip_a,
+                    const char *strStop_a, int intMax_a)
+{
+    ZTBDWalk objWalk;
+    int intI;
+
+    objWalk.strStop  = strStop_a;
+    objWalk.intCount = 0;
+    objWalk.intMax   = intMax_a > ZTBD_TAIL_MAX ? ZTBD_TAIL_MAX : intMax_a;
+    objWalk.arrIDs   = (char(*)[GUID_LEN])malloc((size_t)(objWalk.intMax > 0 ? objWalk.intMax : 1) * GUID_LEN);
+    if (!objWalk.arrIDs) { return 0; }
+
+    if (objWalk.intMax > 0 && strTip_a[0]) { ztb_iterate(objRead_a, strTip_a, walk_block, &objWalk); }
+    for (intI = objWalk.intCount - 1; intI >= 0; intI--)
+    {
+        fprintf(objConn_a->fOut, "%s\n", objWalk.arrIDs[intI]);
+    }
+
+    free(objWalk.arrIDs);
+    return fflush(objConn_a->fOut) == 0;
+}
+
+// --- TAIL <wd> <chain> <count> [-f] ---
+static void do_tail(ZTBDConn *objConn_a, char **arrArgs_a, int intArgs_a)
+{
+    ZTBDWorkdir *objWd  = (intArgs_a == 4 || intArgs_a == 5) ? find_workdir(arrArgs_a[1]) : NULL;
+    ZTBChain *objRead   = objWd ? read_handle(objConn_a, objWd) : NULL;
+    ZTBDChain *objChain = objRead ? find_chain(objWd, arrArgs_a[2]) : NULL;
+    int blnFollow       = (intArgs_a == 5 && strcmp(arrArgs_a[4], "-f") == 0);
+    char strSeen[GUID_LEN];
+
+    if (!objChain || !isdigit((unsigned char)arrArgs_a[3][0]) || (intArgs_a == 5 && !blnFollow))
+    {
+        reply(objConn_a, "ERR Usage: TAIL <wd> <chain> <count> [-f]\n");
+        return;
+    }
+
+    chain_tip(objWd, objChain, strSeen);
+    reply(objConn_a, "OK\n");
+    int blnOpen = send_ids(objConn_a, objRead, strSeen, NULL, atoi(arrArgs_a[3]));
+
+    // --- Follow: wait for the tip to move, then send what was appended since ---
+    while (blnFollow && blnOpen && !blnStop)
+    {
+        char strTip[GUID_LEN];
+        struct timespec objUntil;
+        clock_gettime(CLOCK_REALTIME, &objUntil);
+        objUntil.tv_sec += 1;
+
+        pthread_mutex_lock(&objWd->lockState);
+        if (strcmp(objChain->strTip, strSeen) == 0)
+        {
+            pthread_cond_timedwait(&objWd->condTip, &objWd->lockState, &objUntil);
+        }
+        snprintf(strTip, GUID_LEN, "%s", objChain->strTip);
+        pthread_mutex_unlock(&objWd->lockState);
+
+        if (strcmp(strTip, strSeen) != 0)
+        {
+            blnOpen = send_ids(objConn_a, objRead, strTip, strSeen, ZTBD_TAIL_MAX);
+            snprintf(strSeen, GUID_LEN, "%s", strTip);
+        }
+
+        // Any input (or the client hanging up) ends the follow
+        struct pollfd objPoll;
+        objPoll.fd      = objConn_a->intFd;
+        objPoll.events  = POLLIN;
+        objPoll.revents = 0;
+        if (poll(&objPoll, 1, 0) > 0) { blnFollow = 0; }
+    }
+
+    if (blnOpen) { reply(objConn_a, "END\n"); }
+}
+
+// --- One connection: requests until QUIT, EOF or an unrecoverable APPEND ---
+static void* serve_connection(void *objArg_a)
+{
+    ZTBDConn *objConn = (ZTBDConn*)objArg_a;
+    char strLine[ZTBD_LINE_MAX];
+    int blnOpen = 1;
+    int intI;
+
+    pthread_detach(pthread_self());
+
+    while (blnOpen && !blnStop && fgets(strLine, sizeof(strLine), objConn->fIn))
+    {
+        char *arrArgs[ZTBD_MAX_ARGS];
+        int intArgs = 0;
+        char *strSave = NULL;
+        char *strTok  = strtok_r(strLine, " \t\r\n", &strSave);
+
+        while (strTok && intArgs < ZTBD_MAX_ARGS)
+        {
+            arrArgs[intArgs++] = strTok;
+            strTok = strtok_r(NULL, " \t\r\n", &strSave);
+        }
+        if (intArgs == 0) { continue; }
+
+        if (strcmp(arrArgs[0], "PING") == 0)
+        {
+            reply(objConn, "OK ztbd %s\n", ztb_version());
+        }
+        else if (strcmp(arrArgs[0], "TIP") == 0)
+        {
+            ZTBDWorkdir *objWd = (intArgs == 3) ? find_workdir(arrArgs[1]) : NULL;
+            char strTip[GUID_LEN] = "";
+            if (objWd) { resolve_tip(objWd, arrArgs[2], strTip); }
+
+            if (!objWd)         { reply(objConn, "ERR Usage: TIP <wd> <chain>\n"); }
+            else if (strTip[0]) { reply(objConn, "OK %s\n", strTip); }
+            else                { reply(objConn, "ERR Chain '%s' has no blocks\n", arrArgs[2]); }
+        }
+        else if (strcmp(arrArgs[0], "APPEND") == 0) { blnOpen = do_append(objConn, arrArgs, intArgs); }
+        else if (strcmp(arrArgs[0], "FETCH") == 0)  { do_fetch(objConn, arrArgs, intArgs); }
+        else if (strcmp(arrArgs[0], "VERIFY") == 0) { do_verify(objConn, arrArgs, intArgs); }
+        else if (strcmp(arrArgs[0], "TAIL") == 0)   { do_tail(objConn, arrArgs, intArgs); }
+        else if (strcmp(arrArgs[0], "QUIT") == 0)   { reply(objConn, "OK\n"); blnOpen = 0; }
+        else
+        {
+            reply(objConn, "ERR Unknown request '%s'\n", arrArgs[0]);
+        }
+    }
+
+    for (intI = 0; intI < intWorkdirs; intI++) { ztb_close(objConn->arrRead[intI]); }
+    free(objConn->arrRead);
+    fclose(objConn->fIn);
+    fclose(objConn->fOut);
+    free(objConn);
+    return NULL;
+}
+
+static int socket_address(const char *strPath_a, struct sockaddr_un *objAddr_a)
+{
+    memset(objAddr_a, 0, sizeof(struct sockaddr_un));
+    objAddr_a->sun_family = AF_UNIX;
+    if (strlen(strPath_a) >= sizeof(objAddr_a->sun_path))
+    {
+        fprintf(stderr, "Error: Socket path too long: %s\n", strPath_a);
+        return 0;
+    }
+    snprintf(objAddr_a->sun_path, sizeof(objAddr_a->sun_path), "%s", strPath_a);
+    return 1;
+}
+
+static int socket_connect(const char *strPath_a)
+{
+    struct sockaddr_un objAddr;
+    int intFd = -1;
+
+    if (socket_address(strPath_a, &objAddr))
+    {
+        intFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (intFd >= 0 && connect(intFd, (struct sockaddr*)&objAddr, sizeof(objAddr)) != 0)
+        {
+            close(intFd);
+            intFd = -1;
+        }
+    }
+    return intFd;
+}
+
+// --- -client: send one request, print the reply ---
+static int run_client(const char *strSocket_a, int argc, char *argv[])
+{
+    int intResult = 1;
+    char strLine[ZTBD_LINE_MAX];
+    uint8_t *byPayload = NULL;
+    size_t intPayload  = 0;
+    int blnAppend = (argc > 0 && strcmp(argv[0], "APPEND") == 0);
+    int blnFetch  = (argc > 0 && strcmp(argv[0], "FETCH") == 0);
+    int blnTail   = (argc > 0 && strcmp(argv[0], "TAIL") == 0);
+    size_t intAt  = 0;
+    int intI;
+
+    // --- 1. Request line (APPEND gets the payload length from stdin) ---
+    if (blnAppend)
+    {
+        ZTBDBuffer objBuf;
+        uint8_t arrChunk[ZTBD_IO_CHUNK];
+        size_t intGot;
+        memset(&objBuf, 0, sizeof(objBuf));
+        while ((intGot = fread(arrChunk, 1, sizeof(arrChunk), stdin)) > 0 &&
+               buffer_payload(&objBuf, arrChunk, intGot)) { }
+        byPayload  = objBuf.byData;
+        intPayload = objBuf.intLen;
+    }
+
+    strLine[0] = '\0';
+    for (intI = 0; intI < argc && intAt < sizeof(strLine); intI++)
+    {
+        intAt += (size_t)snprintf(strLine + intAt, sizeof(strLine) - intAt, "%s%s", intI ? " " : "", argv[intI]);
+        if (blnAppend && intI == 2 && intAt < sizeof(strLine))
+        {
+            intAt += (size_t)snprintf(strLine + intAt, sizeof(strLine) - intAt, " %llu",
+                                      (unsigned long long)intPayload);
+        }
+    }
+
+    int intFd = (argc > 0 && intAt < sizeof(strLine) - 1) ? socket_connect(strSocket_a) : -1;
+    if (argc == 0 || intAt >= sizeof(strLine) - 1)
+    {
+        fprintf(stderr, "Error: No request, or request too long\n");
+    }
+    else if (intFd < 0)
+    {
+        fprintf(stderr, "Error: Cannot connect to %s\n", strSocket_a);
+    }
+    else
+    {
+        FILE *fIn  = fdopen(intFd, "rb");
+        FILE *fOut = fdopen(dup(intFd), "wb");
+
+        // --- 2. Send it, with the payload ---
+        if (fIn && fOut)
+        {
+            fprintf(fOut, "%s\n", strLine);
+            if (intPayload > 0) { fwrite(byPayload, 1, intPayload, fOut); }
+            fflush(fOut);
+        }
+
+        // --- 3. Reply ---
+        if (fIn && fOut && fgets(strLine, sizeof(strLine), fIn))
+        {
+            intResult = (strncmp(strLine, "OK", 2) == 0) ? 0 : 1;
+            if (intResult != 0)
+            {
+                fprintf(stderr, "Error: %s", strncmp(strLine, "ERR ", 4) == 0 ? strLine + 4 : strLine);
+            }
+            else if (blnFetch)
+            {
+                unsigned long long intLen = strtoull(strLine + 3, NULL, 10);
+                uint8_t arrChunk[ZTBD_IO_CHUNK];
+                while (intLen > 0)
+                {
+                    size_t intWant = intLen < sizeof(arrChunk) ? (size_t)intLen : sizeof(arrChunk);
+                    size_t intGot  = fread(arrChunk, 1, intWant, fIn);
+                    if (intGot == 0) { intResult = 1; break; }
+                    fwrite(arrChunk, 1, intGot, stdout);
+                    intLen -= intGot;
+                }
+            }
+            else if (blnTail)
+            {
+                while (fgets(strLine, sizeof(strLine), fIn) && strcmp(strLine, "END\n") != 0)
+                {
+                    fputs(strLine, stdout);
+                    fflush(stdout);
+                }
+            }
+            else
+            {
+                fputs(strLine, stdout);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Error: No reply from %s\n", strSocket_a);
+        }
+
+        if (fOut) { fclose(fOut); }
+        if (fIn)  { fclose(fIn); } else { close(intFd); }
+    }
+
+    if (byPayload) { free(byPayload); }
+    return intResult;
+}
+
+// --- Server: listen on strSocket_a, one thread per connection ---
+static int run_server(const char *strSocket_a)
+{
+    int intResult = 0;
+    struct sockaddr_un objAddr;
+    int intListen = -1;
+
+    // --- 1. Bind, replacing a socket file only if no ztbd answers on it ---
+    if (!socket_address(strSocket_a, &objAddr)) { intResult = 1; }
+
+    if (intResult == 0)
+    {
+        int intProbe = socket_connect(strSocket_a);
+        if (intProbe >= 0)
+        {
+            close(intProbe);
+            fprintf(stderr, "Error: A server is already listening on %s\n", strSocket_a);
+            intResult = 1;
+        }
+        else
+        {
+            unlink(strSocket_a);
+        }
+    }
+
+    if (intResult == 0)
+    {
+        intListen = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (intListen < 0 ||
+            bind(intListen, (struct sockaddr*)&objAddr, sizeof(objAddr)) != 0 ||
+            listen(intListen, ZTBD_BACKLOG) != 0)
+        {
+            fprintf(stderr, "Error: Cannot listen on %s\n", strSocket_a);
+            intResult = 1;
+        }
+    }
+
+    // --- 2. Accept until SIGINT/SIGTERM ---
+    if (intResult == 0)
+    {
+        printf("Listening on %s (%d workdir%s)\n", strSocket_a, intWorkdirs, intWorkdirs == 1 ? "" : "s");
+        fflush(stdout);
+
+        while (!blnStop)
+        {
+            int intFd = accept(intListen, NULL, NULL);
+            if (intFd < 0) { continue; }
+
+            ZTBDConn *objConn = (ZTBDConn*)calloc(1, sizeof(ZTBDConn));
+            pthread_t objThread;
+            int blnStarted = 0;
+
+            if (objConn)
+            {
+                objConn->intFd   = intFd;
+                objConn->arrRead = (ZTBChain**)calloc((size_t)intWorkdirs, sizeof(ZTBChain*));
+                objConn->fIn     = fdopen(intFd, "rb");
+                objConn->fOut    = objConn->fIn ? fdopen(dup(intFd), "wb") : NULL;
+                if (objConn->arrRead && objConn->fOut)
+                {
+                    // Only this thread takes SIGINT/SIGTERM, so they always break accept()
+                    sigset_t objStopSignals, objOldMask;
+                    sigemptyset(&objStopSignals);
+                    sigaddset(&objStopSignals, SIGINT);
+                    sigaddset(&objStopSignals, SIGTERM);
+                    pthread_sigmask(SIG_BLOCK, &objStopSignals, &objOldMask);
+                    blnStarted = (pthread_create(&objThread, NULL, serve_connection, objConn) == 0);
+                    pthread_sigmask(SIG_SETMASK, &objOldMask, NULL);
+                }
+            }
+            if (!blnStarted)
+            {
+                fprintf(stderr, "Warning: Cannot serve a connection\n");
+                if (objConn && objConn->fOut) { fclose(objConn->fOut); }
+                if (objConn && objConn->fIn)  { fclose(objConn->fIn); } else { close(intFd); }
+                if (objConn) { free(objConn->arrRead); free(objConn); }
+            }
+        }
+
+        printf("Stopping\n");
+    }
+
+    if (intListen >= 0)
+    {
+        close(intListen);
+        unlink(strSocket_a);
+    }
+
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    int blnClient = (argc >= 3 && strcmp(argv[1], "-client") == 0);
+
+    if (blnClient)
+    {
+        fprintf(stderr, "ZTB Daemon v20261019\n");
+        fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+        return run_client(argv[2], argc - 3, argv + 3);
+    }
+
+    strSyncPolicy = sync_option(&argc, argv);
+    if (argc > 3 && strcmp(argv[argc - 1], "-z") == 0)
+    {
+        blnCompress = 1;
+        argc--;
+    }
+
+    printf("ZTB Daemon v20261019\n");
+    printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <socket> <workdir> [<workdir> ...] [-z] [-sync none|block|group[:count[:ms]]]\n", argv[0]);
+        fprintf(stderr, "       %s -client <socket> <request ...>\n", argv[0]);
+        fprintf(stderr, "\n  Requests: PING | TIP <wd> <chain> | APPEND <wd> <chain> [<prev_id>|- [<block_id>]]\n");
+        fprintf(stderr, "            FETCH <wd> <block_id> | VERIFY <wd> <chain|tip_id> | TAIL <wd> <chain> <count> [-f]\n");
+        intResult = 1;
+    }
+
+    // --- 1. Every workdir must open (and take the sync policy) ---
+    if (intResult == 0)
+    {
+        int intI;
+        intWorkdirs = argc - 2;
+        arrWorkdirs = (ZTBDWorkdir*)calloc((size_t)intWorkdirs, sizeof(ZTBDWorkdir));
+        if (!arrWorkdirs) { fprintf(stderr, "Error: Out of memory\n"); intResult = 1; }
+
+        for (intI = 0; intI < intWorkdirs && intResult == 0; intI++)
+        {
+            ZTBChain *objProbe = ztb_open(argv[intI + 2]);
+            if (!objProbe || (strSyncPolicy && !ztb_set_sync(objProbe, strSyncPolicy))) { intResult = 1; }
+            ztb_close(objProbe);
+
+            arrWorkdirs[intI].strWorkDir = argv[intI + 2];
+            pthread_mutex_init(&arrWorkdirs[intI].lockState, NULL);
+            pthread_cond_init(&arrWorkdirs[intI].condTip, NULL);
+        }
+    }
+
+    // --- 2. Serve until stopped ---
+    if (intResult == 0)
+    {
+        struct sigaction objAction;
+        memset(&objAction, 0, sizeof(objAction));
+        objAction.sa_handler = on_stop_signal;
+        sigemptyset(&objAction.sa_mask);
+        sigaction(SIGINT, &objAction, NULL);
+        sigaction(SIGTERM, &objAction, NULL);
+        signal(SIGPIPE, SIG_IGN);
+
+        intResult = run_server(argv[1]);
+    }
+
+    // --- 3. Wait for appends in flight (each is committed before it is answered) ---
+    if (arrWorkdirs)
+    {
+        int intI;
+        for (intI = 0; intI < intWorkdirs; intI++)
+        {
+            ZTBDChain *objChain;
+            pthread_mutex_lock(&arrWorkdirs[intI].lockState);
+            pthread_cond_broadcast(&arrWorkdirs[intI].condTip);
+            objChain = arrWorkdirs[intI].objChains;
+            pthread_mutex_unlock(&arrWorkdirs[intI].lockState);
+
+            // Chains are only ever added at the head, so the list can be walked unlocked
+            for (; objChain; objChain = objChain->objNext)
+            {
+                pthread_mutex_lock(&objChain->lockAppend);
+                ztb_close(objChain->objHandle);
+                objChain->objHandle = NULL;
+            }
+        }
+    }
+
+    return intResult;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    printf("ZTB Daemon v20261019\n");
+    printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+    fprintf(stderr, "Error: ztbd needs Unix domain sockets and is not built for Windows\n");
+    return 1;
+}
+
+#endif
\ No newline at end of file
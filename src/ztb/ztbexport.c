@@ -0,0 +1,209 @@
+// Cyborg ZTB Export v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Packs a run of blocks into one bundle file for ztbimport on another node.
+//
+// Usage: ztbexport <workdir> <tip_block_id> [-since <peer_tip_id> | -from <first_block_id>]
+//                  [-genesis <genesis_block_id>] [-o <bundle|->]
+//
+// The bundle holds <tip_block_id>'s chain oldest first: the whole chain back to genesis
+// (or a truncation), the blocks from <first_block_id> up to the tip, or with -since
+// only the blocks after <peer_tip_id>, which must be an ancestor of the tip. The walk
+// back reads raw headers only and stops at <peer_tip_id>, so a delta costs the same
+// however large the workdir is. -genesis adds the genesis block first, for seeding an
+// empty workdir. The chain's name is taken from chains.idx when <tip_block_id> is its
+// recorded tip, so ztbimport can move the tip on the other side.
+//
+// The bundle header (see ZTBBundleEntry) lists every block and its length up front,
+// then the block files follow, each with its CRC32. Output goes to stdout by default
+// ("-o -") with the report on stderr, or to <bundle> via <bundle>.tmp.
+
+#include "ztbcommon.h"
+
+// --- Find the chain whose recorded tip is strTipID_a ("" if none) ---
+static void chain_for_tip(const char *strWorkDir_a, const char *strTipID_a, char *strChainID_a)
+{
+    ZTBChainIndex objIndex;
+    int intI;
+
+    strChainID_a[0] = '\0';
+    if (chains_index_load(strWorkDir_a, &objIndex))
+    {
+        for (intI = 0; intI < objIndex.intCount; intI++)
+        {
+            if (strcmp(objIndex.arrChains[intI].strTip, strTipID_a) == 0)
+            {
+                snprintf(strChainID_a, GUID_LEN, "%s", objIndex.arrChains[intI].strName);
+            }
+        }
+        chains_index_free(&objIndex);
+    }
+}
+
+// --- Write the bundle for arrIDs_a (newest first, as collect_chain returns them) ---
+static int write_bundle(FILE *fOut_a, const char *strWorkDir_a, const char *strChainID_a,
+                        const char *strGenesisID_a, char (*arrIDs_a)[GUID_LEN], int intCount_a,
+                        uint64_t *intBytes_a)
+{
+    int intResult = 1;
+    int intTotal  = intCount_a + (strGenesisID_a ? 1 : 0);
+    ZTBBundleEntry *arrEntries = (ZTBBundleEntry*)calloc((size_t)intTotal + 1, sizeof(ZTBBundleEntry));
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    int intI;
+
+    *intBytes_a = 0;
+    if (!arrEntries) { intResult = 0; }
+
+    // --- 1. Index: genesis, then oldest to newest ---
+    for (intI = 0; intI < intTotal && intResult; intI++)
+    {
+        ZTBBundleEntry *objEntry = &arrEntries[intI];
+        if (strGenesisID_a && intI == 0)
+        {
+            snprintf(objEntry->strID, GUID_LEN, "%s", strGenesisID_a);
+            objEntry->intFlags = BUNDLE_FLAG_GENESIS;
+        }
+        else
+        {
+            snprintf(objEntry->strID, GUID_LEN, "%s", arrIDs_a[intTotal - 1 - intI]);
+        }
+
+        if (read_block_prefix(strWorkDir_a, objEntry->strID, arrHeader, HEADER_RAW_SIZE,
+                              &objEntry->intLen) < HEADER_RAW_SIZE ||
+            ((objEntry->intFlags & BUNDLE_FLAG_GENESIS) && objEntry->intLen != ROM_SIZE))
+        {
+            fprintf(stderr, "Error: Cannot export block '%s'\n", objEntry->strID);
+            intResult = 0;
+        }
+    }
+
+    // --- 2. Header, then each block file ---
+    if (intResult)
+    {
+        intResult = bundle_write_header(fOut_a, strChainID_a, arrEntries, intTotal);
+    }
+
+    for (intI = 0; intI < intTotal && intResult; intI++)
+    {
+        char strPath[FILENAME_MAX];
+        block_file_path(strWorkDir_a, arrEntries[intI].strID, ".ztb", strPath);
+        intResult    = bundle_write_block(fOut_a, strPath, arrEntries[intI].intLen);
+        *intBytes_a += arrEntries[intI].intLen;
+    }
+
+    if (arrEntries) { free(arrEntries); }
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    const char *strSince   = NULL;
+    const char *strFrom    = NULL;
+    const char *strGenesis = NULL;
+    const char *strOutFile = "-";
+    int intI;
+
+    fprintf(stderr, "ZTB Export v20261019\n");
+    fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    for (intI = 3; intI + 1 < argc && intResult == 0; intI += 2)
+    {
+        if (strcmp(argv[intI], "-since") == 0)        { strSince   = argv[intI + 1]; }
+        else if (strcmp(argv[intI], "-from") == 0)    { strFrom    = argv[intI + 1]; }
+        else if (strcmp(argv[intI], "-genesis") == 0) { strGenesis = argv[intI + 1]; }
+        else if (strcmp(argv[intI], "-o") == 0)       { strOutFile = argv[intI + 1]; }
+        else                                          { intResult  = 1; }
+    }
+
+    if (argc < 3 || intI != argc || intResult || (strSince && strFrom))
+    {
+        fprintf(stderr, "Usage: %s <workdir> <tip_block_id> [-since <peer_tip_id> | -from <first_block_id>]\n", argv[0]);
+        fprintf(stderr, "                 [-genesis <genesis_block_id>] [-o <bundle|->]\n");
+        intResult = 1;
+    }
+
+    char (*arrIDs)[GUID_LEN] = NULL;
+    int intCount = 0;
+
+    // --- 1. Walk back from the tip to the peer's tip (or the start of the range) ---
+    if (intResult == 0)
+    {
+        const char *strWorkDir_a = argv[1];
+        const char *strTipID_a   = argv[2];
+        const char *strStop      = strSince ? strSince : strFrom;
+
+        intCount = collect_chain(strWorkDir_a, strTipID_a, strStop, 0, &arrIDs);
+        if (intCount < 0)
+        {
+            intResult = 1;
+        }
+        else if (strStop && (intCount == 0 || strcmp(arrIDs[intCount - 1], strStop) != 0))
+        {
+            fprintf(stderr, "Error: '%s' is not an ancestor of '%s'\n", strStop, strTipID_a);
+            intResult = 1;
+        }
+        else if (strSince)
+        {
+            intCount--;                     // the peer already has its tip
+        }
+    }
+
+    // --- 2. Write the bundle ---
+    if (intResult == 0)
+    {
+        const char *strWorkDir_a = argv[1];
+        const char *strTipID_a   = argv[2];
+        int blnStdout = (strcmp(strOutFile, "-") == 0);
+        char strTmpPath[FILENAME_MAX + 4];
+        char strChainID[GUID_LEN];
+        uint64_t intBytes = 0;
+        FILE *fOut = stdout;
+
+        chain_for_tip(strWorkDir_a, strTipID_a, strChainID);
+
+        if (blnStdout)
+        {
+#ifdef _WIN32
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        }
+        else
+        {
+            snprintf(strTmpPath, sizeof(strTmpPath), "%s.tmp", strOutFile);
+            fOut = fopen(strTmpPath, "wb");
+            if (!fOut)
+            {
+                fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+                intResult = 1;
+            }
+        }
+
+        if (intResult == 0 &&
+            (!write_bundle(fOut, strWorkDir_a, strChainID, strGenesis, arrIDs, intCount, &intBytes) ||
+             fflush(fOut) != 0))
+        {
+            intResult = 1;
+        }
+
+        if (!blnStdout && fOut)
+        {
+            if (fclose(fOut) != 0) { intResult = 1; }
+            if (intResult == 0 && !rename_block_file(strTmpPath, strOutFile, 0)) { intResult = 1; }
+            if (intResult != 0) { remove(strTmpPath); }
+        }
+
+        if (intResult == 0)
+        {
+            fprintf(stderr, "Chain:  %s\n", strChainID[0] ? strChainID : "(not in chains index)");
+            fprintf(stderr, "Tip:    %s\n", strTipID_a);
+            fprintf(stderr, "Blocks: %d%s\n", intCount, strGenesis ? " + genesis" : "");
+            fprintf(stderr, "Bytes:  %llu\n", (unsigned long long)intBytes);
+            if (!blnStdout) { fprintf(stderr, "Output: %s\n", strOutFile); }
+        }
+    }
+
+    if (arrIDs) { free(arrIDs); }
+    return intResult;
+}
\ No newline at end of file
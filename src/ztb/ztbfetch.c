@@ -1,174 +1,373 @@
-// Cyborg ZTB Fetch Block v20260618
+// Cyborg ZTB Fetch Block v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
 // Fetches and decodes a block. Matches ZTBChain.FetchBlock exactly.
 //
-// Usage: ztbfetch <workdir> <block_id>
+// Usage: ztbfetch <workdir> <block_id> [-o <file|->]
+//        ztbfetch <workdir> -range <from_block_id> <to_block_id> [-d <dir>]
+//        ztbfetch <workdir> -last <count> <tip_block_id> [-d <dir>]
+//
+// Blocks are decoded STREAM_CHUNK_SIZE bytes at a time (see ZTBBlockReader), so memory
+// stays flat whatever the block size. Without -o the block is read twice: once to
+// check its hashes, then again to print the payload between the usual markers. With
+// -o only the payload bytes are written, in a single pass: to <file> via
+// <file>.tmp, renamed into place only if the block checks out (removed otherwise), or
+// with "-o -" raw to stdout with the report on stderr. The hash is only known once
+// the whole payload has been read, so "-o -" consumers must check the exit status.
+//
+// Range modes decode a contiguous run of blocks oldest first in one pass: the chain
+// is walked back once over the raw headers only, then each block is decoded and
+// checked with a single rolling ROM that is advanced block to block (see
+// ZTBRollingRom) instead of being rebuilt from 64 files per block. A truncation block
+// ends the walk and is not output. Payloads go to stdout as frames:
+//   ZTBFRAME <block_id> <block_type> <payload_len>\n<payload_len raw bytes>\n
+// or, with -d, to <dir>/<block_id>.bin (<dir> must exist) with one
+// "<block_id> <payload_len>" line per block on stdout. In range modes the banner
+// goes to stderr. A frame is streamed before its hash is known; if the block then
+// fails its check the run stops there with a non-zero exit status.
+//
+// Blocks stored compressed (ztbaddblock -z) are decompressed on the way out, so every
+// payload written and every length above is the decompressed payload's; the block
+// report shows both the stored Payload Len and the Data Len.
 
-#include "ztbcommon.c"
+#include "ztbcommon.h"
 
-int main(int argc, char *argv[])
+#define FRAME_MAGIC     "ZTBFRAME"
+
+// --- Decode one block with the current ROM, check it, emit it, advance the ROM ---
+// blnPrevTrunc_a: the previous block is a truncation marker (prev_hash not checked).
+static int fetch_range_block(const char *strWorkDir_a, ZTBRollingRom *objRom_a,
+                             const char *strBlockID_a, int blnPrevTrunc_a,
+                             const char *strOutDir_a)
 {
-    int intResult = 0;
+    int intResult = 1;
+    ZTBBlockReader objReader;
 
-    printf("ZTB Fetch Block v20260618\n");
-    printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+    if (!block_reader_open(&objReader, strWorkDir_a, strBlockID_a, objRom_a->arrRom) ||
+        !objReader.blnEncoded)
+    {
+        fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+        intResult = 0;
+    }
 
-    if (argc != 3)
+    // prev CRC comes from the ROM window, so this is checked before anything is emitted
+    if (intResult &&
+        !(objReader.intStoredPrevHash == 0 || blnPrevTrunc_a ||
+          strcmp(objRom_a->strPrevID, NULL_GUID) == 0 ||
+          objRom_a->intPrevCrc == objReader.intStoredPrevHash))
     {
-        fprintf(stderr, "Usage: %s <workdir> <block_id>\n", argv[0]);
-        intResult = 1;
+        fprintf(stderr, "!!! INTEGRITY FAILURE: %s !!!\n", strBlockID_a);
+        intResult = 0;
     }
 
-    uint8_t *byBlock      = NULL;
+    // --- Emit while decoding: a frame on stdout, or <dir>/<block_id>.bin ---
+    if (intResult)
+    {
+        if (strOutDir_a)
+        {
+            char strPath[FILENAME_MAX];
+            char strTmpPath[FILENAME_MAX + 4];
+            snprintf(strPath, FILENAME_MAX, "%s/%s.bin", strOutDir_a, strBlockID_a);
+            snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strPath);
+
+            FILE *fOut = fopen(strTmpPath, "wb");
+            if (!fOut)
+            {
+                fprintf(stderr, "Error: Cannot write %s\n", strTmpPath);
+                intResult = 0;
+            }
+            else
+            {
+                intResult = block_reader_copy(&objReader, fOut);
+                if (fclose(fOut) != 0) { intResult = 0; }
+                if (intResult && objReader.intCalcHash != objReader.intStoredHash)
+                {
+                    fprintf(stderr, "!!! INTEGRITY FAILURE: %s !!!\n", strBlockID_a);
+                    intResult = 0;
+                }
+                if (intResult) { intResult = rename_block_file(strTmpPath, strPath, 0); }
+                if (!intResult) { remove(strTmpPath); }
+            }
+            if (intResult) { printf("%s %llu\n", strBlockID_a, (unsigned long long)objReader.intDataLen); }
+        }
+        else
+        {
+            printf("%s %s %d %llu\n", FRAME_MAGIC, strBlockID_a,
+                   objReader.arrRawHeader[RAW_OFF_BLOCK_TYPE], (unsigned long long)objReader.intDataLen);
+            intResult = block_reader_copy(&objReader, stdout);
+            if (intResult && fputc('\n', stdout) == EOF)
+            {
+                fprintf(stderr, "Error: Write failed\n");
+                intResult = 0;
+            }
+            if (intResult && objReader.intCalcHash != objReader.intStoredHash)
+            {
+                fprintf(stderr, "!!! INTEGRITY FAILURE: %s !!!\n", strBlockID_a);
+                intResult = 0;
+            }
+        }
+    }
+
+    // --- Move the ROM window on to this block ---
+    if (intResult)
+    {
+        intResult = rolling_rom_advance(objRom_a, objReader.arrHead, objReader.intHeadLen,
+                                        strBlockID_a, objReader.intFileCrc);
+    }
+
+    block_reader_close(&objReader);
+    return intResult;
+}
+
+// --- Range mode: decode the collected blocks oldest first ---
+static int fetch_range(const char *strWorkDir_a, char (*arrIDs_a)[GUID_LEN], int intCount_a,
+                       const char *strOutDir_a)
+{
+    int intResult = 1;
+    int intDone   = 0;
+
+    // ROM as of the oldest block's prev; it is advanced block by block from here on
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint64_t intLen = 0;
+    char strPrevID[GUID_LEN];
+    read_block_prefix(strWorkDir_a, arrIDs_a[intCount_a - 1], arrHeader, HEADER_RAW_SIZE, &intLen);
+    read_fixed_string(arrHeader, RAW_OFF_PREV_ID, 36, strPrevID);
+
+    int blnPrevTrunc = 0;
+    if (strcmp(strPrevID, NULL_GUID) != 0 &&
+        read_block_prefix(strWorkDir_a, strPrevID, arrHeader, HEADER_RAW_SIZE, &intLen) == HEADER_RAW_SIZE)
+    {
+        blnPrevTrunc = (arrHeader[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION);
+    }
+
+    ZTBRollingRom *objRom = rolling_rom_open(strWorkDir_a, strPrevID);
+    if (!objRom)
+    {
+        fprintf(stderr, "Error: Cannot build rolling ROM\n");
+        intResult = 0;
+    }
+
+    int intI;
+    for (intI = intCount_a - 1; intI >= 0 && intResult; intI--)
+    {
+        intResult = fetch_range_block(strWorkDir_a, objRom, arrIDs_a[intI], blnPrevTrunc,
+                                      strOutDir_a);
+        blnPrevTrunc = 0;
+        if (intResult) { intDone++; }
+    }
+
+    fprintf(stderr, "%s %d of %d block(s) fetched\n", intResult ? "+" : "-", intDone, intCount_a);
+
+    if (objRom) { rolling_rom_close(objRom); }
+    return intResult;
+}
+
+// --- Single block: report on stdout and print the payload, or stream it to -o ---
+static int fetch_single(const char *strWorkDir_a, const char *strBlockID_a,
+                        const char *strOutFile_a)
+{
+    int intResult    = 0;
+    int blnStdout    = (strOutFile_a && strcmp(strOutFile_a, "-") == 0);
+    FILE *fInfo      = blnStdout ? stderr : stdout;
     uint8_t *byRollingRom = NULL;
-    uint8_t *byDecoded    = NULL;
+    ZTBBlockReader objReader;
+    objReader.f = NULL;
+
+    // --- 1. Read raw header ---
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint64_t intBlockLen = 0;
+    if (read_block_prefix(strWorkDir_a, strBlockID_a, arrHeader, HEADER_RAW_SIZE,
+                          &intBlockLen) < HEADER_RAW_SIZE)
+    {
+        fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+        intResult = 1;
+    }
 
+    char strPrevID[GUID_LEN];
+    uint8_t byBlockType = 0;
     if (intResult == 0)
     {
-        const char *strWorkDir_a = argv[1];
-        const char *strBlockID_a = argv[2];
+        char strTrunkID[GUID_LEN];
+        char strBlockID[GUID_LEN];
+        byBlockType = arrHeader[RAW_OFF_BLOCK_TYPE];
+
+        read_fixed_string(arrHeader, RAW_OFF_TRUNK_ID, 36, strTrunkID);
+        read_fixed_string(arrHeader, RAW_OFF_BLOCK_ID, 36, strBlockID);
+        read_fixed_string(arrHeader, RAW_OFF_PREV_ID,  36, strPrevID);
+
+        fprintf(fInfo, "--- Block Header ---\n");
+        fprintf(fInfo, "Block ID:     %s\n", strBlockID);
+        fprintf(fInfo, "Prev ID:      %s\n", strPrevID);
+        fprintf(fInfo, "Trunk ID:     %s\n", strTrunkID);
+        fprintf(fInfo, "Is Branch:    %s\n", arrHeader[RAW_OFF_IS_BRANCH] ? "Yes" : "No");
+        fprintf(fInfo, "Block Type:   %d\n", byBlockType);
+    }
 
-        // --- 1. Load block ---
-        int intBlockLen = 0;
-        byBlock = load_block(strWorkDir_a, strBlockID_a, &intBlockLen);
-        if (!byBlock || intBlockLen < HEADER_RAW_SIZE)
+    // Truncation block is not encoded — return directly (matches C# FetchBlock)
+    if (intResult == 0 && byBlockType == BLOCK_TYPE_TRUNCATION)
+    {
+        fprintf(fInfo, "(Truncation block — payload is raw rolling ROM)\n");
+        if (strOutFile_a)
+        {
+            fprintf(stderr, "Error: Truncation block has no encoded payload\n");
+            intResult = 1;
+        }
+    }
+    else if (intResult == 0)
+    {
+        // --- 2. Build rolling ROM ---
+        byRollingRom = build_rolling_rom(strWorkDir_a, strPrevID);
+        if (!byRollingRom)
         {
-            fprintf(stderr, "Error: Cannot load block '%s'\n", strBlockID_a);
+            fprintf(stderr, "Error: Cannot build rolling ROM\n");
             intResult = 1;
         }
 
-        if (intResult == 0)
+        // --- 3. Decode the encoded header ---
+        if (intResult == 0 &&
+            !block_reader_open(&objReader, strWorkDir_a, strBlockID_a, byRollingRom))
         {
-            // --- 2. Read raw header ---
-            uint8_t byBlockType  = byBlock[RAW_OFF_BLOCK_TYPE];
-            uint8_t byIsBranch   = byBlock[RAW_OFF_IS_BRANCH];
-            char strTrunkID[GUID_LEN];
-            char strBlockID[GUID_LEN];
-            char strPrevID[GUID_LEN];
-
-            read_fixed_string(byBlock, RAW_OFF_TRUNK_ID, 36, strTrunkID);
-            read_fixed_string(byBlock, RAW_OFF_BLOCK_ID, 36, strBlockID);
-            read_fixed_string(byBlock, RAW_OFF_PREV_ID,  36, strPrevID);
-
-            printf("--- Block Header ---\n");
-            printf("Block ID:     %s\n", strBlockID);
-            printf("Prev ID:      %s\n", strPrevID);
-            printf("Trunk ID:     %s\n", strTrunkID);
-            printf("Is Branch:    %s\n", byIsBranch ? "Yes" : "No");
-            printf("Block Type:   %d\n", byBlockType);
-
-            // Truncation block is not encoded — return directly (matches C# FetchBlock)
-            if (byBlockType == BLOCK_TYPE_TRUNCATION)
+            fprintf(stderr, "Error: ZOSCII decode failed\n");
+            intResult = 1;
+        }
+
+        // --- 4. Decode the payload: hash only, or straight to the -o target ---
+        FILE *fOut = NULL;
+        char strTmpPath[FILENAME_MAX + 4];
+        strTmpPath[0] = 0;
+        if (intResult == 0 && strOutFile_a)
+        {
+            if (blnStdout)
             {
-                printf("(Truncation block — payload is raw rolling ROM)\n");
+#ifdef _WIN32
+                _setmode(_fileno(stdout), _O_BINARY);
+#endif
+                fOut = stdout;
             }
             else
             {
-                // --- 3. Build rolling ROM ---
-                byRollingRom = build_rolling_rom(strWorkDir_a, strPrevID);
-                if (!byRollingRom)
+                snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutFile_a);
+                fOut = fopen(strTmpPath, "wb");
+                if (!fOut)
                 {
-                    fprintf(stderr, "Error: Cannot build rolling ROM\n");
+                    fprintf(stderr, "Error: Cannot write %s\n", strTmpPath);
                     intResult = 1;
                 }
+            }
+        }
 
-                if (intResult == 0)
-                {
-                    // --- 4. ZOSCII decode encoded section ---
-                    int intEncLen    = intBlockLen - HEADER_RAW_SIZE;
-                    int intDecLen    = 0;
-                    byDecoded        = zoscii_decode(byRollingRom, byBlock,
-                                                     HEADER_RAW_SIZE, intEncLen, &intDecLen);
-                    if (!byDecoded || intDecLen < ENC_HEADER_SIZE)
-                    {
-                        fprintf(stderr, "Error: ZOSCII decode failed\n");
-                        intResult = 1;
-                    }
-
-                    if (intResult == 0)
-                    {
-                        // --- 5. Read encoded section fields ---
-                        uint8_t byHashType     = byDecoded[ENC_OFF_HASH_TYPE];
-                        uint32_t intStoredHash = (uint32_t)(byDecoded[ENC_OFF_HASH] |
-                                                (byDecoded[ENC_OFF_HASH + 1] << 8)  |
-                                                (byDecoded[ENC_OFF_HASH + 2] << 16) |
-                                                (byDecoded[ENC_OFF_HASH + 3] << 24));
-                        uint32_t intStoredPrevHash = (uint32_t)(byDecoded[ENC_OFF_PREV_HASH] |
-                                                    (byDecoded[ENC_OFF_PREV_HASH + 1] << 8)  |
-                                                    (byDecoded[ENC_OFF_PREV_HASH + 2] << 16) |
-                                                    (byDecoded[ENC_OFF_PREV_HASH + 3] << 24));
-                        uint32_t intPayloadLen = (uint32_t)(byDecoded[ENC_OFF_PAYLOAD_LEN] |
-                                                (byDecoded[ENC_OFF_PAYLOAD_LEN + 1] << 8)  |
-                                                (byDecoded[ENC_OFF_PAYLOAD_LEN + 2] << 16) |
-                                                (byDecoded[ENC_OFF_PAYLOAD_LEN + 3] << 24));
-                        uint32_t intPaddedLen  = (uint32_t)(byDecoded[ENC_OFF_PADDED_LEN] |
-                                                (byDecoded[ENC_OFF_PADDED_LEN + 1] << 8)  |
-                                                (byDecoded[ENC_OFF_PADDED_LEN + 2] << 16) |
-                                                (byDecoded[ENC_OFF_PADDED_LEN + 3] << 24));
-
-                        // --- 6. Verify hash --- current-block hash covers the payload ONLY,
-                        // not the header or encoded-section metadata (see ztbaddblock.c).
-                        int intPaddedPayloadLen = intDecLen - ENC_OFF_PAYLOAD;
-                        uint32_t intCalcHash = hash_bytes((int)byHashType,
-                                                          byDecoded + ENC_OFF_PAYLOAD,
-                                                          0, intPaddedPayloadLen);
-                        int blnHashOK = (intCalcHash == intStoredHash);
-
-                        // Verify prev hash
-                        int blnPrevHashOK = 1;
-                        if (intStoredPrevHash != 0 &&
-                            strcmp(strPrevID, NULL_GUID) != 0)
-                        {
-                            int intPrevLen   = 0;
-                            uint8_t *byPrev  = load_block(strWorkDir_a, strPrevID, &intPrevLen);
-                            if (byPrev)
-                            {
-                                // Skip prev hash check if prev is truncation (matches C#)
-                                int blnPrevIsTrunc = (intPrevLen >= HEADER_RAW_SIZE &&
-                                                      byPrev[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION);
-                                if (!blnPrevIsTrunc)
-                                {
-                                    uint32_t intCalcPrev = hash_bytes((int)byHashType,
-                                                                       byPrev, 0, intPrevLen);
-                                    blnPrevHashOK = (intCalcPrev == intStoredPrevHash);
-                                }
-                                free(byPrev);
-                            }
-                        }
-
-                        printf("Hash Type:    %d\n", byHashType);
-                        printf("Hash:         0x%08X %s\n", intStoredHash,
-                               blnHashOK ? "(OK)" : "(FAIL)");
-                        printf("PrevHash:     0x%08X %s\n", intStoredPrevHash,
-                               blnPrevHashOK ? "(OK)" : "(FAIL)");
-                        printf("Payload Len:  %u\n", intPayloadLen);
-                        printf("Padded Len:   %u\n", intPaddedLen);
-
-                        if (!blnHashOK || !blnPrevHashOK)
-                        {
-                            fprintf(stderr, "\n!!! INTEGRITY FAILURE !!!\n");
-                            intResult = 1;
-                        }
-                        else
-                        {
-                            printf("\n--- Payload (%u bytes) ---\n", intPayloadLen);
-                            if (intDecLen >= (int)(ENC_OFF_PAYLOAD + intPayloadLen))
-                            {
-                                fwrite(byDecoded + ENC_OFF_PAYLOAD, 1, intPayloadLen, stdout);
-                            }
-                            printf("\n--- End Payload ---\n");
-                        }
-                    }
-                }
+        if (intResult == 0 && !block_reader_copy(&objReader, fOut)) { intResult = 1; }
+        if (fOut && !blnStdout && fclose(fOut) != 0) { intResult = 1; }
+        if (fOut && blnStdout && fflush(stdout) != 0) { intResult = 1; }
+
+        // --- 5. Verify hash --- current-block hash covers the payload ONLY,
+        // not the header or encoded-section metadata (see ztbaddblock.c).
+        if (intResult == 0)
+        {
+            int blnHashOK     = (objReader.intCalcHash == objReader.intStoredHash);
+            int blnPrevHashOK = block_prev_hash_ok(strWorkDir_a, strPrevID, objReader.byHashType,
+                                                     objReader.intStoredPrevHash);
+
+            fprintf(fInfo, "Hash Type:    %d\n", objReader.byHashType);
+            fprintf(fInfo, "Hash:         0x%08X %s\n", objReader.intStoredHash,
+                    blnHashOK ? "(OK)" : "(FAIL)");
+            fprintf(fInfo, "PrevHash:     0x%08X %s\n", objReader.intStoredPrevHash,
+                    blnPrevHashOK ? "(OK)" : "(FAIL)");
+            fprintf(fInfo, "Payload Len:  %u\n", objReader.intPayloadLen);
+            if (objReader.blnCompressed)
+            {
+                fprintf(fInfo, "Data Len:     %llu (lz4)\n", (unsigned long long)objReader.intDataLen);
+            }
+            fprintf(fInfo, "Padded Len:   %u\n", objReader.intPaddedLen);
+
+            if (!blnHashOK || !blnPrevHashOK)
+            {
+                fprintf(stderr, "\n!!! INTEGRITY FAILURE !!!\n");
+                intResult = 1;
             }
         }
+
+        // --- 6. Output: commit the -o file, or reread and print the payload ---
+        if (strOutFile_a && !blnStdout && fOut)
+        {
+            if (intResult == 0 && !rename_block_file(strTmpPath, strOutFile_a, 0)) { intResult = 1; }
+            if (intResult != 0) { remove(strTmpPath); }
+            if (intResult == 0) { fprintf(fInfo, "Output:       %s\n", strOutFile_a); }
+        }
+        else if (intResult == 0 && !strOutFile_a)
+        {
+            block_reader_close(&objReader);
+            printf("\n--- Payload (%llu bytes) ---\n", (unsigned long long)objReader.intDataLen);
+            if (!block_reader_open(&objReader, strWorkDir_a, strBlockID_a, byRollingRom) ||
+                !block_reader_copy(&objReader, stdout))
+            {
+                fprintf(stderr, "Error: Cannot reread block '%s'\n", strBlockID_a);
+                intResult = 1;
+            }
+            printf("\n--- End Payload ---\n");
+        }
     }
 
-    if (byBlock)      { free(byBlock); }
+    block_reader_close(&objReader);
     if (byRollingRom) { free(byRollingRom); }
-    if (byDecoded)    { free(byDecoded); }
+
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    int blnRange  = (argc >= 5 && (strcmp(argv[2], "-range") == 0 || strcmp(argv[2], "-last") == 0));
+    const char *strOutDir  = NULL;
+    const char *strOutFile = NULL;
+
+    if (blnRange && argc == 7 && strcmp(argv[5], "-d") == 0) { strOutDir = argv[6]; }
+    if (!blnRange && argc == 5 && strcmp(argv[3], "-o") == 0) { strOutFile = argv[4]; }
+
+    // Range output and "-o -" put raw data on stdout, so keep the banner off stdout
+    FILE *fBanner = (blnRange || (strOutFile && strcmp(strOutFile, "-") == 0)) ? stderr : stdout;
+    fprintf(fBanner, "ZTB Fetch Block v20261019\n");
+    fprintf(fBanner, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (argc != 3 && !strOutFile && !(blnRange && (argc == 5 || strOutDir)))
+    {
+        fprintf(stderr, "Usage: %s <workdir> <block_id> [-o <file|->]\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> -range <from_block_id> <to_block_id> [-d <dir>]\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> -last <count> <tip_block_id> [-d <dir>]\n", argv[0]);
+        intResult = 1;
+    }
+    else if (blnRange)
+    {
+        const char *strWorkDir_a = argv[1];
+        char (*arrIDs)[GUID_LEN] = NULL;
+        int intCount;
+
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        if (strcmp(argv[2], "-range") == 0)
+        {
+            intCount = collect_chain(strWorkDir_a, argv[4], argv[3], 0, &arrIDs);
+        }
+        else
+        {
+            int intLast = atoi(argv[3]);
+            intCount    = (intLast > 0) ? collect_chain(strWorkDir_a, argv[4], NULL, intLast, &arrIDs) : -1;
+            if (intLast <= 0) { fprintf(stderr, "Error: Bad count '%s'\n", argv[3]); }
+        }
+
+        if (intCount <= 0 || !fetch_range(strWorkDir_a, arrIDs, intCount, strOutDir))
+        {
+            intResult = 1;
+        }
+        if (arrIDs) { free(arrIDs); }
+    }
+
+    if (intResult == 0 && !blnRange)
+    {
+        intResult = fetch_single(argv[1], argv[2], strOutFile);
+    }
 
     return intResult;
 }
\ No newline at end of file
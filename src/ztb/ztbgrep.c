@@ -0,0 +1,618 @@
+// Cyborg ZTB Grep v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Searches decoded block payloads for one or more byte patterns.
+//
+// Usage: ztbgrep <workdir> <tip_block_id | -all> (-e <text> | -x <hex>)...
+//                [-m <count>] [-j <threads>] [-l]
+//
+// <tip_block_id> searches that block's chain back to genesis (or a truncation);
+// -all searches every block in the workdir once, however many branches share it.
+// Patterns are literal: -e takes text, -x takes hex bytes ("deadbeef"). All patterns
+// are matched in a single pass by one Aho-Corasick automaton, so the cost per byte
+// does not grow with the number of patterns. Only the payload_len payload bytes are
+// searched, never the padding.
+//
+// The blocks are split into runs of consecutive blocks. A pool of -j workers (default
+// one per CPU) each take a run, open a rolling ROM at its start and stream-decode the
+// run block by block (ZTBBlockReader), advancing the ROM as they go. Results are
+// printed in run order (a chain oldest first), one line per match:
+//   <block_id> <payload_offset> <pattern_number>
+// or with -l one line per matching block. -m stops after that many matching blocks.
+// Blocks that fail their hash checks are reported on stderr and still searched.
+//
+// Exit status: 0 = match found, 1 = no match, 2 = error or integrity failure.
+
+#include "ztbcommon.h"
+#include <ctype.h>
+
+#define GREP_MAX_PATTERNS   256
+
+// --- Aho-Corasick automaton, completed into a DFA (one row of 256 per state) ---
+typedef struct
+{
+    int *arrNext;
+    int *arrFail;
+    int *arrMatch;                          // pattern ending at this state, -1 if none
+    int *arrOutLink;                        // next state on the fail chain with a match
+    int  intStates;
+    int  arrPatLen[GREP_MAX_PATTERNS];
+    int  intPatterns;
+} GrepMatcher;
+
+typedef struct
+{
+    int      intBlock;                      // index into the job's block list
+    uint64_t intOffset;
+    int      intPattern;
+} GrepHit;
+
+typedef struct
+{
+    ZTBRun   objRun;
+    GrepHit *arrHits;
+    int      intHits;
+    int      intHitCap;
+    int      intSearched;
+    int      blnDone;
+    int      blnFailed;
+} GrepRun;
+
+typedef struct
+{
+    const char  *strWorkDir;
+    GrepMatcher *objMatcher;
+    char       (*arrIDs)[GUID_LEN];
+    GrepRun     *arrRuns;
+    int          intRuns;
+    int          intNextRun;                // next run for a worker to take
+    int          intNextPrint;              // next run to print
+    int          intMax;
+    int          blnList;
+    int          blnStop;
+    int          blnError;
+    int          intMatched;
+    int          intSearched;
+    ZTBMutex     objLock;
+} GrepJob;
+
+typedef struct
+{
+    GrepJob *objJob;
+    GrepRun *objRun;
+    int      intBlock;
+    int      intState;
+    uint64_t intPos;
+    int      blnHit;
+    int      blnOOM;
+} GrepScan;
+
+// --- Build the automaton over intCount_a patterns ---
+static int matcher_build(GrepMatcher *objM_a, uint8_t **arrPat_a, const int *arrLen_a,
+                         int intCount_a)
+{
+    int intResult = 1;
+    int intMax    = 1;
+    int intI;
+
+    memset(objM_a, 0, sizeof(*objM_a));
+    for (intI = 0; intI < intCount_a; intI++) { intMax += arrLen_a[intI]; }
+
+    objM_a->arrNext    = (int*)malloc((size_t)intMax * 256 * sizeof(int));
+    objM_a->arrFail    = (int*)calloc((size_t)intMax, sizeof(int));
+    objM_a->arrMatch   = (int*)malloc((size_t)intMax * sizeof(int));
+    objM_a->arrOutLink = (int*)calloc((size_t)intMax, sizeof(int));
+    int *arrQueue      = (int*)malloc((size_t)intMax * sizeof(int));
+
+    if (!objM_a->arrNext || !objM_a->arrFail || !objM_a->arrMatch || !objM_a->arrOutLink ||
+        !arrQueue)
+    {
+        fprintf(stderr, "Error: Cannot allocate pattern matcher\n");
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        // --- 1. Trie of the patterns ---
+        memset(objM_a->arrNext, 0xFF, (size_t)intMax * 256 * sizeof(int));
+        memset(objM_a->arrMatch, 0xFF, (size_t)intMax * sizeof(int));
+        objM_a->intStates   = 1;
+        objM_a->intPatterns = intCount_a;
+
+        for (intI = 0; intI < intCount_a; intI++)
+        {
+            int intState = 0;
+            int intJ;
+            for (intJ = 0; intJ < arrLen_a[intI]; intJ++)
+            {
+                int *intSlot = &objM_a->arrNext[intState * 256 + arrPat_a[intI][intJ]];
+                if (*intSlot < 0) { *intSlot = objM_a->intStates++; }
+                intState = *intSlot;
+            }
+            if (objM_a->arrMatch[intState] < 0) { objM_a->arrMatch[intState] = intI; }
+            objM_a->arrPatLen[intI] = arrLen_a[intI];
+        }
+
+        // --- 2. Fail links breadth first, filling in the missing transitions ---
+        int intHead = 0;
+        int intTail = 0;
+        int intB;
+        for (intB = 0; intB < 256; intB++)
+        {
+            int intTo = objM_a->arrNext[intB];
+            if (intTo < 0) { objM_a->arrNext[intB] = 0; }
+            else           { arrQueue[intTail++] = intTo; }
+        }
+
+        while (intHead < intTail)
+        {
+            int intState = arrQueue[intHead++];
+            int intFail  = objM_a->arrFail[intState];
+
+            objM_a->arrOutLink[intState] = (objM_a->arrMatch[intFail] >= 0) ? intFail :
+                                           objM_a->arrOutLink[intFail];
+
+            for (intB = 0; intB < 256; intB++)
+            {
+                int *intSlot = &objM_a->arrNext[intState * 256 + intB];
+                if (*intSlot < 0)
+                {
+                    *intSlot = objM_a->arrNext[intFail * 256 + intB];
+                }
+                else
+                {
+                    objM_a->arrFail[*intSlot] = objM_a->arrNext[intFail * 256 + intB];
+                    arrQueue[intTail++] = *intSlot;
+                }
+            }
+        }
+    }
+
+    if (arrQueue) { free(arrQueue); }
+    return intResult;
+}
+
+static void matcher_free(GrepMatcher *objM_a)
+{
+    if (objM_a->arrNext)    { free(objM_a->arrNext); }
+    if (objM_a->arrFail)    { free(objM_a->arrFail); }
+    if (objM_a->arrMatch)   { free(objM_a->arrMatch); }
+    if (objM_a->arrOutLink) { free(objM_a->arrOutLink); }
+}
+
+// --- Parse a -x argument into bytes. Returns the length, 0 if not valid hex ---
+static int parse_hex(const char *strHex_a, uint8_t **byOut_a)
+{
+    int intLen = (int)strlen(strHex_a);
+    int intResult = 0;
+    *byOut_a = NULL;
+
+    if (intLen > 0 && (intLen % 2) == 0)
+    {
+        *byOut_a = (uint8_t*)malloc((size_t)intLen / 2);
+        intResult = (*byOut_a != NULL) ? intLen / 2 : 0;
+
+        int intI;
+        for (intI = 0; intI < intLen / 2 && intResult; intI++)
+        {
+            unsigned int intByte;
+            char strPair[3] = { strHex_a[intI * 2], strHex_a[intI * 2 + 1], 0 };
+            if (!isxdigit((unsigned char)strPair[0]) || !isxdigit((unsigned char)strPair[1]) ||
+                sscanf(strPair, "%2x", &intByte) != 1)
+            {
+                intResult = 0;
+            }
+            else
+            {
+                (*byOut_a)[intI] = (uint8_t)intByte;
+            }
+        }
+    }
+
+    if (!intResult && *byOut_a) { free(*byOut_a); *byOut_a = NULL; }
+    return intResult;
+}
+
+static int job_stopped(GrepJob *objJob_a)
+{
+    mutex_lock(&objJob_a->objLock);
+    int blnStop = objJob_a->blnStop;
+    mutex_unlock(&objJob_a->objLock);
+    return blnStop;
+}
+
+// --- block_reader_scan callback: run the payload through the automaton ---
+static int grep_chunk(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    GrepScan *objScan      = (GrepScan*)objCtx_a;
+    const GrepMatcher *objM = objScan->objJob->objMatcher;
+    GrepRun *objRun        = objScan->objRun;
+    int intState           = objScan->intState;
+    size_t intI;
+
+    for (intI = 0; intI < intLen_a && !objScan->blnOOM; intI++)
+    {
+        intState = objM->arrNext[intState * 256 + byData_a[intI]];
+        int intHitState = (objM->arrMatch[intState] >= 0) ? intState : objM->arrOutLink[intState];
+
+        while (intHitState > 0 && !(objScan->objJob->blnList && objScan->blnHit))
+        {
+            if (objRun->intHits == objRun->intHitCap)
+            {
+                int intCap = objRun->intHitCap ? objRun->intHitCap * 2 : 64;
+                GrepHit *arrNew = (GrepHit*)realloc(objRun->arrHits, (size_t)intCap * sizeof(GrepHit));
+                if (!arrNew)
+                {
+                    objScan->blnOOM = 1;
+                    break;
+                }
+                objRun->arrHits   = arrNew;
+                objRun->intHitCap = intCap;
+            }
+
+            int intPattern   = objM->arrMatch[intHitState];
+            GrepHit *objHit  = &objRun->arrHits[objRun->intHits++];
+            objHit->intBlock   = objScan->intBlock;
+            objHit->intOffset  = objScan->intPos + intI + 1 - (uint64_t)objM->arrPatLen[intPattern];
+            objHit->intPattern = intPattern;
+            objScan->blnHit    = 1;
+
+            intHitState = objM->arrOutLink[intHitState];
+        }
+    }
+
+    objScan->intState = intState;
+    objScan->intPos  += intLen_a;
+
+    if (objScan->blnOOM) { fprintf(stderr, "Error: Cannot allocate match list\n"); }
+    return !objScan->blnOOM && !job_stopped(objScan->objJob);
+}
+
+// --- Decode and search one run of consecutive blocks with its own rolling ROM ---
+static void grep_run(GrepJob *objJob_a, GrepRun *objRun_a)
+{
+    int blnPrevTrunc = 0;
+    ZTBRollingRom *objRom = rolling_rom_open_before(objJob_a->strWorkDir,
+                                                    objJob_a->arrIDs[objRun_a->objRun.intFirst],
+                                                    &blnPrevTrunc);
+    if (!objRom) { objRun_a->blnFailed = 1; }
+
+    int intI;
+    for (intI = 0; intI < objRun_a->objRun.intCount && !objRun_a->blnFailed; intI++)
+    {
+        int intBlock      = objRun_a->objRun.intFirst + intI;
+        const char *strID = objJob_a->arrIDs[intBlock];
+        int blnIntact     = 0;
+        GrepScan objScan;
+
+        if (job_stopped(objJob_a)) { break; }
+
+        memset(&objScan, 0, sizeof(objScan));
+        objScan.objJob   = objJob_a;
+        objScan.objRun   = objRun_a;
+        objScan.intBlock = intBlock;
+
+        if (!read_run_block(objJob_a->strWorkDir, objRom, strID, blnPrevTrunc, grep_chunk,
+                            &objScan, &blnIntact))
+        {
+            // Stopped by -m, or a read/decode/allocation failure
+            if (!job_stopped(objJob_a))
+            {
+                fprintf(stderr, "Error: Cannot search block '%s'\n", strID);
+                objRun_a->blnFailed = 1;
+            }
+        }
+        else
+        {
+            if (!blnIntact)
+            {
+                fprintf(stderr, "!!! INTEGRITY FAILURE: %s !!!\n", strID);
+                mutex_lock(&objJob_a->objLock);
+                objJob_a->blnError = 1;
+                mutex_unlock(&objJob_a->objLock);
+            }
+            objRun_a->intSearched++;
+        }
+        blnPrevTrunc = 0;
+    }
+
+    if (objRom) { rolling_rom_close(objRom); }
+}
+
+// --- Print finished runs in order (caller holds the lock); applies -m ---
+static void grep_flush(GrepJob *objJob_a)
+{
+    while (!objJob_a->blnStop && objJob_a->intNextPrint < objJob_a->intRuns &&
+           objJob_a->arrRuns[objJob_a->intNextPrint].blnDone)
+    {
+        GrepRun *objRun = &objJob_a->arrRuns[objJob_a->intNextPrint++];
+        int intLastBlock = -1;
+        int intI;
+
+        if (objRun->blnFailed) { objJob_a->blnError = 1; }
+        objJob_a->intSearched += objRun->intSearched;
+
+        for (intI = 0; intI < objRun->intHits && !objJob_a->blnStop; intI++)
+        {
+            GrepHit *objHit = &objRun->arrHits[intI];
+            if (objHit->intBlock != intLastBlock)
+            {
+                if (objJob_a->intMax > 0 && objJob_a->intMatched >= objJob_a->intMax)
+                {
+                    objJob_a->blnStop = 1;
+                    break;
+                }
+                objJob_a->intMatched++;
+                intLastBlock = objHit->intBlock;
+            }
+
+            if (objJob_a->blnList)
+            {
+                printf("%s\n", objJob_a->arrIDs[objHit->intBlock]);
+            }
+            else
+            {
+                printf("%s %llu %d\n", objJob_a->arrIDs[objHit->intBlock],
+                       (unsigned long long)objHit->intOffset, objHit->intPattern + 1);
+            }
+        }
+
+        if (objJob_a->intMax > 0 && objJob_a->intMatched >= objJob_a->intMax)
+        {
+            objJob_a->blnStop = 1;
+        }
+
+        if (objRun->arrHits) { free(objRun->arrHits); objRun->arrHits = NULL; }
+    }
+}
+
+// --- Worker: take runs until none are left or -m has been satisfied ---
+static void grep_worker(void *objArg_a)
+{
+    GrepJob *objJob = (GrepJob*)objArg_a;
+
+    for (;;)
+    {
+        GrepRun *objRun = NULL;
+
+        mutex_lock(&objJob->objLock);
+        if (!objJob->blnStop && objJob->intNextRun < objJob->intRuns)
+        {
+            objRun = &objJob->arrRuns[objJob->intNextRun++];
+        }
+        mutex_unlock(&objJob->objLock);
+
+        if (!objRun) { break; }
+
+        grep_run(objJob, objRun);
+
+        mutex_lock(&objJob->objLock);
+        objRun->blnDone = 1;
+        grep_flush(objJob);
+        mutex_unlock(&objJob->objLock);
+    }
+}
+
+// --- -all: the tips of the workdir (blocks no other block names as prev) ---
+// Truncation markers are neither tips nor counted as children. Returns the number of
+// tips in *arrTips_a, -1 on error.
+static int find_tips(const char *strWorkDir_a, char (*arrIDs_a)[GUID_LEN], int intCount_a,
+                     char (**arrTips_a)[GUID_LEN])
+{
+    int intResult   = 0;
+    uint8_t *arrFlags = (uint8_t*)calloc((size_t)intCount_a + 1, 1);   // 1 trunc, 2 child
+    char (*arrTips)[GUID_LEN] = (char (*)[GUID_LEN])malloc((size_t)(intCount_a + 1) * GUID_LEN);
+    int intI;
+
+    if (!arrFlags || !arrTips)
+    {
+        fprintf(stderr, "Error: Cannot allocate block list\n");
+        intResult = -1;
+    }
+
+    for (intI = 0; intI < intCount_a && intResult >= 0; intI++)
+    {
+        uint8_t arrHeader[HEADER_RAW_SIZE];
+        uint64_t intLen = 0;
+        char strPrevID[GUID_LEN];
+
+        if (read_block_prefix(strWorkDir_a, arrIDs_a[intI], arrHeader, HEADER_RAW_SIZE,
+                              &intLen) < HEADER_RAW_SIZE)
+        {
+            fprintf(stderr, "Error: Cannot load block '%s'\n", arrIDs_a[intI]);
+            intResult = -1;
+        }
+        else if (arrHeader[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION)
+        {
+            arrFlags[intI] |= 1;
+        }
+        else
+        {
+            read_fixed_string(arrHeader, RAW_OFF_PREV_ID, 36, strPrevID);
+            char (*objFound)[GUID_LEN] = (char (*)[GUID_LEN])bsearch(strPrevID, arrIDs_a,
+                                             (size_t)intCount_a, GUID_LEN, compare_ids);
+            if (objFound) { arrFlags[objFound - arrIDs_a] |= 2; }
+        }
+    }
+
+    for (intI = 0; intI < intCount_a && intResult >= 0; intI++)
+    {
+        if (!arrFlags[intI]) { memcpy(arrTips[intResult++], arrIDs_a[intI], GUID_LEN); }
+    }
+
+    if (arrFlags) { free(arrFlags); }
+    if (intResult < 0 && arrTips) { free(arrTips); arrTips = NULL; }
+
+    *arrTips_a = arrTips;
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult   = 0;
+    int intPatterns = 0;
+    int intThreads  = 0;
+    int intMax      = 0;
+    int blnList     = 0;
+    uint8_t *arrPat[GREP_MAX_PATTERNS];
+    int arrLen[GREP_MAX_PATTERNS];
+    int arrOwned[GREP_MAX_PATTERNS];
+
+    // Matches go to stdout, so keep the banner off it
+    fprintf(stderr, "ZTB Grep v20261019\n");
+    fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    // --- 1. Options ---
+    int intI;
+    for (intI = 3; intI < argc && intResult == 0; intI++)
+    {
+        int blnHasValue = (intI + 1 < argc);
+        if ((strcmp(argv[intI], "-e") == 0 || strcmp(argv[intI], "-x") == 0) && blnHasValue &&
+            intPatterns < GREP_MAX_PATTERNS)
+        {
+            if (argv[intI][1] == 'e')
+            {
+                arrPat[intPatterns]   = (uint8_t*)argv[intI + 1];
+                arrLen[intPatterns]   = (int)strlen(argv[intI + 1]);
+                arrOwned[intPatterns] = 0;
+            }
+            else
+            {
+                arrLen[intPatterns]   = parse_hex(argv[intI + 1], &arrPat[intPatterns]);
+                arrOwned[intPatterns] = (arrLen[intPatterns] > 0);
+            }
+            if (arrLen[intPatterns] <= 0)
+            {
+                fprintf(stderr, "Error: Bad pattern '%s'\n", argv[intI + 1]);
+                intResult = 2;
+            }
+            else
+            {
+                intPatterns++;
+            }
+            intI++;
+        }
+        else if (strcmp(argv[intI], "-m") == 0 && blnHasValue)
+        {
+            intMax = atoi(argv[++intI]);
+            if (intMax <= 0) { intResult = 2; }
+        }
+        else if (strcmp(argv[intI], "-j") == 0 && blnHasValue)
+        {
+            intThreads = atoi(argv[++intI]);
+            if (intThreads <= 0 || intThreads > MAX_WORKERS) { intResult = 2; }
+        }
+        else if (strcmp(argv[intI], "-l") == 0)
+        {
+            blnList = 1;
+        }
+        else
+        {
+            intResult = 2;
+        }
+    }
+
+    if (argc < 5 || intPatterns == 0 || intResult != 0)
+    {
+        fprintf(stderr, "Usage: %s <workdir> <tip_block_id | -all> (-e <text> | -x <hex>)... [-m <count>] [-j <threads>] [-l]\n", argv[0]);
+        fprintf(stderr, "  -all   Search every block in the workdir (default: the tip's chain)\n");
+        fprintf(stderr, "  -e     Text pattern; -x hex byte pattern (up to %d patterns)\n", GREP_MAX_PATTERNS);
+        fprintf(stderr, "  -m     Stop after <count> matching blocks\n");
+        fprintf(stderr, "  -j     Worker threads (default: one per CPU, max %d)\n", MAX_WORKERS);
+        fprintf(stderr, "  -l     List matching block IDs only\n");
+        intResult = 2;
+    }
+
+    GrepMatcher objMatcher;
+    memset(&objMatcher, 0, sizeof(objMatcher));
+    if (intResult == 0 && !matcher_build(&objMatcher, arrPat, arrLen, intPatterns))
+    {
+        intResult = 2;
+    }
+
+    // --- 2. Blocks to search, cut into runs ---
+    const char *strWorkDir_a = (argc >= 3) ? argv[1] : NULL;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    ZTBRun *arrPlan  = NULL;
+    GrepRun *arrRuns = NULL;
+    int intRuns      = 0;
+    int intCount     = 0;
+
+    if (intThreads == 0) { intThreads = cpu_count(); }
+    if (intThreads > MAX_WORKERS) { intThreads = MAX_WORKERS; }
+
+    if (intResult == 0)
+    {
+        char (*arrTips)[GUID_LEN] = NULL;
+        int intTips = 0;
+
+        if (strcmp(argv[2], "-all") == 0)
+        {
+            char (*arrAll)[GUID_LEN] = NULL;
+            int intAll = list_blocks(strWorkDir_a, &arrAll);
+            if (intAll < 0) { fprintf(stderr, "Error: Cannot list blocks in '%s'\n", strWorkDir_a); }
+            intTips = (intAll < 0) ? -1 : find_tips(strWorkDir_a, arrAll, intAll, &arrTips);
+            if (arrAll) { free(arrAll); }
+        }
+        else
+        {
+            arrTips = (char (*)[GUID_LEN])malloc(GUID_LEN);
+            intTips = arrTips ? 1 : -1;
+            if (arrTips) { snprintf(arrTips[0], GUID_LEN, "%s", argv[2]); }
+        }
+
+        intCount = (intTips < 0) ? -1 :
+                   plan_runs(strWorkDir_a, arrTips, intTips, intThreads, &arrIDs, &arrPlan, &intRuns);
+        if (intCount >= 0)
+        {
+            arrRuns = (GrepRun*)calloc((size_t)intRuns + 1, sizeof(GrepRun));
+            for (intI = 0; intI < intRuns && arrRuns; intI++) { arrRuns[intI].objRun = arrPlan[intI]; }
+        }
+        if (intCount < 0 || !arrRuns) { intResult = 2; }
+
+        if (arrTips) { free(arrTips); }
+    }
+
+    // --- 3. Search: intThreads workers including this one ---
+    if (intResult == 0)
+    {
+        GrepJob objJob;
+
+        memset(&objJob, 0, sizeof(objJob));
+        objJob.strWorkDir = strWorkDir_a;
+        objJob.objMatcher = &objMatcher;
+        objJob.arrIDs     = arrIDs;
+        objJob.arrRuns    = arrRuns;
+        objJob.intRuns    = intRuns;
+        objJob.intMax     = intMax;
+        objJob.blnList    = blnList;
+        mutex_init(&objJob.objLock);
+
+        if (intThreads > intRuns) { intThreads = intRuns > 0 ? intRuns : 1; }
+        int intWorkers = run_workers(intThreads, grep_worker, &objJob);
+
+        mutex_destroy(&objJob.objLock);
+        for (intI = 0; intI < intRuns; intI++)
+        {
+            if (arrRuns[intI].arrHits) { free(arrRuns[intI].arrHits); }
+        }
+
+        fprintf(stderr, "%s %d matching block(s), %d of %d block(s) searched, %d worker(s)\n",
+                objJob.blnError ? "-" : "+", objJob.intMatched, objJob.intSearched, intCount,
+                intWorkers);
+
+        intResult = objJob.blnError ? 2 : (objJob.intMatched > 0 ? 0 : 1);
+    }
+
+    matcher_free(&objMatcher);
+    for (intI = 0; intI < intPatterns; intI++)
+    {
+        if (arrOwned[intI]) { free(arrPat[intI]); }
+    }
+    if (arrIDs)  { free(arrIDs); }
+    if (arrPlan) { free(arrPlan); }
+    if (arrRuns) { free(arrRuns); }
+
+    return intResult;
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+// Cyborg ZTB Import v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Unpacks a ztbexport bundle into a workdir.
+//
+// Usage: ztbimport <workdir> <bundle|-> [-sync none|block|group[:count[:ms]]]
+//
+// The bundle is read as a stream ("-" = stdin), so it can be piped straight from
+// ztbexport on another node. Each block is written to <block_id>.ztb.tmp, its bundle
+// CRC32 checked, then decoded against its parent with a rolling ROM that is advanced
+// block to block (the same run reader as ztbverify -branches): its hash and prev_hash
+// must match. Only then is it renamed into place, under the -sync policy, so a block
+// is never visible before its parent or before it has been checked. The first block's
+// parent must already be in the workdir.
+//
+// Blocks the workdir already has are skipped if they are byte-identical (by CRC32) and
+// are an error otherwise, so a bundle can be imported twice or overlap a previous one.
+// A genesis entry is written only into a workdir without a genesis (and recorded in its
+// ztb.meta), and must match the existing one otherwise. The import stops at the first
+// bad block; the blocks before it stay imported. If the bundle names its chain, the
+// chains.idx tip is moved to the last block.
+
+#include "ztbcommon.h"
+
+typedef struct
+{
+    const char    *strWorkDir;
+    ZTBSync       *objSync;
+    ZTBRollingRom *objRom;                  // ROM for the block after objRom->strPrevID
+    int            blnPrevTrunc;
+    int            intImported;
+    int            intPresent;
+} ImportState;
+
+// --- Genesis entry: write it into an empty workdir, or check it matches ---
+static int import_genesis(ImportState *objState_a, FILE *fIn_a, const ZTBBundleEntry *objEntry_a)
+{
+    int intResult = 1;
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint32_t intCrc  = 0;
+    uint8_t *byGenesis = find_genesis(objState_a->strWorkDir);
+
+    if (objEntry_a->intLen != ROM_SIZE)
+    {
+        fprintf(stderr, "Error: Genesis '%s' is not %d bytes\n", objEntry_a->strID, ROM_SIZE);
+        intResult = 0;
+    }
+    else if (byGenesis)
+    {
+        intResult = bundle_read_block(fIn_a, objEntry_a->intLen, NULL, arrHeader, &intCrc);
+        if (intResult && intCrc != calculate_crc32(byGenesis, 0, ROM_SIZE))
+        {
+            fprintf(stderr, "Error: Workdir has a different genesis\n");
+            intResult = 0;
+        }
+        objState_a->intPresent++;
+    }
+    else
+    {
+        char strTmpPath[FILENAME_MAX + 4];
+        block_file_path(objState_a->strWorkDir, objEntry_a->strID, ".ztb.tmp", strTmpPath);
+        FILE *fTmp = block_file_dirs(objState_a->strWorkDir, -1, objEntry_a->strID) ?
+                     create_block_tmp(strTmpPath) : NULL;
+
+        intResult = fTmp && bundle_read_block(fIn_a, objEntry_a->intLen, fTmp, arrHeader, &intCrc);
+        if (fTmp && fclose(fTmp) != 0) { intResult = 0; }
+
+        // The ROM of every later block is built from the genesis, so it is made durable now
+        if (intResult)
+        {
+            intResult = publish_block(objState_a->strWorkDir, objEntry_a->strID, objState_a->objSync) &&
+                        sync_commit(objState_a->objSync, objState_a->strWorkDir);
+        }
+
+        // Record it as ztbcreate would, so find_genesis need not scan for it
+        ZTBWorkdirMeta objMeta;
+        workdir_meta_load(objState_a->strWorkDir, &objMeta);
+        if (intResult && !objMeta.strGenesis[0])
+        {
+            snprintf(objMeta.strGenesis, GUID_LEN, "%s", objEntry_a->strID);
+            intResult = workdir_meta_save(objState_a->strWorkDir, &objMeta);
+        }
+        if (!intResult) { remove(strTmpPath); }
+        objState_a->intImported++;
+    }
+
+    if (!intResult) { fprintf(stderr, "Error: Cannot import genesis '%s'\n", objEntry_a->strID); }
+    if (byGenesis) { free(byGenesis); }
+    return intResult;
+}
+
+// --- Rolling ROM for a block whose parent is strPrevID_a ---
+// Blocks are normally consecutive, so this only opens a ROM for the first block, after
+// skipped blocks, or if the bundle jumps to another parent.
+static int import_rom_for(ImportState *objState_a, const char *strPrevID_a)
+{
+    int intResult = 1;
+
+    if (objState_a->objRom && strcmp(objState_a->objRom->strPrevID, strPrevID_a) == 0)
+    {
+        return 1;
+    }
+
+    // A parent still in the group commit is not visible to rolling_rom_open yet
+    if (!sync_commit(objState_a->objSync, objState_a->strWorkDir))
+    {
+        intResult = 0;
+    }
+    else if (strcmp(strPrevID_a, NULL_GUID) != 0 && !block_exists(objState_a->strWorkDir, strPrevID_a))
+    {
+        fprintf(stderr, "Error: Parent block '%s' is missing\n", strPrevID_a);
+        intResult = 0;
+    }
+
+    if (objState_a->objRom)
+    {
+        rolling_rom_close(objState_a->objRom);
+        objState_a->objRom = NULL;
+    }
+
+    if (intResult)
+    {
+        uint8_t arrHeader[HEADER_RAW_SIZE];
+        uint64_t intLen = 0;
+        objState_a->blnPrevTrunc = (strcmp(strPrevID_a, NULL_GUID) != 0 &&
+                                    read_block_prefix(objState_a->strWorkDir, strPrevID_a, arrHeader,
+                                                      HEADER_RAW_SIZE, &intLen) == HEADER_RAW_SIZE &&
+                                    arrHeader[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION);
+
+        objState_a->objRom = rolling_rom_open(objState_a->strWorkDir, strPrevID_a);
+        if (!objState_a->objRom)
+        {
+            fprintf(stderr, "Error: Cannot build rolling ROM for '%s'\n", strPrevID_a);
+            intResult = 0;
+        }
+    }
+
+    return intResult;
+}
+
+// --- One block: stage it, check it against its parent, then publish it ---
+static int import_block(ImportState *objState_a, FILE *fIn_a, const ZTBBundleEntry *objEntry_a)
+{
+    int intResult = 1;
+    const char *strBlockID = objEntry_a->strID;
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint32_t intCrc = 0;
+    char strTmpPath[FILENAME_MAX + 4];
+
+    // --- 1. Already here: skip if identical ---
+    if (block_exists(objState_a->strWorkDir, strBlockID))
+    {
+        uint32_t intLocalCrc = 0;
+        intResult = bundle_read_block(fIn_a, objEntry_a->intLen, NULL, arrHeader, &intCrc);
+        if (!intResult)
+        {
+            fprintf(stderr, "Error: Bundle is damaged at block '%s'\n", strBlockID);
+        }
+        else if (!block_crc32(objState_a->strWorkDir, strBlockID, &intLocalCrc) || intLocalCrc != intCrc)
+        {
+            fprintf(stderr, "Error: Block '%s' already exists with different content\n", strBlockID);
+            intResult = 0;
+        }
+        else
+        {
+            printf("  %s [PRESENT]\n", strBlockID);
+            objState_a->intPresent++;
+        }
+
+        // The next block's ROM is rebuilt from the workdir
+        if (objState_a->objRom)
+        {
+            rolling_rom_close(objState_a->objRom);
+            objState_a->objRom = NULL;
+        }
+        return intResult;
+    }
+
+    // --- 2. Stage it as <block_id>.ztb.tmp ---
+    block_file_path(objState_a->strWorkDir, strBlockID, ".ztb.tmp", strTmpPath);
+    FILE *fTmp = block_file_dirs(objState_a->strWorkDir, -1, strBlockID) ?
+                 create_block_tmp(strTmpPath) : NULL;
+    if (!fTmp)
+    {
+        fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+        intResult = 0;
+    }
+    else
+    {
+        intResult = bundle_read_block(fIn_a, objEntry_a->intLen, fTmp, arrHeader, &intCrc);
+        if (fclose(fTmp) != 0) { intResult = 0; }
+        if (!intResult) { fprintf(stderr, "Error: Bundle is damaged at block '%s'\n", strBlockID); }
+    }
+
+    // --- 3. Check it against its parent ---
+    char strHeaderID[GUID_LEN];
+    char strPrevID[GUID_LEN];
+    read_fixed_string(arrHeader, RAW_OFF_BLOCK_ID, 36, strHeaderID);
+    read_fixed_string(arrHeader, RAW_OFF_PREV_ID,  36, strPrevID);
+
+    if (intResult && strcmp(strHeaderID, strBlockID) != 0)
+    {
+        fprintf(stderr, "Error: Bundle entry '%s' holds block '%s'\n", strBlockID, strHeaderID);
+        intResult = 0;
+    }
+    else if (intResult && arrHeader[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION)
+    {
+        fprintf(stderr, "Error: Cannot import truncation block '%s'\n", strBlockID);
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        intResult = import_rom_for(objState_a, strPrevID);
+    }
+
+    if (intResult)
+    {
+        int blnIntact = 0;
+        if (!read_run_file(strTmpPath, objState_a->objRom, strBlockID, objState_a->blnPrevTrunc,
+                           NULL, NULL, &blnIntact) || !blnIntact)
+        {
+            fprintf(stderr, "Error: Block '%s' failed its check against '%s'\n", strBlockID, strPrevID);
+            intResult = 0;
+        }
+        objState_a->blnPrevTrunc = 0;
+    }
+
+    // --- 4. Make it visible ---
+    if (intResult)
+    {
+        intResult = publish_block(objState_a->strWorkDir, strBlockID, objState_a->objSync);
+    }
+
+    if (intResult)
+    {
+        printf("  %s [OK]\n", strBlockID);
+        objState_a->intImported++;
+    }
+    else
+    {
+        remove(strTmpPath);
+    }
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+
+    printf("ZTB Import v20261019\n");
+    printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    ZTBSync objSync;
+    sync_init(&objSync);
+    if (!sync_take_option(&objSync, &argc, argv))
+    {
+        intResult = 1;
+    }
+    else if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <workdir> <bundle|->\n", argv[0]);
+        fprintf(stderr, "       (optionally followed by -sync none|block|group[:count[:ms]])\n");
+        intResult = 1;
+    }
+
+    FILE *fIn = NULL;
+    ZTBBundleEntry *arrEntries = NULL;
+    int intCount = 0;
+    char strChainID[GUID_LEN];
+
+    // --- 1. Open the bundle and read its index ---
+    if (intResult == 0)
+    {
+        if (strcmp(argv[2], "-") == 0)
+        {
+#ifdef _WIN32
+            _setmode(_fileno(stdin), _O_BINARY);
+#endif
+            fIn = stdin;
+        }
+        else
+        {
+            fIn = fopen(argv[2], "rb");
+            if (!fIn) { fprintf(stderr, "Error: Cannot open: %s\n", argv[2]); }
+        }
+
+        if (!fIn || !bundle_read_header(fIn, strChainID, &arrEntries, &intCount))
+        {
+            intResult = 1;
+        }
+    }
+
+    // --- 2. Import the blocks in order ---
+    if (intResult == 0)
+    {
+        const char *strWorkDir_a = argv[1];
+        const char *strTip       = NULL;
+        ImportState objState;
+        int intI;
+
+        memset(&objState, 0, sizeof(objState));
+        objState.strWorkDir = strWorkDir_a;
+        objState.objSync    = &objSync;
+
+        for (intI = 0; intI < intCount && intResult == 0; intI++)
+        {
+            int blnOK = (arrEntries[intI].intFlags & BUNDLE_FLAG_GENESIS) ?
+                        import_genesis(&objState, fIn, &arrEntries[intI]) :
+                        import_block(&objState, fIn, &arrEntries[intI]);
+            if (!blnOK) { intResult = 1; }
+            else if (!(arrEntries[intI].intFlags & BUNDLE_FLAG_GENESIS)) { strTip = arrEntries[intI].strID; }
+        }
+
+        // Blocks waiting for the group commit were all checked, so commit them either way
+        if (!sync_commit(&objSync, strWorkDir_a)) { intResult = 1; }
+        if (objState.objRom) { rolling_rom_close(objState.objRom); }
+
+        if (intResult == 0 && strChainID[0] && strTip)
+        {
+            chains_index_tip(strWorkDir_a, strChainID, strTip, &objSync);
+        }
+
+        printf("\n=== Import Summary ===\n");
+        printf("Chain:    %s\n", strChainID[0] ? strChainID : "(not named)");
+        printf("Blocks:   %d\n", intCount);
+        printf("Imported: %d\n", objState.intImported);
+        printf("Present:  %d\n", objState.intPresent);
+        if (strTip) { printf("Tip:      %s\n", strTip); }
+        printf(intResult == 0 ? "+++ IMPORT COMPLETE +++\n" : "--- IMPORT FAILED ---\n");
+    }
+
+    if (fIn && fIn != stdin) { fclose(fIn); }
+    if (arrEntries) { free(arrEntries); }
+    sync_free(&objSync);
+    return intResult;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+// Cyborg ZTB Migrate v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Converts a workdir between the flat and fanout block file layouts, in place.
+//
+// Usage: ztbmigrate <workdir> -fanout | -flat
+//
+// ztb.meta is first rewritten with the new layout and a "migrating" mark, then every
+// block file, ROM snapshot and Merkle leaves file (.mrk) is renamed into its new
+// place (creating or removing the shard directories), then the mark is cleared. While
+// the mark is set every tool finds a file in either layout and writes new ones in the
+// new layout, so an interrupted migration leaves a working workdir and is finished by
+// running it again. The genesis ID is recorded in ztb.meta on the way. No other tool
+// should be writing to the workdir while it runs.
+
+#include "ztbcommon.h"
+
+// --- Move one file of a block from the other layout into intLayout_a (if it is there) ---
+// Returns 1 if moved, 0 if there was nothing to move, -1 on failure.
+static int migrate_file(const char *strWorkDir_a, int intLayout_a, const char *strBlockID_a,
+                        const char *strExt_a)
+{
+    int intResult = 0;
+    char strFrom[FILENAME_MAX];
+    char strTo[FILENAME_MAX];
+    block_file_path_in(strWorkDir_a, intLayout_a == LAYOUT_FANOUT ? LAYOUT_FLAT : LAYOUT_FANOUT,
+                       strBlockID_a, strExt_a, strFrom);
+    block_file_path_in(strWorkDir_a, intLayout_a, strBlockID_a, strExt_a, strTo);
+
+    FILE *f = fopen(strFrom, "rb");
+    if (f)
+    {
+        fclose(f);
+        intResult = (block_file_dirs(strWorkDir_a, intLayout_a, strBlockID_a) &&
+                     rename_block_file(strFrom, strTo, 0)) ? 1 : -1;
+    }
+    return intResult;
+}
+
+// --- Remove a block's shard directories once empty (fails harmlessly while not) ---
+static void remove_shard_dirs(const char *strWorkDir_a, const char *strBlockID_a)
+{
+    char strDir[FILENAME_MAX];
+    snprintf(strDir, FILENAME_MAX, "%s/%.2s/%.2s", strWorkDir_a, strBlockID_a, strBlockID_a + 2);
+#ifdef _WIN32
+    RemoveDirectoryA(strDir);
+    snprintf(strDir, FILENAME_MAX, "%s/%.2s", strWorkDir_a, strBlockID_a);
+    RemoveDirectoryA(strDir);
+#else
+    rmdir(strDir);
+    snprintf(strDir, FILENAME_MAX, "%s/%.2s", strWorkDir_a, strBlockID_a);
+    rmdir(strDir);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    int intLayout = LAYOUT_FLAT;
+
+    printf("ZTB Migrate v20261019\n");
+    printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (argc == 3 && strcmp(argv[2], "-fanout") == 0)    { intLayout = LAYOUT_FANOUT; }
+    else if (argc != 3 || strcmp(argv[2], "-flat") != 0)
+    {
+        fprintf(stderr, "Usage: %s <workdir> -fanout | -flat\n", argv[0]);
+        intResult = 1;
+    }
+
+    ZTBWorkdirMeta objMeta;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    int intCount = 0;
+
+    // --- 1. Mark the workdir as migrating to the new layout ---
+    if (intResult == 0)
+    {
+        const char *strWorkDir_a = argv[1];
+        char strGenesisID[GUID_LEN];
+
+        workdir_meta_load(strWorkDir_a, &objMeta);
+        if (!objMeta.strGenesis[0] && find_genesis_id(strWorkDir_a, strGenesisID))
+        {
+            snprintf(objMeta.strGenesis, GUID_LEN, "%s", strGenesisID);
+        }
+
+        intCount = list_blocks(strWorkDir_a, &arrIDs);
+        if (intCount < 0)
+        {
+            fprintf(stderr, "Error: Cannot read workdir %s\n", strWorkDir_a);
+            intResult = 1;
+        }
+        else
+        {
+            objMeta.intLayout    = intLayout;
+            objMeta.blnMigrating = 1;
+            if (!workdir_meta_save(strWorkDir_a, &objMeta)) { intResult = 1; }
+        }
+    }
+
+    // --- 2. Move the genesis, every block, ROM snapshot and .mrk ---
+    if (intResult == 0)
+    {
+        const char *strWorkDir_a = argv[1];
+        int intMoved = 0;
+        int intI;
+
+        for (intI = -1; intI < intCount && intResult == 0; intI++)
+        {
+            const char *strBlockID = (intI < 0) ? objMeta.strGenesis : arrIDs[intI];
+            int intBlock = strBlockID[0] ? migrate_file(strWorkDir_a, intLayout, strBlockID, ".ztb") : 0;
+            int intSnap  = strBlockID[0] ? migrate_file(strWorkDir_a, intLayout, strBlockID, ROM_SNAPSHOT_EXT) : 0;
+            int intMrk   = strBlockID[0] ? migrate_file(strWorkDir_a, intLayout, strBlockID, MERKLE_EXT) : 0;
+
+            if (intBlock < 0 || intSnap < 0 || intMrk < 0)
+            {
+                fprintf(stderr, "Error: Cannot move block '%s'\n", strBlockID);
+                intResult = 1;
+            }
+            else
+            {
+                intMoved += intBlock + intSnap + intMrk;
+                if (intLayout == LAYOUT_FLAT && intBlock + intSnap + intMrk > 0) { remove_shard_dirs(strWorkDir_a, strBlockID); }
+            }
+        }
+
+        // --- 3. Done: clear the mark ---
+        if (intResult == 0)
+        {
+            objMeta.blnMigrating = 0;
+            if (!workdir_meta_save(strWorkDir_a, &objMeta)) { intResult = 1; }
+        }
+
+        printf("Layout:  %s\n", intLayout == LAYOUT_FANOUT ? "fanout" : "flat");
+        printf("Genesis: %s\n", objMeta.strGenesis[0] ? objMeta.strGenesis : "(none)");
+        printf("Blocks:  %d\n", intCount);
+        printf("Moved:   %d files\n", intMoved);
+        printf(intResult == 0 ? "+++ MIGRATION COMPLETE +++\n" :
+                                "--- MIGRATION INCOMPLETE (run it again) ---\n");
+    }
+
+    if (arrIDs) { free(arrIDs); }
+    return intResult;
+}
\ No newline at end of file
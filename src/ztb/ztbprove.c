@@ -0,0 +1,396 @@
+// Cyborg ZTB Prove v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Inclusion proofs for blocks under a Merkle checkpoint (ztbcheckpoint -merkle).
+//
+// Usage: ztbprove <workdir> <block_id> <checkpoint_id> [-o <proof_file>]
+//        ztbprove -check <proof_file> <workdir>
+//        ztbprove -check <proof_file> <block_file> <root>
+//
+// A Merkle checkpoint's payload ends with the SHA-256 root of an RFC 6962 tree over
+// every block below it, oldest first (see ztbcommon.h). The proof for one of those
+// blocks is its audit path: one sibling hash per level, at most 32 of them, however
+// long the chain. It is written as text, to stdout or <proof_file>:
+//   ZTBPROOF1
+//   checkpoint <checkpoint_id>
+//   block <block_id>
+//   index <position from 0 at the oldest block>
+//   leaves <blocks under the root>
+//   leaf <leaf hash>
+//   root <root>
+//   path <sibling hash>            (one line per level, lowest first)
+// Proving reads the checkpoint's own root and its .mrk leaves, hashing the chain
+// again only if those are gone; the chain's raw headers must be present to find the
+// block's position, and the blocks must still hash to the committed root.
+//
+// -check hashes the block file again and walks the path up to the root. Against a
+// workdir, the root is the one decoded from the checkpoint block there; with a block
+// file and a root (64 hex digits, e.g. published when the checkpoint was written) it
+// needs nothing else, so a block can be checked after the chain itself is gone.
+//
+// Exit status: 0 = proof written / proof holds, 1 = error or the proof fails.
+
+#include "ztbcommon.h"
+
+#define PROOF_MAGIC     "ZTBPROOF1"
+
+typedef struct
+{
+    char     strCheckpoint[GUID_LEN];
+    char     strBlock[GUID_LEN];
+    uint32_t intIndex;
+    uint32_t intLeaves;
+    uint8_t  arrLeaf[SHA256_LEN];
+    uint8_t  arrRoot[SHA256_LEN];
+    uint8_t  arrPath[MERKLE_MAX_PATH * SHA256_LEN];
+    int      intPathLen;
+} ZTBProof;
+
+// --- Write a proof as text ---
+static int proof_write(const ZTBProof *objProof_a, FILE *fOut_a)
+{
+    char strHex[SHA256_LEN * 2 + 1];
+    int intI;
+
+    fprintf(fOut_a, "%s\n", PROOF_MAGIC);
+    fprintf(fOut_a, "checkpoint %s\n", objProof_a->strCheckpoint);
+    fprintf(fOut_a, "block %s\n", objProof_a->strBlock);
+    fprintf(fOut_a, "index %u\n", (unsigned)objProof_a->intIndex);
+    fprintf(fOut_a, "leaves %u\n", (unsigned)objProof_a->intLeaves);
+    hex_encode(objProof_a->arrLeaf, SHA256_LEN, strHex);
+    fprintf(fOut_a, "leaf %s\n", strHex);
+    hex_encode(objProof_a->arrRoot, SHA256_LEN, strHex);
+    fprintf(fOut_a, "root %s\n", strHex);
+    for (intI = 0; intI < objProof_a->intPathLen; intI++)
+    {
+        hex_encode(objProof_a->arrPath + (size_t)intI * SHA256_LEN, SHA256_LEN, strHex);
+        fprintf(fOut_a, "path %s\n", strHex);
+    }
+
+    return !ferror(fOut_a);
+}
+
+// --- Read a proof back; every line in order, nothing else ---
+static int proof_read(const char *strPath_a, ZTBProof *objProof_a)
+{
+    int intResult = 1;
+    char strLine[256];
+    char strValue[256];
+    unsigned long intValue = 0;
+    int intLine = 0;
+
+    memset(objProof_a, 0, sizeof(ZTBProof));
+    FILE *f = fopen(strPath_a, "r");
+    if (!f)
+    {
+        fprintf(stderr, "Error: Cannot open %s\n", strPath_a);
+        intResult = 0;
+    }
+    else
+    {
+        while (intResult && fgets(strLine, sizeof(strLine), f))
+        {
+            size_t intLen = strlen(strLine);
+            while (intLen > 0 && (strLine[intLen - 1] == '\n' || strLine[intLen - 1] == '\r')) { strLine[--intLen] = '\0'; }
+
+            switch (intLine++)
+            {
+                case 0:  intResult = (strcmp(strLine, PROOF_MAGIC) == 0); break;
+                case 1:  intResult = (sscanf(strLine, "checkpoint %255s", strValue) == 1 && is_valid_guid(strValue));
+                         if (intResult) { snprintf(objProof_a->strCheckpoint, GUID_LEN, "%.36s", strValue); }
+                         break;
+                case 2:  intResult = (sscanf(strLine, "block %255s", strValue) == 1 && is_valid_guid(strValue));
+                         if (intResult) { snprintf(objProof_a->strBlock, GUID_LEN, "%.36s", strValue); }
+                         break;
+                case 3:  intResult = (sscanf(strLine, "index %lu", &intValue) == 1 && intValue <= UINT32_MAX);
+                         objProof_a->intIndex = (uint32_t)intValue;
+                         break;
+                case 4:  intResult = (sscanf(strLine, "leaves %lu", &intValue) == 1 && intValue <= UINT32_MAX);
+                         objProof_a->intLeaves = (uint32_t)intValue;
+                         break;
+                case 5:  intResult = (sscanf(strLine, "leaf %255s", strValue) == 1 &&
+                                      hex_decode(strValue, objProof_a->arrLeaf, SHA256_LEN));
+                         break;
+                case 6:  intResult = (sscanf(strLine, "root %255s", strValue) == 1 &&
+                                      hex_decode(strValue, objProof_a->arrRoot, SHA256_LEN));
+                         break;
+                default: intResult = (objProof_a->intPathLen < MERKLE_MAX_PATH &&
+                                      sscanf(strLine, "path %255s", strValue) == 1 &&
+                                      hex_decode(strValue, objProof_a->arrPath +
+                                                 (size_t)objProof_a->intPathLen * SHA256_LEN, SHA256_LEN));
+                         if (intResult) { objProof_a->intPathLen++; }
+                         break;
+            }
+        }
+        fclose(f);
+
+        if (!intResult || intLine < 7)
+        {
+            fprintf(stderr, "Error: Not a ZTB proof: %s (line %d)\n", strPath_a, intLine);
+            intResult = 0;
+        }
+    }
+
+    return intResult;
+}
+
+// --- Build the proof of strBlockID_a under checkpoint strCheckpointID_a ---
+static int prove(const char *strWorkDir_a, const char *strBlockID_a, const char *strCheckpointID_a,
+                 ZTBProof *objProof_a)
+{
+    int intResult = 1;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    uint8_t *arrLeaves = NULL;
+    uint8_t arrRoot[SHA256_LEN];
+    ZTBBlockHeader objHeader;
+    int intCount = 0;
+    int intI;
+
+    memset(objProof_a, 0, sizeof(ZTBProof));
+    snprintf(objProof_a->strCheckpoint, GUID_LEN, "%s", strCheckpointID_a);
+    snprintf(objProof_a->strBlock, GUID_LEN, "%s", strBlockID_a);
+
+    // --- 1. The committed root and the blocks below the checkpoint (headers only) ---
+    if (!merkle_checkpoint_root(strWorkDir_a, strCheckpointID_a, &objProof_a->intLeaves, objProof_a->arrRoot) ||
+        !block_header(strWorkDir_a, strCheckpointID_a, &objHeader) ||
+        (intCount = collect_chain(strWorkDir_a, objHeader.strPrevID, NULL, 0, &arrIDs)) < 0)
+    {
+        intResult = 0;
+    }
+    else if ((uint32_t)intCount != objProof_a->intLeaves)
+    {
+        fprintf(stderr, "Error: %d blocks below '%s' but its root covers %u\n",
+                intCount, strCheckpointID_a, (unsigned)objProof_a->intLeaves);
+        intResult = 0;
+    }
+
+    // --- 2. The block's position, oldest first ---
+    if (intResult)
+    {
+        for (intI = 0; intI < intCount && strcmp(arrIDs[intI], strBlockID_a) != 0; intI++) { }
+        if (intI == intCount)
+        {
+            fprintf(stderr, "Error: '%s' is not below checkpoint '%s'\n", strBlockID_a, strCheckpointID_a);
+            intResult = 0;
+        }
+        objProof_a->intIndex = (uint32_t)(intCount - 1 - intI);
+    }
+
+    // --- 3. The leaves: the checkpoint's .mrk, else hash the chain again ---
+    if (intResult && merkle_leaves_load(strWorkDir_a, strCheckpointID_a, &arrLeaves) != intCount)
+    {
+        if (arrLeaves) { free(arrLeaves); arrLeaves = NULL; }
+        fprintf(stderr, "Warning: No saved leaves for '%s'; hashing %d blocks\n", strCheckpointID_a, intCount);
+        intResult = (merkle_chain_leaves(strWorkDir_a, objHeader.strPrevID, NULL, &arrLeaves) == intCount);
+    }
+
+    // --- 4. They must still make the committed root, and the block its leaf ---
+    if (intResult)
+    {
+        merkle_root(arrLeaves, (uint32_t)intCount, arrRoot);
+        if (memcmp(arrRoot, objProof_a->arrRoot, SHA256_LEN) != 0)
+        {
+            fprintf(stderr, "Error: The blocks below '%s' no longer match its Merkle root\n", strCheckpointID_a);
+            intResult = 0;
+        }
+    }
+    if (intResult)
+    {
+        intResult = merkle_leaf(strWorkDir_a, strBlockID_a, objProof_a->arrLeaf);
+        if (intResult && memcmp(objProof_a->arrLeaf, arrLeaves + (size_t)objProof_a->intIndex * SHA256_LEN,
+                                SHA256_LEN) != 0)
+        {
+            fprintf(stderr, "Error: Block '%s' has changed since checkpoint '%s'\n", strBlockID_a, strCheckpointID_a);
+            intResult = 0;
+        }
+    }
+
+    // --- 5. The audit path ---
+    if (intResult)
+    {
+        objProof_a->intPathLen = merkle_path(arrLeaves, (uint32_t)intCount, objProof_a->intIndex,
+                                             objProof_a->arrPath);
+    }
+
+    if (arrIDs)    { free(arrIDs); }
+    if (arrLeaves) { free(arrLeaves); }
+    return intResult;
+}
+
+// --- Leaf hash of a block file on its own; its raw header must name strBlockID_a ---
+static int leaf_of_file(const char *strPath_a, const char *strBlockID_a, uint8_t *byLeaf_a)
+{
+    int intResult = 0;
+    uint8_t arrRaw[HEADER_RAW_SIZE];
+    FILE *f = fopen(strPath_a, "rb");
+
+    if (!f)
+    {
+        fprintf(stderr, "Error: Cannot open %s\n", strPath_a);
+    }
+    else
+    {
+        char strID[GUID_LEN];
+        strID[0] = '\0';
+        if (fread(arrRaw, 1, HEADER_RAW_SIZE, f) == HEADER_RAW_SIZE)
+        {
+            read_fixed_string(arrRaw, RAW_OFF_BLOCK_ID, 36, strID);
+        }
+
+        if (strcmp(strID, strBlockID_a) != 0)
+        {
+            fprintf(stderr, "Error: %s does not hold block '%s'\n", strPath_a, strBlockID_a);
+        }
+        else
+        {
+            rewind(f);
+            intResult = merkle_leaf_file(f, byLeaf_a);
+            if (!intResult) { fprintf(stderr, "Error: Cannot read %s\n", strPath_a); }
+        }
+        fclose(f);
+    }
+
+    return intResult;
+}
+
+// --- -check: the block hashes to the proof's leaf, and the path leads to the trusted root ---
+static int check(int argc, char *argv[])
+{
+    int intResult = 1;
+    ZTBProof objProof;
+    uint8_t arrLeaf[SHA256_LEN];
+    uint8_t arrRoot[SHA256_LEN];
+    uint32_t intLeaves = 0;
+
+    if (!proof_read(argv[2], &objProof)) { intResult = 0; }
+
+    if (intResult && argc == 4)
+    {
+        intResult = merkle_checkpoint_root(argv[3], objProof.strCheckpoint, &intLeaves, arrRoot) &&
+                    merkle_leaf(argv[3], objProof.strBlock, arrLeaf);
+        if (intResult && intLeaves != objProof.intLeaves)
+        {
+            fprintf(stderr, "Error: Checkpoint '%s' covers %u blocks, the proof %u\n",
+                    objProof.strCheckpoint, (unsigned)intLeaves, (unsigned)objProof.intLeaves);
+            intResult = 0;
+        }
+    }
+    else if (intResult)
+    {
+        intResult = leaf_of_file(argv[3], objProof.strBlock, arrLeaf);
+        if (!hex_decode(argv[4], arrRoot, SHA256_LEN))
+        {
+            fprintf(stderr, "Error: Root must be %d hex digits\n", SHA256_LEN * 2);
+            intResult = 0;
+        }
+    }
+
+    if (intResult && memcmp(arrRoot, objProof.arrRoot, SHA256_LEN) != 0)
+    {
+        fprintf(stderr, "Error: The proof is for another root\n");
+        intResult = 0;
+    }
+    if (intResult && memcmp(arrLeaf, objProof.arrLeaf, SHA256_LEN) != 0)
+    {
+        fprintf(stderr, "Error: Block '%s' does not match the proof\n", objProof.strBlock);
+        intResult = 0;
+    }
+    if (intResult && !merkle_verify(arrLeaf, objProof.intIndex, objProof.intLeaves,
+                                    objProof.arrPath, objProof.intPathLen, arrRoot))
+    {
+        fprintf(stderr, "Error: The path does not lead to the root\n");
+        intResult = 0;
+    }
+
+    if (intResult)
+    {
+        char strRoot[SHA256_LEN * 2 + 1];
+        hex_encode(arrRoot, SHA256_LEN, strRoot);
+        printf("OK: block %s is %u of %u under checkpoint %s\n", objProof.strBlock,
+               (unsigned)objProof.intIndex, (unsigned)objProof.intLeaves, objProof.strCheckpoint);
+        printf("Root: %s (%d hashes)\n", strRoot, objProof.intPathLen);
+    }
+    else
+    {
+        printf("FAILED: %s\n", argv[2]);
+    }
+
+    return intResult;
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult = 0;
+    int blnCheck  = (argc >= 2 && strcmp(argv[1], "-check") == 0);
+    int blnFile   = (argc == 6 && strcmp(argv[4], "-o") == 0);
+
+    fprintf(stderr, "ZTB Prove v20261019\n");
+    fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (blnCheck ? (argc != 4 && argc != 5) : (argc != 4 && !blnFile))
+    {
+        fprintf(stderr, "Usage: %s <workdir> <block_id> <checkpoint_id> [-o <proof_file>]\n", argv[0]);
+        fprintf(stderr, "       %s -check <proof_file> <workdir>\n", argv[0]);
+        fprintf(stderr, "       %s -check <proof_file> <block_file> <root>\n", argv[0]);
+        intResult = 1;
+    }
+    else if (blnCheck)
+    {
+        intResult = check(argc, argv) ? 0 : 1;
+    }
+    else
+    {
+        ZTBProof objProof;
+
+        // --- 1. Build the proof and check it before handing it out ---
+        if (!prove(argv[1], argv[2], argv[3], &objProof))
+        {
+            intResult = 1;
+        }
+        else if (!merkle_verify(objProof.arrLeaf, objProof.intIndex, objProof.intLeaves,
+                                objProof.arrPath, objProof.intPathLen, objProof.arrRoot))
+        {
+            fprintf(stderr, "Error: Proof does not verify\n");
+            intResult = 1;
+        }
+
+        // --- 2. Write it: stdout, or <proof_file> via <proof_file>.tmp ---
+        if (intResult == 0 && !blnFile)
+        {
+            intResult = proof_write(&objProof, stdout) ? 0 : 1;
+        }
+        else if (intResult == 0)
+        {
+            char strTmpPath[FILENAME_MAX + 4];
+            snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", argv[5]);
+            FILE *fOut = fopen(strTmpPath, "w");
+            if (!fOut)
+            {
+                fprintf(stderr, "Error: Cannot create: %s\n", strTmpPath);
+                intResult = 1;
+            }
+            else
+            {
+                if (!proof_write(&objProof, fOut)) { intResult = 1; }
+                if (fclose(fOut) != 0)             { intResult = 1; }
+                if (intResult == 0 && !rename_block_file(strTmpPath, argv[5], 0)) { intResult = 1; }
+                if (intResult != 0) { remove(strTmpPath); }
+            }
+
+            if (intResult == 0)
+            {
+                char strRoot[SHA256_LEN * 2 + 1];
+                hex_encode(objProof.arrRoot, SHA256_LEN, strRoot);
+                printf("Block:      %s (%u of %u)\n", objProof.strBlock,
+                       (unsigned)objProof.intIndex, (unsigned)objProof.intLeaves);
+                printf("Checkpoint: %s\n", objProof.strCheckpoint);
+                printf("Root:       %s\n", strRoot);
+                printf("Path:       %d hashes\n", objProof.intPathLen);
+                printf("Proof:      %s\n", argv[5]);
+            }
+        }
+    }
+
+    return intResult;
+}
\ No newline at end of file
@@ -0,0 +1,664 @@
+// Cyborg ZTB Python v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// CPython extension module "ztbpy" over libztb, for Python services that would
+// otherwise run the C tools as subprocesses or use ztb.py (which has its own 132-byte
+// header and is not compatible with the tools' blocks). Build: make -f ztb.mk python
+//
+//   import ztbpy
+//   with ztbpy.Chain("workdir") as objChain:
+//       r = objChain.append(b"payload", "MyChain", strTip)     # dict, r["block_id"] ...
+//       objChain.commit()
+//       data = objChain.fetch(r["block_id"])                   # bytes
+//       objChain.verify(r["block_id"])                         # blocks verified
+//
+// Chain(workdir)                      ztb_open; ZTBError if not a ZTB workdir
+//   .append(data, chain=None, prev=None, *, kind=BLOCK, trunk=None, block_id=None,
+//           snapshot=False, strict=False, compress=False, merkle=False) -> dict
+//   .commit()                         ztb_commit
+//   .set_sync(policy)                 "none", "block" or "group[:count[:ms]]"
+//   .tip(chain) -> str | None
+//   .info(block_id) -> dict           block_id, prev_id, trunk_id, type, is_branch, file_len
+//   .fetch(block_id) -> bytes
+//   .fetch_into(block_id, buffer) -> int   payload length; ValueError if it did not fit
+//   .iterate(tip, limit=0) -> list    info dicts, newest first
+//   .verify(tip, stop=None) -> int    blocks verified; VerifyError(msg, failed_id, verified)
+//   .close()                          commits pending blocks (also on with-exit / del)
+//
+// Payloads go through the buffer protocol: append reads bytes, bytearray, memoryview
+// or any contiguous buffer in place, and fetch_into decodes straight into a writable
+// one. Every libztb call runs with the GIL released, so encoding, decoding and hashing
+// in one thread do not hold up the others. A Chain has its own lock (a libztb handle
+// must not be used by two threads at once); use one Chain per thread to run in
+// parallel. libztb reports the reason for a failure on stderr, as for the tools.
+// ConflictError (append with strict=True) carries the chain's actual tip in args[1].
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+#include <string.h>
+#include "libztb.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    ZTBChain           *objChain;
+    PyThread_type_lock  objLock;
+} ZTBPyChain;
+
+typedef struct
+{
+    uint8_t *byData;
+    size_t   intLen;
+    size_t   intCap;
+    int      blnNoMem;
+} ZTBPyBuffer;
+
+typedef struct
+{
+    uint8_t *byOut;                         // fetch_into: the caller's buffer ...
+    size_t   intCap;
+    size_t   intLen;                        // ... and the payload's full length
+} ZTBPyInto;
+
+typedef struct
+{
+    ZTBBlockInfo *arrInfos;
+    size_t        intCount;
+    size_t        intCap;
+    size_t        intLimit;                 // 0 = no limit
+    int           blnNoMem;
+} ZTBPyInfos;
+
+static PyObject *objZTBError      = NULL;
+static PyObject *objConflictError = NULL;
+static PyObject *objVerifyError   = NULL;
+
+// --- Handle lock, taken with the GIL released; 0 (ValueError set) if closed ---
+static int chain_acquire(ZTBPyChain *objSelf_a)
+{
+    int intResult = 0;
+    if (!objSelf_a->objLock)
+    {
+        PyErr_SetString(PyExc_ValueError, "ZTB chain is not open");
+    }
+    else
+    {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(objSelf_a->objLock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+        if (objSelf_a->objChain) { intResult = 1; }
+        else
+        {
+            PyThread_release_lock(objSelf_a->objLock);
+            PyErr_SetString(PyExc_ValueError, "ZTB chain is closed");
+        }
+    }
+    return intResult;
+}
+
+static void chain_release(ZTBPyChain *objSelf_a)
+{
+    PyThread_release_lock(objSelf_a->objLock);
+}
+
+static PyObject* info_dict(const ZTBBlockInfo *objInfo_a)
+{
+    return Py_BuildValue("{s:s,s:s,s:s,s:i,s:O,s:K}",
+                         "block_id", objInfo_a->strBlockID,
+                         "prev_id", objInfo_a->strPrevID,
+                         "trunk_id", objInfo_a->strTrunkID,
+                         "type", objInfo_a->intBlockType,
+                         "is_branch", objInfo_a->blnIsBranch ? Py_True : Py_False,
+                         "file_len", (unsigned long long)objInfo_a->intFileLen);
+}
+
+// --- libztb callbacks (run without the GIL: PyMem_Raw* only) ---
+static int collect_payload(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    int intResult = 1;
+    ZTBPyBuffer *objBuf = (ZTBPyBuffer*)objCtx_a;
+
+    if (objBuf->intLen + intLen_a > objBuf->intCap)
+    {
+        size_t intCap = objBuf->intCap ? objBuf->intCap : 65536;
+        while (intCap < objBuf->intLen + intLen_a) { intCap *= 2; }
+        uint8_t *byNew = (uint8_t*)PyMem_RawRealloc(objBuf->byData, intCap);
+        if (!byNew)
+        {
+            objBuf->blnNoMem = 1;
+            intResult = 0;
+        }
+        else
+        {
+            objBuf->byData = byNew;
+            objBuf->intCap = intCap;
+        }
+    }
+    if (intResult)
+    {
+        memcpy(objBuf->byData + objBuf->intLen, byData_a, intLen_a);
+        objBuf->intLen += intLen_a;
+    }
+    return intResult;
+}
+
+static int into_payload(void *objCtx_a, const uint8_t *byData_a, size_t intLen_a)
+{
+    ZTBPyInto *objInto = (ZTBPyInto*)objCtx_a;
+    if (objInto->intLen + intLen_a <= objInto->intCap)
+    {
+        memcpy(objInto->byOut + objInto->intLen, byData_a, intLen_a);
+    }
+    objInto->intLen += intLen_a;
+    return 1;
+}
+
+static int collect_info(void *objCtx_a, const ZTBBlockInfo *objInfo_a)
+{
+    int intResult = 1;
+    ZTBPyInfos *objInfos = (ZTBPyInfos*)objCtx_a;
+
+    if (objInfos->intCount == objInfos->intCap)
+    {
+        size_t intCap = objInfos->intCap ? objInfos->intCap * 2 : 256;
+        ZTBBlockInfo *arrNew = (ZTBBlockInfo*)PyMem_RawRealloc(objInfos->arrInfos, intCap * sizeof(ZTBBlockInfo));
+        if (!arrNew)
+        {
+            objInfos->blnNoMem = 1;
+            intResult = 0;
+        }
+        else
+        {
+            objInfos->arrInfos = arrNew;
+            objInfos->intCap   = intCap;
+        }
+    }
+    if (intResult)
+    {
+        objInfos->arrInfos[objInfos->intCount++] = *objInfo_a;
+        intResult = (objInfos->intLimit == 0 || objInfos->intCount < objInfos->intLimit);
+    }
+    return intResult;
+}
+
+// --- Chain(workdir) ---
+static int chain_init(ZTBPyChain *objSelf_a, PyObject *objArgs_a, PyObject *objKwds_a)
+{
+    static char *arrKwds[] = { "workdir", NULL };
+    int intResult = 0;
+    PyObject *objPath = NULL;
+    ZTBChain *objChain = NULL;
+
+    if (objSelf_a->objChain)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "ZTB chain is already open");
+        intResult = -1;
+    }
+    else if (!PyArg_ParseTupleAndKeywords(objArgs_a, objKwds_a, "O&", arrKwds, PyUnicode_FSConverter, &objPath))
+    {
+        intResult = -1;
+    }
+    else
+    {
+        const char *strWorkDir = PyBytes_AS_STRING(objPath);
+        Py_BEGIN_ALLOW_THREADS
+        objChain = ztb_open(strWorkDir);
+        Py_END_ALLOW_THREADS
+        if (!objChain)
+        {
+            PyErr_Format(objZTBError, "not a ZTB workdir: %s", strWorkDir);
+            intResult = -1;
+        }
+        Py_DECREF(objPath);
+    }
+
+    if (intResult == 0)
+    {
+        if (!objSelf_a->objLock) { objSelf_a->objLock = PyThread_allocate_lock(); }
+        if (!objSelf_a->objLock)
+        {
+            Py_BEGIN_ALLOW_THREADS
+            ztb_close(objChain);
+            Py_END_ALLOW_THREADS
+            PyErr_NoMemory();
+            intResult = -1;
+        }
+        else
+        {
+            objSelf_a->objChain = objChain;
+        }
+    }
+
+    return intResult;
+}
+
+static void chain_dealloc(ZTBPyChain *objSelf_a)
+{
+    if (objSelf_a->objChain)
+    {
+        ZTBChain *objChain = objSelf_a->objChain;
+        objSelf_a->objChain = NULL;
+        Py_BEGIN_ALLOW_THREADS
+        ztb_close(objChain);
+        Py_END_ALLOW_THREADS
+    }
+    if (objSelf_a->objLock) { PyThread_free_lock(objSelf_a->objLock); }
+    Py_TYPE(objSelf_a)->tp_free((PyObject*)objSelf_a);
+}
+
+static PyObject* chain_close(ZTBPyChain *objSelf_a, PyObject *objUnused_a)
+{
+    (void)objUnused_a;
+    if (objSelf_a->objLock)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(objSelf_a->objLock, WAIT_LOCK);
+        if (objSelf_a->objChain)
+        {
+            ztb_close(objSelf_a->objChain);
+            objSelf_a->objChain = NULL;
+        }
+        PyThread_release_lock(objSelf_a->objLock);
+        Py_END_ALLOW_THREADS
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* chain_enter(ZTBPyChain *objSelf_a, PyObject *objUnused_a)
+{
+    (void)objUnused_a;
+    Py_INCREF(objSelf_a);
+    return (PyObject*)objSelf_a;
+}
+
+static PyObject* chain_exit(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    (void)objArgs_a;
+    return chain_close(objSelf_a, NULL);
+}
+
+// --- append(data, chain=None, prev=None, *, kind, trunk, block_id, snapshot, strict,
+//     compress, merkle) ---
+static PyObject* chain_append(ZTBPyChain *objSelf_a, PyObject *objArgs_a, PyObject *objKwds_a)
+{
+    static char *arrKwds[] = { "data", "chain", "prev", "kind", "trunk", "block_id",
+                               "snapshot", "strict", "compress", "merkle", NULL };
+    PyObject *objResult = NULL;
+    Py_buffer objData;
+    ZTBAppend objAppend;
+    ZTBAppendResult objAppended;
+    int intOk = 0;
+
+    memset(&objAppend, 0, sizeof(objAppend));
+    memset(&objAppended, 0, sizeof(objAppended));
+    if (!PyArg_ParseTupleAndKeywords(objArgs_a, objKwds_a, "y*|zz$izzpppp", arrKwds, &objData,
+                                     &objAppend.strChain, &objAppend.strPrevID, &objAppend.intKind,
+                                     &objAppend.strTrunk, &objAppend.strBlockID, &objAppend.blnSnapshot,
+                                     &objAppend.blnStrict, &objAppend.blnCompress, &objAppend.blnMerkle))
+    {
+        return NULL;
+    }
+
+    if (objAppend.intKind < ZTB_APPEND_BLOCK || objAppend.intKind > ZTB_APPEND_CHECKPOINT)
+    {
+        PyErr_SetString(PyExc_ValueError, "kind must be BLOCK, BRANCH or CHECKPOINT");
+    }
+    else if (chain_acquire(objSelf_a))
+    {
+        // The Py_buffer holds the object (and its memory) until released below
+        objAppend.byData     = (const uint8_t*)objData.buf;
+        objAppend.intDataLen = (uint64_t)objData.len;
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_append(objSelf_a->objChain, &objAppend, &objAppended);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+
+        if (intOk)
+        {
+            PyObject *objRoot = Py_None;
+            char strRoot[65];
+            int intI;
+            if (objAppended.intMerkleLeaves > 0)
+            {
+                for (intI = 0; intI < 32; intI++) { sprintf(strRoot + intI * 2, "%02x", objAppended.arrMerkleRoot[intI]); }
+                objRoot = PyUnicode_FromString(strRoot);
+            }
+            else
+            {
+                Py_INCREF(objRoot);
+            }
+            if (objRoot)
+            {
+                objResult = Py_BuildValue("{s:s,s:s,s:I,s:I,s:K,s:K,s:K,s:I,s:O,s:O,s:I,s:N}",
+                                          "block_id", objAppended.strBlockID,
+                                          "prev_id", objAppended.strPrevID,
+                                          "hash", (unsigned int)objAppended.intHash,
+                                          "prev_hash", (unsigned int)objAppended.intPrevHash,
+                                          "payload_len", (unsigned long long)objAppended.intPayloadLen,
+                                          "padded_len", (unsigned long long)objAppended.intPaddedLen,
+                                          "data_len", (unsigned long long)objAppended.intDataLen,
+                                          "file_crc", (unsigned int)objAppended.intFileCrc,
+                                          "snapshot", objAppended.blnSnapshot ? Py_True : Py_False,
+                                          "rebased", objAppended.blnRebased ? Py_True : Py_False,
+                                          "merkle_leaves", (unsigned int)objAppended.intMerkleLeaves,
+                                          "merkle_root", objRoot);
+            }
+        }
+        else if (objAppended.blnConflict)
+        {
+            PyObject *objErr = Py_BuildValue("(ss)", "prev is not the chain's tip", objAppended.strPrevID);
+            if (objErr)
+            {
+                PyErr_SetObject(objConflictError, objErr);
+                Py_DECREF(objErr);
+            }
+        }
+        else
+        {
+            PyErr_SetString(objZTBError, "append failed");
+        }
+    }
+
+    PyBuffer_Release(&objData);
+    return objResult;
+}
+
+static PyObject* chain_commit(ZTBPyChain *objSelf_a, PyObject *objUnused_a)
+{
+    PyObject *objResult = NULL;
+    int intOk = 0;
+    (void)objUnused_a;
+
+    if (chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_commit(objSelf_a->objChain);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+        if (intOk) { objResult = Py_None; Py_INCREF(objResult); }
+        else       { PyErr_SetString(objZTBError, "commit failed"); }
+    }
+    return objResult;
+}
+
+static PyObject* chain_set_sync(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    PyObject *objResult = NULL;
+    const char *strPolicy = NULL;
+    int intOk = 0;
+
+    if (PyArg_ParseTuple(objArgs_a, "s", &strPolicy) && chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_set_sync(objSelf_a->objChain, strPolicy);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+        if (intOk) { objResult = Py_None; Py_INCREF(objResult); }
+        else       { PyErr_Format(PyExc_ValueError, "bad sync policy: %s", strPolicy); }
+    }
+    return objResult;
+}
+
+static PyObject* chain_tip(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    PyObject *objResult = NULL;
+    const char *strChain = NULL;
+    char strTip[ZTB_ID_LEN];
+    int intOk = 0;
+
+    if (PyArg_ParseTuple(objArgs_a, "s", &strChain) && chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_tip(objSelf_a->objChain, strChain, strTip);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+        if (intOk) { objResult = PyUnicode_FromString(strTip); }
+        else       { objResult = Py_None; Py_INCREF(objResult); }
+    }
+    return objResult;
+}
+
+static PyObject* chain_info(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    PyObject *objResult = NULL;
+    const char *strBlockID = NULL;
+    ZTBBlockInfo objInfo;
+    int intOk = 0;
+
+    if (PyArg_ParseTuple(objArgs_a, "s", &strBlockID) && chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_block_info(objSelf_a->objChain, strBlockID, &objInfo);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+        if (intOk) { objResult = info_dict(&objInfo); }
+        else       { PyErr_Format(objZTBError, "cannot read block %s", strBlockID); }
+    }
+    return objResult;
+}
+
+// --- fetch(block_id) -> bytes: decoded into a raw buffer, one copy into the bytes ---
+static PyObject* chain_fetch(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    PyObject *objResult = NULL;
+    const char *strBlockID = NULL;
+    ZTBPyBuffer objBuf;
+    int intOk = 0;
+
+    memset(&objBuf, 0, sizeof(objBuf));
+    if (PyArg_ParseTuple(objArgs_a, "s", &strBlockID) && chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_fetch(objSelf_a->objChain, strBlockID, collect_payload, &objBuf, NULL);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+
+        if (objBuf.blnNoMem) { PyErr_NoMemory(); }
+        else if (!intOk)     { PyErr_Format(objZTBError, "fetch failed: %s", strBlockID); }
+        else                 { objResult = PyBytes_FromStringAndSize((const char*)objBuf.byData, (Py_ssize_t)objBuf.intLen); }
+    }
+    PyMem_RawFree(objBuf.byData);
+    return objResult;
+}
+
+// --- fetch_into(block_id, buffer) -> int: decoded straight into a writable buffer ---
+static PyObject* chain_fetch_into(ZTBPyChain *objSelf_a, PyObject *objArgs_a)
+{
+    PyObject *objResult = NULL;
+    const char *strBlockID = NULL;
+    Py_buffer objOut;
+    ZTBPyInto objInto;
+    int intOk = 0;
+
+    if (!PyArg_ParseTuple(objArgs_a, "sw*", &strBlockID, &objOut)) { return NULL; }
+
+    if (chain_acquire(objSelf_a))
+    {
+        objInto.byOut  = (uint8_t*)objOut.buf;
+        objInto.intCap = (size_t)objOut.len;
+        objInto.intLen = 0;
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_fetch(objSelf_a->objChain, strBlockID, into_payload, &objInto, NULL);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+
+        if (!intOk)
+        {
+            PyErr_Format(objZTBError, "fetch failed: %s", strBlockID);
+        }
+        else if (objInto.intLen > objInto.intCap)
+        {
+            PyErr_Format(PyExc_ValueError, "buffer too small: payload is %zu bytes", objInto.intLen);
+        }
+        else
+        {
+            objResult = PyLong_FromSize_t(objInto.intLen);
+        }
+    }
+
+    PyBuffer_Release(&objOut);
+    return objResult;
+}
+
+static PyObject* chain_iterate(ZTBPyChain *objSelf_a, PyObject *objArgs_a, PyObject *objKwds_a)
+{
+    static char *arrKwds[] = { "tip", "limit", NULL };
+    PyObject *objResult = NULL;
+    const char *strTip = NULL;
+    Py_ssize_t intLimit = 0;
+    ZTBPyInfos objInfos;
+    int intOk = 0;
+    size_t intI;
+
+    memset(&objInfos, 0, sizeof(objInfos));
+    if (PyArg_ParseTupleAndKeywords(objArgs_a, objKwds_a, "s|n", arrKwds, &strTip, &intLimit) &&
+        chain_acquire(objSelf_a))
+    {
+        objInfos.intLimit = intLimit > 0 ? (size_t)intLimit : 0;
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_iterate(objSelf_a->objChain, strTip, collect_info, &objInfos);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+
+        if (objInfos.blnNoMem) { PyErr_NoMemory(); }
+        else if (!intOk)       { PyErr_Format(objZTBError, "iterate failed: %s", strTip); }
+        else                   { objResult = PyList_New((Py_ssize_t)objInfos.intCount); }
+
+        for (intI = 0; objResult && intI < objInfos.intCount; intI++)
+        {
+            PyObject *objInfo = info_dict(&objInfos.arrInfos[intI]);
+            if (!objInfo) { Py_CLEAR(objResult); }
+            else          { PyList_SET_ITEM(objResult, (Py_ssize_t)intI, objInfo); }
+        }
+    }
+    PyMem_RawFree(objInfos.arrInfos);
+    return objResult;
+}
+
+static PyObject* chain_verify(ZTBPyChain *objSelf_a, PyObject *objArgs_a, PyObject *objKwds_a)
+{
+    static char *arrKwds[] = { "tip", "stop", NULL };
+    PyObject *objResult = NULL;
+    const char *strTip  = NULL;
+    const char *strStop = NULL;
+    ZTBVerifyResult objVerify;
+    int intOk = 0;
+
+    memset(&objVerify, 0, sizeof(objVerify));
+    if (PyArg_ParseTupleAndKeywords(objArgs_a, objKwds_a, "s|z", arrKwds, &strTip, &strStop) &&
+        chain_acquire(objSelf_a))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        intOk = ztb_verify(objSelf_a->objChain, strTip, strStop, &objVerify);
+        Py_END_ALLOW_THREADS
+        chain_release(objSelf_a);
+
+        if (intOk)
+        {
+            objResult = PyLong_FromLong(objVerify.intVerified);
+        }
+        else
+        {
+            PyObject *objErr = Py_BuildValue("(ssi)", "verify failed", objVerify.strFailedID,
+                                             objVerify.intVerified);
+            if (objErr)
+            {
+                PyErr_SetObject(objVerifyError, objErr);
+                Py_DECREF(objErr);
+            }
+        }
+    }
+    return objResult;
+}
+
+static PyMethodDef arrChainMethods[] =
+{
+    { "append",     (PyCFunction)(void(*)(void))chain_append, METH_VARARGS | METH_KEYWORDS,
+      "append(data, chain=None, prev=None, *, kind=BLOCK, trunk=None, block_id=None, snapshot=False, "
+      "strict=False, compress=False, merkle=False) -> dict" },
+    { "commit",     (PyCFunction)chain_commit,     METH_NOARGS,  "commit(): make appended blocks durable, record tips" },
+    { "set_sync",   (PyCFunction)chain_set_sync,   METH_VARARGS, "set_sync(policy): none, block or group[:count[:ms]]" },
+    { "tip",        (PyCFunction)chain_tip,        METH_VARARGS, "tip(chain) -> block ID or None" },
+    { "info",       (PyCFunction)chain_info,       METH_VARARGS, "info(block_id) -> dict of the block's header" },
+    { "fetch",      (PyCFunction)chain_fetch,      METH_VARARGS, "fetch(block_id) -> bytes" },
+    { "fetch_into", (PyCFunction)chain_fetch_into, METH_VARARGS, "fetch_into(block_id, buffer) -> payload length" },
+    { "iterate",    (PyCFunction)(void(*)(void))chain_iterate, METH_VARARGS | METH_KEYWORDS,
+      "iterate(tip, limit=0) -> list of info dicts, newest first" },
+    { "verify",     (PyCFunction)(void(*)(void))chain_verify, METH_VARARGS | METH_KEYWORDS,
+      "verify(tip, stop=None) -> blocks verified; VerifyError(msg, failed_id, verified)" },
+    { "close",      (PyCFunction)chain_close,      METH_NOARGS,  "close(): commit and release the handle" },
+    { "__enter__",  (PyCFunction)chain_enter,      METH_NOARGS,  NULL },
+    { "__exit__",   (PyCFunction)chain_exit,       METH_VARARGS, NULL },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject objChainType =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name      = "ztbpy.Chain",
+    .tp_basicsize = sizeof(ZTBPyChain),
+    .tp_flags     = Py_TPFLAGS_DEFAULT,
+    .tp_doc       = "Chain(workdir): an open ZTB workdir (libztb handle)",
+    .tp_new       = PyType_GenericNew,
+    .tp_init      = (initproc)chain_init,
+    .tp_dealloc   = (destructor)chain_dealloc,
+    .tp_methods   = arrChainMethods,
+};
+
+static PyObject* module_version(PyObject *objSelf_a, PyObject *objUnused_a)
+{
+    (void)objSelf_a;
+    (void)objUnused_a;
+    return PyUnicode_FromString(ztb_version());
+}
+
+static PyMethodDef arrModuleMethods[] =
+{
+    { "version", module_version, METH_NOARGS, "version() -> libztb version" },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef objModuleDef =
+{
+    PyModuleDef_HEAD_INIT, "ztbpy", "ZTB chains through libztb (see ztbpy.c)", -1, arrModuleMethods,
+    NULL, NULL, NULL, NULL
+};
+
+static int add_object(PyObject *objModule_a, const char *strName_a, PyObject *objValue_a)
+{
+    int intResult = 1;
+    Py_XINCREF(objValue_a);
+    if (!objValue_a || PyModule_AddObject(objModule_a, strName_a, objValue_a) < 0)
+    {
+        Py_XDECREF(objValue_a);
+        intResult = 0;
+    }
+    return intResult;
+}
+
+PyMODINIT_FUNC PyInit_ztbpy(void)
+{
+    PyObject *objModule = NULL;
+
+    if (PyType_Ready(&objChainType) == 0) { objModule = PyModule_Create(&objModuleDef); }
+    if (objModule)
+    {
+        if (!objZTBError)      { objZTBError      = PyErr_NewException("ztbpy.ZTBError", NULL, NULL); }
+        if (!objConflictError) { objConflictError = PyErr_NewException("ztbpy.ConflictError", objZTBError, NULL); }
+        if (!objVerifyError)   { objVerifyError   = PyErr_NewException("ztbpy.VerifyError", objZTBError, NULL); }
+
+        if (!add_object(objModule, "Chain", (PyObject*)&objChainType) ||
+            !add_object(objModule, "ZTBError", objZTBError) ||
+            !add_object(objModule, "ConflictError", objConflictError) ||
+            !add_object(objModule, "VerifyError", objVerifyError) ||
+            PyModule_AddIntConstant(objModule, "BLOCK", ZTB_APPEND_BLOCK) < 0 ||
+            PyModule_AddIntConstant(objModule, "BRANCH", ZTB_APPEND_BRANCH) < 0 ||
+            PyModule_AddIntConstant(objModule, "CHECKPOINT", ZTB_APPEND_CHECKPOINT) < 0)
+        {
+            Py_CLEAR(objModule);
+        }
+    }
+    return objModule;
+}
\ No newline at end of file
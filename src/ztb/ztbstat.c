@@ -0,0 +1,419 @@
+// Cyborg ZTB Stat v20261019
+// (c) 2026 Cyborg Unicorn Pty Ltd.
+// This software is released under MIT License.
+//
+// Chain statistics and a health report for a workdir, as JSON on stdout.
+//
+// Usage: ztbstat <workdir> [-j <threads>]
+//
+// Nothing is decoded: every block contributes its 111-byte raw header and its file
+// size, read by a pool of -j workers (default one per CPU), and chains.idx supplies
+// the chains, their tips and which are branches. The chain walks then run over the
+// headers in memory, so a million-block workdir costs one small read per block.
+//
+// The report holds:
+//   blocks, bytes        every block file but genesis (genesis_bytes is separate)
+//   types                blocks of each type; branch_blocks have is_branch set
+//   overhead             how the bytes of the encoded blocks split up (see below)
+//   size_histogram       block files by size, in powers of two from 1 KB
+//   chains               per chain: length, bytes, trunk, checkpoint positions and
+//                        where the walk back ended ("genesis", "truncation" with its
+//                        position, or "missing" with the block that was not there);
+//                        positions count from 1 at the oldest block still present
+//   health               unreadable headers, blocks whose prev is missing, blocks
+//                        no recorded tip reaches (ztbarchive -severed lists them),
+//                        chains whose tip is missing
+// payload_len is in the encoded header, which only the ROM decodes, so the overhead
+// is taken from file sizes. An encoded block is the raw header and the encoded header
+// (header_bytes) plus the padded payload (payload_bytes) stored as 2-byte ROM
+// addresses, the second byte of each being encoding_bytes. A payload short enough to
+// leave the block under ROM_ENTRY_SIZE is padded up to SMALL_PADDED_LEN bytes;
+// small_blocks counts those, and padding_bytes_max is the most padding they can hold.
+//
+// Exit status: 0 = report written (whatever it says), 1 = error.
+
+#include "ztbcommon.h"
+
+#define SMALL_PADDED_LEN    ((ROM_ENTRY_SIZE - HEADER_RAW_SIZE) / 2 - ENC_HEADER_SIZE + 1)
+#define HIST_MIN_SHIFT      10              // first bucket: up to 1 KB
+#define HIST_BUCKETS        40
+#define STAT_CHUNK          1024            // blocks a worker takes at a time
+
+#define PREV_NONE           -1              // prev_block_id is NULL_GUID
+#define PREV_MISSING        -2              // prev_block_id is not in the workdir
+
+typedef struct
+{
+    uint64_t intFileLen;
+    int      intPrev;                       // index into arrIDs, PREV_NONE or PREV_MISSING
+    uint8_t  byType;
+    uint8_t  blnBranch;
+    uint8_t  blnRead;                       // raw header read
+    uint8_t  blnReached;                    // on the walk back from some chain's tip
+} StatBlock;
+
+typedef struct
+{
+    const char  *strWorkDir;
+    char       (*arrIDs)[GUID_LEN];
+    StatBlock   *arrBlocks;
+    int          intCount;
+    int          intNext;
+    ZTBMutex     objLock;
+} StatJob;
+
+// --- Index of a block ID in the sorted list, or -1 ---
+static int find_block(const StatJob *objJob_a, const char *strBlockID_a)
+{
+    char (*objFound)[GUID_LEN] = (char (*)[GUID_LEN])bsearch(strBlockID_a, objJob_a->arrIDs,
+                                                              (size_t)objJob_a->intCount, GUID_LEN,
+                                                              compare_ids);
+    return objFound ? (int)(objFound - objJob_a->arrIDs) : -1;
+}
+
+// --- Raw header and file size of one block; payloads are never opened ---
+static void stat_block(StatJob *objJob_a, int intIndex_a)
+{
+    StatBlock *objBlock = &objJob_a->arrBlocks[intIndex_a];
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    char strPath[FILENAME_MAX];
+    char strPrevID[GUID_LEN];
+
+    block_file_path(objJob_a->strWorkDir, objJob_a->arrIDs[intIndex_a], ".ztb", strPath);
+    FILE *f = fopen(strPath, "rb");
+    if (f)
+    {
+        objBlock->blnRead = (fread(arrHeader, 1, HEADER_RAW_SIZE, f) == HEADER_RAW_SIZE &&
+                             ZTB_FSEEK(f, 0, SEEK_END) == 0);
+        if (objBlock->blnRead) { objBlock->intFileLen = (uint64_t)ZTB_FTELL(f); }
+        fclose(f);
+    }
+
+    if (objBlock->blnRead)
+    {
+        objBlock->byType    = arrHeader[RAW_OFF_BLOCK_TYPE];
+        objBlock->blnBranch = (arrHeader[RAW_OFF_IS_BRANCH] != 0);
+        read_fixed_string(arrHeader, RAW_OFF_PREV_ID, 36, strPrevID);
+        if (strcmp(strPrevID, NULL_GUID) == 0) { objBlock->intPrev = PREV_NONE; }
+        else
+        {
+            objBlock->intPrev = find_block(objJob_a, strPrevID);
+            if (objBlock->intPrev < 0) { objBlock->intPrev = PREV_MISSING; }
+        }
+    }
+    else
+    {
+        objBlock->intPrev = PREV_MISSING;
+    }
+}
+
+static void stat_worker(void *objArg_a)
+{
+    StatJob *objJob = (StatJob*)objArg_a;
+
+    for (;;)
+    {
+        int intFrom;
+        int intI;
+
+        mutex_lock(&objJob->objLock);
+        intFrom = objJob->intNext;
+        objJob->intNext += STAT_CHUNK;
+        mutex_unlock(&objJob->objLock);
+
+        if (intFrom >= objJob->intCount) { break; }
+        for (intI = intFrom; intI < intFrom + STAT_CHUNK && intI < objJob->intCount; intI++)
+        {
+            stat_block(objJob, intI);
+        }
+    }
+}
+
+// --- A JSON string (chain names are free text) ---
+static void json_string(const char *strValue_a)
+{
+    const unsigned char *byC;
+    putchar('"');
+    for (byC = (const unsigned char*)strValue_a; *byC; byC++)
+    {
+        if (*byC == '"' || *byC == '\\') { printf("\\%c", *byC); }
+        else if (*byC < 0x20)            { printf("\\u%04x", *byC); }
+        else                             { putchar(*byC); }
+    }
+    putchar('"');
+}
+
+// --- Walk one chain back from its tip and write its JSON object ---
+static void report_chain(StatJob *objJob_a, const ZTBChainEntry *objChain_a, int *intMissingTips_a)
+{
+    const char *strTip = objChain_a->strTip[0] ? objChain_a->strTip : objChain_a->strFirst;
+    int intAt          = strTip[0] ? find_block(objJob_a, strTip) : -1;
+    int *arrCheckpoints = NULL;
+    int intCheckpoints = 0;
+    int intCap         = 0;
+    int intLength      = 0;
+    int intTruncDepth  = -1;
+    int intLast        = -1;
+    uint64_t intBytes  = 0;
+    int intI;
+
+    // --- 1. Walk back, noting checkpoints by depth below the tip ---
+    while (intAt >= 0 && intLength < objJob_a->intCount)
+    {
+        StatBlock *objBlock = &objJob_a->arrBlocks[intAt];
+        if (!objBlock->blnRead) { break; }
+
+        objBlock->blnReached = 1;
+        intBytes += objBlock->intFileLen;
+        if (objBlock->byType == BLOCK_TYPE_CHECKPOINT)
+        {
+            if (intCheckpoints == intCap)
+            {
+                intCap = intCap ? intCap * 2 : 16;
+                int *arrNew = (int*)realloc(arrCheckpoints, (size_t)intCap * sizeof(int));
+                if (!arrNew) { break; }
+                arrCheckpoints = arrNew;
+            }
+            arrCheckpoints[intCheckpoints++] = intLength;
+        }
+        if (objBlock->byType == BLOCK_TYPE_TRUNCATION) { intTruncDepth = intLength; }
+
+        intLength++;
+        intLast = intAt;
+        intAt   = objBlock->intPrev;
+    }
+
+    // --- 2. Positions count up from the oldest block present ---
+    printf("    {\"name\": ");
+    json_string(objChain_a->strName);
+    printf(", \"tip\": ");
+    if (strTip[0]) { json_string(strTip); } else { printf("null"); }
+    printf(", \"trunk\": ");
+    if (objChain_a->strTrunk[0]) { json_string(objChain_a->strTrunk); } else { printf("null"); }
+    printf(", \"length\": %d, \"bytes\": %llu,\n     \"checkpoints\": [", intLength, (unsigned long long)intBytes);
+    for (intI = intCheckpoints - 1; intI >= 0; intI--)
+    {
+        printf("%s%d", intI == intCheckpoints - 1 ? "" : ", ", intLength - arrCheckpoints[intI]);
+    }
+    printf("],\n     \"start\": ");
+
+    if (intLength == 0)
+    {
+        printf("{\"kind\": \"missing\", \"block\": ");
+        if (strTip[0]) { json_string(strTip); } else { printf("null"); }
+        printf("}}");
+        (*intMissingTips_a)++;
+    }
+    else if (intTruncDepth >= 0)
+    {
+        printf("{\"kind\": \"truncation\", \"position\": %d}}", intLength - intTruncDepth);
+    }
+    else if (intAt == PREV_NONE)
+    {
+        printf("{\"kind\": \"genesis\"}}");
+    }
+    else
+    {
+        // The walk stopped at a prev that is not here (or could not be read)
+        printf("{\"kind\": \"missing\", \"below\": ");
+        json_string(objJob_a->arrIDs[intLast]);
+        printf("}}");
+    }
+
+    if (arrCheckpoints) { free(arrCheckpoints); }
+}
+
+int main(int argc, char *argv[])
+{
+    int intResult  = 0;
+    int intThreads = 0;
+
+    fprintf(stderr, "ZTB Stat v20261019\n");
+    fprintf(stderr, "(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
+
+    if (argc == 4 && strcmp(argv[2], "-j") == 0)
+    {
+        intThreads = atoi(argv[3]);
+        if (intThreads <= 0 || intThreads > MAX_WORKERS) { intResult = 1; }
+    }
+    if (intResult || (argc != 2 && argc != 4))
+    {
+        fprintf(stderr, "Usage: %s <workdir> [-j <threads>]\n", argv[0]);
+        fprintf(stderr, "  -j     Worker threads (default: one per CPU, max %d)\n", MAX_WORKERS);
+        intResult = 1;
+    }
+    if (intThreads == 0) { intThreads = cpu_count(); }
+    if (intThreads > MAX_WORKERS) { intThreads = MAX_WORKERS; }
+
+    StatJob objJob;
+    ZTBChainIndex objIndex;
+    ZTBWorkdirMeta objMeta;
+    int blnIndex = 0;
+
+    memset(&objJob, 0, sizeof(objJob));
+    memset(&objIndex, 0, sizeof(objIndex));
+
+    // --- 1. Every block's raw header and size, in parallel ---
+    if (intResult == 0)
+    {
+        objJob.strWorkDir = argv[1];
+        objJob.intCount   = list_blocks(argv[1], &objJob.arrIDs);
+        if (objJob.intCount < 0)
+        {
+            fprintf(stderr, "Error: Cannot read workdir %s\n", argv[1]);
+            intResult = 1;
+        }
+        else
+        {
+            objJob.arrBlocks = (StatBlock*)calloc((size_t)objJob.intCount + 1, sizeof(StatBlock));
+            if (!objJob.arrBlocks)
+            {
+                fprintf(stderr, "Error: Cannot allocate block table\n");
+                intResult = 1;
+            }
+        }
+    }
+
+    if (intResult == 0)
+    {
+        mutex_init(&objJob.objLock);
+        run_workers(intThreads, stat_worker, &objJob);
+        mutex_destroy(&objJob.objLock);
+
+        workdir_meta_load(argv[1], &objMeta);
+        blnIndex = chains_index_load(argv[1], &objIndex);
+    }
+
+    // --- 2. Totals, overhead and the size histogram ---
+    if (intResult == 0)
+    {
+        static const char *arrTypeNames[] = { "genesis", "normal", "checkpoint", "truncation", "finalise", "bridge" };
+        uint64_t arrTypes[6];
+        uint64_t arrHist[HIST_BUCKETS];
+        uint64_t intBytes        = 0;
+        uint64_t intBranchBlocks = 0;
+        uint64_t intUnreadable   = 0;
+        uint64_t intDangling     = 0;
+        uint64_t intEncoded      = 0;
+        uint64_t intPayload      = 0;
+        uint64_t intSmall        = 0;
+        uint64_t intOtherTypes   = 0;
+        uint64_t intGenesisBytes = 0;
+        char strGenesisID[GUID_LEN];
+        int intTopBucket = 0;
+        int intI;
+
+        memset(arrTypes, 0, sizeof(arrTypes));
+        memset(arrHist, 0, sizeof(arrHist));
+
+        for (intI = 0; intI < objJob.intCount; intI++)
+        {
+            const StatBlock *objBlock = &objJob.arrBlocks[intI];
+            int intBucket = 0;
+
+            if (!objBlock->blnRead) { intUnreadable++; continue; }
+
+            intBytes += objBlock->intFileLen;
+            if (objBlock->byType < 6) { arrTypes[objBlock->byType]++; }
+            else                      { intOtherTypes++; }
+            if (objBlock->blnBranch)  { intBranchBlocks++; }
+            if (objBlock->intPrev == PREV_MISSING) { intDangling++; }
+
+            if (objBlock->byType != BLOCK_TYPE_TRUNCATION &&
+                objBlock->intFileLen >= HEADER_RAW_SIZE + 2 * ENC_HEADER_SIZE)
+            {
+                uint64_t intPadded = (objBlock->intFileLen - HEADER_RAW_SIZE) / 2 - ENC_HEADER_SIZE;
+                intEncoded++;
+                intPayload += intPadded;
+                if (intPadded == SMALL_PADDED_LEN) { intSmall++; }
+            }
+
+            while (intBucket < HIST_BUCKETS - 1 &&
+                   objBlock->intFileLen > ((uint64_t)1 << (HIST_MIN_SHIFT + intBucket)))
+            {
+                intBucket++;
+            }
+            arrHist[intBucket]++;
+            if (intBucket > intTopBucket) { intTopBucket = intBucket; }
+        }
+
+        if (find_genesis_id(argv[1], strGenesisID))
+        {
+            char strPath[FILENAME_MAX];
+            block_file_path(argv[1], strGenesisID, ".ztb", strPath);
+            FILE *f = fopen(strPath, "rb");
+            if (f)
+            {
+                if (ZTB_FSEEK(f, 0, SEEK_END) == 0) { intGenesisBytes = (uint64_t)ZTB_FTELL(f); }
+                fclose(f);
+            }
+        }
+        else
+        {
+            strGenesisID[0] = '\0';
+        }
+
+        printf("{\n  \"workdir\": ");
+        json_string(argv[1]);
+        printf(",\n  \"layout\": \"%s\",\n  \"genesis\": ", objMeta.intLayout == LAYOUT_FANOUT ? "fanout" : "flat");
+        if (strGenesisID[0]) { json_string(strGenesisID); } else { printf("null"); }
+        printf(",\n  \"genesis_bytes\": %llu,\n", (unsigned long long)intGenesisBytes);
+        printf("  \"blocks\": %d,\n  \"bytes\": %llu,\n", objJob.intCount, (unsigned long long)intBytes);
+
+        printf("  \"types\": {");
+        for (intI = BLOCK_TYPE_NORMAL; intI < 6; intI++)
+        {
+            printf("\"%s\": %llu, ", arrTypeNames[intI], (unsigned long long)arrTypes[intI]);
+        }
+        printf("\"other\": %llu},\n", (unsigned long long)intOtherTypes);
+        printf("  \"branch_blocks\": %llu,\n", (unsigned long long)intBranchBlocks);
+
+        printf("  \"overhead\": {\"encoded_blocks\": %llu, \"header_bytes\": %llu, \"payload_bytes\": %llu,\n",
+               (unsigned long long)intEncoded,
+               (unsigned long long)(intEncoded * (HEADER_RAW_SIZE + 2 * ENC_HEADER_SIZE)),
+               (unsigned long long)intPayload);
+        printf("               \"encoding_bytes\": %llu, \"small_blocks\": %llu, \"padding_bytes_max\": %llu,\n",
+               (unsigned long long)intPayload, (unsigned long long)intSmall,
+               (unsigned long long)(intSmall * SMALL_PADDED_LEN));
+        printf("               \"truncation_rom_bytes\": %llu},\n",
+               (unsigned long long)(arrTypes[BLOCK_TYPE_TRUNCATION] * ROM_SIZE));
+
+        printf("  \"size_histogram\": [");
+        for (intI = 0; intI <= intTopBucket && objJob.intCount > 0; intI++)
+        {
+            printf("%s{\"max_bytes\": %llu, \"blocks\": %llu}", intI ? ", " : "",
+                   (unsigned long long)1 << (HIST_MIN_SHIFT + intI), (unsigned long long)arrHist[intI]);
+        }
+        printf("],\n");
+
+        // --- 3. Chains from chains.idx, walked over the headers in memory ---
+        int intBranches    = 0;
+        int intMissingTips = 0;
+        uint64_t intUnreached = 0;
+
+        printf("  \"chains\": [\n");
+        for (intI = 0; blnIndex && intI < objIndex.intCount; intI++)
+        {
+            if (objIndex.arrChains[intI].strTrunk[0]) { intBranches++; }
+            report_chain(&objJob, &objIndex.arrChains[intI], &intMissingTips);
+            printf(intI + 1 < objIndex.intCount ? ",\n" : "\n");
+        }
+        printf("  ],\n  \"branches\": %d,\n", intBranches);
+
+        for (intI = 0; intI < objJob.intCount; intI++)
+        {
+            if (objJob.arrBlocks[intI].blnRead && !objJob.arrBlocks[intI].blnReached) { intUnreached++; }
+        }
+
+        printf("  \"health\": {\"unreadable\": %llu, \"missing_prev\": %llu, \"unreached\": %llu, \"missing_tips\": %d}\n}\n",
+               (unsigned long long)intUnreadable, (unsigned long long)intDangling,
+               (unsigned long long)intUnreached, intMissingTips);
+
+        if (fflush(stdout) != 0) { intResult = 1; }
+    }
+
+    if (blnIndex)         { chains_index_free(&objIndex); }
+    if (objJob.arrBlocks) { free(objJob.arrBlocks); }
+    if (objJob.arrIDs)    { free(objJob.arrIDs); }
+    return intResult;
+}
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Cyborg ZTB Truncate v20260618
+// Cyborg ZTB Truncate v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
@@ -13,16 +13,73 @@
 //      trunk_id=NULL_GUID, block_id=block10ID, prev_block_id=NULL_GUID
 //   5. Output = raw header (111 bytes) + raw rolling ROM (65536 bytes), NOT ZOSCII encoded
 //   6. This OVERWRITES block10's own file (<block10ID>.ztb), severing the chain there.
+//   7. Every ROM snapshot (<checkpointID>.rom) whose 64-block window reaches block10 is
+//      rebuilt: the ROM as of that checkpoint now fills from the truncation payload.
+//      That is the nominated checkpoint's and any other checkpoint up to 63 blocks
+//      above block10, on the chain or a branch forked there. Their block CRCs do not
+//      change, so left alone they would still pass as valid. block10's own snapshot,
+//      if it was a checkpoint, is removed.
 //
 // Usage: ztbtruncate <workdir> <checkpoint_block_id>
 
-#include "ztbcommon.c"
+#include "ztbcommon.h"
+
+// --- IDs of the checkpoints whose snapshot window reaches strBlock10ID_a (before truncating) ---
+// Returns the number found, -1 on error.
+static int snapshots_over(const char *strWorkDir_a, const char *strBlock10ID_a, char (**arrSnaps_a)[GUID_LEN])
+{
+    int intResult = 0;
+    char (*arrIDs)[GUID_LEN] = NULL;
+    int intBlocks = list_blocks(strWorkDir_a, &arrIDs);
+    int intI;
+
+    *arrSnaps_a = NULL;
+    if (intBlocks < 0) { intResult = -1; }
+    else if (intBlocks > 0)
+    {
+        *arrSnaps_a = (char (*)[GUID_LEN])malloc((size_t)intBlocks * GUID_LEN);
+        if (!*arrSnaps_a) { intResult = -1; }
+    }
+
+    for (intI = 0; intI < intBlocks && intResult >= 0; intI++)
+    {
+        if (rom_snapshot_valid(strWorkDir_a, arrIDs[intI]))
+        {
+            char (*arrWindow)[GUID_LEN] = NULL;
+            int intWindow = collect_chain(strWorkDir_a, arrIDs[intI], NULL, MAX_HISTORY_BLOCKS, &arrWindow);
+            int blnOver   = 0;
+            int intJ;
+
+            for (intJ = 0; intJ < intWindow && !blnOver; intJ++)
+            {
+                blnOver = (strcmp(arrWindow[intJ], strBlock10ID_a) == 0);
+            }
+            if (intWindow < 0) { intResult = -1; }
+            else if (blnOver)  { snprintf((*arrSnaps_a)[intResult++], GUID_LEN, "%s", arrIDs[intI]); }
+            if (arrWindow) { free(arrWindow); }
+        }
+    }
+
+    if (arrIDs) { free(arrIDs); }
+    return intResult;
+}
+
+// --- Rebuild a checkpoint's snapshot against the truncated chain ---
+static int snapshot_rebuild(const char *strWorkDir_a, const char *strCheckpointID_a)
+{
+    ZTBRollingRom *objRom = rolling_rom_open(strWorkDir_a, strCheckpointID_a);
+    int intResult = objRom &&
+                    rom_snapshot_write(strWorkDir_a, strCheckpointID_a, objRom->arrRom,
+                                       objRom->intSlices, objRom->intPrevCrc);
+    if (objRom) { rolling_rom_close(objRom); }
+    return intResult;
+}
 
 int main(int argc, char *argv[])
 {
     int intResult = 0;
 
-    printf("ZTB Truncate v20260618\n");
+    printf("ZTB Truncate v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
     if (argc != 3)
@@ -38,6 +95,8 @@ int main(int argc, char *argv[])
     uint8_t *byBlock10     = NULL;
     uint8_t *byRollingRom  = NULL;
     uint8_t *byFinal       = NULL;
+    char   (*arrSnaps)[GUID_LEN] = NULL;
+    int      intSnaps      = 0;
 
     if (intResult == 0)
     {
@@ -70,6 +129,17 @@ int main(int argc, char *argv[])
             }
         }
 
+        // --- 2b. Find the snapshots to rebuild while the chain still runs through block10 ---
+        if (intResult == 0)
+        {
+            intSnaps = snapshots_over(strWorkDir_a, strBlock10ID, &arrSnaps);
+            if (intSnaps < 0)
+            {
+                fprintf(stderr, "Error: Cannot scan the ROM snapshots above block10\n");
+                intResult = 1;
+            }
+        }
+
         if (intResult == 0)
         {
             printf("Checkpoint:  %s\n", strCheckpointID_a);
@@ -115,7 +185,7 @@ int main(int argc, char *argv[])
                 // --- 6. Write via tmp then rename, overwriting <block10ID>.ztb ---
                 char strOutPath[FILENAME_MAX];
                 char strTmpPath[FILENAME_MAX + 4];
-                snprintf(strOutPath, FILENAME_MAX, "%s/%s.ztb", strWorkDir_a, strBlock10ID);
+                block_file_path(strWorkDir_a, strBlock10ID, ".ztb", strOutPath);
                 snprintf(strTmpPath, FILENAME_MAX + 4, "%s.tmp", strOutPath);
 
                 FILE *fOut = fopen(strTmpPath, "wb");
@@ -146,6 +216,25 @@ int main(int argc, char *argv[])
                     }
                 }
 
+                // --- 7. Rebuild every snapshot over block10 (all removed first, so none is built from a stale one) ---
+                if (intResult == 0)
+                {
+                    int intI;
+                    for (intI = 0; intI < intSnaps; intI++) { rom_snapshot_remove(strWorkDir_a, arrSnaps[intI]); }
+                    for (intI = 0; intI < intSnaps; intI++)
+                    {
+                        if (strcmp(arrSnaps[intI], strBlock10ID) == 0) { printf("  Snapshot removed: %s\n", arrSnaps[intI]); }
+                        else if (snapshot_rebuild(strWorkDir_a, arrSnaps[intI]))
+                        {
+                            printf("  Snapshot rebuilt: %s\n", arrSnaps[intI]);
+                        }
+                        else
+                        {
+                            fprintf(stderr, "Warning: ROM snapshot of %s removed, not rebuilt\n", arrSnaps[intI]);
+                        }
+                    }
+                }
+
                 if (intResult == 0)
                 {
                     printf("\n+ Truncation block written: %s\n", strOutPath);
@@ -164,6 +253,7 @@ int main(int argc, char *argv[])
     if (byBlock10)    { free(byBlock10); }
     if (byRollingRom) { free(byRollingRom); }
     if (byFinal)      { free(byFinal); }
+    if (arrSnaps)     { free(arrSnaps); }
 
     return intResult;
 }
\ No newline at end of file
@@ -1,126 +1,480 @@
-// Cyborg ZTB Verify v20260618
+// Cyborg ZTB Verify v20261019
 // (c) 2026 Cyborg Unicorn Pty Ltd.
 // This software is released under MIT License.
 //
 // Verifies a block or walks back verifying the whole chain.
 // Matches ZTBChain.Verify exactly.
 //
-// Usage: ztbverify <workdir> <tip_block_id> [-walk]
+// Usage: ztbverify <workdir> <tip_block_id> [-walk | -checkpoint | -incremental [watermark_file]]
+//        ztbverify <workdir> <chain_id> -branches [-j <threads>]
+//
+// -checkpoint walks like -walk but stops at the newest checkpoint whose ROM snapshot
+// (written by ztbcheckpoint) still matches the checkpoint block. That checkpoint is
+// trusted, so only the blocks after it are verified; the blocks below it are left to
+// -walk or -incremental (taking the snapshot does not verify them). The tip itself is
+// always verified, even when it is a checkpoint.
+//
+// -incremental walks like -walk but stops at the watermark left by the last
+// successful -incremental run (default <workdir>/verify.wm), after checking that the
+// watermark block's CRC is unchanged. On success the tip becomes the new watermark.
+// A missing or damaged watermark, or one not on the tip's chain, means a full walk.
+// -walk always verifies the whole chain and leaves the watermark alone.
+//
+// Watermark file (one text line; check = CRC32 of everything before it):
+//   ZTBWM1 <block_id> <block_crc32 hex> <check hex>
+//
+// -branches verifies a chain and every branch forked from it (and their branches),
+// taking the chains and their tips from <workdir>/chains.idx. The blocks below each
+// fork are shared, so every tip's walk stops at the first block an earlier walk took
+// and each block is verified once. The walks are cut into runs of consecutive blocks
+// (plan_runs) verified concurrently by -j workers (default one per CPU), each with its
+// own rolling ROM advanced block to block. A failure ends its run; the blocks after
+// it in that run are counted as skipped.
+//
+// The serial walks read ancestors ahead on a second thread (readahead_start), so the
+// next blocks are coming off disk while the current one is decoded and hashed
+// (depth: ZTB_READAHEAD blocks, default 8, 0 = off).
+//
+// The summary ends with the block cache's hit and miss counts (budget: ZTB_CACHE_MB).
 
-#include "ztbcommon.c"
+#include "ztbcommon.h"
+
+#define WATERMARK_FILE      "verify.wm"
+#define WATERMARK_MAGIC     "ZTBWM1"
+#define WATERMARK_LINE_MAX  128
+
+// --- Read the watermark. Returns 1 if present and its checksum is intact ---
+static int watermark_read(const char *strPath_a, char *strBlockID_a, uint32_t *intBlockCrc_a)
+{
+    int intResult = 0;
+    FILE *f = fopen(strPath_a, "rb");
+
+    if (f)
+    {
+        char strLine[WATERMARK_LINE_MAX];
+        if (fgets(strLine, sizeof(strLine), f))
+        {
+            char strMagic[16];
+            char strID[64];
+            unsigned int intCrc   = 0;
+            unsigned int intCheck = 0;
+            if (sscanf(strLine, "%15s %63s %8x %8x", strMagic, strID, &intCrc, &intCheck) == 4 &&
+                strcmp(strMagic, WATERMARK_MAGIC) == 0 && strlen(strID) == 36)
+            {
+                // Checksum covers "<magic> <id> <crc>" exactly as written
+                int intBodyLen = (int)strlen(WATERMARK_MAGIC) + 1 + 36 + 1 + 8;
+                if ((int)strlen(strLine) > intBodyLen &&
+                    calculate_crc32((const uint8_t*)strLine, 0, intBodyLen) == intCheck)
+                {
+                    snprintf(strBlockID_a, GUID_LEN, "%s", strID);
+                    *intBlockCrc_a = (uint32_t)intCrc;
+                    intResult      = 1;
+                }
+            }
+        }
+        fclose(f);
+    }
+
+    return intResult;
+}
+
+// --- Write the watermark via tmp then rename. Returns 1 on success ---
+static int watermark_write(const char *strPath_a, const char *strBlockID_a, uint32_t intBlockCrc_a)
+{
+    int intResult = 0;
+    char strBody[WATERMARK_LINE_MAX];
+    char strTmpPath[FILENAME_MAX + 4];
+    snprintf(strBody, sizeof(strBody), "%s %s %08X", WATERMARK_MAGIC, strBlockID_a, intBlockCrc_a);
+    snprintf(strTmpPath, sizeof(strTmpPath), "%s.tmp", strPath_a);
+
+    FILE *f = fopen(strTmpPath, "wb");
+    if (f)
+    {
+        uint32_t intCheck = calculate_crc32((const uint8_t*)strBody, 0, (int)strlen(strBody));
+        intResult = (fprintf(f, "%s %08X\n", strBody, intCheck) > 0);
+        if (fclose(f) != 0) { intResult = 0; }
+
+        if (intResult)
+        {
+            intResult = rename_block_file(strTmpPath, strPath_a, 0);
+        }
+        else
+        {
+            remove(strTmpPath);
+        }
+    }
+
+    return intResult;
+}
+
+// --- Block cache counters for the summary ---
+static void print_cache_stats(void)
+{
+    ZTBCacheStats objStats;
+    block_cache_stats(&objStats);
+    printf("Cache:    %llu hits, %llu misses\n", (unsigned long long)objStats.intHits,
+           (unsigned long long)objStats.intMisses);
+}
 
 // Verify a single block. Returns 1 if valid, 0 if not.
+// The block is decoded and hashed in STREAM_CHUNK_SIZE pieces (block_reader_scan), as
+// ztbfetch and ztb_verify do, so memory stays flat whatever the block size.
 static int verify_block(const char *strWorkDir_a, const char *strBlockID_a)
 {
-    int intValid      = 0;
-    uint8_t *byBlock  = NULL;
+    int intValid = 0;
     uint8_t *byRollingRom = NULL;
-    uint8_t *byDecoded    = NULL;
+    uint8_t arrHeader[HEADER_RAW_SIZE];
+    uint64_t intBlockLen = 0;
+    ZTBBlockReader objReader;
+    objReader.f = NULL;
 
-    int intBlockLen = 0;
-    byBlock = load_block(strWorkDir_a, strBlockID_a, &intBlockLen);
-
-    if (byBlock && intBlockLen >= HEADER_RAW_SIZE)
+    if (read_block_prefix(strWorkDir_a, strBlockID_a, arrHeader, HEADER_RAW_SIZE,
+                          &intBlockLen) >= HEADER_RAW_SIZE)
     {
-        uint8_t byBlockType = byBlock[RAW_OFF_BLOCK_TYPE];
         char strPrevID[GUID_LEN];
-        read_fixed_string(byBlock, RAW_OFF_PREV_ID, 36, strPrevID);
+        read_fixed_string(arrHeader, RAW_OFF_PREV_ID, 36, strPrevID);
 
         // Truncation block is not encoded — treat as valid (matches C# FetchBlock)
-        if (byBlockType == BLOCK_TYPE_TRUNCATION)
+        if (arrHeader[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION)
         {
             intValid = 1;
         }
         else
         {
+            // Current-block hash covers the payload ONLY (see ztbaddblock.c); a compressed
+            // payload must also decompress to its data_crc (checked by the scan)
             byRollingRom = build_rolling_rom(strWorkDir_a, strPrevID);
-            if (byRollingRom)
+            if (byRollingRom &&
+                block_reader_open(&objReader, strWorkDir_a, strBlockID_a, byRollingRom) &&
+                objReader.blnEncoded && block_reader_scan(&objReader, NULL, NULL))
             {
-                int intEncLen = intBlockLen - HEADER_RAW_SIZE;
-                int intDecLen = 0;
-                byDecoded     = zoscii_decode(byRollingRom, byBlock,
-                                              HEADER_RAW_SIZE, intEncLen, &intDecLen);
-                if (byDecoded && intDecLen >= ENC_HEADER_SIZE)
-                {
-                    uint8_t byHashType     = byDecoded[ENC_OFF_HASH_TYPE];
-                    uint32_t intStoredHash = (uint32_t)(byDecoded[ENC_OFF_HASH] |
-                                            (byDecoded[ENC_OFF_HASH + 1] << 8)  |
-                                            (byDecoded[ENC_OFF_HASH + 2] << 16) |
-                                            (byDecoded[ENC_OFF_HASH + 3] << 24));
-                    uint32_t intStoredPrevHash = (uint32_t)(byDecoded[ENC_OFF_PREV_HASH] |
-                                                (byDecoded[ENC_OFF_PREV_HASH + 1] << 8)  |
-                                                (byDecoded[ENC_OFF_PREV_HASH + 2] << 16) |
-                                                (byDecoded[ENC_OFF_PREV_HASH + 3] << 24));
-
-                    // Current-block hash covers the payload ONLY (see ztbaddblock.c)
-                    int intPaddedPayloadLen = intDecLen - ENC_OFF_PAYLOAD;
-                    uint32_t intCalcHash = hash_bytes((int)byHashType,
-                                                      byDecoded + ENC_OFF_PAYLOAD,
-                                                      0, intPaddedPayloadLen);
-                    int blnHashOK = (intCalcHash == intStoredHash);
-
-                    int blnPrevHashOK = 1;
-                    if (intStoredPrevHash != 0 && strcmp(strPrevID, NULL_GUID) != 0)
-                    {
-                        int intPrevLen  = 0;
-                        uint8_t *byPrev = load_block(strWorkDir_a, strPrevID, &intPrevLen);
-                        if (byPrev)
-                        {
-                            int blnPrevIsTrunc = (intPrevLen >= HEADER_RAW_SIZE &&
-                                                  byPrev[RAW_OFF_BLOCK_TYPE] == BLOCK_TYPE_TRUNCATION);
-                            if (!blnPrevIsTrunc)
-                            {
-                                uint32_t intCalcPrev = hash_bytes((int)byHashType,
-                                                                   byPrev, 0, intPrevLen);
-                                blnPrevHashOK = (intCalcPrev == intStoredPrevHash);
-                            }
-                            free(byPrev);
-                        }
-                    }
-
-                    if (blnHashOK && blnPrevHashOK) { intValid = 1; }
-                }
+                int blnHashOK     = (objReader.intCalcHash == objReader.intStoredHash);
+                int blnPrevHashOK = block_prev_hash_ok(strWorkDir_a, strPrevID, objReader.byHashType,
+                                                       objReader.intStoredPrevHash);
+                if (blnHashOK && blnPrevHashOK) { intValid = 1; }
             }
         }
     }
 
-    if (byBlock)      { free(byBlock); }
+    block_reader_close(&objReader);
     if (byRollingRom) { free(byRollingRom); }
-    if (byDecoded)    { free(byDecoded); }
 
     return intValid;
 }
 
+// --- -branches: runs of blocks verified by a pool of workers ---
+typedef struct
+{
+    ZTBRun objRun;
+    int    intVerified;
+    int    intFailedAt;                     // block index that failed, -1 if none
+} VerifyRun;
+
+typedef struct
+{
+    const char *strWorkDir;
+    char      (*arrIDs)[GUID_LEN];
+    VerifyRun  *arrRuns;
+    int         intRuns;
+    int         intNextRun;
+    ZTBMutex    objLock;
+} VerifyJob;
+
+static void verify_run(VerifyJob *objJob_a, VerifyRun *objRun_a)
+{
+    int intFirst     = objRun_a->objRun.intFirst;
+    int blnPrevTrunc = 0;
+    ZTBRollingRom *objRom = rolling_rom_open_before(objJob_a->strWorkDir,
+                                                    objJob_a->arrIDs[intFirst], &blnPrevTrunc);
+
+    objRun_a->intFailedAt = objRom ? -1 : intFirst;
+
+    int intI;
+    for (intI = 0; intI < objRun_a->objRun.intCount && objRun_a->intFailedAt < 0; intI++)
+    {
+        int blnIntact = 0;
+        if (read_run_block(objJob_a->strWorkDir, objRom, objJob_a->arrIDs[intFirst + intI],
+                           blnPrevTrunc, NULL, NULL, &blnIntact) && blnIntact)
+        {
+            objRun_a->intVerified++;
+        }
+        else
+        {
+            objRun_a->intFailedAt = intFirst + intI;
+        }
+        blnPrevTrunc = 0;
+    }
+
+    if (objRom) { rolling_rom_close(objRom); }
+}
+
+static void verify_worker(void *objArg_a)
+{
+    VerifyJob *objJob = (VerifyJob*)objArg_a;
+
+    for (;;)
+    {
+        VerifyRun *objRun = NULL;
+
+        mutex_lock(&objJob->objLock);
+        if (objJob->intNextRun < objJob->intRuns) { objRun = &objJob->arrRuns[objJob->intNextRun++]; }
+        mutex_unlock(&objJob->objLock);
+
+        if (!objRun) { break; }
+        verify_run(objJob, objRun);
+    }
+}
+
+// --- Verify a chain and all of its branches. Returns 0 if every block passed ---
+static int verify_branches(const char *strWorkDir_a, const char *strChainID_a, int intThreads_a)
+{
+    int intResult = 0;
+    ZTBChainIndex objIndex;
+    char (*arrTips)[GUID_LEN] = NULL;
+    int intTips = 0;
+
+    // --- 1. The chain and, transitively, every chain branched from it ---
+    if (!chains_index_load(strWorkDir_a, &objIndex))
+    {
+        fprintf(stderr, "Error: Cannot read %s/%s\n", strWorkDir_a, CHAINS_INDEX_FILE);
+        intResult = 1;
+    }
+    else if (chains_index_find(&objIndex, strChainID_a) < 0)
+    {
+        fprintf(stderr, "Error: Chain '%s' is not in the chains index\n", strChainID_a);
+        intResult = 1;
+    }
+
+    uint8_t *arrIn = NULL;
+    if (intResult == 0)
+    {
+        arrIn   = (uint8_t*)calloc((size_t)objIndex.intCount, 1);
+        arrTips = (char (*)[GUID_LEN])malloc((size_t)objIndex.intCount * GUID_LEN);
+        if (!arrIn || !arrTips) { intResult = 1; }
+    }
+
+    if (intResult == 0)
+    {
+        int blnGrew = 1;
+        int intI;
+        arrIn[chains_index_find(&objIndex, strChainID_a)] = 1;
+        while (blnGrew)
+        {
+            blnGrew = 0;
+            for (intI = 0; intI < objIndex.intCount; intI++)
+            {
+                int intTrunk = objIndex.arrChains[intI].strTrunk[0] ?
+                               chains_index_find(&objIndex, objIndex.arrChains[intI].strTrunk) : -1;
+                if (!arrIn[intI] && intTrunk >= 0 && arrIn[intTrunk])
+                {
+                    arrIn[intI] = 1;
+                    blnGrew     = 1;
+                }
+            }
+        }
+
+        // Trunk first, then branches in the order they were made
+        for (intI = -1; intI < objIndex.intCount; intI++)
+        {
+            int intAt = (intI < 0) ? chains_index_find(&objIndex, strChainID_a) : intI;
+            ZTBChainEntry *objChain = &objIndex.arrChains[intAt];
+            if (!arrIn[intAt] || (intI >= 0 && intAt == chains_index_find(&objIndex, strChainID_a)))
+            {
+                continue;
+            }
+
+            // A branch whose tip line was lost (crash between the two lines) starts at its first block
+            const char *strTip = objChain->strTip[0] ? objChain->strTip : objChain->strFirst;
+            if (objChain->strTrunk[0])
+            {
+                printf("  Branch %s of %s at %s, tip %s\n", objChain->strName, objChain->strTrunk,
+                       objChain->strFork, strTip);
+            }
+            else
+            {
+                printf("  Chain %s, tip %s\n", objChain->strName, strTip);
+            }
+            if (strTip[0]) { snprintf(arrTips[intTips++], GUID_LEN, "%s", strTip); }
+        }
+    }
+
+    // --- 2. Each block once, in runs, across the workers ---
+    char (*arrIDs)[GUID_LEN] = NULL;
+    ZTBRun *arrPlan   = NULL;
+    VerifyRun *arrRuns = NULL;
+    int intRuns  = 0;
+    int intCount = 0;
+
+    if (intResult == 0)
+    {
+        intCount = plan_runs(strWorkDir_a, arrTips, intTips, intThreads_a, &arrIDs, &arrPlan, &intRuns);
+        arrRuns  = (intCount >= 0) ? (VerifyRun*)calloc((size_t)intRuns + 1, sizeof(VerifyRun)) : NULL;
+        if (!arrRuns) { intResult = 1; }
+    }
+
+    if (intResult == 0)
+    {
+        VerifyJob objJob;
+        int intVerified = 0;
+        int intFailed   = 0;
+        int intI;
+
+        memset(&objJob, 0, sizeof(objJob));
+        objJob.strWorkDir = strWorkDir_a;
+        objJob.arrIDs     = arrIDs;
+        objJob.arrRuns    = arrRuns;
+        objJob.intRuns    = intRuns;
+        for (intI = 0; intI < intRuns; intI++) { arrRuns[intI].objRun = arrPlan[intI]; }
+
+        mutex_init(&objJob.objLock);
+        int intWorkers = run_workers(intThreads_a < intRuns ? intThreads_a : (intRuns > 0 ? intRuns : 1),
+                                     verify_worker, &objJob);
+        mutex_destroy(&objJob.objLock);
+
+        for (intI = 0; intI < intRuns; intI++)
+        {
+            intVerified += arrRuns[intI].intVerified;
+            if (arrRuns[intI].intFailedAt >= 0)
+            {
+                printf("  Verifying %s... [FAIL]\n", arrIDs[arrRuns[intI].intFailedAt]);
+                intFailed++;
+            }
+        }
+
+        printf("\n=== Verify Summary ===\n");
+        printf("Chains:   %d\n", intTips);
+        printf("Verified: %d\n", intVerified);
+        printf("Failed:   %d\n", intFailed);
+        printf("Skipped:  %d\n", intCount - intVerified - intFailed);
+        printf("Workers:  %d\n", intWorkers);
+        print_cache_stats();
+
+        if (intFailed == 0 && intVerified > 0)
+        {
+            printf("+++ ALL VERIFICATIONS PASSED +++\n");
+        }
+        else
+        {
+            printf("--- VERIFICATION FAILED ---\n");
+            intResult = 1;
+        }
+    }
+
+    chains_index_free(&objIndex);
+    if (arrIn)   { free(arrIn); }
+    if (arrTips) { free(arrTips); }
+    if (arrIDs)  { free(arrIDs); }
+    if (arrPlan) { free(arrPlan); }
+    if (arrRuns) { free(arrRuns); }
+
+    return intResult;
+}
+
 int main(int argc, char *argv[])
 {
     int intResult = 0;
 
-    printf("ZTB Verify v20260618\n");
+    printf("ZTB Verify v20261019\n");
     printf("(c) 2026 Cyborg Unicorn Pty Ltd - MIT License\n\n");
 
-    if (argc < 3 || argc > 4)
+    int blnIncremental = (argc >= 4 && strcmp(argv[3], "-incremental") == 0);
+    int blnBranches    = (argc >= 4 && strcmp(argv[3], "-branches") == 0);
+    int intThreads     = 0;
+
+    if (blnBranches && argc == 6 && strcmp(argv[4], "-j") == 0)
     {
-        fprintf(stderr, "Usage: %s <workdir> <tip_block_id> [-walk]\n", argv[0]);
-        fprintf(stderr, "  -walk   Walk back through the chain verifying all blocks\n");
+        intThreads = atoi(argv[5]);
+        if (intThreads <= 0 || intThreads > MAX_WORKERS) { blnBranches = 0; }
+    }
+
+    if (argc < 3 || argc > 6 || (argc == 5 && !blnIncremental) ||
+        (argc == 6 && !(blnBranches && intThreads > 0)))
+    {
+        fprintf(stderr, "Usage: %s <workdir> <tip_block_id> [-walk | -checkpoint | -incremental [watermark_file]]\n", argv[0]);
+        fprintf(stderr, "       %s <workdir> <chain_id> -branches [-j <threads>]\n", argv[0]);
+        fprintf(stderr, "  -walk         Walk back through the chain verifying all blocks\n");
+        fprintf(stderr, "  -checkpoint   Walk back only as far as the last trusted checkpoint\n");
+        fprintf(stderr, "  -incremental  Walk back only as far as the last verified watermark,\n");
+        fprintf(stderr, "                then move the watermark to the tip (default <workdir>/%s)\n",
+                WATERMARK_FILE);
+        fprintf(stderr, "  -branches     Verify the chain and all its branches from %s, in parallel\n",
+                CHAINS_INDEX_FILE);
         intResult = 1;
     }
+    else if (blnBranches)
+    {
+        intResult = verify_branches(argv[1], argv[2], intThreads > 0 ? intThreads : cpu_count());
+    }
 
-    if (intResult == 0)
+    if (intResult == 0 && !blnBranches)
     {
         const char *strWorkDir_a = argv[1];
         const char *strTipID_a   = argv[2];
-        int blnWalk              = (argc == 4 && strcmp(argv[3], "-walk") == 0);
+        int blnFromCheckpoint    = (argc == 4 && strcmp(argv[3], "-checkpoint") == 0);
+        int blnWalk              = (argc == 4 && strcmp(argv[3], "-walk") == 0) ||
+                                   blnFromCheckpoint || blnIncremental;
 
         int intVerified = 0;
         int intFailed   = 0;
+        int intTrusted  = 0;
+
+        // --- Watermark from the last -incremental run ---
+        char strWmPath[FILENAME_MAX];
+        char strWmID[GUID_LEN];
+        uint32_t intWmCrc = 0;
+        int blnHaveWm     = 0;
+
+        strWmID[0] = '\0';
+        if (blnIncremental)
+        {
+            if (argc == 5) { snprintf(strWmPath, FILENAME_MAX, "%s", argv[4]); }
+            else           { snprintf(strWmPath, FILENAME_MAX, "%s/%s", strWorkDir_a, WATERMARK_FILE); }
+
+            blnHaveWm = watermark_read(strWmPath, strWmID, &intWmCrc);
+            if (blnHaveWm) { printf("  Watermark %s (0x%08X)\n", strWmID, intWmCrc); }
+            else           { printf("  No usable watermark - full walk\n"); }
+        }
 
         // Walk matches ZTBChain.Verify: start at tip, follow prev_block_id
         char strCurrentID[GUID_LEN];
         strncpy(strCurrentID, strTipID_a, GUID_LEN - 1);
         strCurrentID[GUID_LEN - 1] = '\0';
 
+        // The ancestors are read ahead while each block is decoded and hashed
+        ZTBReadahead *objReadahead = blnWalk ? readahead_start(strWorkDir_a, strTipID_a, readahead_depth()) : NULL;
+
         while (strcmp(strCurrentID, NULL_GUID) != 0 && strlen(strCurrentID) > 0)
         {
+            // A trusted checkpoint ends the walk: its snapshot stands in for the ROM of the
+            // blocks below it, which are not checked here (ztbcheckpoint does not verify them
+            // either; a -walk or -incremental run covers them). The tip is never trusted, so
+            // a run always verifies at least one block.
+            if (blnFromCheckpoint && strcmp(strCurrentID, strTipID_a) != 0 &&
+                rom_snapshot_valid(strWorkDir_a, strCurrentID))
+            {
+                printf("  Trusted checkpoint %s [SNAPSHOT]\n", strCurrentID);
+                intTrusted++;
+                break;
+            }
+
+            // Blocks below the watermark were verified by an earlier run; the watermark
+            // block itself must be byte-for-byte what that run saw
+            if (blnHaveWm && strcmp(strCurrentID, strWmID) == 0)
+            {
+                uint32_t intCrc = 0;
+                if (block_crc32(strWorkDir_a, strCurrentID, &intCrc) && intCrc == intWmCrc)
+                {
+                    printf("  Watermark %s unchanged [TRUSTED]\n", strCurrentID);
+                    intTrusted++;
+                }
+                else
+                {
+                    printf("  Watermark %s CHANGED [FAIL]\n", strCurrentID);
+                    intFailed++;
+                }
+                break;
+            }
+
             printf("  Verifying %s... ", strCurrentID);
 
             int blnOK = verify_block(strWorkDir_a, strCurrentID);
@@ -146,36 +500,54 @@ int main(int argc, char *argv[])
                 }
                 else
                 {
-                    // Load block to get prev_block_id for next iteration
-                    int intBlockLen = 0;
-                    uint8_t *byBlock = load_block(strWorkDir_a, strCurrentID, &intBlockLen);
-                    if (byBlock && intBlockLen >= HEADER_RAW_SIZE)
+                    // Raw header (cached by the verify) gives prev_block_id for next iteration
+                    ZTBBlockHeader objHeader;
+                    if (block_header(strWorkDir_a, strCurrentID, &objHeader))
                     {
-                        uint8_t byBlockType = byBlock[RAW_OFF_BLOCK_TYPE];
-                        read_fixed_string(byBlock, RAW_OFF_PREV_ID, 36, strCurrentID);
-                        free(byBlock);
+                        snprintf(strCurrentID, GUID_LEN, "%s", objHeader.strPrevID);
                         // Stop at truncation block (matches C# Verify)
-                        if (byBlockType == BLOCK_TYPE_TRUNCATION)
+                        if (objHeader.intBlockType == BLOCK_TYPE_TRUNCATION)
                         {
                             strcpy(strCurrentID, NULL_GUID);
                         }
                     }
                     else
                     {
-                        if (byBlock) { free(byBlock); }
                         strcpy(strCurrentID, NULL_GUID);
                     }
+                    readahead_step(objReadahead);
                 }
             }
         }
+        readahead_stop(objReadahead);
 
         printf("\n=== Verify Summary ===\n");
         printf("Verified: %d\n", intVerified);
         printf("Failed:   %d\n", intFailed);
+        if (blnFromCheckpoint || blnIncremental)
+        {
+            printf("Trusted:  %d\n", intTrusted);
+        }
+        print_cache_stats();
 
-        if (intFailed == 0 && intVerified > 0)
+        if (intFailed == 0 && intVerified + intTrusted > 0)
         {
             printf("+++ ALL VERIFICATIONS PASSED +++\n");
+
+            // --- Move the watermark up to the tip ---
+            uint32_t intTipCrc = 0;
+            if (blnIncremental)
+            {
+                if (block_crc32(strWorkDir_a, strTipID_a, &intTipCrc) &&
+                    watermark_write(strWmPath, strTipID_a, intTipCrc))
+                {
+                    printf("Watermark: %s (0x%08X)\n", strTipID_a, intTipCrc);
+                }
+                else
+                {
+                    fprintf(stderr, "Warning: Cannot write watermark %s\n", strWmPath);
+                }
+            }
         }
         else
         {